@@ -0,0 +1,63 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======
+#include <cstring>
+#include "Benchmark.h"
+//=================
+
+namespace
+{
+    struct Entry
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    const Entry benchmarks[] =
+    {
+        { "threading",          Benchmark::Threading },
+        { "render_queue",       Benchmark::RenderQueue },
+        { "texture_compressor", Benchmark::TextureCompressor }
+    };
+}
+
+// Runs every benchmark, or only the ones named on the command line
+int main(int argc, char** argv)
+{
+    for (const Entry& benchmark : benchmarks)
+    {
+        bool selected = argc <= 1;
+        for (int i = 1; i < argc; i++)
+        {
+            selected |= strcmp(argv[i], benchmark.name) == 0;
+        }
+
+        if (!selected)
+            continue;
+
+        printf("== %s ==\n", benchmark.name);
+        benchmark.run();
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ====================
+#include <vector>
+#include <array>
+#include <map>
+#include <limits>
+#include <random>
+#include <algorithm>
+#include "Benchmark.h"
+#include "Rendering/RenderQueue.h"
+//===============================
+
+//= NAMESPACES ========
+using namespace std;
+using namespace Spartan;
+//=====================
+
+// Replays the bindings Pass_GBuffer records, before the render queue (a distance sort followed by a rescan per shader variation)
+// and after it (a single walk over the RenderQueue order). Redundant binds are filtered the way the command lists do it.
+namespace
+{
+    constexpr uint32_t variations_registered = 8; // ShaderGBuffer::GetVariations() in a typical session
+
+    struct Draw
+    {
+        uint32_t model;
+        uint32_t submesh;
+        uint32_t material;
+        float distance;
+    };
+
+    struct Counters
+    {
+        uint32_t pipeline           = 0;
+        uint32_t render_target      = 0;
+        uint32_t buffer_vertex      = 0;
+        uint32_t buffer_index       = 0;
+        uint32_t texture            = 0;
+        uint32_t buffer_constant    = 0;
+    };
+
+    // Materials use 5 of the variations and have 4 textures (color, roughness, metallic, normal)
+    uint32_t GetVariation(const uint32_t material)                      { return material % 5; }
+    uint32_t GetTexture(const uint32_t material, const uint32_t slot)   { return slot < 4 ? 1 + material * 8 + slot : 0; }
+
+    struct State
+    {
+        void BeginRenderPass()
+        {
+            counters.pipeline++;
+            counters.render_target += 5; // 4 color targets and depth
+        }
+
+        void SetGeometry(const uint32_t model)
+        {
+            if (vertex_buffer != model)
+            {
+                vertex_buffer = model;
+                counters.buffer_vertex++;
+            }
+
+            if (index_buffer != model)
+            {
+                index_buffer = model;
+                counters.buffer_index++;
+            }
+        }
+
+        void SetMaterial(const uint32_t material)
+        {
+            for (uint32_t slot = 0; slot < static_cast<uint32_t>(textures.size()); slot++)
+            {
+                const uint32_t texture = GetTexture(material, slot);
+                if (textures[slot] != texture)
+                {
+                    textures[slot] = texture;
+                    counters.texture++;
+                }
+            }
+            counters.buffer_constant++;
+        }
+
+        void Draw() { counters.buffer_constant++; }
+
+        int64_t vertex_buffer   = -1;
+        int64_t index_buffer    = -1;
+        array<uint32_t, 8> textures = {};
+        Counters counters;
+    };
+
+    Counters ReplayBefore(vector<Draw> draws)
+    {
+        sort(draws.begin(), draws.end(), [](const Draw& a, const Draw& b) { return a.distance < b.distance; });
+
+        State state;
+        uint32_t material_bound = numeric_limits<uint32_t>::max();
+        for (uint32_t variation = 0; variation < variations_registered; variation++)
+        {
+            bool render_pass_active = false;
+            for (const Draw& draw : draws)
+            {
+                if (GetVariation(draw.material) != variation)
+                    continue;
+
+                if (!render_pass_active)
+                {
+                    state.BeginRenderPass();
+                    render_pass_active = true;
+                }
+
+                state.SetGeometry(draw.model);
+
+                if (material_bound != draw.material)
+                {
+                    material_bound = draw.material;
+                    state.SetMaterial(draw.material);
+                }
+
+                state.Draw();
+            }
+        }
+
+        return state.counters;
+    }
+
+    Counters ReplayAfter(const vector<Draw>& draws, const float distance_max)
+    {
+        // Geometry is numbered densely in the order it's first seen, like Renderer::RenderablesSort() does
+        map<pair<uint32_t, uint32_t>, uint16_t> geometry_ids;
+
+        RenderQueue queue;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(draws.size()); i++)
+        {
+            const Draw& draw        = draws[i];
+            const uint16_t geometry = geometry_ids.emplace(make_pair(draw.model, draw.submesh), static_cast<uint16_t>(geometry_ids.size())).first->second;
+            const uint16_t shader   = static_cast<uint16_t>(GetVariation(draw.material));
+            const uint16_t material = static_cast<uint16_t>(draw.material);
+
+            queue.Add(RenderQueue::KeyState(shader, material, geometry, RenderQueue::QuantizeDepth(draw.distance, distance_max)), i);
+        }
+        queue.Sort();
+
+        vector<uint32_t> order;
+        queue.GetIndices(order);
+
+        State state;
+        uint32_t material_bound     = numeric_limits<uint32_t>::max();
+        uint32_t variation_bound    = numeric_limits<uint32_t>::max();
+        for (const uint32_t i : order)
+        {
+            const Draw& draw = draws[i];
+
+            if (GetVariation(draw.material) != variation_bound)
+            {
+                variation_bound = GetVariation(draw.material);
+                state.BeginRenderPass();
+            }
+
+            state.SetGeometry(draw.model);
+
+            if (material_bound != draw.material)
+            {
+                material_bound = draw.material;
+                state.SetMaterial(draw.material);
+            }
+
+            state.Draw();
+        }
+
+        return state.counters;
+    }
+
+    // A model with a number of sub-meshes spread over some materials, placed a number of times
+    struct ModelDesc
+    {
+        uint32_t submeshes;
+        uint32_t materials;
+        uint32_t placements;
+    };
+
+    vector<Draw> GenerateScene(const vector<ModelDesc>& models, const float distance_max, const uint32_t seed)
+    {
+        mt19937 rng(seed);
+        uniform_real_distribution<float> distance(1.0f, distance_max);
+        uniform_real_distribution<float> spread(-2.0f, 2.0f);
+
+        vector<Draw> draws;
+        uint32_t material_base = 0;
+        for (uint32_t model = 0; model < static_cast<uint32_t>(models.size()); model++)
+        {
+            const ModelDesc& desc = models[model];
+            for (uint32_t placement = 0; placement < desc.placements; placement++)
+            {
+                const float distance_placement = distance(rng);
+                for (uint32_t submesh = 0; submesh < desc.submeshes; submesh++)
+                {
+                    // A single placement is a big model (e.g. a level) whose sub-meshes are all over the place
+                    const float distance_submesh = desc.placements == 1 ? distance(rng) : distance_placement + spread(rng);
+                    draws.push_back({ model, submesh, material_base + (submesh % desc.materials), max(0.0f, distance_submesh) });
+                }
+            }
+            material_base += desc.materials;
+        }
+
+        return draws;
+    }
+
+    void Report(const char* name, const vector<ModelDesc>& models, const float distance_max, const uint32_t seed)
+    {
+        const vector<Draw> draws    = GenerateScene(models, distance_max, seed);
+        const Counters before       = ReplayBefore(draws);
+        const Counters after        = ReplayAfter(draws, distance_max);
+
+        printf("%s (%zu draws)\n", name, draws.size());
+        printf("  %-16s %8s %8s\n", "binding",         "before",               "after");
+        printf("  %-16s %8u %8u\n", "pipeline",        before.pipeline,        after.pipeline);
+        printf("  %-16s %8u %8u\n", "render_target",   before.render_target,   after.render_target);
+        printf("  %-16s %8u %8u\n", "buffer_vertex",   before.buffer_vertex,   after.buffer_vertex);
+        printf("  %-16s %8u %8u\n", "buffer_index",    before.buffer_index,    after.buffer_index);
+        printf("  %-16s %8u %8u\n", "texture",         before.texture,         after.texture);
+        printf("  %-16s %8u %8u\n", "buffer_constant", before.buffer_constant, after.buffer_constant);
+    }
+}
+
+// G-buffer binding counts (the Profiler::m_rhi_bindings_* counters) with and without the render queue
+void Benchmark::RenderQueue()
+{
+    // One big model with many sub-meshes and materials, plus a few props
+    Report("Sponza + props", { { 380, 25, 1 }, { 4, 2, 20 }, { 2, 1, 30 } }, 100.0f, 1);
+
+    // Many placed props, with few materials each
+    Report("Props", { { 3, 2, 200 }, { 5, 3, 150 }, { 1, 1, 400 }, { 8, 4, 50 } }, 300.0f, 2);
+}
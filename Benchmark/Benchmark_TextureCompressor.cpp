@@ -0,0 +1,234 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==============================
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "Benchmark.h"
+#include "RHI/RHI_Texture.h"
+#include "Resource/Import/TextureCompressor.h"
+//=========================================
+
+//= NAMESPACES ========
+using namespace std;
+using namespace Spartan;
+//=====================
+
+// Quality and speed of the block encoders on procedural textures, on a single thread
+namespace
+{
+    constexpr uint32_t runs = 3;
+    constexpr uint32_t size = 2048;
+
+    struct Image
+    {
+        Image() : texels(static_cast<size_t>(size) * size * 4) {}
+
+        uint8_t* GetTexel(const uint32_t x, const uint32_t y) { return &texels[(static_cast<size_t>(y) * size + x) * 4]; }
+        vector<uint8_t> texels;
+    };
+
+    // Value noise, summed over a few octaves
+    float Hash(const int x, const int y)
+    {
+        uint32_t hash   = static_cast<uint32_t>(x) * 374761393u + static_cast<uint32_t>(y) * 668265263u;
+        hash            = (hash ^ (hash >> 13)) * 1274126177u;
+        return (hash & 0xFFFF) / 65535.0f;
+    }
+
+    float Noise(const float x, const float y)
+    {
+        const int ix    = static_cast<int>(floor(x));
+        const int iy    = static_cast<int>(floor(y));
+        float fx        = x - ix;
+        float fy        = y - iy;
+        fx              = fx * fx * (3.0f - 2.0f * fx);
+        fy              = fy * fy * (3.0f - 2.0f * fy);
+
+        const float a = Hash(ix, iy);
+        const float b = Hash(ix + 1, iy);
+        const float c = Hash(ix, iy + 1);
+        const float d = Hash(ix + 1, iy + 1);
+
+        return a + (b - a) * fx + (c - a) * fy + (a - b - c + d) * fx * fy;
+    }
+
+    float Fbm(float x, float y)
+    {
+        float sum       = 0.0f;
+        float amplitude = 0.5f;
+        for (uint32_t octave = 0; octave < 6; octave++)
+        {
+            sum         += amplitude * Noise(x, y);
+            x           *= 2.0f;
+            y           *= 2.0f;
+            amplitude   *= 0.5f;
+        }
+
+        return sum;
+    }
+
+    uint8_t ToUnorm(const float value) { return static_cast<uint8_t>(clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); }
+
+    // An albedo, its normal map and a roughness map, derived from the same height field, and an icon-like cut-out
+    void GenerateImages(Image& albedo, Image& normal, Image& roughness, Image& cutout)
+    {
+        vector<float> height(static_cast<size_t>(size) * size);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                height[y * size + x] = Fbm(x / 64.0f, y / 64.0f);
+            }
+        }
+
+        const auto get_height = [&height](const uint32_t x, const uint32_t y) { return height[(y % size) * size + (x % size)]; };
+
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const float h       = get_height(x, y);
+                const float grain   = Fbm(x / 16.0f + 100.0f, y / 16.0f);
+
+                uint8_t* texel = albedo.GetTexel(x, y);
+                texel[0] = ToUnorm(0.3f + 0.6f * h);
+                texel[1] = ToUnorm(0.2f + 0.5f * grain);
+                texel[2] = ToUnorm(0.4f * h * grain + 0.16f);
+                texel[3] = 255;
+
+                const float dx      = (get_height(x + 1, y) - get_height(x + size - 1, y)) * 8.0f;
+                const float dy      = (get_height(x, y + 1) - get_height(x, y + size - 1)) * 8.0f;
+                const float length  = sqrt(dx * dx + dy * dy + 1.0f);
+                texel = normal.GetTexel(x, y);
+                texel[0] = ToUnorm(-dx / length * 0.5f + 0.5f);
+                texel[1] = ToUnorm(-dy / length * 0.5f + 0.5f);
+                texel[2] = ToUnorm(1.0f / length * 0.5f + 0.5f);
+                texel[3] = 255;
+
+                texel = roughness.GetTexel(x, y);
+                texel[0] = texel[1] = texel[2] = ToUnorm(grain);
+                texel[3] = 255;
+
+                // Rings of a flat color with anti-aliased edges, empty in between
+                const float u           = (x % 64) - 31.5f;
+                const float v           = (y % 64) - 31.5f;
+                const float distance    = sqrt(u * u + v * v);
+                const float coverage    = clamp(24.0f - distance, 0.0f, 1.0f) * clamp(distance - 12.0f, 0.0f, 1.0f);
+                texel = cutout.GetTexel(x, y);
+                texel[0] = 230;
+                texel[1] = ToUnorm(0.3f + 0.4f * (y % 64) / 63.0f);
+                texel[2] = 40;
+                texel[3] = ToUnorm(coverage);
+            }
+        }
+    }
+
+    uint32_t GetChannelCount(const RHI_Format format)
+    {
+        switch (format)
+        {
+            case RHI_Format_BC1_Unorm:  return 3;
+            case RHI_Format_BC4_Unorm:  return 1;
+            case RHI_Format_BC5_Unorm:  return 2;
+            default:                    return 4;
+        }
+    }
+
+    float GetPsnr(const double error, const uint64_t samples)
+    {
+        const double mse = error / static_cast<double>(samples);
+        return mse > 0.0 ? static_cast<float>(10.0 * log10(255.0 * 255.0 / mse)) : 99.0f;
+    }
+
+    void Report(const char* name, Image& image, const RHI_Format format)
+    {
+        const uint32_t channels     = GetChannelCount(format);
+        const uint32_t block_size   = RHI_Texture::GetBlockSize(format);
+        const uint32_t block_count  = size / 4;
+        vector<uint8_t> blocks(static_cast<size_t>(block_count) * block_count * block_size);
+
+        const float time = Benchmark::MeasureBest(runs, [&]()
+        {
+            uint8_t texels[64];
+            for (uint32_t y = 0; y < block_count; y++)
+            {
+                for (uint32_t x = 0; x < block_count; x++)
+                {
+                    for (uint32_t row = 0; row < 4; row++)
+                    {
+                        memcpy(texels + row * 16, image.GetTexel(x * 4, y * 4 + row), 16);
+                    }
+                    TextureCompressor::EncodeBlock(format, texels, &blocks[(static_cast<size_t>(y) * block_count + x) * block_size]);
+                }
+            }
+        });
+
+        // Error over the stored channels, and over RGB only
+        double error            = 0.0;
+        double error_rgb        = 0.0;
+        uint8_t decoded[64];
+        for (uint32_t y = 0; y < block_count; y++)
+        {
+            for (uint32_t x = 0; x < block_count; x++)
+            {
+                TextureCompressor::DecodeBlock(format, &blocks[(static_cast<size_t>(y) * block_count + x) * block_size], decoded);
+
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    const uint8_t* texel = image.GetTexel(x * 4 + i % 4, y * 4 + i / 4);
+                    for (uint32_t channel = 0; channel < channels; channel++)
+                    {
+                        const double difference = static_cast<double>(texel[channel]) - decoded[i * 4 + channel];
+                        error       += difference * difference;
+                        error_rgb   += channel < 3 ? difference * difference : 0.0;
+                    }
+                }
+            }
+        }
+
+        const uint64_t texel_count = static_cast<uint64_t>(size) * size;
+        printf("%-20s %-22s %6.2f dB (rgb %6.2f) %8.1f ms %6.1f Mpix/s\n",
+            name,
+            rhi_format_to_string(format),
+            GetPsnr(error, texel_count * channels),
+            GetPsnr(error_rgb, texel_count * min(channels, 3u)),
+            time,
+            texel_count / (time * 1000.0f)
+        );
+    }
+}
+
+void Benchmark::TextureCompressor()
+{
+    Image albedo, normal, roughness, cutout;
+    GenerateImages(albedo, normal, roughness, cutout);
+
+    Report("albedo 2048^2",     albedo,     RHI_Format_BC1_Unorm);
+    Report("albedo 2048^2",     albedo,     RHI_Format_BC7_Unorm);
+    Report("normal 2048^2",     normal,     RHI_Format_BC5_Unorm);
+    Report("roughness 2048^2",  roughness,  RHI_Format_BC4_Unorm);
+    Report("cut-out 2048^2",    cutout,     RHI_Format_BC3_Unorm);
+    Report("cut-out 2048^2",    cutout,     RHI_Format_BC7_Unorm);
+}
@@ -0,0 +1,95 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ====================
+#include <vector>
+#include <chrono>
+#include "Benchmark.h"
+#include "Core/Context.h"
+#include "Threading/Threading.h"
+//===============================
+
+//= NAMESPACES ========
+using namespace std;
+using namespace Spartan;
+//=====================
+
+namespace
+{
+    constexpr uint32_t runs                 = 5;
+    constexpr uint32_t empty_task_count     = 100000;
+    constexpr uint32_t busy_task_count      = 10000;
+    constexpr auto busy_task_duration       = chrono::microseconds(5);
+    constexpr uint32_t loop_count           = 2000;
+    constexpr uint32_t loop_range           = 100000;
+
+    void Spin(const chrono::nanoseconds duration)
+    {
+        const auto start = chrono::high_resolution_clock::now();
+        while (chrono::high_resolution_clock::now() - start < duration) {}
+    }
+}
+
+// Scheduling overhead and contention of the task system, the same loads which were used to compare it against the old single queue
+void Benchmark::Threading()
+{
+    Context context;
+    context.RegisterSubsystem<Spartan::Threading>();
+    Spartan::Threading* threading = context.GetSubsystem<Spartan::Threading>();
+
+    printf("workers: %u\n", threading->GetThreadCount());
+
+    const float empty_tasks = MeasureBest(runs, [threading]()
+    {
+        for (uint32_t i = 0; i < empty_task_count; i++)
+        {
+            threading->AddTask([]() {});
+        }
+        threading->Flush();
+    });
+    printf("%-32s %8.1f ms\n", "100k empty tasks", empty_tasks);
+
+    const float busy_tasks = MeasureBest(runs, [threading]()
+    {
+        for (uint32_t i = 0; i < busy_task_count; i++)
+        {
+            threading->AddTask([]() { Spin(busy_task_duration); });
+        }
+        threading->Flush();
+    });
+    printf("%-32s %8.1f ms\n", "10k tasks of ~5us work", busy_tasks);
+
+    vector<uint32_t> data(loop_range);
+    const float loops = MeasureBest(runs, [threading, &data]()
+    {
+        for (uint32_t i = 0; i < loop_count; i++)
+        {
+            threading->ParallelFor(loop_range, 0, [&data, i](uint32_t start, uint32_t end)
+            {
+                for (uint32_t j = start; j < end; j++)
+                {
+                    data[j] = j * i;
+                }
+            });
+        }
+    });
+    printf("%-32s %8.1f ms\n", "2000 loops of 100k items", loops);
+}
@@ -91,7 +91,8 @@ cbuffer BufferUber : register(b2)
     float g_mat_height;
 
     float g_mat_id;
-    float3 g_padding2;
+    uint g_shadow_slice;
+    float2 g_padding2;
 };
 
 // High frequency - Updates per object
@@ -100,7 +101,33 @@ cbuffer BufferObject : register(b3)
     matrix g_object_transform;
     matrix g_object_wvp_current;
     matrix g_object_wvp_previous;
+
+    uint g_object_instance_offset;
+    float3 g_object_padding;
+};
+
+// High frequency - Updates once per frame, indexed by instanced draws (g_object_instance_offset + SV_InstanceID)
+struct Instance
+{
+    matrix transform;
+    matrix wvp_previous;
+};
+StructuredBuffer<Instance> g_instances : register(t33);
+
+// High frequency - Updates once per frame, point and spot lights binned into view space clusters (see LightClusters.h)
+static const uint3 g_cluster_grid = uint3(16, 9, 24);
+struct ClusterLight
+{
+    float3 position;
+    float range;
+    float3 color;
+    float angle;
+    float3 direction;
+    uint spot;
 };
+StructuredBuffer<ClusterLight> g_cluster_lights : register(t34);
+StructuredBuffer<uint2> g_clusters              : register(t35); // offset and count into g_cluster_light_indices
+StructuredBuffer<uint> g_cluster_light_indices  : register(t36);
 
 // High frequency - Updates per light
 cbuffer LightBuffer : register(b4)
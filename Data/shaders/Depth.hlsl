@@ -23,6 +23,20 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Common.hlsl"
 //====================
 
+#if INSTANCING
+// The instances carry the world transform, the object buffer carries the view projection of the whole batch
+Pixel_PosUv mainVS(Vertex_PosUv input, uint instance_id : SV_InstanceID)
+{
+    Pixel_PosUv output;
+
+    input.position.w    = 1.0f; 
+    output.position     = mul(input.position, g_instances[g_object_instance_offset + instance_id].transform);
+    output.position     = mul(output.position, g_object_transform);
+    output.uv           = input.uv;
+
+    return output;
+}
+#else
 Pixel_PosUv mainVS(Vertex_PosUv input)
 {
     Pixel_PosUv output;
@@ -33,9 +47,35 @@ Pixel_PosUv mainVS(Vertex_PosUv input)
 
     return output;
 }
+#endif
 
+#if COPY
+// Writes the cached depth of the static shadow casters into slice g_shadow_slice of a shadow map, the dynamic ones are drawn on top
+float mainPS(Pixel_PosUv input) : SV_Depth
+{
+    #if DIRECTIONAL
+    return light_directional_depth.Load(int4(input.position.xy, g_shadow_slice, 0)).r;
+    #elif POINT
+    // Direction of the texel, following the cube map face layout
+    float2 uv = input.uv * 2.0f - 1.0f;
+    float3 direction[6] =
+    {
+        float3( 1.0f, -uv.y, -uv.x), // x+
+        float3(-1.0f, -uv.y,  uv.x), // x-
+        float3( uv.x,  1.0f,  uv.y), // y+
+        float3( uv.x, -1.0f, -uv.y), // y-
+        float3( uv.x, -uv.y,  1.0f), // z+
+        float3(-uv.x, -uv.y, -1.0f)  // z-
+    };
+    return light_point_depth.SampleLevel(sampler_point_clamp, direction[g_shadow_slice], 0).r;
+    #elif SPOT
+    return light_spot_depth.Load(int3(input.position.xy, 0)).r;
+    #endif
+}
+#else
 float4 mainPS(Pixel_PosUv input) : SV_TARGET
 {
     float2 uv = float2(input.uv.x * g_mat_tiling.x + g_mat_offset.x, input.uv.y * g_mat_offset.y + g_mat_tiling.y);
     return degamma(tex.Sample(sampler_anisotropic_wrap, uv)) * g_mat_color;
 }
+#endif
@@ -42,17 +42,19 @@ struct PixelOutputType
     float2 velocity : SV_Target3;
 };
 
-PixelInputType mainVS(Vertex_PosUvNorTan input)
+PixelInputType mainVS(Vertex_PosUvNorTan input, uint instance_id : SV_InstanceID)
 {
     PixelInputType output;
+
+    Instance instance = g_instances[g_object_instance_offset + instance_id];
     
     input.position.w            = 1.0f;     
-    output.position_ss_previous = mul(input.position, g_object_wvp_previous);
-    output.position             = mul(input.position, g_object_transform);
+    output.position_ss_previous = mul(input.position, instance.wvp_previous);
+    output.position             = mul(input.position, instance.transform);
     output.position             = mul(output.position, g_viewProjection);
     output.position_ss_current  = output.position;
-    output.normal               = normalize(mul(input.normal, (float3x3)g_object_transform)).xyz;   
-    output.tangent              = normalize(mul(input.tangent, (float3x3)g_object_transform)).xyz;
+    output.normal               = normalize(mul(input.normal, (float3x3)instance.transform)).xyz;   
+    output.tangent              = normalize(mul(input.tangent, (float3x3)instance.transform)).xyz;
     output.uv                   = input.uv;
     
     return output;
@@ -117,7 +119,9 @@ PixelOutputType mainPS(PixelInputType input)
     
     #if NORMAL_MAP
         // Get tangent space normal and apply intensity
-        float3 tangent_normal   = normalize(unpack(tex_material_normal.Sample(sampler_anisotropic_wrap, texCoords).rgb));
+        // Reconstruct z, since compressed normal maps only store xy
+        float2 normal_xy        = unpack(tex_material_normal.Sample(sampler_anisotropic_wrap, texCoords).rg);
+        float3 tangent_normal   = normalize(float3(normal_xy, sqrt(saturate(1.0f - dot(normal_xy, normal_xy)))));
         float normal_intensity  = clamp(g_mat_normal, 0.012f, g_mat_normal);
         tangent_normal.xy       *= saturate(normal_intensity);
         normal                  = normalize(mul(tangent_normal, TBN).xyz); // Transform to world space
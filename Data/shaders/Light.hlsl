@@ -39,60 +39,177 @@ float attunation_distance(const Light light)
     return attenuation * attenuation;
 }
 
-float attunation_angle(const Light light)
+float attunation_angle(const Light light, const float3 light_direction)
 {
     float cutoffAngle       = 1.0f - light.angle;
-    float light_dot_pixel   = dot(direction.xyz, light.direction);
+    float light_dot_pixel   = dot(light_direction, light.direction);
     float epsilon           = cutoffAngle - cutoffAngle * 0.9f;
     float attenuation       = saturate((light_dot_pixel - cutoffAngle) / epsilon); // attenuate when approaching the outer cone
     return attenuation * attenuation;
 }
 
-PixelOutputType mainPS(Pixel_PosUv input)
+void get_surface_and_material(const float2 uv, out Surface surface, out Material material)
 {
-    PixelOutputType light_out;
-    light_out.diffuse       = 0.0f;
-    light_out.specular      = 0.0f;
-    light_out.volumetric    = 0.0f;
-
     // Sample textures
-    float4 sample_albedo    = tex_albedo.Sample(sampler_point_clamp, input.uv);
-    float4 sample_normal    = tex_normal.Sample(sampler_point_clamp, input.uv);
-    float4 sample_material  = tex_material.Sample(sampler_point_clamp, input.uv);
-    float4 sample_hbao      = tex_hbao.Sample(sampler_point_clamp, input.uv);
+    float4 sample_albedo    = tex_albedo.Sample(sampler_point_clamp, uv);
+    float4 sample_normal    = tex_normal.Sample(sampler_point_clamp, uv);
+    float4 sample_material  = tex_material.Sample(sampler_point_clamp, uv);
+    float4 sample_hbao      = tex_hbao.Sample(sampler_point_clamp, uv);
 
     // Post-process samples
     int mat_id      = round(sample_normal.a * 65535);
     float occlusion = sample_material.a;
     
     // Fill surface struct
-    Surface surface;
-    surface.uv                      = input.uv;
+    surface.uv                      = uv;
     surface.depth                   = tex_depth.Sample(sampler_point_clamp, surface.uv).r;
     surface.position                = get_position(surface.depth, surface.uv);
     surface.normal                  = normal_decode(sample_normal.xyz);
     surface.camera_to_pixel         = normalize(surface.position - g_camera_position.xyz);
     surface.camera_to_pixel_length  = length(surface.position - g_camera_position.xyz);
 
-    // Create material
+    // Fill material struct
+    material.albedo                 = sample_albedo.rgb;
+    material.roughness              = sample_material.r;
+    material.metallic               = sample_material.g;
+    material.emissive               = sample_material.b;
+    material.clearcoat              = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].x;
+    material.clearcoat_roughness    = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].y;
+    material.anisotropic            = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].z;
+    material.anisotropic_rotation   = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].w;
+    material.sheen                  = mat_sheen_sheenTint_pad[mat_id].x;
+    material.sheen_tint             = mat_sheen_sheenTint_pad[mat_id].y;
+    material.occlusion              = min(occlusion, sample_hbao.a);
+    material.F0                     = lerp(0.04f, material.albedo, material.metallic);
+    material.is_transparent         = sample_albedo.a != 1.0f;
+    material.is_sky                 = mat_id == 0;
+}
+
+// Reflectance equation, the returned diffuse and specular are multiplied by the light's radiance
+void reflectance(const Surface surface, const Material material, const Light light, out float3 diffuse, out float3 specular, out float3 reflective_energy)
+{
+    // Compute some vectors and dot products
+    float3 l        = -light.direction;
+    float3 v        = -surface.camera_to_pixel;
+    float3 h        = normalize(v + l);
+    float l_dot_h   = saturate(dot(l, h));
+    float v_dot_h   = saturate(dot(v, h));
+    float n_dot_v   = saturate(dot(surface.normal, v));
+    float n_dot_l   = saturate(dot(surface.normal, l));
+    float n_dot_h   = saturate(dot(surface.normal, h));
+
+    float3 diffuse_energy   = 1.0f;
+    reflective_energy       = 1.0f;
+    
+    // Specular
+    specular = 0.0f;
+    if (material.anisotropic == 0.0f)
+    {
+        specular = BRDF_Specular_Isotropic(material, n_dot_v, n_dot_l, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
+    }
+    else
+    {
+        specular = BRDF_Specular_Anisotropic(material, surface, v, l, h, n_dot_v, n_dot_l, n_dot_h, l_dot_h, diffuse_energy, reflective_energy);
+    }
+
+    // Specular clearcoat
+    if (material.clearcoat != 0.0f)
+    {
+        specular += BRDF_Specular_Clearcoat(material, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
+    }
+
+    // Sheen
+    if (material.sheen != 0.0f)
+    {
+        specular += BRDF_Specular_Sheen(material, n_dot_v, n_dot_l, n_dot_h, diffuse_energy, reflective_energy);
+    }
+    
+    // Diffuse
+    diffuse = BRDF_Diffuse(material, n_dot_v, n_dot_l, v_dot_h);
+
+    // Tone down diffuse such as that only non metals have it
+    diffuse *= diffuse_energy;
+
+    float3 radiance = light.color * n_dot_l;
+    diffuse         *= radiance;
+    specular        *= radiance;
+}
+
+#if CLUSTERED
+
+// Point and spot lights without shadows, each pixel loops through the lights which reach its cluster (see LightClusters.h)
+PixelOutputType mainPS(Pixel_PosUv input)
+{
+    PixelOutputType light_out;
+    light_out.diffuse       = 0.0f;
+    light_out.specular      = 0.0f;
+    light_out.volumetric    = 0.0f;
+
+    Surface surface;
     Material material;
+    get_surface_and_material(input.uv, surface, material);
+
+    [branch]
+    if (material.is_sky)
+        return light_out;
+
+    // Find the cluster, tiles follow the texture coordinates and slices are exponential in view space depth
+    float depth_view    = dot(surface.position - g_camera_position, g_camera_direction);
+    uint slice          = depth_view <= g_camera_near ? 0 : min(uint(log(depth_view / g_camera_near) / log(g_camera_far / g_camera_near) * g_cluster_grid.z), g_cluster_grid.z - 1);
+    uint2 tile          = min(uint2(input.uv * g_cluster_grid.xy), g_cluster_grid.xy - 1);
+    uint2 cluster       = g_clusters[tile.x + tile.y * g_cluster_grid.x + slice * g_cluster_grid.x * g_cluster_grid.y];
+
+    // Compute multi-bounce ambient occlusion
+    float3 multi_bounce_ao = MultiBounceAO(material.occlusion, material.albedo);
+
+    for (uint i = 0; i < cluster.y; i++)
     {
-        material.albedo                 = sample_albedo.rgb;
-        material.roughness              = sample_material.r;
-        material.metallic               = sample_material.g;
-        material.emissive               = sample_material.b;
-        material.clearcoat              = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].x;
-        material.clearcoat_roughness    = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].y;
-        material.anisotropic            = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].z;
-        material.anisotropic_rotation   = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].w;
-        material.sheen                  = mat_sheen_sheenTint_pad[mat_id].x;
-        material.sheen_tint             = mat_sheen_sheenTint_pad[mat_id].y;
-        material.occlusion              = min(occlusion, sample_hbao.a);
-        material.F0                     = lerp(0.04f, material.albedo, material.metallic);
-        material.is_transparent         = sample_albedo.a != 1.0f;
-        material.is_sky                 = mat_id == 0;
+        ClusterLight cluster_light = g_cluster_lights[g_cluster_light_indices[cluster.x + i]];
+
+        // Fill light struct
+        Light light;
+        light.color             = cluster_light.color;
+        light.position          = cluster_light.position;
+        light.range             = cluster_light.range;
+        light.angle             = cluster_light.angle;
+        light.bias              = 0.0f;
+        light.normal_bias       = 0.0f;
+        light.array_size        = 1;
+        light.distance_to_pixel = length(surface.position - light.position);
+        light.direction         = normalize(surface.position - light.position);
+        light.color             *= attunation_distance(light) * (cluster_light.spot ? attunation_angle(light, cluster_light.direction) : 1.0f); // attenuate
+        light.color             *= multi_bounce_ao;
+
+        [branch]
+        if (any(light.color))
+        {
+            float3 diffuse, specular, reflective_energy;
+            reflectance(surface, material, light, diffuse, specular, reflective_energy);
+            
+            light_out.diffuse   += diffuse;
+            light_out.specular  += specular;
+        }
     }
 
+    light_out.diffuse   = saturate_16(light_out.diffuse);
+    light_out.specular  = saturate_16(light_out.specular);
+
+    return light_out;
+}
+
+#else
+
+PixelOutputType mainPS(Pixel_PosUv input)
+{
+    PixelOutputType light_out;
+    light_out.diffuse       = 0.0f;
+    light_out.specular      = 0.0f;
+    light_out.volumetric    = 0.0f;
+
+    Surface surface;
+    Material material;
+    get_surface_and_material(input.uv, surface, material);
+
     // Fill light struct
     Light light;
     light.color             = color.xyz;
@@ -115,7 +232,7 @@ PixelOutputType mainPS(Pixel_PosUv input)
     light.array_size    = 1;
     light.direction     = normalize(surface.position - light.position);
     light.color         *= intensity_range_angle_bias.x;
-    light.color         *= attunation_distance(light) * attunation_angle(light); // attenuate
+    light.color         *= attunation_distance(light) * attunation_angle(light, direction.xyz); // attenuate
     #endif
     
     // Compute shadows and volumetric fog/light
@@ -145,58 +262,16 @@ PixelOutputType mainPS(Pixel_PosUv input)
     }
 
     // Compute multi-bounce ambient occlusion
-    float3 multi_bounce_ao = MultiBounceAO(material.occlusion, sample_albedo.rgb);
+    float3 multi_bounce_ao = MultiBounceAO(material.occlusion, material.albedo);
 
     // Modulate light with shadow color, visibility and ambient occlusion
     light.color *= shadow.rgb * shadow.a * multi_bounce_ao;
 
-    // Reflectance equation
     [branch]
     if (any(light.color) && !material.is_sky)
     {
-        // Compute some vectors and dot products
-        float3 l        = -light.direction;
-        float3 v        = -surface.camera_to_pixel;
-        float3 h        = normalize(v + l);
-        float l_dot_h   = saturate(dot(l, h));
-        float v_dot_h   = saturate(dot(v, h));
-        float n_dot_v   = saturate(dot(surface.normal, v));
-        float n_dot_l   = saturate(dot(surface.normal, l));
-        float n_dot_h   = saturate(dot(surface.normal, h));
-
-        float3 diffuse_energy       = 1.0f;
-        float3 reflective_energy    = 1.0f;
-        
-        // Specular
-        float3 specular = 0.0f;
-        if (material.anisotropic == 0.0f)
-        {
-            specular = BRDF_Specular_Isotropic(material, n_dot_v, n_dot_l, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
-        }
-        else
-        {
-            specular = BRDF_Specular_Anisotropic(material, surface, v, l, h, n_dot_v, n_dot_l, n_dot_h, l_dot_h, diffuse_energy, reflective_energy);
-        }
-
-        // Specular clearcoat
-        float3 specular_clearcoat = 0.0f;
-        if (material.clearcoat != 0.0f)
-        {
-            specular_clearcoat = BRDF_Specular_Clearcoat(material, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
-        }
-
-        // Sheen
-        float3 specular_sheen = 0.0f;
-        if (material.sheen != 0.0f)
-        {
-            specular_sheen = BRDF_Specular_Sheen(material, n_dot_v, n_dot_l, n_dot_h, diffuse_energy, reflective_energy);
-        }
-        
-        // Diffuse
-        float3 diffuse = BRDF_Diffuse(material, n_dot_v, n_dot_l, v_dot_h);
-
-        // Tone down diffuse such as that only non metals have it
-        diffuse *= diffuse_energy;
+        float3 diffuse, specular, reflective_energy;
+        reflectance(surface, material, light, diffuse, specular, reflective_energy);
 
         // SSR
         float3 light_reflection = 0.0f;
@@ -212,14 +287,13 @@ PixelOutputType mainPS(Pixel_PosUv input)
         }
         #endif
 
-        float3 radiance = light.color * n_dot_l;
-        
-        light_out.diffuse.rgb  = saturate_16(diffuse * radiance);
-        light_out.specular.rgb = saturate_16((specular + specular_clearcoat + specular_sheen) * radiance + light_reflection);
-        
+        light_out.diffuse.rgb  = saturate_16(diffuse);
+        light_out.specular.rgb = saturate_16(specular + light_reflection);
     }
 
     light_out.volumetric.rgb = saturate_16(volumetric);
 
     return light_out;
 }
+
+#endif
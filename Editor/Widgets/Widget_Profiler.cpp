@@ -71,7 +71,7 @@ void Widget_Profiler::ShowCPU()
 {
 	// Get stuff
 	const auto& time_blocks		= m_profiler->GetTimeBlocks();
-	const auto time_block_count = static_cast<unsigned int>(time_blocks.size());
+	const auto time_block_count = m_profiler->GetTimeBlockCount();
 	const auto time_cpu			= m_profiler->GetTimeCpuLast();	
 
 	// Time blocks	
@@ -91,7 +91,7 @@ void Widget_Profiler::ShowGPU()
 {
 	// Get stuff
 	const auto& time_blocks		= m_profiler->GetTimeBlocks();
-	const auto time_block_count	= static_cast<unsigned int>(time_blocks.size());
+	const auto time_block_count	= m_profiler->GetTimeBlockCount();
 	const auto time_gpu			= m_profiler->GetTimeGpuLast();
 
 	// Time blocks
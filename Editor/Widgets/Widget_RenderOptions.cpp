@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Rendering/Renderer.h"
 #include "Core/Context.h"
 #include "Core/Timer.h"
+#include "Core/Engine.h"
 #include "Math/MathHelper.h"
 #include "Rendering/Model.h"
 #include "../ImGui_Extension.h"
@@ -66,6 +67,7 @@ void Widget_RenderOptions::Tick()
         bool do_chromatic_aberration    = m_renderer->GetOption(Render_ChromaticAberration);
         bool do_dithering               = m_renderer->GetOption(Render_Dithering);
         bool do_indirect_bounce         = m_renderer->GetOption(Render_IndirectBounce);
+        bool do_texture_streaming       = m_renderer->GetOption(Render_TextureStreaming);
         int resolution_shadow           = m_renderer->GetOptionValue<int>(Option_Value_ShadowResolution);
 
         // Display
@@ -235,6 +237,11 @@ void Widget_RenderOptions::Tick()
             ImGuiEx::Tooltip("Reduces color banding");
             ImGui::Separator();
 
+            // Texture streaming
+            ImGui::Checkbox("Texture Streaming", &do_texture_streaming);
+            ImGui::SameLine(); render_option_float("##texture_streaming_option_1", "Budget (MB)", Option_Value_TextureStreaming_Budget, "Memory which the mips of streamed textures can take, they get blurrier when it's exceeded", 64.0f);
+            ImGui::Separator();
+
             // Shadow resolution
             ImGui::InputInt("Shadow Resolution", &resolution_shadow, 1);
         }
@@ -254,6 +261,7 @@ void Widget_RenderOptions::Tick()
         m_renderer->SetOption(Render_Sharpening_LumaSharpen,        do_sharperning);
         m_renderer->SetOption(Render_ChromaticAberration,           do_chromatic_aberration);
         m_renderer->SetOption(Render_Dithering,                     do_dithering);
+        m_renderer->SetOption(Render_TextureStreaming,              do_texture_streaming);
         m_renderer->SetOptionValue(Option_Value_ShadowResolution,   static_cast<float>(resolution_shadow));
     }
 
@@ -319,6 +327,9 @@ void Widget_RenderOptions::Tick()
         // Reflect from engine
         auto do_depth_prepass   = m_renderer->GetOption(Render_DepthPrepass);
         auto do_reverse_z       = m_renderer->GetOption(Render_ReverseZ);
+        auto do_clustered       = m_renderer->GetOption(Render_ClusteredLighting);
+        auto do_occlusion       = m_renderer->GetOption(Render_OcclusionCulling);
+        auto do_pipelined       = m_context->m_engine->EngineMode_IsSet(Engine_Pipelined);
 
         {
             // Buffer
@@ -379,10 +390,28 @@ void Widget_RenderOptions::Tick()
 
             // Reverse-Z
             ImGui::Checkbox("Reverse-Z", &do_reverse_z);
+
+            // Clustered lighting
+            ImGui::Checkbox("Clustered Lighting", &do_clustered);
+            ImGuiEx::Tooltip("Point and spot lights without shadows are shaded together in a single pass");
+
+            // Occlusion culling
+            ImGui::Checkbox("Occlusion Culling", &do_occlusion);
+            ImGuiEx::Tooltip("Large objects are rasterized on the CPU, what's behind them isn't drawn");
+
+            // Pipelined recording
+            ImGui::Checkbox("Pipelined Recording", &do_pipelined);
+            ImGuiEx::Tooltip("The commands of a frame are recorded while the next one is simulated, at the cost of a frame of latency");
         }
 
         // Map back to engine
         m_renderer->SetOption(Render_DepthPrepass, do_depth_prepass);
         m_renderer->SetOption(Render_ReverseZ, do_reverse_z);
+        m_renderer->SetOption(Render_ClusteredLighting, do_clustered);
+        m_renderer->SetOption(Render_OcclusionCulling, do_occlusion);
+        if (do_pipelined != m_context->m_engine->EngineMode_IsSet(Engine_Pipelined))
+        {
+            m_context->m_engine->EngineMode_Toggle(Engine_Pipelined);
+        }
     }
 }
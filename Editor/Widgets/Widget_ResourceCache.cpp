@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Resource/ResourceCache.h"
 #include "../ImGui/Source/imgui.h"
 #include "Core/Spartan_Object.h"
+#include "RHI/RHI_Texture.h"
 //=================================
 
 //= NAMESPACES ==========
@@ -66,7 +67,7 @@ void Widget_ResourceCache::Tick()
 
 	ImGui::Text("Resource count: %d, Memory usage cpu: %d Mb, Memory usage gpu: %d Mb", static_cast<uint32_t>(resources.size()), static_cast<uint32_t>(memory_usage_cpu), static_cast<uint32_t>(memory_usage_gpu));
 	ImGui::Separator();
-	ImGui::Columns(7, "##Widget_ResourceCache");
+	ImGui::Columns(8, "##Widget_ResourceCache");
 
     // Set column width - Has to be done only once in order to allow for the user to resize them
     if (!m_column_width_set)
@@ -74,9 +75,10 @@ void Widget_ResourceCache::Tick()
         ImGui::SetColumnWidth(0, m_size.x * 0.15f);
         ImGui::SetColumnWidth(1, m_size.x * 0.05f);
         ImGui::SetColumnWidth(2, m_size.x * 0.15f);
-        ImGui::SetColumnWidth(3, m_size.x * 0.3f);
-        ImGui::SetColumnWidth(4, m_size.x * 0.3f);
+        ImGui::SetColumnWidth(3, m_size.x * 0.25f);
+        ImGui::SetColumnWidth(4, m_size.x * 0.25f);
         ImGui::SetColumnWidth(5, m_size.x * 0.05f);
+        ImGui::SetColumnWidth(6, m_size.x * 0.05f);
         m_column_width_set = true;
     }
 
@@ -88,6 +90,7 @@ void Widget_ResourceCache::Tick()
 	ImGui::Text("Path (native)");   ImGui::NextColumn();
 	ImGui::Text("Size CPU");        ImGui::NextColumn();
     ImGui::Text("Size GPU");        ImGui::NextColumn();
+    ImGui::Text("Mips");            ImGui::NextColumn();
 	ImGui::Separator();
 
     // Fill rows with resource information
@@ -109,6 +112,12 @@ void Widget_ResourceCache::Tick()
             print_memory(object->GetSizeCpu());                             ImGui::NextColumn();
             // Memory GPU
             print_memory(object->GetSizeGpu());                             ImGui::NextColumn();
+            // Mips (resident/total, streamed textures only keep some of them on the GPU)
+            if (RHI_Texture* texture = dynamic_cast<RHI_Texture*>(resource.get()))
+            {
+                ImGui::Text("%d/%d%s", texture->GetMipCount() - texture->GetMipResident(), texture->GetMipCount(), texture->IsStreamed() ? " (streamed)" : "");
+            }
+            ImGui::NextColumn();
         }
 	}
 	ImGui::Columns(1);
@@ -43,7 +43,7 @@ namespace Spartan
 	Audio::~Audio()
 	{
 		// Unsubscribe from events
-		UNSUBSCRIBE_FROM_EVENT(Event_World_Unload, [this](Variant) { m_listener = nullptr; });
+		UNSUBSCRIBE_FROM_EVENT(m_event_world_unload);
 
 		if (!m_system_fmod)
 			return;
@@ -128,7 +128,7 @@ namespace Spartan
         m_profiler = m_context->GetSubsystem<Profiler>();
 
         // Subscribe to events
-        SUBSCRIBE_TO_EVENT(Event_World_Unload, [this](Variant) { m_listener = nullptr; });
+        m_event_world_unload = SUBSCRIBE_TO_EVENT(Event_World_Unload, [this]() { m_listener = nullptr; });
    
         return true;
     }
@@ -152,12 +152,12 @@ namespace Spartan
 			return;
 		}
 
-		if (m_listener)
+		if (Transform* listener = m_listener.load())
 		{
-			auto position = m_listener->GetPosition();
+			auto position = listener->GetPosition();
 			auto velocity = Math::Vector3::Zero;
-			auto forward = m_listener->GetForward();
-			auto up = m_listener->GetUp();
+			auto forward = listener->GetForward();
+			auto up = listener->GetUp();
 
 			// Set 3D attributes
 			m_result_fmod = m_system_fmod->set3DListenerAttributes(
@@ -22,7 +22,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==================
+#include <atomic>
 #include "../Core/ISubsystem.h"
+#include "../Core/EventSystem.h"
 //=============================
 
 //= FORWARD DECLARATIONS =
@@ -58,8 +60,9 @@ namespace Spartan
 		uint32_t m_max_channels		= 32;
 		float m_distance_entity		= 1.0f;
 		bool m_initialized			= false;
-		Transform* m_listener		= nullptr;
+		std::atomic<Transform*> m_listener = nullptr; // cleared by the world unloading, which runs on a worker
 		Profiler* m_profiler		= nullptr;
 		FMOD::System* m_system_fmod = nullptr;
+		EventToken m_event_world_unload;
 	};
 }
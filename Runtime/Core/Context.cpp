@@ -0,0 +1,178 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ======================
+#include "Spartan.h"
+#include "../Threading/Threading.h"
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    void Context::Tick(Tick_Group tick_group, float delta_time /*= 0.0f*/)
+    {
+        if (m_tick_graph_dirty)
+        {
+            TickBuildGraph();
+        }
+
+        // Without worker threads, tick in registration order
+        if (!m_threading || m_threading->GetThreadCount() == 0)
+        {
+            for (const auto& subsystem : m_subsystems)
+            {
+                if (subsystem.tick_group != tick_group)
+                    continue;
+
+                subsystem.ptr->Tick(delta_time);
+            }
+
+            return;
+        }
+
+        m_tick_delta_time = delta_time;
+
+        // Reset the graph
+        uint32_t subsystem_count = 0;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_subsystems.size()); i++)
+        {
+            if (m_subsystems[i].tick_group != tick_group)
+                continue;
+
+            m_tick_dependencies_left[i] = m_subsystems[i].dependency_count;
+            subsystem_count++;
+        }
+        m_tick_remaining = subsystem_count;
+
+        // Start with the subsystems which don't have to wait for anything
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_subsystems.size()); i++)
+        {
+            if (m_subsystems[i].tick_group == tick_group && m_subsystems[i].dependency_count == 0)
+            {
+                TickMakeReady(i);
+            }
+        }
+
+        // The calling thread works through the graph as well, it's the only one which ticks main thread subsystems.
+        // It doesn't pick up queued tasks while waiting, one of them could be waiting on a main thread subsystem (e.g. a world load waiting on World::Tick).
+        while (m_tick_remaining.load() != 0)
+        {
+            if (!TickReady(true))
+            {
+                this_thread::yield();
+            }
+        }
+    }
+
+    void Context::TickBuildGraph()
+    {
+        m_threading                 = GetSubsystem<Threading>();
+        m_tick_dependencies_left    = make_unique<atomic<uint32_t>[]>(m_subsystems.size());
+
+        for (_subystem& subsystem : m_subsystems)
+        {
+            subsystem.dependents.clear();
+            subsystem.dependency_count = 0;
+        }
+
+        // A subsystem waits for any subsystem registered before it (in the same tick group) when
+        // one of them writes something the other one reads or writes.
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_subsystems.size()); i++)
+        {
+            _subystem& subsystem = m_subsystems[i];
+
+            for (uint32_t j = 0; j < i; j++)
+            {
+                _subystem& subsystem_previous = m_subsystems[j];
+
+                if (subsystem_previous.tick_group != subsystem.tick_group)
+                    continue;
+
+                const bool conflict = (subsystem_previous.writes & (subsystem.reads | subsystem.writes)) || (subsystem.writes & subsystem_previous.reads);
+                if (conflict)
+                {
+                    subsystem_previous.dependents.emplace_back(i);
+                    subsystem.dependency_count++;
+                }
+            }
+        }
+
+        m_tick_graph_dirty = false;
+    }
+
+    void Context::TickMakeReady(uint32_t index)
+    {
+        {
+            lock_guard<mutex> lock(m_tick_mutex);
+            m_tick_ready.emplace_back(index);
+        }
+
+        // A worker picks it up, unless the calling thread gets to it first
+        if (!m_subsystems[index].main_thread)
+        {
+            m_threading->AddTask([this]() { TickReady(false); });
+        }
+    }
+
+    bool Context::TickReady(bool main_thread)
+    {
+        uint32_t index = 0;
+        {
+            lock_guard<mutex> lock(m_tick_mutex);
+
+            // The calling thread prefers main thread subsystems since nobody else can tick them
+            auto it = find_if(m_tick_ready.begin(), m_tick_ready.end(), [this, main_thread](uint32_t i) { return m_subsystems[i].main_thread == main_thread; });
+            if (it == m_tick_ready.end() && main_thread)
+            {
+                it = m_tick_ready.begin();
+            }
+
+            if (it == m_tick_ready.end())
+                return false;
+
+            index = *it;
+            m_tick_ready.erase(it);
+        }
+
+        TickSubsystem(index);
+        return true;
+    }
+
+    void Context::TickSubsystem(uint32_t index)
+    {
+        m_subsystems[index].ptr->Tick(m_tick_delta_time);
+
+        // Release the subsystems which were waiting on this one
+        for (const uint32_t dependent : m_subsystems[index].dependents)
+        {
+            if (m_tick_dependencies_left[dependent].fetch_sub(1) == 1)
+            {
+                TickMakeReady(dependent);
+            }
+        }
+
+        m_tick_remaining.fetch_sub(1);
+    }
+}
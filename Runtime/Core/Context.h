@@ -22,6 +22,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ===================
+#include <vector>
+#include <atomic>
+#include <mutex>
 #include "ISubsystem.h"
 #include "../Logging/Log.h"
 #include "Spartan_Definitions.h"
@@ -30,6 +33,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace Spartan
 {
     class Engine;
+    class Threading;
 
     enum Tick_Group
     {
@@ -37,16 +41,43 @@ namespace Spartan
         Tick_Smoothed
     };
 
+    // What a subsystem reads and writes while ticking. Subsystems of the same tick group which
+    // don't conflict tick concurrently, the ones which do tick in the order they were registered.
+    enum Tick_Access : uint32_t
+    {
+        Access_None         = 0,
+        Access_Time         = 1 << 0,
+        Access_Input        = 1 << 1,
+        Access_Transforms   = 1 << 2,
+        Access_Entities     = 1 << 3,
+        Access_Audio        = 1 << 4,
+        Access_Physics      = 1 << 5,
+        Access_Gpu          = 1 << 6,
+        Access_DebugDraw    = 1 << 7,
+        Access_Profiling    = 1 << 8,
+        Access_All          = 0xFFFFFFFF
+    };
+
     struct _subystem
     {
-        _subystem(const std::shared_ptr<ISubsystem>& subsystem, Tick_Group tick_group)
+        _subystem(const std::shared_ptr<ISubsystem>& subsystem, Tick_Group tick_group, uint32_t reads, uint32_t writes, bool main_thread)
         {
-            ptr = subsystem;
-            this->tick_group = tick_group;
+            ptr                 = subsystem;
+            this->tick_group    = tick_group;
+            this->reads         = reads;
+            this->writes        = writes;
+            this->main_thread   = main_thread;
         }
 
         std::shared_ptr<ISubsystem> ptr;
         Tick_Group tick_group;
+        uint32_t reads      = Access_All;
+        uint32_t writes     = Access_All;
+        bool main_thread    = false; // has to tick on the thread which calls Context::Tick()
+
+        // Tick graph
+        std::vector<uint32_t> dependents;   // subsystems which have to wait for this one
+        uint32_t dependency_count = 0;      // subsystems this one has to wait for
     };
 
 	class SPARTAN_CLASS Context
@@ -65,13 +96,14 @@ namespace Spartan
             m_subsystems.clear();
         }
 
-		// Register a subsystem
+		// Register a subsystem, along with what it accesses while ticking (see Tick_Access)
 		template <class T>
-		void RegisterSubsystem(Tick_Group tick_group = Tick_Variable)
+		void RegisterSubsystem(Tick_Group tick_group = Tick_Variable, uint32_t reads = Access_All, uint32_t writes = Access_All, bool main_thread = false)
 		{
             validate_subsystem_type<T>();
 
-            m_subsystems.emplace_back(std::make_shared<T>(this), tick_group);
+            m_subsystems.emplace_back(std::make_shared<T>(this), tick_group, reads, writes, main_thread);
+            m_tick_graph_dirty = true;
 		}
 
 		// Initialize subsystems
@@ -90,17 +122,8 @@ namespace Spartan
 			return result;
 		}
 
-        // Tick
-		void Tick(Tick_Group tick_group, float delta_time = 0.0f)
-		{
-            for (const auto& subsystem : m_subsystems)
-            {
-                if (subsystem.tick_group != tick_group)
-                    continue;
-
-                subsystem.ptr->Tick(delta_time);
-            }
-		}
+        // Tick, independent subsystems tick concurrently on the worker threads
+		void Tick(Tick_Group tick_group, float delta_time = 0.0f);
 
 		// Get a subsystem
 		template <class T> 
@@ -120,6 +143,20 @@ namespace Spartan
         Engine* m_engine = nullptr;
 
 	private:
+        void TickBuildGraph();
+        void TickMakeReady(uint32_t index);
+        bool TickReady(bool main_thread);
+        void TickSubsystem(uint32_t index);
+
 		std::vector<_subystem> m_subsystems;
+
+        // Tick graph
+        std::vector<uint32_t> m_tick_ready;
+        std::unique_ptr<std::atomic<uint32_t>[]> m_tick_dependencies_left;
+        std::atomic<uint32_t> m_tick_remaining  = 0;
+        std::mutex m_tick_mutex;
+        float m_tick_delta_time                 = 0.0f;
+        bool m_tick_graph_dirty                 = true;
+        Threading* m_threading                  = nullptr;
 	};
 }
@@ -52,23 +52,25 @@ namespace Spartan
 		m_context = make_shared<Context>();
         m_context->m_engine = this;
 
-		// Register subsystems
-        m_context->RegisterSubsystem<Timer>(Tick_Variable);         // must be first so it ticks first
-        m_context->RegisterSubsystem<Threading>(Tick_Variable);
-		m_context->RegisterSubsystem<ResourceCache>(Tick_Variable);		
-		m_context->RegisterSubsystem<Audio>(Tick_Variable);
-        m_context->RegisterSubsystem<Physics>(Tick_Variable);       // integrates internally
-        m_context->RegisterSubsystem<Input>(Tick_Smoothed);
-		m_context->RegisterSubsystem<Scripting>(Tick_Smoothed);
-		m_context->RegisterSubsystem<World>(Tick_Smoothed);
-        m_context->RegisterSubsystem<Profiler>(Tick_Variable);
-        m_context->RegisterSubsystem<Renderer>(Tick_Smoothed);
-        m_context->RegisterSubsystem<Settings>(Tick_Variable);
+		// Register subsystems, along with what they read and write while ticking (independent subsystems tick concurrently).
+        // Subsystems which touch the window, the GPU, the script runtime or the components are pinned to the main thread.
+        m_context->RegisterSubsystem<Timer>(Tick_Variable,          Access_None,                                                       Access_Time);   // must be first so it ticks first
+        m_context->RegisterSubsystem<Threading>(Tick_Variable,      Access_None,                                                       Access_None);
+        m_context->RegisterSubsystem<ResourceCache>(Tick_Variable,  Access_None,                                                       Access_None);
+        m_context->RegisterSubsystem<Audio>(Tick_Variable,          Access_Time | Access_Transforms,                                   Access_Audio);
+        m_context->RegisterSubsystem<Physics>(Tick_Variable,        Access_Time,                                                       Access_Physics | Access_Transforms | Access_DebugDraw); // integrates internally
+        m_context->RegisterSubsystem<Input>(Tick_Smoothed,          Access_None,                                                       Access_Input,    true); // reads what the window procedure wrote
+        m_context->RegisterSubsystem<Scripting>(Tick_Smoothed,      Access_None,                                                       Access_Entities, true); // script instances live in the entities
+        m_context->RegisterSubsystem<World>(Tick_Smoothed,          Access_Time | Access_Input,                                        Access_Entities | Access_Transforms | Access_Audio | Access_Physics | Access_DebugDraw, true); // components and scripts tick
+        m_context->RegisterSubsystem<Profiler>(Tick_Variable,       Access_Time | Access_Gpu,                                          Access_Profiling, true); // time blocks are merged on the main thread
+        m_context->RegisterSubsystem<Renderer>(Tick_Smoothed,       Access_Time | Access_Input | Access_Transforms | Access_Entities,  Access_Gpu | Access_DebugDraw, true); // records into the swap chain's command list
+        m_context->RegisterSubsystem<Settings>(Tick_Variable,       Access_None,                                                       Access_None);
              	
 		// Initialize above subsystems
 		m_context->Initialize();
 
-        m_timer = m_context->GetSubsystem<Timer>();
+        m_timer     = m_context->GetSubsystem<Timer>();
+        m_renderer  = m_context->GetSubsystem<Renderer>();
 	}
 
 	Engine::~Engine()
@@ -78,8 +80,24 @@ namespace Spartan
 
 	void Engine::Tick() const
     {
+        // Events which other threads (loading, importing, physics) have queued since the last frame
+        EventSystem::Get().Drain();
+
+        // When pipelined, the previous frame is recorded while this one is simulated
+        const bool pipelined = EngineMode_IsSet(Engine_Pipelined);
+        if (pipelined)
+        {
+            m_renderer->RecordAsync();
+        }
+
         m_context->Tick(Tick_Variable, static_cast<float>(m_timer->GetDeltaTimeSec()));
         m_context->Tick(Tick_Smoothed, static_cast<float>(m_timer->GetDeltaTimeSmoothedSec()));
+
+        // The command list has to be complete before anyone else (editor, present) can use it
+        if (pipelined)
+        {
+            m_renderer->RecordWait();
+        }
 	}
 
     void Engine::SetWindowData(WindowData& window_data)
@@ -30,6 +30,7 @@ namespace Spartan
 {
 	class Context;
     class Timer;
+    class Renderer;
 
     struct WindowData
     {
@@ -53,6 +54,7 @@ namespace Spartan
 	{
 		Engine_Physics	= 1UL << 0, // Should the physics tick?	
 		Engine_Game		= 1UL << 1,	// Is the engine running in game or editor mode?
+		Engine_Pipelined = 1UL << 2, // Should the renderer record the previous frame while the current one is simulated?
 	};
 
 	class SPARTAN_CLASS Engine
@@ -82,6 +84,7 @@ namespace Spartan
         WindowData m_window_data;
         uint32_t m_flags        = 0;
         Timer* m_timer          = nullptr;
+        Renderer* m_renderer    = nullptr;
 		std::shared_ptr<Context> m_context;
 	};
 }
@@ -19,24 +19,37 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+
 #pragma once
 
 //= INCLUDES ===============
-#include <unordered_map>
+#include <array>
+#include <algorithm>
 #include <vector>
+#include <mutex>
+#include <memory>
+#include <atomic>
 #include <functional>
-#include "../Core/Variant.h"
+#include <type_traits>
 //==========================
 
 /*
 HOW TO USE
 =================================================================================
-To subscribe a function to an event		-> SUBSCRIBE_TO_EVENT(EVENT_ID, Handler);
-To unsubscribe a function from an event	-> SUBSCRIBE_TO_EVENT(EVENT_ID, Handler);
+To subscribe a function to an event		-> token = SUBSCRIBE_TO_EVENT(EVENT_ID, Handler);
+To unsubscribe a function from an event	-> UNSUBSCRIBE_FROM_EVENT(token);
 To fire an event						-> FIRE_EVENT(EVENT_ID);
-To fire an event with data				-> FIRE_EVENT_DATA(EVENT_ID, Variant);
+To fire an event with data				-> FIRE_EVENT_DATA(EVENT_ID, data);
+To fire an event from any thread		-> FIRE_EVENT_DEFERRED(EVENT_ID);
 
-Note: Currently, this is a blocking event system
+Note: Events are typed, EventData<EVENT_ID> is the type of the data they carry
+(void for none) and handlers take it as a const reference, which is checked at
+compile time. Fired events are blocking, deferred events are queued and
+dispatched on the main thread when the engine calls Drain(), at the start of
+every frame. Firing, subscribing and unsubscribing is safe from any thread and
+from within a handler. A fired event runs its handlers on the firing thread, so
+the handlers of events which workers fire (world loading and saving, entity
+changes) have to be thread safe.
 =================================================================================
 */
 
@@ -53,29 +66,45 @@ enum Event_Type
 	Event_World_Resolve_Complete,	// The world has finished resolving
 	Event_World_Stop,		        // The world should stop ticking
 	Event_World_Start,		        // The world should start ticking
-    Event_Frame_Resolution_Changed
+    Event_Frame_Resolution_Changed,
+    Event_Count
 };
 
 //= MACROS ====================================================================================================
-#define EVENT_HANDLER_EXPRESSION(expression)		[this](const Spartan::Variant& var)	{ ##expression }
-#define EVENT_HANDLER_EXPRESSION_STATIC(expression)	[](const Spartan::Variant& var)		{ ##expression }
+// Handlers work with any event, the data (if there is any) is passed as a const reference
+#define EVENT_HANDLER_EXPRESSION(expression)		[this](const auto&... data)	{ expression }
+#define EVENT_HANDLER_EXPRESSION_STATIC(expression)	[](const auto&... data)		{ expression }
 
-#define EVENT_HANDLER(function)						[this](const Spartan::Variant& var)	{ function(); }
-#define EVENT_HANDLER_STATIC(function)				[](const Spartan::Variant& var)		{ function(); }
+#define EVENT_HANDLER(function)						[this](const auto&...)	{ function(); }
+#define EVENT_HANDLER_STATIC(function)				[](const auto&...)		{ function(); }
 
-#define EVENT_HANDLER_VARIANT(function)				[this](const Spartan::Variant& var)	{ function(var); }
-#define EVENT_HANDLER_VARIANT_STATIC(function)		[](const Spartan::Variant& var)		{ function(var); }
+#define EVENT_HANDLER_DATA(function)				[this](const auto& data)	{ function(data); }
+#define EVENT_HANDLER_DATA_STATIC(function)			[](const auto& data)		{ function(data); }
 
-#define FIRE_EVENT(eventID)							Spartan::EventSystem::Get().Fire(eventID)
-#define FIRE_EVENT_DATA(eventID, data)				Spartan::EventSystem::Get().Fire(eventID, data)
+#define FIRE_EVENT(eventID)							Spartan::EventSystem::Get().Fire<eventID>()
+#define FIRE_EVENT_DATA(eventID, data)				Spartan::EventSystem::Get().Fire<eventID>(data)
+#define FIRE_EVENT_DEFERRED(eventID)				Spartan::EventSystem::Get().FireDeferred<eventID>()
 
-#define SUBSCRIBE_TO_EVENT(eventID, function)		Spartan::EventSystem::Get().Subscribe(eventID, function);
-#define UNSUBSCRIBE_FROM_EVENT(eventID, function)	Spartan::EventSystem::Get().Unsubscribe(eventID, function);
+#define SUBSCRIBE_TO_EVENT(eventID, function)		Spartan::EventSystem::Get().Subscribe<eventID>(function)
+#define UNSUBSCRIBE_FROM_EVENT(token)				Spartan::EventSystem::Get().Unsubscribe(token)
 //=============================================================================================================
 
 namespace Spartan
 {
-	using subscriber = std::function<void(const Variant&)>;
+    struct WorldResolve;
+
+    // The data an event carries, void if it doesn't carry any
+    template <Event_Type event_id> struct EventData                 { using type = void; };
+    template <> struct EventData<Event_World_Resolve_Complete>      { using type = WorldResolve; };
+
+    // Returned by Subscribe(), identifies a subscription so it can be removed later
+    struct EventToken
+    {
+        Event_Type event_id = Event_Count;
+        uint32_t id         = 0;
+
+        bool IsValid() const { return id != 0; }
+    };
 
 	class SPARTAN_CLASS EventSystem
 	{
@@ -86,44 +115,180 @@ namespace Spartan
 			return instance;
 		}
 
-		void Subscribe(const Event_Type event_id, subscriber&& function)
+        // The function takes a const reference to the event's data, or nothing if the event carries no data
+        template <Event_Type event_id, typename Function>
+		EventToken Subscribe(Function&& function)
 		{
-			m_subscribers[event_id].push_back(std::forward<subscriber>(function));
+            using data_type = typename EventData<event_id>::type;
+
+            // The event's data is type checked here, so the dispatch can pass it around untyped
+            subscriber handler;
+            if constexpr (std::is_void_v<data_type>)
+            {
+                handler = [function = std::forward<Function>(function)](const void*) { function(); };
+            }
+            else
+            {
+                handler = [function = std::forward<Function>(function)](const void* data) { function(*static_cast<const data_type*>(data)); };
+            }
+
+            std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+
+            EventToken token;
+            token.event_id  = event_id;
+            token.id        = ++m_id;
+
+            // The list is copied, dispatches which are in progress keep iterating over the one they took
+            auto subscribers = m_subscribers[event_id] ? std::make_shared<subscriber_list>(*m_subscribers[event_id]) : std::make_shared<subscriber_list>();
+            subscribers->emplace_back(std::make_shared<Subscriber>(token.id, std::move(handler)));
+            m_subscribers[event_id] = std::move(subscribers);
+
+            return token;
 		}
 
-		void Unsubscribe(const Event_Type event_id, subscriber&& function)
+		void Unsubscribe(EventToken& token)
 		{
-			const size_t function_adress	= *reinterpret_cast<long*>(reinterpret_cast<char*>(&function));
-			auto& subscribers				= m_subscribers[event_id];
-
-			for (auto it = subscribers.begin(); it != subscribers.end();)
-			{
-				const size_t subscriber_adress = *reinterpret_cast<long*>(reinterpret_cast<char*>(&(*it)));
-				if (subscriber_adress == function_adress)
-				{
-					it = subscribers.erase(it);
-					return;
-				}
-			}
+            if (!token.IsValid())
+                return;
+
+            std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+
+            if (const std::shared_ptr<const subscriber_list>& subscribers_current = m_subscribers[token.event_id])
+            {
+                auto subscribers = std::make_shared<subscriber_list>();
+                subscribers->reserve(subscribers_current->size());
+			    for (const std::shared_ptr<Subscriber>& subscriber : *subscribers_current)
+			    {
+				    if (subscriber->id == token.id)
+				    {
+                        // A dispatch which is in progress might still reach it, this tells it to skip it
+                        subscriber->active = false;
+                    }
+                    else
+                    {
+                        subscribers->emplace_back(subscriber);
+                    }
+			    }
+                m_subscribers[token.event_id] = std::move(subscribers);
+            }
+
+            token = EventToken();
 		}
 
-		void Fire(const Event_Type event_id, const Variant& data = 0)
+        // Dispatches immediately, on the calling thread
+        template <Event_Type event_id>
+		void Fire()
 		{
-			if (m_subscribers.find(event_id) == m_subscribers.end())
-				return;
+            static_assert(std::is_void_v<typename EventData<event_id>::type>, "This event carries data, use FIRE_EVENT_DATA()");
+            Dispatch(event_id, nullptr);
+		}
 
-			for (const auto& subscriber : m_subscribers[event_id])
-			{
-				subscriber(data);
-			}
+        template <Event_Type event_id>
+		void Fire(const typename EventData<event_id>::type& data)
+		{
+            Dispatch(event_id, &data);
 		}
 
+        // Queues the event, it will be dispatched on the main thread by the next Drain()
+        template <Event_Type event_id>
+        void FireDeferred()
+        {
+            static_assert(std::is_void_v<typename EventData<event_id>::type>, "Deferred events can't carry data, it would have to outlive the caller");
+
+            std::lock_guard<std::mutex> lock(m_deferred_mutex);
+            m_deferred.push_back(event_id);
+        }
+
+        // Dispatches the queued events, called by the engine once per frame
+        void Drain()
+        {
+            // Swap the queues so that the handlers can queue events (for the next frame) without blocking
+            {
+                std::lock_guard<std::mutex> lock(m_deferred_mutex);
+                if (m_deferred.empty())
+                    return;
+
+                m_deferred.swap(m_deferred_draining);
+            }
+
+            for (const Event_Type event_id : m_deferred_draining)
+            {
+                Dispatch(event_id, nullptr);
+            }
+
+            // Keeps the capacity, so the queues stop allocating once they have grown to their working size
+            m_deferred_draining.clear();
+        }
+
 		void Clear() 
 		{
-			m_subscribers.clear(); 
+            {
+                std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+                for (std::shared_ptr<const subscriber_list>& subscribers : m_subscribers)
+                {
+                    if (subscribers)
+                    {
+                        for (const std::shared_ptr<Subscriber>& subscriber : *subscribers)
+                        {
+                            subscriber->active = false;
+                        }
+                        subscribers = nullptr;
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(m_deferred_mutex);
+            m_deferred.clear();
 		}
 
 	private:
-		std::unordered_map<Event_Type, std::vector<subscriber>> m_subscribers;
+        using subscriber = std::function<void(const void*)>;
+
+        EventSystem()
+        {
+            m_deferred.reserve(64);
+            m_deferred_draining.reserve(64);
+        }
+
+        void Dispatch(const Event_Type event_id, const void* data)
+        {
+            // Iterate over a snapshot, handlers (and other threads) can (un)subscribe without invalidating it
+            std::shared_ptr<const subscriber_list> subscribers;
+            {
+                std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+                subscribers = m_subscribers[event_id];
+            }
+
+            if (!subscribers)
+                return;
+
+            for (const std::shared_ptr<Subscriber>& subscriber : *subscribers)
+            {
+                if (subscriber->active)
+                {
+                    subscriber->function(data);
+                }
+            }
+        }
+
+        struct Subscriber
+        {
+            Subscriber(const uint32_t id, subscriber&& function) : id(id), function(std::move(function)) {}
+
+            uint32_t id;
+            subscriber function;
+            std::atomic<bool> active = true; // cleared once unsubscribed
+        };
+        using subscriber_list = std::vector<std::shared_ptr<Subscriber>>;
+
+        // Indexed by event, firing doesn't have to hash or search. The lists are immutable, changing one replaces it.
+		std::array<std::shared_ptr<const subscriber_list>, Event_Count> m_subscribers;
+        std::mutex m_subscribers_mutex;
+        uint32_t m_id = 0;
+
+        // Deferred events, double buffered
+        std::vector<Event_Type> m_deferred;
+        std::vector<Event_Type> m_deferred_draining;
+        std::mutex m_deferred_mutex;
 	};
 }
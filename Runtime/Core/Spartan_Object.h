@@ -43,13 +43,22 @@ namespace Spartan
             m_context   = context;
             m_id        = GenerateId();
         }
+        virtual ~Spartan_Object() = default;
 
         // Name
         const std::string& GetName()    const { return m_name; }
 
         // Id
 		const uint32_t GetId()          const { return m_id; }
-		void SetId(const uint32_t id)	      { m_id = id; }
+		void SetId(const uint32_t id)
+        {
+            if (m_id == id)
+                return;
+
+            const uint32_t id_previous = m_id;
+            m_id = id;
+            OnIdChange(id_previous);
+        }
         static uint32_t GenerateId()          { return ++g_id; }
 
         // CPU & GPU sizes
@@ -60,6 +69,9 @@ namespace Spartan
         Context* GetContext()           const { return m_context; }
 
 	protected:
+        // Called by SetId(), for objects which are looked up by id
+        virtual void OnIdChange(uint32_t /*id_previous*/) {}
+
         // Execution context
         Context* m_context = nullptr;
 
@@ -0,0 +1,173 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ====================
+#include "Spartan.h"
+#include "AssetContainer.h"
+#include "FileStream.h"
+#include "../Utilities/Hash.h"
+//===============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    AssetContainer::AssetContainer() = default;
+
+    AssetContainer::~AssetContainer()
+    {
+        Close();
+    }
+
+    void AssetContainer::AddChunk(const uint32_t type, const uint32_t index, const void* data, const uint64_t size)
+    {
+        Chunk& chunk        = m_chunks.emplace_back();
+        chunk.type          = type;
+        chunk.index         = index;
+        chunk.size          = size;
+        chunk.compression   = Compression_None;
+        chunk.checksum      = Utility::Hash::fnv1a(data, size);
+        m_chunk_sources.emplace_back(data);
+    }
+
+    bool AssetContainer::Save(const string& file_path)
+    {
+        // Lay out the chunks after the table of contents
+        uint64_t offset = sizeof(Header) + m_chunks.size() * sizeof(Chunk);
+        for (Chunk& chunk : m_chunks)
+        {
+            offset          = (offset + alignment - 1) & ~(alignment - 1);
+            chunk.offset    = offset;
+            offset         += chunk.size;
+        }
+
+        auto file = make_unique<FileStream>(file_path, FileStream_Write);
+        if (!file->IsOpen())
+            return false;
+
+        const Header header = { magic, version, static_cast<uint32_t>(m_chunks.size()), 0 };
+        file->Write(&header, sizeof(Header));
+        file->Write(m_chunks.data(), m_chunks.size() * sizeof(Chunk));
+
+        uint64_t position = sizeof(Header) + m_chunks.size() * sizeof(Chunk);
+        const array<std::byte, alignment> padding = {};
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_chunks.size()); i++)
+        {
+            file->Write(padding.data(), m_chunks[i].offset - position);
+            file->Write(m_chunk_sources[i], m_chunks[i].size);
+            position = m_chunks[i].offset + m_chunks[i].size;
+        }
+
+        file->Close();
+
+        m_chunks.clear();
+        m_chunk_sources.clear();
+
+        return true;
+    }
+
+    bool AssetContainer::Open(const string& file_path)
+    {
+        Close();
+
+        m_file_path = file_path;
+        m_stream    = make_unique<FileStream>(file_path, FileStream_Read);
+        if (!m_stream->IsOpen())
+            return false;
+
+        const std::byte* header_data = m_stream->ReadView(sizeof(Header));
+        if (!header_data)
+        {
+            LOG_ERROR("\"%s\" is too small to be an asset container", file_path.c_str());
+            return false;
+        }
+
+        Header header;
+        memcpy(&header, header_data, sizeof(Header));
+        if (header.magic != magic || header.version != version)
+        {
+            LOG_ERROR("\"%s\" is not an asset container of version %d", file_path.c_str(), version);
+            return false;
+        }
+
+        const std::byte* chunks_data = m_stream->ReadView(static_cast<uint64_t>(header.chunk_count) * sizeof(Chunk));
+        if (!chunks_data)
+            return false;
+
+        m_chunks.resize(header.chunk_count);
+        memcpy(m_chunks.data(), chunks_data, m_chunks.size() * sizeof(Chunk));
+
+        return true;
+    }
+
+    void AssetContainer::Close()
+    {
+        m_stream.reset();
+        m_chunks.clear();
+        m_chunk_sources.clear();
+    }
+
+    const AssetContainer::Chunk* AssetContainer::FindChunk(const uint32_t type, const uint32_t index) const
+    {
+        for (const Chunk& chunk : m_chunks)
+        {
+            if (chunk.type == type && chunk.index == index)
+                return &chunk;
+        }
+
+        return nullptr;
+    }
+
+    const std::byte* AssetContainer::GetChunkData(const Chunk& chunk)
+    {
+        if (!m_stream || chunk.compression != Compression_None || chunk.offset > m_stream->GetSize() || chunk.size > m_stream->GetSize() - chunk.offset)
+        {
+            LOG_ERROR("Invalid chunk in \"%s\"", m_file_path.c_str());
+            return nullptr;
+        }
+
+        m_stream->Seek(chunk.offset);
+        const std::byte* data = m_stream->ReadView(chunk.size);
+        if (!data || Utility::Hash::fnv1a(data, chunk.size) != chunk.checksum)
+        {
+            LOG_ERROR("Corrupt chunk in \"%s\"", m_file_path.c_str());
+            return nullptr;
+        }
+
+        return data;
+    }
+
+    bool AssetContainer::ReadChunk(const uint32_t type, const uint32_t index, vector<std::byte>* data)
+    {
+        const Chunk* chunk = FindChunk(type, index);
+        if (!chunk)
+            return false;
+
+        const std::byte* chunk_data = GetChunkData(*chunk);
+        if (!chunk_data)
+            return false;
+
+        data->assign(chunk_data, chunk_data + chunk->size);
+        return true;
+    }
+}
@@ -0,0 +1,98 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include <vector>
+#include <memory>
+#include <string>
+#include "../Core/Spartan_Definitions.h"
+//==============================
+
+namespace Spartan
+{
+    class FileStream;
+
+    // A file made of chunks which can be found through a table of contents, instead of being read in sequence.
+    // Layout: header, table of contents, then the chunks, each one starting at a multiple of the alignment, so
+    // a chunk can be handed over to the GPU (or read with aligned loads) straight from the mapped file.
+    class SPARTAN_CLASS AssetContainer
+    {
+    public:
+        static constexpr uint32_t magic     = 0x43415053; // "SPAC"
+        static constexpr uint32_t version   = 1;
+        static constexpr uint64_t alignment = 256;
+
+        enum Compression : uint32_t
+        {
+            Compression_None
+        };
+
+        struct Chunk
+        {
+            uint32_t type           = 0;    // see MakeType()
+            uint32_t index          = 0;    // to tell apart chunks of the same type (e.g. mips)
+            uint64_t offset         = 0;    // from the start of the file
+            uint64_t size           = 0;
+            uint32_t compression    = Compression_None;
+            uint32_t checksum       = 0;    // FNV-1a of the stored bytes
+        };
+
+        static constexpr uint32_t MakeType(const char a, const char b, const char c, const char d)
+        {
+            return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+        }
+
+        AssetContainer();
+        ~AssetContainer();
+
+        //= WRITING =====================================================================================================
+        // The data is only referenced, it has to stay alive until Save()
+        void AddChunk(uint32_t type, uint32_t index, const void* data, uint64_t size);
+        bool Save(const std::string& file_path);
+        //===============================================================================================================
+
+        //= READING =====================================================================================================
+        bool Open(const std::string& file_path);
+        void Close();
+        const Chunk* FindChunk(uint32_t type, uint32_t index = 0) const;
+        // Zero copy, valid until Close(), null if the chunk is missing or its checksum doesn't match
+        const std::byte* GetChunkData(const Chunk& chunk);
+        bool ReadChunk(uint32_t type, uint32_t index, std::vector<std::byte>* data);
+        const auto& GetChunks() const { return m_chunks; }
+        //===============================================================================================================
+
+    private:
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t chunk_count;
+            uint32_t reserved;
+        };
+
+        std::vector<Chunk> m_chunks;
+        std::vector<const void*> m_chunk_sources; // writing, same order as m_chunks
+        std::unique_ptr<FileStream> m_stream;     // reading
+        std::string m_file_path;
+    };
+}
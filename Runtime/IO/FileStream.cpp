@@ -23,6 +23,16 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "FileStream.h"
 #include "../RHI/RHI_Vertex.h"
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 //============================
 
 //= NAMESPACES =====
@@ -35,25 +45,25 @@ namespace Spartan
 	{
 		m_is_open	= false;
 		m_flags		= flags;
-
-		int ios_flags	= ios::binary;
-		ios_flags		|= (flags & FileStream_Read)	? ios::in	: 0;
-		ios_flags		|= (flags & FileStream_Write)	? ios::out	: 0;
-		ios_flags		|= (flags & FileStream_Append)	? ios::app	: 0;
+		m_path		= path;
 
 		if (m_flags & FileStream_Write)
 		{
-			out.open(path, ios_flags);
-			if (out.fail())
+			ios::openmode ios_flags	= ios::binary | ios::out;
+			ios_flags				|= (flags & FileStream_Append) ? ios::app : ios::openmode();
+
+			m_out.open(path, ios_flags);
+			if (m_out.fail())
 			{
 				LOG_ERROR("Failed to open \"%s\" for writing", path.c_str());
 				return;
 			}
+
+			m_write_buffer.reserve(m_write_buffer_size);
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.open(path, ios_flags);
-			if(in.fail())
+			if (!Map(path))
 			{
 				LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
 				return;
@@ -70,24 +80,27 @@ namespace Spartan
 
 	void FileStream::Close()
 	{
+		if (!m_is_open)
+			return;
+
 		if (m_flags & FileStream_Write)
 		{
-			out.flush();
-			out.close();
+			Flush();
+			m_out.close();
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.clear();
-			in.close();
+			Unmap();
 		}
+
+		m_is_open = false;
 	}
 
 	void FileStream::Write(const string& value)
 	{
 		const auto length = static_cast<uint32_t>(value.length());
 		Write(length);
-
-		out.write(const_cast<char*>(value.c_str()), length);
+		WriteBytes(value.c_str(), length);
 	}
 
 	void FileStream::Write(const vector<string>& value)
@@ -105,28 +118,33 @@ namespace Spartan
 	{
 		const auto length = static_cast<uint32_t>(value.size());
 		Write(length);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(RHI_Vertex_PosTexNorTan) * length);
+		WriteBytes(value.data(), sizeof(RHI_Vertex_PosTexNorTan) * length);
 	}
 
 	void FileStream::Write(const vector<uint32_t>& value)
 	{
 		const auto length = static_cast<uint32_t>(value.size());
 		Write(length);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(uint32_t) * length);
+		WriteBytes(value.data(), sizeof(uint32_t) * length);
 	}
 
 	void FileStream::Write(const vector<unsigned char>& value)
 	{
 		const auto size = static_cast<uint32_t>(value.size());
 		Write(size);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(unsigned char) * size);
+		WriteBytes(value.data(), sizeof(unsigned char) * size);
 	}
 
 	void FileStream::Write(const vector<std::byte>& value)
 	{
 		const auto size = static_cast<uint32_t>(value.size());
 		Write(size);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(std::byte) * size);
+		WriteBytes(value.data(), sizeof(std::byte) * size);
+	}
+
+	void FileStream::Write(const void* data, const uint64_t size)
+	{
+		WriteBytes(data, size);
 	}
 
 	void FileStream::Skip(uint32_t n)
@@ -134,11 +152,28 @@ namespace Spartan
 		// Set the seek cursor to offset n from the current position
 		if (m_flags & FileStream_Write)
 		{
-			out.seekp(n, ios::cur);
+			Flush();
+			m_out.seekp(n, ios::cur);
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.ignore(n, ios::cur);
+			if (ReadCheck(n))
+			{
+				m_read_cursor += n;
+			}
+		}
+	}
+
+	void FileStream::Seek(const uint64_t offset)
+	{
+		if (m_flags & FileStream_Write)
+		{
+			Flush();
+			m_out.seekp(offset, ios::beg);
+		}
+		else if (m_flags & FileStream_Read)
+		{
+			m_read_cursor = Math::Helper::Min(offset, m_read_size);
 		}
 	}
 
@@ -147,8 +182,14 @@ namespace Spartan
 		uint32_t length = 0;
 		Read(&length);
 
-		value->resize(length);
-		in.read(const_cast<char*>(value->c_str()), length);
+		if (!ReadCheck(length))
+		{
+			value->clear();
+			return;
+		}
+
+		value->assign(reinterpret_cast<const char*>(m_read_data + m_read_cursor), length);
+		m_read_cursor += length;
 	}
 
 	void FileStream::Read(vector<string>* vec)
@@ -162,11 +203,14 @@ namespace Spartan
 		uint32_t size = 0;
 		Read(&size);
 
-		string str;
+		// Every string takes at least its length
+		if (!ReadCheck(static_cast<uint64_t>(size) * sizeof(uint32_t)))
+			return;
+
+		vec->resize(size);
 		for (uint32_t i = 0; i < size; i++)
 		{
-			Read(&str);
-			vec->emplace_back(str);
+			Read(&(*vec)[i]);
 		}
 	}
 
@@ -178,12 +222,12 @@ namespace Spartan
 		vec->clear();
 		vec->shrink_to_fit();
 
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
-		vec->resize(length);
-
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(RHI_Vertex_PosTexNorTan) * length);
+		uint32_t length = 0;
+		if (const std::byte* view = ReadView<RHI_Vertex_PosTexNorTan>(&length))
+		{
+			vec->resize(length);
+			memcpy(vec->data(), view, sizeof(RHI_Vertex_PosTexNorTan) * length);
+		}
 	}
 
 	void FileStream::Read(vector<uint32_t>* vec)
@@ -194,12 +238,12 @@ namespace Spartan
 		vec->clear();
 		vec->shrink_to_fit();
 
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
-		vec->resize(length);
-
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(uint32_t) * length);
+		uint32_t length = 0;
+		if (const std::byte* view = ReadView<uint32_t>(&length))
+		{
+			vec->resize(length);
+			memcpy(vec->data(), view, sizeof(uint32_t) * length);
+		}
 	}
 
 	void FileStream::Read(vector<unsigned char>* vec)
@@ -210,12 +254,12 @@ namespace Spartan
 		vec->clear();
 		vec->shrink_to_fit();
 
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
-		vec->resize(length);
-
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(unsigned char) * length);
+		uint32_t length = 0;
+		if (const std::byte* view = ReadView<unsigned char>(&length))
+		{
+			vec->resize(length);
+			memcpy(vec->data(), view, sizeof(unsigned char) * length);
+		}
 	}
 
 	void FileStream::Read(vector<std::byte>* vec)
@@ -226,11 +270,158 @@ namespace Spartan
 		vec->clear();
 		vec->shrink_to_fit();
 
-		const auto length = ReadAs<uint32_t>();
+		uint32_t length = 0;
+		if (const std::byte* view = ReadView<std::byte>(&length))
+		{
+			vec->assign(view, view + length);
+		}
+	}
+
+	const std::byte* FileStream::ReadView(const uint64_t size)
+	{
+		if (!ReadCheck(size))
+			return nullptr;
+
+		const std::byte* view = m_read_data + m_read_cursor;
+		m_read_cursor += size;
+		return view;
+	}
+
+	void FileStream::WriteBytes(const void* data, const uint64_t size)
+	{
+		if (size == 0)
+			return;
+
+		// Big payloads go straight to the file
+		if (size >= m_write_buffer_size)
+		{
+			Flush();
+			m_out.write(static_cast<const char*>(data), size);
+			return;
+		}
+
+		if (m_write_buffer.size() + size > m_write_buffer_size)
+		{
+			Flush();
+		}
+
+		const std::byte* bytes = static_cast<const std::byte*>(data);
+		m_write_buffer.insert(m_write_buffer.end(), bytes, bytes + size);
+	}
+
+	void FileStream::ReadBytes(void* data, const uint64_t size)
+	{
+		if (!ReadCheck(size))
+		{
+			memset(data, 0, size);
+			return;
+		}
+
+		memcpy(data, m_read_data + m_read_cursor, size);
+		m_read_cursor += size;
+	}
+
+	bool FileStream::ReadCheck(const uint64_t size)
+	{
+		if (size <= m_read_size - m_read_cursor)
+			return true;
+
+		// Only once, a corrupt file would otherwise flood the log
+		if (!m_read_past_end)
+		{
+			LOG_ERROR("Attempted to read %llu bytes past the end of \"%s\"", static_cast<unsigned long long>(size - (m_read_size - m_read_cursor)), m_path.c_str());
+			m_read_past_end = true;
+		}
+
+		m_read_cursor = m_read_size;
+		return false;
+	}
+
+	void FileStream::Flush()
+	{
+		if (m_write_buffer.empty())
+			return;
 
-		vec->reserve(length);
-		vec->resize(length);
+		m_out.write(reinterpret_cast<const char*>(m_write_buffer.data()), m_write_buffer.size());
+		m_write_buffer.clear();
+	}
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(std::byte) * length);
+	bool FileStream::Map(const string& path)
+	{
+#if defined(_WIN32)
+		const wstring path_wide = FileSystem::StringToWstring(path);
+		HANDLE file = CreateFileW(path_wide.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		{
+			if (HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+			{
+				if (void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+				{
+					m_map_file		= file;
+					m_map_handle	= mapping;
+					m_map_view		= view;
+					m_read_data		= static_cast<const std::byte*>(view);
+					m_read_size		= static_cast<uint64_t>(size.QuadPart);
+					return true;
+				}
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file == -1)
+			return false;
+
+		struct stat info;
+		if (fstat(file, &info) == 0 && info.st_size > 0)
+		{
+			void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if (view != MAP_FAILED)
+			{
+				close(file);
+				m_map_view		= view;
+				m_read_data		= static_cast<const std::byte*>(view);
+				m_read_size		= static_cast<uint64_t>(info.st_size);
+				return true;
+			}
+		}
+		close(file);
+#endif
+
+		// Empty files can't be mapped, and some file systems don't support it, read everything in one go instead
+		ifstream in(path, ios::binary | ios::ate);
+		if (in.fail())
+			return false;
+
+		m_read_buffer.resize(static_cast<size_t>(in.tellg()));
+		in.seekg(0, ios::beg);
+		in.read(reinterpret_cast<char*>(m_read_buffer.data()), m_read_buffer.size());
+		m_read_data = m_read_buffer.data();
+		m_read_size = m_read_buffer.size();
+		return true;
+	}
+
+	void FileStream::Unmap()
+	{
+#if defined(_WIN32)
+		if (m_map_view)     UnmapViewOfFile(m_map_view);
+		if (m_map_handle)   CloseHandle(m_map_handle);
+		if (m_map_file)     CloseHandle(m_map_file);
+#else
+		if (m_map_view)     munmap(m_map_view, m_read_size);
+#endif
+		m_map_view		= nullptr;
+		m_map_handle	= nullptr;
+		m_map_file		= nullptr;
+		m_read_data		= nullptr;
+		m_read_size		= 0;
+		m_read_cursor	= 0;
+		m_read_buffer.clear();
+		m_read_buffer.shrink_to_fit();
 	}
 }
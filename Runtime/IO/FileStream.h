@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===================
 #include <vector>
 #include <fstream>
+#include <cstring>
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
@@ -42,6 +43,9 @@ namespace Spartan
 		FileStream_Append	= 1 << 2,
 	};
 
+	// Reading maps the whole file into memory (or loads it in one go if that's not possible) and then only moves a cursor,
+	// so values are copied straight out of the mapping and arrays can even be viewed in place. Writing goes to a large buffer
+	// which is flushed to the file when it fills up and on Close(). Reads past the end are logged and yield zeros.
 	class SPARTAN_CLASS FileStream
 	{
 	public:
@@ -76,7 +80,7 @@ namespace Spartan
 		>::type>
 		void Write(T value)
 		{
-			out.write(reinterpret_cast<char*>(&value), sizeof(value));
+			WriteBytes(&value, sizeof(value));
 		}
 
 		void Write(const std::string& value);
@@ -85,7 +89,9 @@ namespace Spartan
 		void Write(const std::vector<uint32_t>& value);
 		void Write(const std::vector<unsigned char>& value);
 		void Write(const std::vector<std::byte>& value);
+		void Write(const void* data, uint64_t size); // raw, no length
 		void Skip(uint32_t n);
+		void Seek(uint64_t offset); // from the start of the file
 		//===========================================================
 		
 		//= READING ===========================================
@@ -114,7 +120,7 @@ namespace Spartan
 		>::type>
 		void Read(T* value)
 		{
-			in.read(reinterpret_cast<char*>(value), sizeof(T));
+			ReadBytes(value, sizeof(T));
 		}
 		void Read(std::string* value);
 		void Read(std::vector<std::string>* vec);
@@ -123,6 +129,19 @@ namespace Spartan
 		void Read(std::vector<unsigned char>* vec);
 		void Read(std::vector<std::byte>* vec);
 
+		// Zero copy, points to the elements of an array written by Write(std::vector), valid until Close(). The
+		// mapping is only byte aligned, so the elements are best copied out with memcpy() or uploaded as they are.
+		template <class T>
+		const std::byte* ReadView(uint32_t* count)
+		{
+			*count = ReadAs<uint32_t>();
+			const std::byte* view = ReadView(static_cast<uint64_t>(*count) * sizeof(T));
+			*count = view ? *count : 0;
+			return view;
+		}
+		const std::byte* ReadView(uint64_t size);
+		uint64_t GetSize() const { return m_read_size; }
+
 		// Reading with explicit type definition
 		template <class T, class = typename std::enable_if
 		<
@@ -152,8 +171,29 @@ namespace Spartan
 		//=====================================================
 
 	private:
-		std::ofstream out;
-		std::ifstream in;
+		void WriteBytes(const void* data, uint64_t size);
+		void ReadBytes(void* data, uint64_t size);
+		bool ReadCheck(uint64_t size);
+		void Flush();
+		bool Map(const std::string& path);
+		void Unmap();
+
+		// Writing
+		std::ofstream m_out;
+		std::vector<std::byte> m_write_buffer;
+		static constexpr uint64_t m_write_buffer_size = 4 * 1024 * 1024;
+
+		// Reading
+		const std::byte* m_read_data	= nullptr;
+		uint64_t m_read_size			= 0;
+		uint64_t m_read_cursor			= 0;
+		std::vector<std::byte> m_read_buffer;	// when the file can't be mapped
+		void* m_map_file				= nullptr;
+		void* m_map_handle				= nullptr;
+		void* m_map_view				= nullptr;
+		bool m_read_past_end			= false;
+
+		std::string m_path;
 		uint32_t m_flags;
 		bool m_is_open;
 	};
@@ -0,0 +1,344 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ========
+#include "Spartan.h"
+#include "AabbTree.h"
+//===================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::Math
+{
+    namespace
+    {
+        // How much leaf boxes are enlarged by, relative to their size
+        constexpr float margin_factor = 0.1f;
+
+        BoundingBox merged(const BoundingBox& a, const BoundingBox& b)
+        {
+            BoundingBox box = a;
+            box.Merge(b);
+            return box;
+        }
+
+        float surface_area(const BoundingBox& box)
+        {
+            const Vector3 size = box.GetSize();
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+    }
+
+    uint32_t AabbTree::Insert(const BoundingBox& box, const uint32_t user_data)
+    {
+        const uint32_t proxy    = NodeAllocate();
+        const Vector3 margin    = box.GetSize() * margin_factor;
+        Node& node              = m_nodes[proxy];
+        node.box                = BoundingBox(box.GetMin() - margin, box.GetMax() + margin);
+        node.user_data          = user_data;
+        node.height             = 0;
+
+        LeafInsert(proxy);
+        m_proxy_count++;
+
+        return proxy;
+    }
+
+    void AabbTree::Remove(const uint32_t proxy)
+    {
+        SPARTAN_ASSERT(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf());
+
+        LeafRemove(proxy);
+        NodeFree(proxy);
+        m_proxy_count--;
+    }
+
+    bool AabbTree::Move(const uint32_t proxy, const BoundingBox& box)
+    {
+        SPARTAN_ASSERT(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf());
+
+        // Still within the enlarged box, nothing to do
+        if (m_nodes[proxy].box.IsInside(box) == Inside)
+            return false;
+
+        LeafRemove(proxy);
+
+        const Vector3 margin    = box.GetSize() * margin_factor;
+        m_nodes[proxy].box      = BoundingBox(box.GetMin() - margin, box.GetMax() + margin);
+
+        LeafInsert(proxy);
+
+        return true;
+    }
+
+    void AabbTree::Clear()
+    {
+        m_nodes.clear();
+        m_root          = node_invalid;
+        m_free          = node_invalid;
+        m_proxy_count   = 0;
+    }
+
+    void AabbTree::GetSubtrees(const uint32_t count, vector<uint32_t>& subtrees) const
+    {
+        subtrees.clear();
+        if (m_root == node_invalid)
+            return;
+
+        // Level by level, replacing nodes with their children until there are enough of them
+        subtrees.emplace_back(m_root);
+        bool expanded = true;
+        while (expanded && subtrees.size() < count)
+        {
+            expanded = false;
+
+            const size_t size = subtrees.size();
+            for (size_t i = 0; i < size && subtrees.size() < count; i++)
+            {
+                const Node& node = m_nodes[subtrees[i]];
+                if (node.IsLeaf())
+                    continue;
+
+                subtrees[i] = node.child_left;
+                subtrees.emplace_back(node.child_right);
+                expanded = true;
+            }
+        }
+    }
+
+    uint32_t AabbTree::NodeAllocate()
+    {
+        uint32_t index = m_free;
+        if (index != node_invalid)
+        {
+            m_free          = m_nodes[index].parent;
+            m_nodes[index]  = Node();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        return index;
+    }
+
+    void AabbTree::NodeFree(const uint32_t index)
+    {
+        Node& node      = m_nodes[index];
+        node.parent     = m_free;
+        node.height     = -1;
+        m_free          = index;
+    }
+
+    void AabbTree::LeafInsert(const uint32_t leaf)
+    {
+        if (m_root == node_invalid)
+        {
+            m_root                  = leaf;
+            m_nodes[leaf].parent    = node_invalid;
+            return;
+        }
+
+        // Descend towards the sibling which is the cheapest to pair with, in terms of surface area
+        const BoundingBox box_leaf = m_nodes[leaf].box;
+        uint32_t index = m_root;
+        while (!m_nodes[index].IsLeaf())
+        {
+            const Node& node                = m_nodes[index];
+            const float area                = surface_area(node.box);
+            const float area_combined       = surface_area(merged(node.box, box_leaf));
+
+            // Cost of creating a new parent for this node and the leaf
+            const float cost                = 2.0f * area_combined;
+
+            // Minimum cost of pushing the leaf further down the tree
+            const float cost_inheritance    = 2.0f * (area_combined - area);
+
+            auto cost_descend = [this, &box_leaf, cost_inheritance](const uint32_t child)
+            {
+                const Node& node_child = m_nodes[child];
+                const float area_new   = surface_area(merged(box_leaf, node_child.box));
+                return (node_child.IsLeaf() ? area_new : area_new - surface_area(node_child.box)) + cost_inheritance;
+            };
+
+            const float cost_left   = cost_descend(node.child_left);
+            const float cost_right  = cost_descend(node.child_right);
+
+            if (cost < cost_left && cost < cost_right)
+                break;
+
+            index = cost_left < cost_right ? node.child_left : node.child_right;
+        }
+
+        // Create a new parent for the sibling and the leaf (allocating can reallocate the nodes, so no references are held)
+        const uint32_t sibling      = index;
+        const uint32_t parent_old   = m_nodes[sibling].parent;
+        const uint32_t parent_new   = NodeAllocate();
+        {
+            Node& node          = m_nodes[parent_new];
+            node.parent         = parent_old;
+            node.box            = merged(box_leaf, m_nodes[sibling].box);
+            node.height         = m_nodes[sibling].height + 1;
+            node.child_left     = sibling;
+            node.child_right    = leaf;
+        }
+
+        if (parent_old != node_invalid)
+        {
+            Node& node = m_nodes[parent_old];
+            (node.child_left == sibling ? node.child_left : node.child_right) = parent_new;
+        }
+        else
+        {
+            m_root = parent_new;
+        }
+
+        m_nodes[sibling].parent = parent_new;
+        m_nodes[leaf].parent    = parent_new;
+
+        Refit(parent_new);
+    }
+
+    void AabbTree::LeafRemove(const uint32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = node_invalid;
+            return;
+        }
+
+        // The sibling takes the place of the parent
+        const uint32_t parent       = m_nodes[leaf].parent;
+        const uint32_t grandparent  = m_nodes[parent].parent;
+        const uint32_t sibling      = m_nodes[parent].child_left == leaf ? m_nodes[parent].child_right : m_nodes[parent].child_left;
+
+        m_nodes[sibling].parent = grandparent;
+        NodeFree(parent);
+
+        if (grandparent != node_invalid)
+        {
+            Node& node = m_nodes[grandparent];
+            (node.child_left == parent ? node.child_left : node.child_right) = sibling;
+            Refit(grandparent);
+        }
+        else
+        {
+            m_root = sibling;
+        }
+    }
+
+    void AabbTree::Refit(uint32_t index)
+    {
+        // Walk up to the root, balancing and fixing the boxes and heights
+        while (index != node_invalid)
+        {
+            index = Balance(index);
+
+            Node& node                  = m_nodes[index];
+            const Node& node_left       = m_nodes[node.child_left];
+            const Node& node_right      = m_nodes[node.child_right];
+            node.height                 = 1 + Helper::Max(node_left.height, node_right.height);
+            node.box                    = merged(node_left.box, node_right.box);
+
+            index = node.parent;
+        }
+    }
+
+    uint32_t AabbTree::Balance(const uint32_t index_a)
+    {
+        /*
+               A
+             /   \
+            B     C
+           / \   / \
+          D   E F   G
+        */
+
+        Node& a = m_nodes[index_a];
+        if (a.IsLeaf() || a.height < 2)
+            return index_a;
+
+        const uint32_t index_b  = a.child_left;
+        const uint32_t index_c  = a.child_right;
+        Node& b                 = m_nodes[index_b];
+        Node& c                 = m_nodes[index_c];
+        const int32_t balance   = c.height - b.height;
+
+        // Rotates a child up, it takes the place of A and A takes the place of one of its children
+        auto rotate = [this, index_a, &a](const uint32_t index_up, Node& up, Node& other, const bool up_is_left)
+        {
+            const uint32_t index_f  = up.child_left;
+            const uint32_t index_g  = up.child_right;
+            Node& f                 = m_nodes[index_f];
+            Node& g                 = m_nodes[index_g];
+
+            // Swap A and the child
+            up.child_left   = index_a;
+            up.parent       = a.parent;
+            a.parent        = index_up;
+
+            if (up.parent != node_invalid)
+            {
+                Node& parent = m_nodes[up.parent];
+                (parent.child_left == index_a ? parent.child_left : parent.child_right) = index_up;
+            }
+            else
+            {
+                m_root = index_up;
+            }
+
+            // The taller grandchild stays with the child, the other one goes to A
+            const bool f_taller             = f.height > g.height;
+            const uint32_t index_keep       = f_taller ? index_f : index_g;
+            const uint32_t index_give       = f_taller ? index_g : index_f;
+            Node& keep                      = f_taller ? f : g;
+            Node& give                      = f_taller ? g : f;
+
+            up.child_right                                      = index_keep;
+            (up_is_left ? a.child_left : a.child_right)         = index_give;
+            give.parent                                         = index_a;
+
+            a.box       = merged(other.box, give.box);
+            a.height    = 1 + Helper::Max(other.height, give.height);
+            up.box      = merged(a.box, keep.box);
+            up.height   = 1 + Helper::Max(a.height, keep.height);
+        };
+
+        // C is too tall
+        if (balance > 1)
+        {
+            rotate(index_c, c, b, false);
+            return index_c;
+        }
+
+        // B is too tall
+        if (balance < -1)
+        {
+            rotate(index_b, b, c, true);
+            return index_b;
+        }
+
+        return index_a;
+    }
+}
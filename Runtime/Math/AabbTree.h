@@ -0,0 +1,206 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =============
+#include <vector>
+#include <array>
+#include "BoundingBox.h"
+#include "Frustum.h"
+//========================
+
+namespace Spartan::Math
+{
+    // A dynamic bounding volume hierarchy. Leaves are inserted where they increase the surface area the least,
+    // and the tree is kept balanced with rotations, so it stays shallow as entries come and go. Leaf boxes are
+    // slightly enlarged, which allows small movements without having to re-insert anything.
+    class SPARTAN_CLASS AabbTree
+    {
+    public:
+        static constexpr uint32_t node_invalid = 0xFFFFFFFF;
+
+        AabbTree() = default;
+        ~AabbTree() = default;
+
+        // Entries (proxies), the user data is an arbitrary id which is handed back by queries
+        uint32_t Insert(const BoundingBox& box, uint32_t user_data);
+        void Remove(uint32_t proxy);
+        bool Move(uint32_t proxy, const BoundingBox& box); // returns true if the entry had to be re-inserted
+        void Clear();
+
+        uint32_t GetUserData(uint32_t proxy) const                  { return m_nodes[proxy].user_data; }
+        void SetUserData(uint32_t proxy, const uint32_t user_data)  { m_nodes[proxy].user_data = user_data; }
+        const BoundingBox& GetBox(uint32_t proxy) const             { return m_nodes[proxy].box; }
+        uint32_t GetProxyCount() const                              { return m_proxy_count; }
+        uint32_t GetHeight() const                                  { return m_root == node_invalid ? 0 : m_nodes[m_root].height; }
+
+        // Calls function(user_data) for every entry which intersects the frustum. Subtrees outside of it are
+        // skipped as a whole, and subtrees fully inside of it are reported without any further tests.
+        template <typename Function>
+        void Query(const Frustum& frustum, Function&& function, const bool ignore_depth = false) const
+        {
+            if (m_root == node_invalid)
+                return;
+
+            struct Entry
+            {
+                uint32_t node;
+                bool inside;
+            };
+
+            // The tree is balanced, so this is deep enough for far more entries than will ever fit in memory
+            std::array<Entry, stack_size> stack;
+            uint32_t stack_count = 0;
+            stack[stack_count++] = { m_root, false };
+
+            while (stack_count != 0)
+            {
+                const Entry entry   = stack[--stack_count];
+                const Node& node    = m_nodes[entry.node];
+
+                bool inside = entry.inside;
+                if (!inside)
+                {
+                    const Intersection intersection = frustum.IsInside(node.box.GetCenter(), node.box.GetExtents(), ignore_depth);
+                    if (intersection == Outside)
+                        continue;
+
+                    inside = intersection == Inside;
+                }
+
+                if (node.IsLeaf())
+                {
+                    function(node.user_data);
+                    continue;
+                }
+
+                stack[stack_count++] = { node.child_left, inside };
+                stack[stack_count++] = { node.child_right, inside };
+            }
+        }
+
+        // Calls function(frustum_index, user_data) for every entry which intersects any of the frustums (up to 64). All of them are tested
+        // during a single traversal, each one drops out of a subtree once it rejects it. Starting from a node returned by GetSubtrees()
+        // only visits that part of the tree, which allows splitting the work across threads.
+        template <typename Function>
+        void Query(const Frustum* frustums, const uint32_t frustum_count, const uint64_t ignore_depth_mask, Function&& function, const uint32_t node_start = node_invalid) const
+        {
+            const uint32_t node_first = node_start == node_invalid ? m_root : node_start;
+            if (node_first == node_invalid || frustum_count == 0 || frustum_count > 64)
+                return;
+
+            struct Entry
+            {
+                uint32_t node;
+                uint64_t intersecting; // frustums which still have to test the node
+                uint64_t inside;       // frustums which fully contain the node
+            };
+
+            std::array<Entry, stack_size> stack;
+            uint32_t stack_count = 0;
+            stack[stack_count++] = { node_first, frustum_count == 64 ? ~0ull : (1ull << frustum_count) - 1, 0 };
+
+            while (stack_count != 0)
+            {
+                const Entry entry   = stack[--stack_count];
+                const Node& node    = m_nodes[entry.node];
+
+                uint64_t intersecting   = 0;
+                uint64_t inside         = entry.inside;
+                if (entry.intersecting != 0)
+                {
+                    const Vector3 center    = node.box.GetCenter();
+                    const Vector3 extents   = node.box.GetExtents();
+                    for (uint64_t mask = entry.intersecting; mask != 0; mask &= mask - 1)
+                    {
+                        const uint32_t index            = LowestBit(mask);
+                        const Intersection intersection = frustums[index].IsInside(center, extents, (ignore_depth_mask >> index) & 1);
+                        if (intersection == Inside)
+                        {
+                            inside |= 1ull << index;
+                        }
+                        else if (intersection == Intersects)
+                        {
+                            intersecting |= 1ull << index;
+                        }
+                    }
+                }
+
+                if ((intersecting | inside) == 0)
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    for (uint64_t mask = intersecting | inside; mask != 0; mask &= mask - 1)
+                    {
+                        function(LowestBit(mask), node.user_data);
+                    }
+                    continue;
+                }
+
+                stack[stack_count++] = { node.child_left, intersecting, inside };
+                stack[stack_count++] = { node.child_right, intersecting, inside };
+            }
+        }
+
+        // Returns up to count disjoint subtrees which together contain every entry, for distributing queries
+        void GetSubtrees(uint32_t count, std::vector<uint32_t>& subtrees) const;
+
+    private:
+        static constexpr uint32_t stack_size = 128;
+
+        static uint32_t LowestBit(const uint64_t mask)
+        {
+        #if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return static_cast<uint32_t>(index);
+        #else
+            return static_cast<uint32_t>(__builtin_ctzll(mask));
+        #endif
+        }
+
+        struct Node
+        {
+            bool IsLeaf() const { return child_left == node_invalid; }
+
+            BoundingBox box;
+            uint32_t user_data      = 0;
+            uint32_t parent         = node_invalid; // or the next free node, while in the free list
+            uint32_t child_left     = node_invalid;
+            uint32_t child_right    = node_invalid;
+            int32_t height          = -1;           // leaves are 0, free nodes are -1
+        };
+
+        uint32_t NodeAllocate();
+        void NodeFree(uint32_t index);
+        void LeafInsert(uint32_t leaf);
+        void LeafRemove(uint32_t leaf);
+        void Refit(uint32_t index);
+        uint32_t Balance(uint32_t index);
+
+        std::vector<Node> m_nodes;
+        uint32_t m_root         = node_invalid;
+        uint32_t m_free         = node_invalid;
+        uint32_t m_proxy_count  = 0;
+    };
+}
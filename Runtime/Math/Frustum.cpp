@@ -21,6 +21,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =======
 #include "Spartan.h"
+#if defined(_M_X64) || defined(__SSE2__)
+#define FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
 //==================
 
 //= NAMESPACES =====
@@ -82,13 +86,21 @@ namespace Spartan::Math
 		m_planes[5].normal.z = view_projection.m23 + view_projection.m21;
 		m_planes[5].d = view_projection.m33 + view_projection.m31;
 		m_planes[5].Normalize();
+
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            m_planes_x[i] = m_planes[i].normal.x;
+            m_planes_y[i] = m_planes[i].normal.y;
+            m_planes_z[i] = m_planes[i].normal.z;
+            m_planes_d[i] = m_planes[i].d;
+        }
 	}
 
-    bool Frustum::IsVisible(const Vector3& center, const Vector3& extent, bool ignore_near_plane /*= false*/) const
+    bool Frustum::IsVisible(const Vector3& center, const Vector3& extent, bool ignore_depth /*= false*/) const
     {
         float radius = 0.0f;
 
-        if (!ignore_near_plane)
+        if (!ignore_depth)
         {
             radius = Helper::Max3(extent.x, extent.y, extent.z);
         }
@@ -108,15 +120,53 @@ namespace Spartan::Math
         return false;
     }
 
-	Intersection Frustum::CheckCube(const Vector3& center, const Vector3& extent) const
+	Intersection Frustum::CheckCube(const Vector3& center, const Vector3& extent, const bool ignore_depth /*= false*/) const
 	{
+#if defined(FRUSTUM_SSE)
+        const __m128 center_x   = _mm_set1_ps(center.x);
+        const __m128 center_y   = _mm_set1_ps(center.y);
+        const __m128 center_z   = _mm_set1_ps(center.z);
+        const __m128 extent_x   = _mm_set1_ps(extent.x);
+        const __m128 extent_y   = _mm_set1_ps(extent.y);
+        const __m128 extent_z   = _mm_set1_ps(extent.z);
+        const __m128 sign       = _mm_set1_ps(-0.0f);
+        const __m128 zero       = _mm_setzero_ps();
+
+        // Four planes at a time, bit i of the masks is set when plane i rejects (or cuts through) the box
+        int mask_outside    = 0;
+        int mask_intersects = 0;
+        for (uint32_t i = 0; i < 8; i += 4)
+        {
+            const __m128 normal_x   = _mm_load_ps(&m_planes_x[i]);
+            const __m128 normal_y   = _mm_load_ps(&m_planes_y[i]);
+            const __m128 normal_z   = _mm_load_ps(&m_planes_z[i]);
+            const __m128 d          = _mm_load_ps(&m_planes_d[i]);
+
+            // Signed distance of the center and projected radius of the box
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normal_x, center_x), _mm_mul_ps(normal_y, center_y)), _mm_add_ps(_mm_mul_ps(normal_z, center_z), d));
+            const __m128 radius   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, normal_x), extent_x), _mm_mul_ps(_mm_andnot_ps(sign, normal_y), extent_y)), _mm_mul_ps(_mm_andnot_ps(sign, normal_z), extent_z));
+
+            mask_outside    |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero)) << i;
+            mask_intersects |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), zero)) << i;
+        }
+
+        // When ignoring depth, the near and far planes (the first two) don't count
+        const int mask_planes = ignore_depth ? 0b111100 : 0b111111;
+
+        if (mask_outside & mask_planes)
+            return Outside;
+
+        return (mask_intersects & mask_planes) ? Intersects : Inside;
+#else
         Intersection result = Inside;
         Plane plane_abs;
 
 		// Check if any one point of the cube is in the view frustum.
-		
-		for (const Plane& plane : m_planes)
+		// When ignoring depth, only the side planes are tested, the near and far planes come first.
+		for (uint32_t i = ignore_depth ? 2 : 0; i < 6; i++)
 		{
+            const Plane& plane = m_planes[i];
+
             plane_abs.normal    = plane.normal.Abs();
             plane_abs.d         = plane.d;
 
@@ -139,6 +189,7 @@ namespace Spartan::Math
 		}
 
 		return result;
+#endif
 	}
 
 	Intersection Frustum::CheckSphere(const Vector3& center, float radius) const
@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES =============
+#include <array>
 #include "../Math/Plane.h"
 #include "Matrix.h"
 #include "Vector3.h"
@@ -36,12 +37,23 @@ namespace Spartan::Math
         Frustum(const Matrix& mView, const Matrix& mProjection, float screenDepth);
 		~Frustum() = default;
 
-        bool IsVisible(const Vector3& center, const Vector3& extent, bool ignore_near_plane = false) const;
+        bool IsVisible(const Vector3& center, const Vector3& extent, bool ignore_depth = false) const;
+
+        // Classifies a box, when it's inside, anything it contains is inside as well (used for hierarchical culling).
+        // Ignoring depth skips both the near and the far plane, so shadow casters behind the light are kept.
+        Intersection IsInside(const Vector3& center, const Vector3& extent, bool ignore_depth = false) const { return CheckCube(center, extent, ignore_depth); }
 
 	private:
-        Intersection CheckCube(const Vector3& center, const Vector3& extent) const;
+        Intersection CheckCube(const Vector3& center, const Vector3& extent, bool ignore_depth = false) const;
         Intersection CheckSphere(const Vector3& center, float radius) const;
 
 		Plane m_planes[6];
+
+        // The same planes as a structure of arrays (padded with planes which contain everything),
+        // so that CheckCube() can test four of them with a single instruction
+        alignas(16) std::array<float, 8> m_planes_x = {};
+        alignas(16) std::array<float, 8> m_planes_y = {};
+        alignas(16) std::array<float, 8> m_planes_z = {};
+        alignas(16) std::array<float, 8> m_planes_d = {};
 	};
 }
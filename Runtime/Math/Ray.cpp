@@ -46,30 +46,25 @@ namespace Spartan::Math
 	{
 		// Find all the entities that the ray hits
 		vector<RayHit> hits;
-		const auto& entities = context->GetSubsystem<World>()->EntityGetAll();
-		for (const auto& entity : entities)
+		context->GetSubsystem<World>()->Each<Renderable>([this, &hits](Renderable* renderable)
 		{
-			// Make sure there entity has a renderable
-			if (!entity->HasComponent<Renderable>())
-				continue;
-
 			// Get object oriented bounding box
-			const auto& aabb = entity->GetComponent<Renderable>()->GetAabb();
+			const auto& aabb = renderable->GetAabb();
 
 			// Compute hit distance
 			auto distance = HitDistance(aabb);
 
 			// Don't store hit data if there was no hit
 			if (distance == INFINITY)
-				continue;
+				return;
 
 			hits.emplace_back(
-                entity,                             // Entity
-                m_start + distance * m_direction,   // Position
-                distance,                           // Distance
-                distance == 0.0f                    // Inside
+                renderable->GetEntity()->GetPtrShared(),    // Entity
+                m_start + distance * m_direction,           // Position
+                distance,                                   // Distance
+                distance == 0.0f                            // Inside
             );
-		}
+		});
 
 		// Sort by distance (ascending)
 		sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b)
@@ -41,6 +41,7 @@ namespace Spartan
         m_time_blocks_read.resize(m_time_block_capacity);
 		m_time_blocks_write.reserve(m_time_block_capacity);
 		m_time_blocks_write.resize(m_time_block_capacity);
+        m_thread_id = this_thread::get_id();
 	}
 
     Profiler::~Profiler()
@@ -73,12 +74,12 @@ namespace Spartan
         {
             OnFrameEnd();
 
-            const uint32_t new_size = m_time_block_count + 100;
+            const uint32_t new_size = static_cast<uint32_t>(m_time_blocks_write.size()) + 100;
             m_time_blocks_read.reserve(new_size);
             m_time_blocks_read.resize(new_size);
             m_time_blocks_write.reserve(new_size);
             m_time_blocks_write.resize(new_size);
-            LOG_WARNING("Time block list has grown to fit %d commands. Consider making the capacity larger to avoid re-allocations.", m_time_block_count + 1);
+            LOG_WARNING("Time block list has grown to fit %d commands. Consider making the capacity larger to avoid re-allocations.", new_size);
             m_increase_capacity = false;
             m_profile = true;
         }
@@ -123,8 +124,10 @@ namespace Spartan
     void Profiler::OnFrameEnd()
     {
         // Clear time blocks
+        uint32_t time_block_count_main = 0;
         {
             uint32_t pass_index_gpu = 0;
+            m_time_block_count_read = 0;
 
             for (uint32_t i = 0; i < m_time_block_count; i++)
             {
@@ -132,15 +135,7 @@ namespace Spartan
 
                 if (time_block.IsComplete())
                 {
-                    // Must not happen when TimeBlockEnd() ends as D3D11 waits
-                    // too much for the results to be ready, which increases CPU time.
-                    time_block.ComputeDuration(pass_index_gpu);
-                    if (time_block.GetType() == TimeBlock_Gpu)
-                    {
-                        pass_index_gpu += 2;
-                    }
-
-                    m_time_blocks_read[i] = time_block;
+                    MergeTimeBlock(time_block, pass_index_gpu);
                 }
                 else
                 {
@@ -150,7 +145,35 @@ namespace Spartan
                 time_block.Reset();
             }
 
-            m_time_block_count = 0;
+            m_time_block_count      = 0;
+            time_block_count_main   = m_time_block_count_read;
+        }
+
+        // Merge the time blocks of the other threads
+        {
+            lock_guard<mutex> lock(m_time_blocks_threads_mutex);
+
+            for (auto& it : m_time_blocks_threads)
+            {
+                ThreadTimeBlocks& thread = it.second;
+
+                // A thread which records commands (e.g. a pipelined renderer) starts its command list
+                uint32_t pass_index_gpu = 0;
+                for (uint32_t i = 0; i < thread.count_ready; i++)
+                {
+                    MergeTimeBlock(thread.ready[i], pass_index_gpu);
+                    thread.ready[i].Reset();
+                }
+                thread.count_ready = 0;
+
+                // Hand over what the thread recorded since, unless it's in the middle of a block (the parents have to stay put)
+                if (thread.open == 0)
+                {
+                    thread.write.swap(thread.ready);
+                    thread.count_ready = thread.count_write;
+                    thread.count_write = 0;
+                }
+            }
         }
 
         // Detect stutters
@@ -166,12 +189,14 @@ namespace Spartan
             m_time_cpu_last         = 0.0f;
             m_time_gpu_last         = 0.0f;
 
-            for (const TimeBlock& time_block : m_time_blocks_read)
+            for (uint32_t i = 0; i < m_time_block_count_read; i++)
             {
+                const TimeBlock& time_block = m_time_blocks_read[i];
                 if (!time_block.IsComplete())
                     continue;
 
-                if (!time_block.GetParent() && time_block.GetType() == TimeBlock_Cpu)
+                // The other threads run alongside the profiling one, their time is not added to the frame's
+                if (!time_block.GetParent() && time_block.GetType() == TimeBlock_Cpu && i < time_block_count_main)
                 {
                     m_time_cpu_last += time_block.GetDuration();
                 }
@@ -200,19 +225,41 @@ namespace Spartan
         }
     }
 
+    // Last incomplete block of the same type, is the parent
+    static TimeBlock* get_last_incomplete_time_block(vector<TimeBlock>& time_blocks, const uint32_t count, const TimeBlock_Type type = TimeBlock_Undefined)
+    {
+        for (int i = count - 1; i >= 0; i--)
+        {
+            TimeBlock& time_block = time_blocks[i];
+
+            if (type == time_block.GetType() || type == TimeBlock_Undefined)
+            {
+                if (!time_block.IsComplete())
+                    return &time_block;
+            }
+        }
+
+        return nullptr;
+    }
+
     void Profiler::TimeBlockStart(const char* func_name, TimeBlock_Type type, RHI_CommandList* cmd_list /*= nullptr*/)
 	{
-		if (!m_profile)
-			return;
-
         const bool can_profile_cpu = (type == TimeBlock_Cpu) && m_profile_cpu_enabled;
         const bool can_profile_gpu = (type == TimeBlock_Gpu) && m_profile_gpu_enabled;
 
+        if (!IsProfilingThread())
+        {
+            TimeBlockStartThread(func_name, type, cmd_list, m_profile && (can_profile_cpu || can_profile_gpu));
+            return;
+        }
+
+		if (!m_profile)
+			return;
+
 		if (!can_profile_cpu && !can_profile_gpu)
 			return;
 
-        // Last incomplete block of the same type, is the parent
-        TimeBlock* time_block_parent = GetLastIncompleteTimeBlock(type);
+        TimeBlock* time_block_parent = get_last_incomplete_time_block(m_time_blocks_write, m_time_block_count, type);
 
 		if (TimeBlock* time_block = GetNewTimeBlock())
 		{
@@ -222,16 +269,82 @@ namespace Spartan
 
 	void Profiler::TimeBlockEnd()
 	{
+        if (!IsProfilingThread())
+        {
+            TimeBlockEndThread();
+            return;
+        }
+
         // If the capacity 
         if (m_increase_capacity)
             return;
 
-		if (TimeBlock* time_block = GetLastIncompleteTimeBlock())
+		if (TimeBlock* time_block = get_last_incomplete_time_block(m_time_blocks_write, m_time_block_count))
 		{
 			time_block->End();
 		}
 	}
 
+    void Profiler::TimeBlockStartThread(const char* func_name, TimeBlock_Type type, RHI_CommandList* cmd_list, const bool record)
+    {
+        lock_guard<mutex> lock(m_time_blocks_threads_mutex);
+
+        ThreadTimeBlocks& thread = m_time_blocks_threads[this_thread::get_id()];
+        if (thread.write.empty())
+        {
+            // Fixed capacity, so the parents stay put
+            thread.write.resize(m_time_block_capacity);
+            thread.ready.resize(m_time_block_capacity);
+        }
+
+        if (!record || thread.count_write >= static_cast<uint32_t>(thread.write.size()))
+        {
+            thread.stack.emplace_back(nullptr);
+            return;
+        }
+
+        TimeBlock* time_block_parent    = get_last_incomplete_time_block(thread.write, thread.count_write, type);
+        TimeBlock* time_block           = &thread.write[thread.count_write++];
+        time_block->Begin(func_name, type, time_block_parent, cmd_list, m_renderer->GetRhiDevice());
+        thread.stack.emplace_back(time_block);
+        thread.open++;
+    }
+
+    void Profiler::TimeBlockEndThread()
+    {
+        lock_guard<mutex> lock(m_time_blocks_threads_mutex);
+
+        ThreadTimeBlocks& thread = m_time_blocks_threads[this_thread::get_id()];
+        if (thread.stack.empty())
+            return;
+
+        if (TimeBlock* time_block = thread.stack.back())
+        {
+            time_block->End();
+            thread.open--;
+        }
+        thread.stack.pop_back();
+    }
+
+    void Profiler::MergeTimeBlock(TimeBlock& time_block, uint32_t& pass_index_gpu)
+    {
+        // Must not happen when TimeBlockEnd() ends as D3D11 waits
+        // too much for the results to be ready, which increases CPU time.
+        time_block.ComputeDuration(pass_index_gpu);
+        if (time_block.GetType() == TimeBlock_Gpu)
+        {
+            pass_index_gpu += 2;
+        }
+
+        // The other threads can add up to more than the capacity
+        if (m_time_block_count_read == static_cast<uint32_t>(m_time_blocks_read.size()))
+        {
+            m_time_blocks_read.emplace_back();
+        }
+
+        m_time_blocks_read[m_time_block_count_read++] = time_block;
+    }
+
     void Profiler::ResetMetrics()
     {
         m_time_frame_avg    = 0.0f;
@@ -261,22 +374,6 @@ namespace Spartan
 		return &m_time_blocks_write[m_time_block_count++];
 	}
 
-	TimeBlock* Profiler::GetLastIncompleteTimeBlock(TimeBlock_Type type /*= TimeBlock_Undefined*/)
-	{
-		for (int i = m_time_block_count - 1; i >= 0; i--)
-		{
-			TimeBlock& time_block = m_time_blocks_write[i];
-
-            if (type == time_block.GetType() || type == TimeBlock_Undefined)
-            {
-                if (!time_block.IsComplete())
-                    return &time_block;
-            }
-		}
-
-		return nullptr;
-	}
-
 	void Profiler::ComputeFps(const float delta_time)
 	{
 		m_frames_since_last_fps_computation++;
@@ -337,6 +434,7 @@ namespace Spartan
             "Index buffer bindings:\t\t%d\n"
             "Vertex buffer bindings:\t\t%d\n"
             "Constant buffer bindings:\t%d\n"
+            "Structured buffer bindings:\t%d\n"
             "Sampler bindings:\t\t\t%d\n"
             "Texture bindings:\t\t\t%d\n"
             "Vertex shader bindings:\t%d\n"
@@ -375,6 +473,7 @@ namespace Spartan
 			m_rhi_bindings_buffer_index,
 			m_rhi_bindings_buffer_vertex,
 			m_rhi_bindings_buffer_constant,
+            m_rhi_bindings_buffer_structured,
 			m_rhi_bindings_sampler,
 			m_rhi_bindings_texture,
 			m_rhi_bindings_shader_vertex,
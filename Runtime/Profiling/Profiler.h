@@ -24,6 +24,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===========================
 #include <string>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
 #include "TimeBlock.h"
 #include "../Core/ISubsystem.h"
 #include "../Core/Stopwatch.h"
@@ -64,6 +68,7 @@ namespace Spartan
 		void SetProfilingEnabledGpu(const bool enabled)	{ m_profile_gpu_enabled = enabled; }
 		const std::string& GetMetrics()                 const { return m_metrics; }
 		const auto& GetTimeBlocks()                     const { return m_time_blocks_read; }
+        uint32_t GetTimeBlockCount()                    const { return m_time_block_count_read; }
 		float GetTimeCpuLast()                          const { return m_time_cpu_last; }
 		float GetTimeGpuLast()                          const { return m_time_gpu_last; }
 		float GetTimeFrameLast()                        const { return m_time_frame_last; }
@@ -81,6 +86,7 @@ namespace Spartan
 		uint32_t m_rhi_bindings_buffer_index	= 0;
 		uint32_t m_rhi_bindings_buffer_vertex	= 0;
 		uint32_t m_rhi_bindings_buffer_constant = 0;
+        uint32_t m_rhi_bindings_buffer_structured = 0;
 		uint32_t m_rhi_bindings_sampler			= 0;
 		uint32_t m_rhi_bindings_texture			= 0;
 		uint32_t m_rhi_bindings_shader_vertex	= 0;
@@ -116,6 +122,7 @@ namespace Spartan
             m_rhi_bindings_buffer_index     = 0;
             m_rhi_bindings_buffer_vertex    = 0;
             m_rhi_bindings_buffer_constant  = 0;
+            m_rhi_bindings_buffer_structured = 0;
             m_rhi_bindings_sampler          = 0;
             m_rhi_bindings_texture          = 0;
             m_rhi_bindings_shader_vertex    = 0;
@@ -127,8 +134,22 @@ namespace Spartan
             m_rhi_pipeline_barriers         = 0;
         }
 
+        // Time blocks nest, so threads other than the one which created the profiler record theirs separately
+        struct ThreadTimeBlocks
+        {
+            std::vector<TimeBlock> write;
+            std::vector<TimeBlock> ready;       // handed over at the last frame end, merged at the next one (by then their command lists have been submitted)
+            uint32_t count_write    = 0;
+            uint32_t count_ready    = 0;
+            uint32_t open           = 0;        // blocks which have started but not ended
+            std::vector<TimeBlock*> stack;      // started blocks, null for the ones which were not recorded (so their ends can be ignored)
+        };
+
+		bool IsProfilingThread() const { return std::this_thread::get_id() == m_thread_id; }
 		TimeBlock* GetNewTimeBlock();
-		TimeBlock* GetLastIncompleteTimeBlock(TimeBlock_Type type = TimeBlock_Undefined);
+        void TimeBlockStartThread(const char* func_name, TimeBlock_Type type, RHI_CommandList* cmd_list, bool record);
+        void TimeBlockEndThread();
+        void MergeTimeBlock(TimeBlock& time_block, uint32_t& pass_index_gpu);
 		void ComputeFps(float delta_time);
         void AcquireGpuData();
 		void UpdateRhiMetricsString();
@@ -142,8 +163,11 @@ namespace Spartan
 		// Time blocks (double buffered)
 		uint32_t m_time_block_capacity	= 200;
 		uint32_t m_time_block_count		= 0;
+        uint32_t m_time_block_count_read = 0;
 		std::vector<TimeBlock> m_time_blocks_write;
-        std::vector<TimeBlock> m_time_blocks_read;
+        std::vector<TimeBlock> m_time_blocks_read;  // all the threads, the profiling one first
+        std::unordered_map<std::thread::id, ThreadTimeBlocks> m_time_blocks_threads;
+        std::mutex m_time_blocks_threads_mutex;
 
 		// FPS
         float m_delta_time      = 0.0f;
@@ -165,9 +189,10 @@ namespace Spartan
 
 		// Misc
 		std::string m_metrics = "N/A";
-		bool m_profile = true;
+		std::atomic<bool> m_profile = { true };
         bool m_increase_capacity = 0.0f;
         bool m_allow_time_block_end = true;
+        std::thread::id m_thread_id;
 	
 		// Dependencies
 		ResourceCache* m_resource_manager	= nullptr;
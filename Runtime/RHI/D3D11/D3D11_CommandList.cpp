@@ -29,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Texture.h"
 #include "../RHI_Shader.h"
 #include "../RHI_ConstantBuffer.h"
+#include "../RHI_StructuredBuffer.h"
 #include "../RHI_VertexBuffer.h"
 #include "../RHI_IndexBuffer.h"
 #include "../RHI_BlendState.h"
@@ -413,6 +414,23 @@ namespace Spartan
         return true;
 	}
 
+    bool RHI_CommandList::DrawIndexedInstanced(const uint32_t index_count, const uint32_t instance_count, const uint32_t index_offset, const uint32_t vertex_offset)
+    {
+        // The start instance is always zero, shaders offset into their instance data themselves (SV_InstanceID doesn't include it)
+        m_rhi_device->GetContextRhi()->device_context->DrawIndexedInstanced
+        (
+            static_cast<UINT>(index_count),
+            static_cast<UINT>(instance_count),
+            static_cast<UINT>(index_offset),
+            static_cast<INT>(vertex_offset),
+            0
+        );
+
+        m_profiler->m_rhi_draw_calls++;
+
+        return true;
+    }
+
     void RHI_CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z /*= 1*/) const
     {
         ID3D11Device5* device                   = m_rhi_device->GetContextRhi()->device;
@@ -559,6 +577,50 @@ namespace Spartan
         return true;
     }
 
+    void RHI_CommandList::SetStructuredBuffer(const uint32_t slot, const uint8_t scope, RHI_StructuredBuffer* structured_buffer) const
+    {
+        void* resource_view                 = structured_buffer ? structured_buffer->GetResourceView() : nullptr;
+        const void* resource_array[1]       = { resource_view };
+        const UINT range                    = 1;
+        ID3D11DeviceContext* device_context = m_rhi_device->GetContextRhi()->device_context;
+
+        if (scope & RHI_Shader_Vertex)
+        {
+            // Set only if not set
+            ID3D11ShaderResourceView* set_view = nullptr;
+            device_context->VSGetShaderResources(slot, range, &set_view);
+            if (set_view != resource_view)
+            {
+                device_context->VSSetShaderResources(slot, range, reinterpret_cast<ID3D11ShaderResourceView* const*>(&resource_array));
+                m_profiler->m_rhi_bindings_buffer_structured++;
+            }
+        }
+
+        if (scope & RHI_Shader_Pixel)
+        {
+            // Set only if not set
+            ID3D11ShaderResourceView* set_view = nullptr;
+            device_context->PSGetShaderResources(slot, range, &set_view);
+            if (set_view != resource_view)
+            {
+                device_context->PSSetShaderResources(slot, range, reinterpret_cast<ID3D11ShaderResourceView* const*>(&resource_array));
+                m_profiler->m_rhi_bindings_buffer_structured++;
+            }
+        }
+
+        if (scope & RHI_Shader_Compute)
+        {
+            // Set only if not set
+            ID3D11ShaderResourceView* set_view = nullptr;
+            device_context->CSGetShaderResources(slot, range, &set_view);
+            if (set_view != resource_view)
+            {
+                device_context->CSSetShaderResources(slot, range, reinterpret_cast<ID3D11ShaderResourceView* const*>(&resource_array));
+                m_profiler->m_rhi_bindings_buffer_structured++;
+            }
+        }
+    }
+
     void RHI_CommandList::SetSampler(const uint32_t slot, RHI_Sampler* sampler) const
     {
         const UINT start_slot               = slot;
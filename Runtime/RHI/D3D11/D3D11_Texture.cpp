@@ -98,6 +98,7 @@ namespace Spartan
 		const uint32_t bits_per_channel,
 		const uint32_t array_size,
 		const DXGI_FORMAT format,
+		const uint32_t block_size,
 		const UINT bind_flags,
 		vector<vector<std::byte>>& data,
 		const shared_ptr<RHI_Device>& rhi_device
@@ -129,7 +130,8 @@ namespace Spartan
 
 			auto& subresource_data				= vec_subresource_data.emplace_back(D3D11_SUBRESOURCE_DATA{});
 			subresource_data.pSysMem			= data[mip_level].data();					                // Data pointer		
-			subresource_data.SysMemPitch		= (width >> mip_level) * channels * (bits_per_channel / 8);	// Line width in bytes
+			const uint32_t mip_width			= Math::Helper::Max(width >> mip_level, 1u);
+			subresource_data.SysMemPitch		= block_size ? ((mip_width + 3) / 4) * block_size : mip_width * channels * (bits_per_channel / 8);	// Line width in bytes, a line of blocks for compressed formats
 			subresource_data.SysMemSlicePitch	= 0;								                        // This is only used for 3D textures
 		}
 
@@ -237,6 +239,12 @@ namespace Spartan
 
     RHI_Texture2D::~RHI_Texture2D()
     {
+        RHI_Texture2D::DestroyResourceGpu();
+    }
+
+    void RHI_Texture2D::DestroyResourceGpu(const bool deferred /*= false*/)
+    {
+        // The driver keeps the resources alive for as long as queued work references them, so there is nothing to defer
         d3d11_utility::release(*reinterpret_cast<ID3D11ShaderResourceView**>(&m_resource_view[0]));
         d3d11_utility::release(*reinterpret_cast<ID3D11UnorderedAccessView**>(&m_resource_view_unorderedAccess));
         d3d11_utility::release(*reinterpret_cast<ID3D11Texture2D**>(&m_resource));
@@ -285,12 +293,13 @@ namespace Spartan
 		result_tex = CreateTexture2d
 		(
             m_resource,
-			m_width,
-			m_height,
+			GetWidthResident(),
+			GetHeightResident(),
 			m_channel_count,
 			m_bits_per_channel,
 			m_array_size,
 			format,
+			GetBlockSize(m_format),
 			flags,
 			m_data,
 			m_rhi_device
@@ -45,6 +45,7 @@ namespace Spartan
 	class RHI_VertexBuffer;
 	class RHI_IndexBuffer;
 	class RHI_ConstantBuffer;
+	class RHI_StructuredBuffer;
 	class RHI_Sampler;
 	class RHI_Viewport;
 	class RHI_Texture;
@@ -194,6 +195,12 @@ namespace Spartan
         // DEPTH
         RHI_Format_D32_Float,
         RHI_Format_D32_Float_S8X24_Uint,
+        // BLOCK COMPRESSED
+        RHI_Format_BC1_Unorm,
+        RHI_Format_BC3_Unorm,
+        RHI_Format_BC4_Unorm,
+        RHI_Format_BC5_Unorm,
+        RHI_Format_BC7_Unorm,
 
         RHI_Format_Undefined
 	};
@@ -234,6 +241,7 @@ namespace Spartan
 		RHI_Descriptor_Texture,
 		RHI_Descriptor_ConstantBuffer,
         RHI_Descriptor_ConstantBufferDynamic,
+        RHI_Descriptor_StructuredBuffer,
         RHI_Descriptor_Undefined
 	};
 
@@ -295,6 +303,11 @@ namespace Spartan
             case RHI_Format_R32G32B32A32_Float:	    return "RHI_Format_R32G32B32A32_Float";
             case RHI_Format_D32_Float:	            return "RHI_Format_D32_Float";
             case RHI_Format_D32_Float_S8X24_Uint:	return "RHI_Format_D32_Float_S8X24_Uint";
+            case RHI_Format_BC1_Unorm:	            return "RHI_Format_BC1_Unorm";
+            case RHI_Format_BC3_Unorm:	            return "RHI_Format_BC3_Unorm";
+            case RHI_Format_BC4_Unorm:	            return "RHI_Format_BC4_Unorm";
+            case RHI_Format_BC5_Unorm:	            return "RHI_Format_BC5_Unorm";
+            case RHI_Format_BC7_Unorm:	            return "RHI_Format_BC7_Unorm";
             case RHI_Format_Undefined:              return "RHI_Format_Undefined";
         }
 
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "RHI_DescriptorSetLayout.h"
 #include "RHI_ConstantBuffer.h"
+#include "RHI_StructuredBuffer.h"
 #include "RHI_Sampler.h"
 #include "RHI_Texture.h"
 #include "RHI_Implementation.h"
@@ -125,6 +126,27 @@ namespace Spartan
         }
     }
 
+    void RHI_DescriptorSetLayout::SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer)
+    {
+        for (RHI_Descriptor& descriptor : m_descriptors)
+        {
+            // Structured buffers are bound to t registers, so they share the texture shift
+            if (descriptor.type == RHI_Descriptor_StructuredBuffer && descriptor.slot == slot + m_rhi_device->GetContextRhi()->shader_shift_texture)
+            {
+                // Determine if the descriptor set needs to bind
+                m_needs_to_bind = descriptor.resource   != structured_buffer->GetResource() ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+                m_needs_to_bind = descriptor.range      != structured_buffer->GetSizeGpu()  ? true : m_needs_to_bind; // affects vkUpdateDescriptorSets
+
+                // Update
+                descriptor.resource = structured_buffer->GetResource();
+                descriptor.offset   = 0;
+                descriptor.range    = structured_buffer->GetSizeGpu();
+
+                break;
+            }
+        }
+    }
+
     bool RHI_DescriptorSetLayout::GetResource_DescriptorSet(RHI_DescriptorCache* descriptor_cache, void*& descriptor_set)
     {
         // Get the hash of the current state of the descriptors
@@ -153,4 +153,36 @@ namespace Spartan
 
         return 0;
     }
+
+    void RHI_Device::ReleaseDeferred(function<void()>&& release)
+    {
+        lock_guard<mutex> lock(m_release_mutex);
+        m_release_queue.emplace_back(m_release_frame, move(release));
+    }
+
+    void RHI_Device::ReleaseRetired(const uint64_t frame, const uint32_t frames_in_flight)
+    {
+        // Take out what the GPU is done with, and run it without holding the lock (a release may queue another)
+        vector<function<void()>> retired;
+        {
+            lock_guard<mutex> lock(m_release_mutex);
+            m_release_frame = frame;
+
+            auto it = partition(m_release_queue.begin(), m_release_queue.end(), [frame, frames_in_flight](const pair<uint64_t, function<void()>>& entry)
+            {
+                return entry.first + frames_in_flight > frame;
+            });
+
+            for (auto it_retired = it; it_retired != m_release_queue.end(); it_retired++)
+            {
+                retired.emplace_back(move(it_retired->second));
+            }
+            m_release_queue.erase(it, m_release_queue.end());
+        }
+
+        for (function<void()>& release : retired)
+        {
+            release();
+        }
+    }
 }
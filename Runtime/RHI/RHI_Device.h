@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Core/Spartan_Object.h"
 #include <mutex>
 #include <memory>
+#include <functional>
 #include "RHI_DisplayMode.h"
 #include "RHI_PhysicalDevice.h"
 //=================================
@@ -58,6 +59,10 @@ namespace Spartan
         void* Queue_Get(const RHI_Queue_Type type) const;
         uint32_t Queue_Index(const RHI_Queue_Type type) const;
 
+        // Deferred release, for resources which the frames in flight might still be reading
+        void ReleaseDeferred(std::function<void()>&& release);
+        void ReleaseRetired(uint64_t frame, uint32_t frames_in_flight);
+
         // Misc
 		auto IsInitialized()                const { return m_initialized; }
         RHI_Context* GetContextRhi()	    const { return m_rhi_context.get(); }
@@ -72,6 +77,9 @@ namespace Spartan
         uint32_t m_enabled_graphics_shader_stages   = 0;
         bool m_initialized                          = false;
         mutable std::mutex m_queue_mutex;
+        std::mutex m_release_mutex;
+        std::vector<std::pair<uint64_t, std::function<void()>>> m_release_queue; // frame it was queued on, release
+        uint64_t m_release_frame = 0;
         std::shared_ptr<RHI_Context> m_rhi_context;
 	};
 }
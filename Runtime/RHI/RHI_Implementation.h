@@ -76,6 +76,12 @@ static const DXGI_FORMAT d3d11_format[] =
     // Depth
     DXGI_FORMAT_D32_FLOAT,
     DXGI_FORMAT_D32_FLOAT_S8X24_UINT,
+    // Block compressed
+    DXGI_FORMAT_BC1_UNORM,
+    DXGI_FORMAT_BC3_UNORM,
+    DXGI_FORMAT_BC4_UNORM,
+    DXGI_FORMAT_BC5_UNORM,
+    DXGI_FORMAT_BC7_UNORM,
 
     DXGI_FORMAT_UNKNOWN
 };
@@ -206,6 +212,12 @@ static const VkFormat vulkan_format[] =
     // DEPTH
     VK_FORMAT_D32_SFLOAT,
     VK_FORMAT_D32_SFLOAT_S8_UINT,
+    // BLOCK COMPRESSED
+    VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+    VK_FORMAT_BC3_UNORM_BLOCK,
+    VK_FORMAT_BC4_UNORM_BLOCK,
+    VK_FORMAT_BC5_UNORM_BLOCK,
+    VK_FORMAT_BC7_UNORM_BLOCK,
 
     VK_FORMAT_MAX_ENUM
 };
@@ -291,6 +303,7 @@ static const VkDescriptorType vulkan_descriptor_type[] =
 	VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
 	VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
     VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
     VK_DESCRIPTOR_TYPE_MAX_ENUM
 };
 
@@ -399,6 +412,7 @@ namespace Spartan
         static const uint32_t descriptor_max_constant_buffers_dynamic   = 10;
         static const uint32_t descriptor_max_samplers                   = 10;
         static const uint32_t descriptor_max_textures                   = 10;
+        static const uint32_t descriptor_max_structured_buffers         = 10;
 
         // Device limits
         uint32_t max_texture_dimension_2d   = 16384;
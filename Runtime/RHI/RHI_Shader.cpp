@@ -227,6 +227,17 @@ namespace Spartan
                 shader_type                                                     // Stage
             );
 		}
+
+        // Get structured buffers
+        for (const auto& resource : resources.storage_buffers)
+        {
+            m_descriptors.emplace_back
+            (
+                RHI_Descriptor_Type::RHI_Descriptor_StructuredBuffer,           // Type
+                compiler.get_decoration(resource.id, spv::DecorationBinding),   // Slot
+                shader_type                                                     // Stage
+            );
+        }
 	}
 
     //= Explicit template instantiation =======================================================================
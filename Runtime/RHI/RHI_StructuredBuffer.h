@@ -0,0 +1,73 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <memory>
+#include "../Core/Spartan_Object.h"
+//=================================
+
+namespace Spartan
+{
+    // A read-only array of structures which shaders index into (e.g. per-instance data),
+    // written by the CPU every frame.
+	class SPARTAN_CLASS RHI_StructuredBuffer : public Spartan_Object
+	{
+	public:
+        RHI_StructuredBuffer(const std::shared_ptr<RHI_Device>& rhi_device, const std::string& name);
+        ~RHI_StructuredBuffer() { _destroy(); }
+
+		template<typename T>
+		bool Create(const uint32_t element_count)
+		{
+            m_stride        = static_cast<uint32_t>(sizeof(T));
+            m_element_count = element_count;
+            m_size_gpu      = static_cast<uint64_t>(m_stride) * static_cast<uint64_t>(m_element_count);
+
+            return _create();
+		}
+
+		void* Map();
+		bool Unmap();
+
+		void* GetResource()         const { return m_buffer; }
+        void* GetResourceView()     const { return m_resource_view; }
+        uint32_t GetStride()        const { return m_stride; }
+        uint32_t GetElementCount()  const { return m_element_count; }
+
+	private:
+		bool _create();
+        void _destroy();
+
+        void* m_mapped              = nullptr;
+        uint32_t m_stride           = 0;
+        uint32_t m_element_count    = 0;
+
+		// API
+		void* m_buffer          = nullptr;
+        void* m_resource_view   = nullptr; // only affects D3D11
+        void* m_allocation      = nullptr; // only affects Vulkan
+
+        // Dependencies
+        std::shared_ptr<RHI_Device> m_rhi_device;
+	};
+}
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Texture.h"
 #include "RHI_Device.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetContainer.h"
 #include "../Rendering/Renderer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/Import/ImageImporter.h"
@@ -35,6 +36,23 @@ using namespace std;
 
 namespace Spartan
 {
+	// Chunks of a texture file
+	static constexpr uint32_t chunk_properties	= AssetContainer::MakeType('T', 'P', 'R', 'P');
+	static constexpr uint32_t chunk_path		= AssetContainer::MakeType('P', 'A', 'T', 'H');
+	static constexpr uint32_t chunk_mip			= AssetContainer::MakeType('M', 'I', 'P', ' '); // one per mip, the index is the level
+
+	struct TextureProperties
+	{
+		uint32_t bits_per_channel;
+		uint32_t width;
+		uint32_t height;
+		uint32_t format;
+		uint32_t channel_count;
+		uint32_t flags;
+		uint32_t id;
+		uint32_t mip_count;
+	};
+
 	RHI_Texture::RHI_Texture(Context* context) : IResource(context, Resource_Texture)
 	{
 		m_rhi_device = context->GetSubsystem<Renderer>()->GetRhiDevice();
@@ -48,63 +66,56 @@ namespace Spartan
 
 	bool RHI_Texture::SaveToFile(const string& file_path)
 	{
-		// Check to see if the file already exists (if so, get the byte count)
-		uint32_t byte_count = 0;
+		// The bytes are freed once they are on the GPU, in that case the ones which are already in the file are kept
+		vector<vector<std::byte>> data_existing;
+		const vector<vector<std::byte>>* data = &m_data;
+		if (m_data.empty())
 		{
-			if (FileSystem::Exists(file_path))
+			// Without them (no file, or one in an older layout) the texture would be saved without any mips
+			AssetContainer container;
+			if (!FileSystem::Exists(file_path) || !container.Open(file_path))
 			{
-				auto file = make_unique<FileStream>(file_path, FileStream_Read);
-				if (file->IsOpen())
-				{
-					file->Read(&byte_count);
-				}
+				LOG_ERROR("The bytes of \"%s\" have been freed and \"%s\" can't be read back, it won't be saved", GetResourceFilePathNative().c_str(), file_path.c_str());
+				return false;
 			}
-		}
 
-		auto append = true;
-		auto file = make_unique<FileStream>(file_path, FileStream_Write | FileStream_Append);
-		if (!file->IsOpen())
-			return false;
+			while (container.ReadChunk(chunk_mip, static_cast<uint32_t>(data_existing.size()), &data_existing.emplace_back())) {}
+			data_existing.pop_back();
 
-		// If the existing file has a byte count but we 
-		// hold no data, don't overwrite the file's bytes.
-		if (byte_count != 0 && m_data.empty())
-		{
-			file->Skip
-			(
-				sizeof(uint32_t) +	// byte count
-				sizeof(uint32_t) +	// mipmap count
-				byte_count			// bytes
-			);
-		}
-		else
-		{
-			byte_count = GetByteCount();
-
-			// Write byte count
-			file->Write(byte_count);
-			// Write mipmap count
-			file->Write(static_cast<uint32_t>(m_data.size()));
-			// Write bytes
-			for (auto& mip : m_data)
+			if (static_cast<uint32_t>(data_existing.size()) != GetMipCount())
 			{
-				file->Write(mip);
+				LOG_ERROR("\"%s\" has %d mips instead of %d, it won't be saved", file_path.c_str(), static_cast<uint32_t>(data_existing.size()), GetMipCount());
+				return false;
 			}
 
-			// The bytes have been saved, so we can now free some memory
-			m_data.clear();
-			m_data.shrink_to_fit();
+			data = &data_existing;
 		}
 
-		// Write properties
-		file->Write(m_bits_per_channel);
-		file->Write(m_width);
-		file->Write(m_height);
-        file->Write(static_cast<uint32_t>(m_format));
-		file->Write(m_channel_count);
-		file->Write(m_flags);
-		file->Write(GetId());
-		file->Write(GetResourceFilePath());
+		TextureProperties properties;
+		properties.bits_per_channel	= m_bits_per_channel;
+		properties.width			= m_width;
+		properties.height			= m_height;
+		properties.format			= static_cast<uint32_t>(m_format);
+		properties.channel_count	= m_channel_count;
+		properties.flags			= m_flags;
+		properties.id				= GetId();
+		properties.mip_count		= static_cast<uint32_t>(data->size());
+		const string path			= GetResourceFilePath();
+
+		AssetContainer container;
+		container.AddChunk(chunk_properties, 0, &properties, sizeof(TextureProperties));
+		container.AddChunk(chunk_path, 0, path.data(), path.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(data->size()); i++)
+		{
+			container.AddChunk(chunk_mip, i, (*data)[i].data(), (*data)[i].size());
+		}
+
+		if (!container.Save(file_path))
+			return false;
+
+		// The bytes have been saved, so we can now free some memory
+		m_data.clear();
+		m_data.shrink_to_fit();
 
 		return true;
 	}
@@ -120,7 +131,9 @@ namespace Spartan
 
 		m_data.clear();
 		m_data.shrink_to_fit();
-		m_load_state = LoadState_Started;
+		m_mip_resident	= 0;
+		m_is_streamed	= false;
+		m_load_state	= LoadState_Started;
 
 		// Load from disk
 		auto texture_data_loaded = false;		
@@ -159,22 +172,87 @@ namespace Spartan
 		}
 		m_load_state = LoadState_Completed;
 
-        // Compute memory usage
+        ComputeMemoryUsage();
+
+		return true;
+	}
+
+    bool RHI_Texture::ReadMips(const uint32_t mip_top, vector<vector<std::byte>>& data) const
+    {
+        data.clear();
+
+        AssetContainer container;
+        if (!container.Open(GetResourceFilePathNative()))
+            return false;
+
+        data.resize(GetMipCount() - mip_top);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(data.size()); i++)
         {
-            m_size_cpu = 0;
-            m_size_gpu = 0;
-            for (uint8_t mip_index = 0; mip_index < m_mip_levels; mip_index++)
+            if (!container.ReadChunk(chunk_mip, mip_top + i, &data[i]))
             {
-                const uint32_t mip_width  = m_width >> mip_index;
-                const uint32_t mip_height = m_height >> mip_index;
-
-                m_size_cpu += mip_index < m_data.size() ? m_data[mip_index].size() * sizeof(std::byte) : 0;
-                m_size_gpu += mip_width * mip_height * (m_bits_per_channel / 8);
+                LOG_ERROR("\"%s\" is missing mip %d", GetResourceFilePathNative().c_str(), mip_top + i);
+                data.clear();
+                return false;
             }
         }
 
-		return true;
-	}
+        return true;
+    }
+
+    bool RHI_Texture::StreamMips(const uint32_t mip_top, vector<vector<std::byte>>& data)
+    {
+        if (!m_is_streamed || mip_top + static_cast<uint32_t>(data.size()) != GetMipCount() || mip_top > GetMipTail())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        if (mip_top == m_mip_resident)
+            return true;
+
+        // The GPU resource can't change its size, so it's created again with the new top mip
+        // The old one is released once the frames in flight are done with it, so streaming never stalls on the GPU
+        const uint32_t mip_resident = m_mip_resident;
+        DestroyResourceGpu(true);
+        m_data.swap(data);
+        m_mip_resident  = mip_top;
+        m_mip_levels    = static_cast<uint32_t>(m_data.size());
+        const bool result = CreateResourceGpu();
+        m_data.clear();
+        m_data.shrink_to_fit();
+
+        if (!result)
+        {
+            LOG_ERROR("Failed to stream \"%s\" from mip %d to mip %d", GetResourceFilePathNative().c_str(), mip_resident, mip_top);
+            m_load_state = LoadState_Failed;
+        }
+
+        ComputeMemoryUsage();
+
+        return result;
+    }
+
+    uint32_t RHI_Texture::GetMipTail(const uint32_t mip_count) const
+    {
+        uint32_t mip = 0;
+        while (mip + 1 < mip_count && Math::Helper::Max(m_width, m_height) >> mip > mip_tail_size)
+        {
+            mip++;
+        }
+
+        return mip;
+    }
+
+    void RHI_Texture::ComputeMemoryUsage()
+    {
+        m_size_cpu = 0;
+        m_size_gpu = 0;
+        for (uint32_t mip_index = 0; mip_index < m_mip_levels; mip_index++)
+        {
+            m_size_cpu += mip_index < m_data.size() ? m_data[mip_index].size() * sizeof(std::byte) : 0;
+            m_size_gpu += GetMipSize(m_mip_resident + mip_index);
+        }
+    }
 
 	vector<std::byte>* RHI_Texture::GetData(const uint32_t index)
 	{
@@ -196,31 +274,17 @@ namespace Spartan
         {
             data = m_data[index];
         }
-        // Else attempt to load the data
+        // Else attempt to load the data, only the chunk of the requested mip is read
         else
         {
-            auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read);
-            if (file->IsOpen())
+            AssetContainer container;
+            if (!container.Open(GetResourceFilePathNative()))
             {
-                auto byte_count = file->ReadAs<uint32_t>();
-                const auto mip_count  = file->ReadAs<uint32_t>();
-
-                if (index < mip_count)
-                {
-                    for (uint32_t i = 0; i <= index; i++)
-                    {
-                        file->Read(&data);
-                    }
-                }
-                else
-                {
-                    LOG_ERROR("Invalid index");
-                }
-                file->Close();
+                LOG_ERROR("Unable to retreive data");
             }
-            else
+            else if (!container.ReadChunk(chunk_mip, index, &data))
             {
-                LOG_ERROR("Unable to retreive data");
+                LOG_ERROR("Invalid index");
             }
         }
 
@@ -242,34 +306,52 @@ namespace Spartan
 
 	bool RHI_Texture::LoadFromFile_NativeFormat(const string& file_path)
 	{
-		auto file = make_unique<FileStream>(file_path, FileStream_Read);
-		if (!file->IsOpen())
+		AssetContainer container;
+		if (!container.Open(file_path))
 			return false;
 
 		m_data.clear();
 		m_data.shrink_to_fit();
 
-		// Read byte and mipmap count
-		auto byte_count = file->ReadAs<uint32_t>();
-        const auto mip_count  = file->ReadAs<uint32_t>();
+		// Read properties
+		const AssetContainer::Chunk* chunk_properties_info = container.FindChunk(chunk_properties);
+		const std::byte* properties_data = chunk_properties_info && chunk_properties_info->size == sizeof(TextureProperties) ? container.GetChunkData(*chunk_properties_info) : nullptr;
+		if (!properties_data)
+		{
+			LOG_ERROR("\"%s\" has no valid properties", file_path.c_str());
+			return false;
+		}
+
+		TextureProperties properties;
+		memcpy(&properties, properties_data, sizeof(TextureProperties));
+		m_bits_per_channel	= properties.bits_per_channel;
+		m_width				= properties.width;
+		m_height			= properties.height;
+		m_format			= static_cast<RHI_Format>(properties.format);
+		m_channel_count		= properties.channel_count;
+		m_flags				= static_cast<uint16_t>(properties.flags);
+		SetId(properties.id);
+
+		vector<std::byte> path;
+		container.ReadChunk(chunk_path, 0, &path);
+		SetResourceFilePath(string(reinterpret_cast<const char*>(path.data()), path.size()));
+
+		// Streamable textures start with their tail mips only, the rest are read when something on the screen needs them (see TextureStreamer)
+		m_is_streamed	= (m_flags & RHI_Texture_Streamable) && m_resource_type == Resource_Texture2d && m_context->GetSubsystem<Renderer>()->GetOption(Render_TextureStreaming);
+		m_mip_resident	= m_is_streamed ? GetMipTail(properties.mip_count) : 0;
+		m_is_streamed	= m_mip_resident != 0;
 
 		// Read bytes
-		m_data.resize(mip_count);
-		for (auto& mip : m_data)
+		m_data.resize(properties.mip_count - m_mip_resident);
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_data.size()); i++)
 		{
-			file->Read(&mip);
+			if (!container.ReadChunk(chunk_mip, m_mip_resident + i, &m_data[i]))
+			{
+				LOG_ERROR("\"%s\" is missing mip %d", file_path.c_str(), m_mip_resident + i);
+				return false;
+			}
 		}
 
-		// Read properties
-		file->Read(&m_bits_per_channel);
-		file->Read(&m_width);
-		file->Read(&m_height);
-        file->Read(reinterpret_cast<uint32_t*>(&m_format));
-		file->Read(&m_channel_count);
-		file->Read(&m_flags);
-		SetId(file->ReadAs<uint32_t>());
-		SetResourceFilePath(file->ReadAs<string>());
-
 		return true;
 	}
 
@@ -291,10 +373,40 @@ namespace Spartan
 			case RHI_Format_R32G32B32A32_Float:	    return 4;
             case RHI_Format_D32_Float:			    return 1;
             case RHI_Format_D32_Float_S8X24_Uint:   return 2;
+            case RHI_Format_BC1_Unorm:              return 4;
+            case RHI_Format_BC3_Unorm:              return 4;
+            case RHI_Format_BC4_Unorm:              return 1;
+            case RHI_Format_BC5_Unorm:              return 2;
+            case RHI_Format_BC7_Unorm:              return 4;
 			default:						        return 0;
 		}
 	}
 
+    uint32_t RHI_Texture::GetBlockSize(const RHI_Format format)
+    {
+        switch (format)
+        {
+            case RHI_Format_BC1_Unorm:  return 8;
+            case RHI_Format_BC3_Unorm:  return 16;
+            case RHI_Format_BC4_Unorm:  return 8;
+            case RHI_Format_BC5_Unorm:  return 16;
+            case RHI_Format_BC7_Unorm:  return 16;
+            default:                    return 0;
+        }
+    }
+
+    uint64_t RHI_Texture::GetMipSize(const uint32_t mip_index) const
+    {
+        const uint64_t mip_width  = Math::Helper::Max(m_width >> mip_index, 1u);
+        const uint64_t mip_height = Math::Helper::Max(m_height >> mip_index, 1u);
+
+        // Compressed formats store whole blocks, even for mips which are smaller than a block
+        if (const uint32_t block_size = GetBlockSize(m_format))
+            return ((mip_width + 3) / 4) * ((mip_height + 3) / 4) * block_size;
+
+        return mip_width * mip_height * GetBytesPerPixel();
+    }
+
 	uint32_t RHI_Texture::GetByteCount()
 	{
 		uint32_t byte_count = 0;
@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Viewport.h"
 #include "RHI_Definition.h"
 #include "../Resource/IResource.h"
+#include "../Math/MathHelper.h"
 //================================
 
 namespace Spartan
@@ -40,7 +41,11 @@ namespace Spartan
         RHI_Texture_DepthStencilViewReadOnly    = 1 << 4,
         RHI_Texture_Grayscale                   = 1 << 5,
         RHI_Texture_Transparent                 = 1 << 6,
-        RHI_Texture_GenerateMipsWhenLoading     = 1 << 7
+        RHI_Texture_GenerateMipsWhenLoading     = 1 << 7,
+        RHI_Texture_CompressWhenLoading         = 1 << 8,
+        RHI_Texture_NormalMap                   = 1 << 9,   // Only xy is stored when compressed, z is reconstructed
+        RHI_Texture_SingleChannel               = 1 << 10,  // Only r is stored when compressed
+        RHI_Texture_Streamable                  = 1 << 11   // Only the tail mips are loaded from an engine texture file, the rest are streamed on demand
 	};
 
     enum RHI_Shader_View_Type : uint8_t
@@ -77,6 +82,7 @@ namespace Spartan
 		void SetBitsPerChannel(const uint32_t bits)						{ m_bits_per_channel = bits; }
         uint32_t GetBytesPerChannel() const                             { return m_bits_per_channel / 8; }
         uint32_t GetBytesPerPixel() const                               { return (m_bits_per_channel / 8) * m_channel_count; }
+        uint64_t GetMipSize(uint32_t mip_index) const;
 
         uint32_t GetChannelCount() const								{ return m_channel_count; }
 		void SetChannelCount(const uint32_t channel_count)				{ m_channel_count = channel_count; }
@@ -94,6 +100,17 @@ namespace Spartan
         std::vector<std::byte>* GetData(uint32_t mipmap_index);
         std::vector<std::byte> GetMipmap(uint32_t index);
 
+        // Streaming, only the mips from GetMipResident() down are on the GPU (and the dimensions of the GPU resource are those of that mip)
+        bool IsStreamed()               const { return m_is_streamed; }
+        uint32_t GetMipResident()       const { return m_mip_resident; }
+        uint32_t GetMipCount()          const { return m_mip_resident + m_mip_levels; }
+        uint32_t GetMipTail()           const { return GetMipTail(GetMipCount()); } // the first mip which always stays resident
+        uint32_t GetWidthResident()     const { return Math::Helper::Max(m_width >> m_mip_resident, 1u); }
+        uint32_t GetHeightResident()    const { return Math::Helper::Max(m_height >> m_mip_resident, 1u); }
+        bool ReadMips(uint32_t mip_top, std::vector<std::vector<std::byte>>& data) const;
+        bool StreamMips(uint32_t mip_top, std::vector<std::vector<std::byte>>& data);
+        static constexpr uint32_t mip_tail_size = 128; // mips which are this big or smaller are never streamed out
+
         // Binding type
         bool IsSampled()                    const { return m_flags & RHI_Texture_ShaderView; }
         bool IsRenderTargetCompute()        const { return m_flags & RHI_Texture_UnorderedAccessView; }
@@ -105,6 +122,8 @@ namespace Spartan
         bool IsStencilFormat()  const { return m_format == RHI_Format_D32_Float_S8X24_Uint; }
         bool IsDepthStencil()   const { return IsDepthFormat() || IsStencilFormat(); }
         bool IsColorFormat()    const { return !IsDepthStencil(); }
+        bool IsCompressedFormat() const { return GetBlockSize(m_format) != 0; }
+        static uint32_t GetBlockSize(RHI_Format format); // bytes per 4x4 block of a compressed format, 0 for the rest
         
         // Layout
         void SetLayout(const RHI_Image_Layout layout, RHI_CommandList* command_list = nullptr);
@@ -114,6 +133,7 @@ namespace Spartan
         auto GetArraySize()         const { return m_array_size; }
         const auto& GetViewport()   const { return m_viewport; }
         uint16_t GetFlags()         const { return m_flags; }
+        void SetFlags(const uint16_t flags) { m_flags = flags; }
 
         // GPU resources
         void* Get_Resource()                                                const { return m_resource; }
@@ -129,13 +149,18 @@ namespace Spartan
 		bool LoadFromFile_ForeignFormat(const std::string& file_path, bool generate_mipmaps);
 		static uint32_t GetChannelCountFromFormat(RHI_Format format);
         virtual bool CreateResourceGpu() { LOG_ERROR("Function not implemented by API"); return false; }
+        virtual void DestroyResourceGpu(bool deferred = false) {} // deferred: release once the frames in flight are done with the resource
+        uint32_t GetMipTail(uint32_t mip_count) const;
+        void ComputeMemoryUsage();
 
 		uint32_t m_bits_per_channel = 8;
 		uint32_t m_width		    = 0;
 		uint32_t m_height		    = 0;
 		uint32_t m_channel_count	= 4;
         uint32_t m_array_size       = 1;
-        uint32_t m_mip_levels       = 1;
+        uint32_t m_mip_levels       = 1; // resident ones
+        uint32_t m_mip_resident     = 0;
+        bool m_is_streamed          = false;
 		RHI_Format m_format		    = RHI_Format_Undefined;
         RHI_Image_Layout m_layout   = RHI_Image_Undefined;
         uint16_t m_flags	        = 0;
@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Pipeline.h"
 #include "../RHI_VertexBuffer.h"
 #include "../RHI_IndexBuffer.h"
+#include "../RHI_StructuredBuffer.h"
 #include "../RHI_DescriptorCache.h"
 #include "../RHI_PipelineCache.h"
 #include "../RHI_DescriptorSetLayout.h"
@@ -416,6 +417,33 @@ namespace Spartan
         return true;
 	}
 
+    bool RHI_CommandList::DrawIndexedInstanced(const uint32_t index_count, const uint32_t instance_count, const uint32_t index_offset, const uint32_t vertex_offset)
+    {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("Can't record command");
+            return false;
+        }
+
+        // Ensure correct state before attempting to draw
+        if (!OnDraw())
+            return false;
+
+        // The first instance is always zero, shaders offset into their instance data themselves (keeps SV_InstanceID the same as in D3D)
+        vkCmdDrawIndexed(
+            static_cast<VkCommandBuffer>(m_cmd_buffer), // commandBuffer
+            index_count,                                // indexCount
+            instance_count,                             // instanceCount
+            index_offset,                               // firstIndex
+            vertex_offset,                              // vertexOffset
+            0                                           // firstInstance
+        );
+
+        m_profiler->m_rhi_draw_calls++;
+
+        return true;
+    }
+
     void RHI_CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z /*= 1*/) const
     {
         
@@ -529,6 +557,24 @@ namespace Spartan
         return m_descriptor_cache->SetConstantBuffer(slot, constant_buffer);
     }
 
+    void RHI_CommandList::SetStructuredBuffer(const uint32_t slot, const uint8_t scope, RHI_StructuredBuffer* structured_buffer) const
+    {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("Can't record command");
+            return;
+        }
+
+        if (!structured_buffer || !structured_buffer->GetResource())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        // Set (will only happen if it's not already set)
+        m_descriptor_cache->SetStructuredBuffer(slot, structured_buffer);
+    }
+
     void RHI_CommandList::SetSampler(const uint32_t slot, RHI_Sampler* sampler) const
     {
         if (m_cmd_state != RHI_Cmd_List_Recording)
@@ -73,7 +73,7 @@ namespace Spartan
     bool RHI_DescriptorCache::CreateDescriptorPool(uint32_t descriptor_set_capacity)
     {
         // Pool sizes
-        vector<VkDescriptorPoolSize> pool_sizes(4);
+        vector<VkDescriptorPoolSize> pool_sizes(5);
         pool_sizes[0].type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         pool_sizes[0].descriptorCount   = RHI_Context::descriptor_max_constant_buffers;
         pool_sizes[1].type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
@@ -82,6 +82,8 @@ namespace Spartan
         pool_sizes[2].descriptorCount   = RHI_Context::descriptor_max_textures;
         pool_sizes[3].type              = VK_DESCRIPTOR_TYPE_SAMPLER;
         pool_sizes[3].descriptorCount   = RHI_Context::descriptor_max_samplers;
+        pool_sizes[4].type              = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_sizes[4].descriptorCount   = RHI_Context::descriptor_max_structured_buffers;
 
         // Create info
         VkDescriptorPoolCreateInfo pool_create_info = {};
@@ -98,13 +98,13 @@ namespace Spartan
                 descriptor.type == RHI_Descriptor_Texture && descriptor.resource ? vulkan_image_layout[descriptor.layout] : VK_IMAGE_LAYOUT_UNDEFINED   // imageLayout
             });
         
-            // Constant/Uniform buffer
-            const bool is_constant_buffer = descriptor.type == RHI_Descriptor_ConstantBuffer || descriptor.type == RHI_Descriptor_ConstantBufferDynamic;
+            // Constant/Uniform or structured/storage buffer
+            const bool is_buffer = descriptor.type == RHI_Descriptor_ConstantBuffer || descriptor.type == RHI_Descriptor_ConstantBufferDynamic || descriptor.type == RHI_Descriptor_StructuredBuffer;
             buffer_infos.push_back
             ({
-                is_constant_buffer ? static_cast<VkBuffer>(descriptor.resource) : nullptr,  // buffer
-                is_constant_buffer ? descriptor.offset  : 0,                                // offset
-                is_constant_buffer ? descriptor.range   : 0                                 // range
+                is_buffer ? static_cast<VkBuffer>(descriptor.resource) : nullptr,   // buffer
+                is_buffer ? descriptor.offset  : 0,                                 // offset
+                is_buffer ? descriptor.range   : 0                                  // range
             });
 
             write_descriptor_sets.push_back
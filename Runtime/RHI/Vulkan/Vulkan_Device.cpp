@@ -268,6 +268,9 @@ namespace Spartan
         // Release resources
 		if (Queue_Wait(RHI_Queue_Graphics))
 		{
+            // Nothing is in flight anymore, so whatever is still waiting to be released can go
+            ReleaseRetired(numeric_limits<uint64_t>::max(), 0);
+
             m_rhi_context->destroy_allocator();
 
             if (m_rhi_context->debug)
@@ -75,11 +75,11 @@ namespace Spartan
             return true;
         }
 
-        const uint32_t width            = texture->GetWidth();
-        const uint32_t height           = texture->GetHeight();
+        const uint32_t width            = texture->GetWidthResident();
+        const uint32_t height           = texture->GetHeightResident();
         const uint32_t array_size       = texture->GetArraySize();
         const uint32_t mip_levels       = texture->GetMiplevels();
-        const uint32_t bytes_per_pixel  = texture->GetBytesPerPixel();
+        const uint32_t mip_resident     = texture->GetMipResident();
 
         // Fill out VkBufferImageCopy structs describing the array and the mip levels   
         VkDeviceSize buffer_offset = 0;
@@ -87,8 +87,8 @@ namespace Spartan
         {
             for (uint32_t mip_index = 0; mip_index < mip_levels; mip_index++)
             {
-                uint32_t mip_width  = width >> mip_index;
-                uint32_t mip_height = height >> mip_index;
+                uint32_t mip_width  = Math::Helper::Max(width >> mip_index, 1u);
+                uint32_t mip_height = Math::Helper::Max(height >> mip_index, 1u);
 
                 VkBufferImageCopy region				= {};
                 region.bufferOffset						= buffer_offset;
@@ -104,7 +104,7 @@ namespace Spartan
                 buffer_image_copies[mip_index] = region;
 
                 // Update staging buffer memory requirement (in bytes)
-                buffer_offset += mip_width * mip_height * bytes_per_pixel;
+                buffer_offset += texture->GetMipSize(mip_resident + mip_index);
             }
         }
 
@@ -120,7 +120,7 @@ namespace Spartan
             {
                 for (uint32_t mip_index = 0; mip_index < mip_levels; mip_index++)
                 {
-                    uint64_t buffer_size = (width >> mip_index) * (height >> mip_index) * bytes_per_pixel;
+                    uint64_t buffer_size = texture->GetMipSize(mip_resident + mip_index);
                     memcpy(static_cast<std::byte*>(data) + buffer_offset, texture->GetData(array_index + mip_index)->data(), buffer_size);
                     buffer_offset += buffer_size;
                 }
@@ -179,8 +179,50 @@ namespace Spartan
         if (!m_rhi_device->IsInitialized())
             return;
 
-        m_rhi_device->Queue_WaitAll();
         m_data.clear();
+        RHI_Texture2D::DestroyResourceGpu();
+	}
+
+    void RHI_Texture2D::DestroyResourceGpu(const bool deferred /*= false*/)
+    {
+        // Hand the image and its views over to the device, which destroys them once the frames in flight are done sampling them
+        if (deferred)
+        {
+            RHI_Context* rhi_context    = m_rhi_device->GetContextRhi();
+            VmaAllocation allocation    = nullptr;
+            auto it = rhi_context->allocations.find(GetId());
+            if (it != rhi_context->allocations.end())
+            {
+                allocation = it->second;
+                rhi_context->allocations.erase(it); // the new image is allocated under the same id
+            }
+
+            void* resource                                                          = m_resource;
+            array<void*, 2> resource_view                                           = { m_resource_view[0], m_resource_view[1] };
+            array<void*, state_max_render_target_count> resource_view_depthStencil  = m_resource_view_depthStencil;
+            array<void*, state_max_render_target_count> resource_view_renderTarget  = m_resource_view_renderTarget;
+            m_rhi_device->ReleaseDeferred([rhi_context, allocation, resource, resource_view, resource_view_depthStencil, resource_view_renderTarget]() mutable
+            {
+                vulkan_utility::image::view::destroy(resource_view[0]);
+                vulkan_utility::image::view::destroy(resource_view[1]);
+                vulkan_utility::image::view::destroy(resource_view_depthStencil);
+                vulkan_utility::image::view::destroy(resource_view_renderTarget);
+                if (allocation)
+                {
+                    vmaDestroyImage(rhi_context->allocator, static_cast<VkImage>(resource), allocation);
+                }
+            });
+
+            m_resource          = nullptr;
+            m_resource_view[0]  = nullptr;
+            m_resource_view[1]  = nullptr;
+            m_resource_view_depthStencil.fill(nullptr);
+            m_resource_view_renderTarget.fill(nullptr);
+            m_layout            = RHI_Image_Undefined;
+            return;
+        }
+
+        m_rhi_device->Queue_WaitAll();
 
         vulkan_utility::image::view::destroy(m_resource_view[0]);
         vulkan_utility::image::view::destroy(m_resource_view[1]);
@@ -190,7 +232,10 @@ namespace Spartan
             vulkan_utility::image::view::destroy(m_resource_view_renderTarget[i]);
         }
         vulkan_utility::image::destroy(this);
-	}
+
+        // A new image starts out undefined
+        m_layout = RHI_Image_Undefined;
+    }
 
     void RHI_Texture::SetLayout(const RHI_Image_Layout new_layout, RHI_CommandList* command_list /*= nullptr*/)
     {
@@ -49,13 +49,14 @@ namespace Spartan::vulkan_utility
         // Get format support
         RHI_Format format                   = texture->GetFormat();
         bool is_render_target_depth_stencil = texture->IsRenderTargetDepthStencil();
-        VkFormatFeatureFlags format_flags   = is_render_target_depth_stencil ? VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT;
+        bool is_render_target_color         = texture->IsRenderTargetColor();
+        VkFormatFeatureFlags format_flags   = is_render_target_depth_stencil ? VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT : (is_render_target_color ? VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT : VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
         VkImageTiling image_tiling          = get_format_tiling(format, format_flags);
         
         // Ensure the format is supported by the GPU
         if (image_tiling == VK_IMAGE_TILING_MAX_ENUM)
         {
-            LOG_ERROR("GPU does not support the usage of %s as a %s.", rhi_format_to_string(format), is_render_target_depth_stencil ? "depth-stencil attachment" : "color attachment");
+            LOG_ERROR("GPU does not support the usage of %s as a %s.", rhi_format_to_string(format), is_render_target_depth_stencil ? "depth-stencil attachment" : (is_render_target_color ? "color attachment" : "sampled image"));
             return false;
         }
         
@@ -73,8 +74,8 @@ namespace Spartan::vulkan_utility
         create_info.sType               = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         create_info.imageType           = VK_IMAGE_TYPE_2D;
         create_info.flags               = (texture->GetResourceType() == Resource_TextureCube) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
-        create_info.extent.width        = texture->GetWidth();
-        create_info.extent.height       = texture->GetHeight();
+        create_info.extent.width        = texture->GetWidthResident();
+        create_info.extent.height       = texture->GetHeightResident();
         create_info.extent.depth        = 1;
         create_info.mipLevels           = texture->GetMiplevels();
         create_info.arrayLayers         = texture->GetArraySize();
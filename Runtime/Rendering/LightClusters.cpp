@@ -0,0 +1,183 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===============
+#include "Spartan.h"
+#include "LightClusters.h"
+//==========================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    void LightClusters::Clear()
+    {
+        m_clusters.assign(cluster_count, Cluster());
+        m_light_indices.clear();
+    }
+
+    void LightClusters::Build(const Matrix& view, const Matrix& projection, const float near_plane, const float far_plane, const vector<Sphere>& lights)
+    {
+        // The bounds only depend on the projection
+        const float tan_half_fov_x = 1.0f / projection.m00;
+        const float tan_half_fov_y = 1.0f / projection.m11;
+        if (m_bounds.empty() || tan_half_fov_x != m_tan_half_fov_x || tan_half_fov_y != m_tan_half_fov_y || near_plane != m_near_plane || far_plane != m_far_plane)
+        {
+            UpdateBounds(tan_half_fov_x, tan_half_fov_y, near_plane, far_plane);
+        }
+
+        Clear();
+        m_pairs.clear();
+
+        for (uint32_t light_index = 0; light_index < static_cast<uint32_t>(lights.size()); light_index++)
+        {
+            const Vector3 center    = lights[light_index].center * view;
+            const float radius      = lights[light_index].radius;
+
+            // Depth range, clipped to the planes
+            const float depth_near  = Helper::Max(center.z - radius, near_plane);
+            const float depth_far   = Helper::Min(center.z + radius, far_plane);
+            if (depth_near > depth_far)
+                continue;
+
+            // Screen space extents of the box around the sphere, x / z peaks at either end of the depth range
+            const float x_min = center.x - radius;
+            const float x_max = center.x + radius;
+            const float y_min = center.y - radius;
+            const float y_max = center.y + radius;
+            const float ndc_x_min = x_min / ((x_min >= 0.0f ? depth_far : depth_near) * tan_half_fov_x);
+            const float ndc_x_max = x_max / ((x_max >= 0.0f ? depth_near : depth_far) * tan_half_fov_x);
+            const float ndc_y_min = y_min / ((y_min >= 0.0f ? depth_far : depth_near) * tan_half_fov_y);
+            const float ndc_y_max = y_max / ((y_max >= 0.0f ? depth_near : depth_far) * tan_half_fov_y);
+            if (ndc_x_min > 1.0f || ndc_x_max < -1.0f || ndc_y_min > 1.0f || ndc_y_max < -1.0f)
+                continue;
+
+            // Tiles go from the top left, like texture coordinates
+            const auto tile = [](const float uv, const uint32_t count)
+            {
+                return static_cast<uint32_t>(Helper::Clamp(static_cast<int>(Helper::Floor(uv * count)), 0, static_cast<int>(count) - 1));
+            };
+            const uint32_t tile_x_start = tile(ndc_x_min * 0.5f + 0.5f, grid_x);
+            const uint32_t tile_x_end   = tile(ndc_x_max * 0.5f + 0.5f, grid_x);
+            const uint32_t tile_y_start = tile(0.5f - ndc_y_max * 0.5f, grid_y);
+            const uint32_t tile_y_end   = tile(0.5f - ndc_y_min * 0.5f, grid_y);
+            const uint32_t slice_start  = GetSlice(depth_near, near_plane, far_plane);
+            const uint32_t slice_end    = GetSlice(depth_far, near_plane, far_plane);
+
+            // The above is conservative, test the sphere against each cluster to trim the corners
+            const float radius_squared = radius * radius;
+            for (uint32_t z = slice_start; z <= slice_end; z++)
+            {
+                for (uint32_t y = tile_y_start; y <= tile_y_end; y++)
+                {
+                    for (uint32_t x = tile_x_start; x <= tile_x_end; x++)
+                    {
+                        const uint32_t cluster_index    = GetClusterIndex(x, y, z);
+                        const BoundingBox& bounds       = m_bounds[cluster_index];
+
+                        const Vector3 closest
+                        (
+                            Helper::Clamp(center.x, bounds.GetMin().x, bounds.GetMax().x),
+                            Helper::Clamp(center.y, bounds.GetMin().y, bounds.GetMax().y),
+                            Helper::Clamp(center.z, bounds.GetMin().z, bounds.GetMax().z)
+                        );
+
+                        if ((closest - center).LengthSquared() <= radius_squared)
+                        {
+                            m_pairs.emplace_back(cluster_index, light_index);
+                            m_clusters[cluster_index].count++;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Counting sort by cluster, lights stay in ascending order within a cluster
+        uint32_t offset = 0;
+        for (Cluster& cluster : m_clusters)
+        {
+            cluster.offset  = offset;
+            offset          += cluster.count;
+            cluster.count   = 0;
+        }
+
+        m_light_indices.resize(m_pairs.size());
+        for (const auto& pair : m_pairs)
+        {
+            Cluster& cluster = m_clusters[pair.first];
+            m_light_indices[cluster.offset + cluster.count++] = pair.second;
+        }
+    }
+
+    uint32_t LightClusters::GetSlice(const float depth_view, const float near_plane, const float far_plane)
+    {
+        if (depth_view <= near_plane)
+            return 0;
+
+        const float slice = Helper::Log(depth_view / near_plane) / Helper::Log(far_plane / near_plane) * grid_z;
+        return Helper::Min(static_cast<uint32_t>(slice), grid_z - 1);
+    }
+
+    void LightClusters::UpdateBounds(const float tan_half_fov_x, const float tan_half_fov_y, const float near_plane, const float far_plane)
+    {
+        m_tan_half_fov_x    = tan_half_fov_x;
+        m_tan_half_fov_y    = tan_half_fov_y;
+        m_near_plane        = near_plane;
+        m_far_plane         = far_plane;
+
+        m_bounds.resize(cluster_count);
+        for (uint32_t z = 0; z < grid_z; z++)
+        {
+            const float depth_near  = near_plane * Helper::Pow(far_plane / near_plane, static_cast<float>(z) / grid_z);
+            const float depth_far   = near_plane * Helper::Pow(far_plane / near_plane, static_cast<float>(z + 1) / grid_z);
+
+            for (uint32_t y = 0; y < grid_y; y++)
+            {
+                const float ndc_top     = 1.0f - 2.0f * y / grid_y;
+                const float ndc_bottom  = 1.0f - 2.0f * (y + 1) / grid_y;
+
+                for (uint32_t x = 0; x < grid_x; x++)
+                {
+                    const float ndc_left    = 2.0f * x / grid_x - 1.0f;
+                    const float ndc_right   = 2.0f * (x + 1) / grid_x - 1.0f;
+
+                    // The corners of the frustum slice, at both ends of the depth range
+                    Vector3 corners[8];
+                    uint32_t i = 0;
+                    for (const float depth : { depth_near, depth_far })
+                    {
+                        const float extent_x = depth * tan_half_fov_x;
+                        const float extent_y = depth * tan_half_fov_y;
+                        corners[i++] = Vector3(ndc_left * extent_x,  ndc_top * extent_y,    depth);
+                        corners[i++] = Vector3(ndc_right * extent_x, ndc_top * extent_y,    depth);
+                        corners[i++] = Vector3(ndc_left * extent_x,  ndc_bottom * extent_y, depth);
+                        corners[i++] = Vector3(ndc_right * extent_x, ndc_bottom * extent_y, depth);
+                    }
+
+                    m_bounds[GetClusterIndex(x, y, z)] = BoundingBox(corners, 8);
+                }
+            }
+        }
+    }
+}
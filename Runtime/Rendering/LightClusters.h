@@ -0,0 +1,86 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <vector>
+#include "../Math/Matrix.h"
+#include "../Math/Vector3.h"
+#include "../Math/BoundingBox.h"
+#include "../Core/Spartan_Definitions.h"
+//=================================
+
+namespace Spartan
+{
+    // Bins point and spot lights into a view space grid of clusters (froxels), so that a pixel only has to
+    // shade the lights which can reach its cluster. Tiles split the screen evenly, slices split the depth
+    // exponentially between the near and the far plane. The grid is mirrored by g_cluster_grid (Common_Buffer.hlsl).
+    class SPARTAN_CLASS LightClusters
+    {
+    public:
+        static constexpr uint32_t grid_x        = 16;
+        static constexpr uint32_t grid_y        = 9;
+        static constexpr uint32_t grid_z        = 24;
+        static constexpr uint32_t cluster_count = grid_x * grid_y * grid_z;
+
+        // A range of the light index list
+        struct Cluster
+        {
+            uint32_t offset = 0;
+            uint32_t count  = 0;
+        };
+
+        // World space bounds of a light
+        struct Sphere
+        {
+            Math::Vector3 center;
+            float radius;
+        };
+
+        LightClusters() = default;
+        ~LightClusters() = default;
+
+        void Clear();
+
+        // Bins the lights, the projection has to be a perspective one (tiles are built from its field of view)
+        void Build(const Math::Matrix& view, const Math::Matrix& projection, float near_plane, float far_plane, const std::vector<Sphere>& lights);
+
+        // Clusters are laid out x first, then y (top to bottom), then z
+        static uint32_t GetClusterIndex(const uint32_t x, const uint32_t y, const uint32_t z) { return x + y * grid_x + z * grid_x * grid_y; }
+        static uint32_t GetSlice(float depth_view, float near_plane, float far_plane);
+
+        const std::vector<Cluster>& GetClusters()       const { return m_clusters; }
+        const std::vector<uint32_t>& GetLightIndices()  const { return m_light_indices; } // indices into the lights passed to Build()
+
+    private:
+        void UpdateBounds(float tan_half_fov_x, float tan_half_fov_y, float near_plane, float far_plane);
+
+        std::vector<Math::BoundingBox> m_bounds; // view space bounds of every cluster, rebuilt when the projection changes
+        std::vector<Cluster> m_clusters;
+        std::vector<uint32_t> m_light_indices;
+        std::vector<std::pair<uint32_t, uint32_t>> m_pairs; // scratch, cluster and light
+        float m_tan_half_fov_x  = 0.0f;
+        float m_tan_half_fov_y  = 0.0f;
+        float m_near_plane      = 0.0f;
+        float m_far_plane       = 0.0f;
+    };
+}
@@ -0,0 +1,337 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==============
+#include "Spartan.h"
+#include "MeshSimplifier.h"
+#include "../RHI/RHI_Vertex.h"
+//=========================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    void MeshSimplifier::Quadric::AddPlane(const Vector3& normal, const float distance, const float area)
+    {
+        const double a = normal.x, b = normal.y, c = normal.z, d = distance, w = area;
+
+        a2 += a * a * w; ab += a * b * w; ac += a * c * w; ad += a * d * w;
+        b2 += b * b * w; bc += b * c * w; bd += b * d * w;
+        c2 += c * c * w; cd += c * d * w;
+        d2 += d * d * w;
+        weight += w;
+    }
+
+    void MeshSimplifier::Quadric::Add(const Quadric& quadric)
+    {
+        a2 += quadric.a2; ab += quadric.ab; ac += quadric.ac; ad += quadric.ad;
+        b2 += quadric.b2; bc += quadric.bc; bd += quadric.bd;
+        c2 += quadric.c2; cd += quadric.cd;
+        d2 += quadric.d2;
+        weight += quadric.weight;
+    }
+
+    double MeshSimplifier::Quadric::Evaluate(const Vector3& position) const
+    {
+        const double x = position.x, y = position.y, z = position.z;
+
+        return
+            a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+            b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+            c2 * z * z + 2.0 * cd * z +
+            d2;
+    }
+
+    float MeshSimplifier::Simplify(const RHI_Vertex_PosTexNorTan* vertices, const uint32_t vertex_count, const vector<uint32_t>& indices, const uint32_t index_target, const float error_max, vector<uint32_t>& result)
+    {
+        result = indices;
+
+        if (!vertices || vertex_count == 0 || indices.size() % 3 != 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return 0.0f;
+        }
+
+        if (result.size() <= index_target)
+            return 0.0f;
+
+        // Positions and the size of the mesh, which the errors are relative to
+        m_positions.resize(vertex_count);
+        Vector3 min = Vector3::Infinity;
+        Vector3 max = Vector3::InfinityNeg;
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            const Vector3 position = Vector3(vertices[i].pos[0], vertices[i].pos[1], vertices[i].pos[2]);
+            m_positions[i] = position;
+            min = Vector3(Helper::Min(min.x, position.x), Helper::Min(min.y, position.y), Helper::Min(min.z, position.z));
+            max = Vector3(Helper::Max(max.x, position.x), Helper::Max(max.y, position.y), Helper::Max(max.z, position.z));
+        }
+        const float extent = Helper::Max(Vector3::Distance(min, max), Helper::M_EPSILON);
+
+        // Vertices which share a position are welded, sorting them brings them next to each other
+        {
+            vector<uint32_t> order(vertex_count);
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                order[i] = i;
+            }
+
+            sort(order.begin(), order.end(), [this](const uint32_t a, const uint32_t b)
+            {
+                const Vector3& p_a = m_positions[a];
+                const Vector3& p_b = m_positions[b];
+                if (p_a.x != p_b.x) return p_a.x < p_b.x;
+                if (p_a.y != p_b.y) return p_a.y < p_b.y;
+                return p_a.z < p_b.z;
+            });
+
+            m_canonical.resize(vertex_count);
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                const bool same = i != 0 && m_positions[order[i]] == m_positions[order[i - 1]];
+                m_canonical[order[i]] = same ? m_canonical[order[i - 1]] : order[i];
+            }
+        }
+
+        // A position with more than one (referenced) vertex is on a seam
+        m_wedge_count.assign(vertex_count, 0);
+        m_touched.assign(vertex_count, 0);
+        for (const uint32_t index : result)
+        {
+            if (!m_touched[index])
+            {
+                m_touched[index] = 1;
+                m_wedge_count[m_canonical[index]]++;
+            }
+        }
+
+        // Every position starts with the planes of the triangles around it
+        m_quadrics.assign(vertex_count, Quadric());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(result.size()); i += 3)
+        {
+            const uint32_t c0 = m_canonical[result[i + 0]];
+            const uint32_t c1 = m_canonical[result[i + 1]];
+            const uint32_t c2 = m_canonical[result[i + 2]];
+
+            Vector3 normal      = Vector3::Cross(m_positions[c1] - m_positions[c0], m_positions[c2] - m_positions[c0]);
+            const float length  = normal.Length();
+            if (length == 0.0f)
+                continue;
+
+            normal = normal / length;
+            const float distance    = -Vector3::Dot(normal, m_positions[c0]);
+            const float area        = length * 0.5f;
+            m_quadrics[c0].AddPlane(normal, distance, area);
+            m_quadrics[c1].AddPlane(normal, distance, area);
+            m_quadrics[c2].AddPlane(normal, distance, area);
+        }
+
+        // The error of moving a position onto another, as a squared distance
+        auto cost = [this](const uint32_t from, const uint32_t to)
+        {
+            Quadric quadric = m_quadrics[from];
+            quadric.Add(m_quadrics[to]);
+            return quadric.weight > 0.0 ? static_cast<float>(Helper::Max(quadric.Evaluate(m_positions[to]) / quadric.weight, 0.0)) : 0.0f;
+        };
+
+        const float error_limit = (error_max * extent) * (error_max * extent);
+        float error_reached     = 0.0f;
+
+        m_remap.resize(vertex_count);
+        while (result.size() > index_target)
+        {
+            const uint32_t triangle_count = static_cast<uint32_t>(result.size() / 3);
+            BuildAdjacency(result);
+
+            // Lock seams and borders, an edge is on a border when no triangle runs along it in the opposite direction
+            m_locked.assign(vertex_count, 0);
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                m_locked[i] = m_wedge_count[i] > 1;
+            }
+
+            for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+            {
+                for (uint32_t edge = 0; edge < 3; edge++)
+                {
+                    const uint32_t a = m_canonical[result[triangle * 3 + edge]];
+                    const uint32_t b = m_canonical[result[triangle * 3 + (edge + 1) % 3]];
+
+                    bool twin = false;
+                    for (uint32_t j = m_adjacency_offsets[a]; j < m_adjacency_offsets[a + 1] && !twin; j++)
+                    {
+                        const uint32_t* other = &result[m_adjacency[j] * 3];
+                        for (uint32_t k = 0; k < 3 && !twin; k++)
+                        {
+                            twin = m_canonical[other[k]] == b && m_canonical[other[(k + 1) % 3]] == a;
+                        }
+                    }
+
+                    if (!twin)
+                    {
+                        m_locked[a] = 1;
+                        m_locked[b] = 1;
+                    }
+                }
+            }
+
+            // Every edge can collapse either way, as long as the moving position isn't locked
+            m_collapses.clear();
+            for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+            {
+                for (uint32_t edge = 0; edge < 3; edge++)
+                {
+                    const uint32_t i0 = result[triangle * 3 + edge];
+                    const uint32_t i1 = result[triangle * 3 + (edge + 1) % 3];
+                    const uint32_t c0 = m_canonical[i0];
+                    const uint32_t c1 = m_canonical[i1];
+                    if (c0 == c1)
+                        continue;
+
+                    if (!m_locked[c0]) m_collapses.push_back({ i0, i1, cost(c0, c1) });
+                    if (!m_locked[c1]) m_collapses.push_back({ i1, i0, cost(c1, c0) });
+                }
+            }
+
+            if (m_collapses.empty())
+                break;
+
+            sort(m_collapses.begin(), m_collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+            // A collapse removes two triangles, so a pass goes for about half of what's left to remove.
+            // Positions around a collapse have changed, they wait for the next pass.
+            const uint32_t collapse_limit = Helper::Max<uint32_t>(static_cast<uint32_t>(result.size() - index_target) / 6, 1);
+            uint32_t collapse_count = 0;
+            for (uint32_t i = 0; i < vertex_count; i++)
+            {
+                m_remap[i] = i;
+            }
+            m_touched.assign(vertex_count, 0);
+
+            for (const Collapse& collapse : m_collapses)
+            {
+                if (collapse.cost > error_limit)
+                    break;
+
+                const uint32_t c0 = m_canonical[collapse.from];
+                const uint32_t c1 = m_canonical[collapse.to];
+                if (m_touched[c0] || m_touched[c1] || Flips(c0, c1, result))
+                    continue;
+
+                m_remap[collapse.from] = collapse.to;
+                for (uint32_t j = m_adjacency_offsets[c0]; j < m_adjacency_offsets[c0 + 1]; j++)
+                {
+                    const uint32_t* triangle = &result[m_adjacency[j] * 3];
+                    m_touched[m_canonical[triangle[0]]] = 1;
+                    m_touched[m_canonical[triangle[1]]] = 1;
+                    m_touched[m_canonical[triangle[2]]] = 1;
+                }
+                m_quadrics[c1].Add(m_quadrics[c0]);
+                error_reached = Helper::Max(error_reached, collapse.cost);
+
+                if (++collapse_count >= collapse_limit)
+                    break;
+            }
+
+            if (collapse_count == 0)
+                break;
+
+            // Apply the collapses, dropping the triangles which became degenerate
+            uint32_t write = 0;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(result.size()); i += 3)
+            {
+                const uint32_t i0 = m_remap[result[i + 0]];
+                const uint32_t i1 = m_remap[result[i + 1]];
+                const uint32_t i2 = m_remap[result[i + 2]];
+                const uint32_t c0 = m_canonical[i0];
+                const uint32_t c1 = m_canonical[i1];
+                const uint32_t c2 = m_canonical[i2];
+                if (c0 == c1 || c1 == c2 || c0 == c2)
+                    continue;
+
+                result[write++] = i0;
+                result[write++] = i1;
+                result[write++] = i2;
+            }
+            result.resize(write);
+        }
+
+        return Helper::Sqrt(error_reached) / extent;
+    }
+
+    void MeshSimplifier::BuildAdjacency(const vector<uint32_t>& indices)
+    {
+        const uint32_t vertex_count = static_cast<uint32_t>(m_canonical.size());
+
+        // Count, then fill
+        m_adjacency_offsets.assign(vertex_count + 1, 0);
+        for (const uint32_t index : indices)
+        {
+            m_adjacency_offsets[m_canonical[index] + 1]++;
+        }
+
+        for (uint32_t i = 1; i <= vertex_count; i++)
+        {
+            m_adjacency_offsets[i] += m_adjacency_offsets[i - 1];
+        }
+
+        m_adjacency.resize(indices.size());
+        vector<uint32_t> cursor(m_adjacency_offsets.begin(), m_adjacency_offsets.end() - 1);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(indices.size()); i++)
+        {
+            m_adjacency[cursor[m_canonical[indices[i]]]++] = i / 3;
+        }
+    }
+
+    bool MeshSimplifier::Flips(const uint32_t from, const uint32_t to, const vector<uint32_t>& indices) const
+    {
+        for (uint32_t j = m_adjacency_offsets[from]; j < m_adjacency_offsets[from + 1]; j++)
+        {
+            const uint32_t* triangle = &indices[m_adjacency[j] * 3];
+            const uint32_t c[3] = { m_canonical[triangle[0]], m_canonical[triangle[1]], m_canonical[triangle[2]] };
+
+            // Triangles along the edge disappear
+            if (c[0] == to || c[1] == to || c[2] == to)
+                continue;
+
+            Vector3 before[3] = { m_positions[c[0]], m_positions[c[1]], m_positions[c[2]] };
+            Vector3 after[3]  = { before[0], before[1], before[2] };
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                if (c[k] == from)
+                {
+                    after[k] = m_positions[to];
+                }
+            }
+
+            // Reject turns of more than ~75 degrees, which also rejects triangles which would become degenerate
+            const Vector3 normal_before = Vector3::Cross(before[1] - before[0], before[2] - before[0]);
+            const Vector3 normal_after  = Vector3::Cross(after[1] - after[0], after[2] - after[0]);
+            if (Vector3::Dot(normal_before, normal_after) <= 0.25f * normal_before.Length() * normal_after.Length())
+                return true;
+        }
+
+        return false;
+    }
+}
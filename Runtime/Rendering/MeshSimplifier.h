@@ -0,0 +1,90 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <vector>
+#include "../Math/Vector3.h"
+#include "../RHI/RHI_Definition.h"
+#include "../Core/Spartan_Definitions.h"
+//=================================
+
+namespace Spartan
+{
+    // Reduces the triangle count of a mesh by collapsing edges, cheapest first, where the cost of a collapse is the
+    // squared distance of the moved vertex from the planes of the triangles it has absorbed so far (quadric error metric).
+    // Vertices only ever collapse into one of their neighbours, so the result is a new index list over the same vertices.
+    // Vertices on borders and on attribute seams (uv or normal splits) are kept in place, to keep the silhouette and the texturing intact.
+    class SPARTAN_CLASS MeshSimplifier
+    {
+    public:
+        MeshSimplifier() = default;
+        ~MeshSimplifier() = default;
+
+        // Simplifies until the index count is no more than index_target, or until the next collapse would move the surface further than
+        // error_max (relative to the size of the mesh). Returns the error which was reached, relative to the size of the mesh.
+        float Simplify(
+            const RHI_Vertex_PosTexNorTan* vertices,
+            uint32_t vertex_count,
+            const std::vector<uint32_t>& indices,
+            uint32_t index_target,
+            float error_max,
+            std::vector<uint32_t>& result
+        );
+
+    private:
+        // The plane distance error of a vertex, as a symmetric 4x4 matrix (weighted by triangle area)
+        struct Quadric
+        {
+            double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+            double b2 = 0.0, bc = 0.0, bd = 0.0;
+            double c2 = 0.0, cd = 0.0;
+            double d2 = 0.0;
+            double weight = 0.0;
+
+            void AddPlane(const Math::Vector3& normal, float distance, float area);
+            void Add(const Quadric& quadric);
+            double Evaluate(const Math::Vector3& position) const;
+        };
+
+        struct Collapse
+        {
+            uint32_t from;
+            uint32_t to;
+            float cost;
+        };
+
+        void BuildAdjacency(const std::vector<uint32_t>& indices);
+        bool Flips(uint32_t from, uint32_t to, const std::vector<uint32_t>& indices) const;
+
+        std::vector<Math::Vector3> m_positions;
+        std::vector<uint32_t> m_canonical;      // the first vertex with the same position, collapses happen between positions
+        std::vector<uint32_t> m_wedge_count;    // per position, how many vertices share it
+        std::vector<uint8_t> m_locked;          // per position
+        std::vector<Quadric> m_quadrics;        // per position
+        std::vector<uint32_t> m_adjacency_offsets;
+        std::vector<uint32_t> m_adjacency;      // per position, the triangles which use it
+        std::vector<Collapse> m_collapses;
+        std::vector<uint32_t> m_remap;
+        std::vector<uint8_t> m_touched;
+    };
+}
@@ -28,6 +28,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Core/Stopwatch.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/Import/ModelImporter.h"
+#include "../Threading/Threading.h"
 #include "../World/Entity.h"
 #include "../World/Components/Transform.h"
 #include "../World/Components/Renderable.h"
@@ -157,6 +158,17 @@ namespace Spartan
 		m_mesh->Vertices_Append(vertices, vertex_offset);
 	}
 
+	void Model::AppendIndices(const vector<uint32_t>& indices, uint32_t* index_offset) const
+	{
+		if (indices.empty())
+		{
+			LOG_ERROR_INVALID_PARAMETER();
+			return;
+		}
+
+		m_mesh->Indices_Append(indices, index_offset);
+	}
+
 	void Model::GetGeometry(const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset, const uint32_t vertex_count, vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices) const
 	{
 		m_mesh->Geometry_Get(index_offset, index_count, vertex_offset, vertex_count, indices, vertices);
@@ -172,7 +184,13 @@ namespace Spartan
 
 		GeometryCreateBuffers();
 		m_normalized_scale	= GeometryComputeNormalizedScale();
-		m_aabb				= BoundingBox(m_mesh->Vertices_Get().data(), static_cast<uint32_t>(m_mesh->Vertices_Get().size()));
+
+		// Compute the AABB in parallel, every thread bounds its own chunks and the results are merged at the end
+		const vector<RHI_Vertex_PosTexNorTan>& vertices = m_mesh->Vertices_Get();
+		m_aabb = m_context->GetSubsystem<Threading>()->ParallelReduce(static_cast<uint32_t>(vertices.size()), 0, BoundingBox(),
+			[&vertices](uint32_t start, uint32_t end, BoundingBox& aabb) { aabb.Merge(BoundingBox(vertices.data() + start, end - start)); },
+			[](BoundingBox& result, const BoundingBox& aabb) { result.Merge(aabb); }
+		);
 	}
 
 	void Model::AddMaterial(shared_ptr<Material>& material, const shared_ptr<Entity>& entity) const
@@ -211,6 +229,19 @@ namespace Spartan
 			// Load texture
 			auto generate_mipmaps = true;
             texture = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
+
+            // Block compress it, storing only the channels which the slot reads, and stream its mips once it's saved
+            uint16_t flags = texture->GetFlags() | RHI_Texture_CompressWhenLoading | RHI_Texture_Streamable;
+            if (texture_type == Material_Normal)
+            {
+                flags |= RHI_Texture_NormalMap;
+            }
+            else if (texture_type == Material_Roughness || texture_type == Material_Metallic || texture_type == Material_Height || texture_type == Material_Occlusion || texture_type == Material_Mask)
+            {
+                flags |= RHI_Texture_SingleChannel;
+            }
+            texture->SetFlags(flags);
+
 			texture->LoadFromFile(file_path);
 
 			// Set the texture to the provided material
@@ -57,6 +57,7 @@ namespace Spartan
             uint32_t* index_offset  = nullptr,
             uint32_t* vertex_offset = nullptr
         ) const;
+        void AppendIndices(const std::vector<uint32_t>& indices, uint32_t* index_offset = nullptr) const; // for more ranges over existing vertices, like levels of detail
         void GetGeometry(
             uint32_t index_offset,
             uint32_t index_count,
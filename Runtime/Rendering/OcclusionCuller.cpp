@@ -0,0 +1,336 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========================
+#include "Spartan.h"
+#include "OcclusionCuller.h"
+#include "../RHI/RHI_Vertex.h"
+#include "../Math/Vector4.h"
+#include "../Threading/Threading.h"
+#if defined(_M_X64) || defined(__SSE2__)
+#define OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+//=====================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    void OcclusionCuller::Rasterize(const Matrix& view_projection, const float near_plane, const vector<Occluder>& occluders, Threading* threading)
+    {
+        m_view_projection   = view_projection;
+        m_near_plane        = Helper::Max(near_plane, Helper::M_EPSILON);
+
+        if (m_levels.empty())
+        {
+            for (uint32_t level_width = width, level_height = height; level_width > 0 && level_height > 0; level_width >>= 1, level_height >>= 1)
+            {
+                m_levels.emplace_back(level_width * level_height, 0.0f);
+            }
+        }
+        fill(m_levels[0].begin(), m_levels[0].end(), 0.0f);
+
+        const uint32_t occluder_count   = static_cast<uint32_t>(occluders.size());
+        const uint32_t band_count       = height / band_height;
+        m_triangles.resize(occluder_count);
+
+        // Project the triangles, every occluder on its own, and then fill the bands of the screen, every band on its own.
+        // The waiting thread doesn't pick up unrelated tasks, whoever calls this might be holding a lock.
+        if (threading)
+        {
+            threading->ParallelFor(occluder_count, 1, [this, &occluders](uint32_t start, uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    Transform(occluders[i], m_triangles[i]);
+                }
+            }, false);
+
+            threading->ParallelFor(band_count, 1, [this](uint32_t start, uint32_t end)
+            {
+                for (uint32_t band = start; band < end; band++)
+                {
+                    RasterizeBand(band);
+                }
+            }, false);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < occluder_count; i++)
+            {
+                Transform(occluders[i], m_triangles[i]);
+            }
+
+            for (uint32_t band = 0; band < band_count; band++)
+            {
+                RasterizeBand(band);
+            }
+        }
+
+        BuildPyramid();
+    }
+
+    bool OcclusionCuller::IsVisible(const BoundingBox& aabb) const
+    {
+        if (m_levels.empty())
+            return true;
+
+        const Vector3& min = aabb.GetMin();
+        const Vector3& max = aabb.GetMax();
+
+        // Screen rectangle and closest depth of the corners
+        float x_min     = numeric_limits<float>::max();
+        float y_min     = numeric_limits<float>::max();
+        float x_max     = numeric_limits<float>::lowest();
+        float y_max     = numeric_limits<float>::lowest();
+        float depth_max = 0.0f;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            const Vector4 clip = m_view_projection * Vector4((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0f);
+
+            // Crosses the near plane, it's right in front of the camera
+            if (clip.w < m_near_plane)
+                return true;
+
+            const float w_inverse   = 1.0f / clip.w;
+            const float x           = (clip.x * w_inverse * 0.5f + 0.5f) * width;
+            const float y           = (0.5f - clip.y * w_inverse * 0.5f) * height;
+            x_min                   = Helper::Min(x_min, x);
+            y_min                   = Helper::Min(y_min, y);
+            x_max                   = Helper::Max(x_max, x);
+            y_max                   = Helper::Max(y_max, y);
+            depth_max               = Helper::Max(depth_max, w_inverse);
+        }
+
+        // Off screen, that's for the frustum to decide
+        if (x_max < 0.0f || y_max < 0.0f || x_min >= width || y_min >= height)
+            return true;
+
+        // The covered texels, plus one on every side, a pixel on the edge of an occluder isn't necessarily fully covered
+        uint32_t x_first    = static_cast<uint32_t>(Helper::Clamp(x_min - 1.0f, 0.0f, static_cast<float>(width - 1)));
+        uint32_t y_first    = static_cast<uint32_t>(Helper::Clamp(y_min - 1.0f, 0.0f, static_cast<float>(height - 1)));
+        uint32_t x_last     = static_cast<uint32_t>(Helper::Clamp(x_max + 1.0f, 0.0f, static_cast<float>(width - 1)));
+        uint32_t y_last     = static_cast<uint32_t>(Helper::Clamp(y_max + 1.0f, 0.0f, static_cast<float>(height - 1)));
+
+        // Go up the pyramid until they are at most 2x2 texels
+        uint32_t level = 0;
+        while (level + 1 < static_cast<uint32_t>(m_levels.size()) && ((x_last >> level) - (x_first >> level) > 1 || (y_last >> level) - (y_first >> level) > 1))
+        {
+            level++;
+        }
+        x_first >>= level;
+        y_first >>= level;
+        x_last  >>= level;
+        y_last  >>= level;
+
+        // Hidden only if every texel has something closer than the box
+        const vector<float>& depth  = m_levels[level];
+        const uint32_t level_width  = width >> level;
+        for (uint32_t y = y_first; y <= y_last; y++)
+        {
+            for (uint32_t x = x_first; x <= x_last; x++)
+            {
+                if (depth[y * level_width + x] <= depth_max)
+                    return true;
+            }
+        }
+
+        return false;
+    }
+
+    void OcclusionCuller::Transform(const Occluder& occluder, vector<Triangle>& triangles) const
+    {
+        triangles.clear();
+
+        const Matrix world_view_projection = occluder.transform * m_view_projection;
+        for (uint32_t i = 0; i + 2 < occluder.index_count; i += 3)
+        {
+            Vector4 clip[3];
+            uint32_t behind_count = 0;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const float* position   = occluder.vertices[occluder.indices[i + k]].pos;
+                clip[k]                 = world_view_projection * Vector4(position[0], position[1], position[2], 1.0f);
+                behind_count           += clip[k].w < m_near_plane ? 1 : 0;
+            }
+
+            if (behind_count == 3)
+                continue;
+
+            // Clip against the near plane, which leaves a triangle or a quad
+            Vector4 polygon[4];
+            uint32_t polygon_count = 0;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const Vector4& a = clip[k];
+                const Vector4& b = clip[(k + 1) % 3];
+                if (a.w >= m_near_plane)
+                {
+                    polygon[polygon_count++] = a;
+                }
+
+                if ((a.w < m_near_plane) != (b.w < m_near_plane))
+                {
+                    const float t = (m_near_plane - a.w) / (b.w - a.w);
+                    polygon[polygon_count++] = Vector4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, m_near_plane);
+                }
+            }
+
+            // To pixels, as a fan
+            Triangle triangle;
+            for (uint32_t k = 0; k < polygon_count; k++)
+            {
+                const float w_inverse   = 1.0f / polygon[k].w;
+                const uint32_t slot     = k == 0 ? 0 : (k == 1 ? 1 : 2);
+                triangle.x[slot]        = (polygon[k].x * w_inverse * 0.5f + 0.5f) * width;
+                triangle.y[slot]        = (0.5f - polygon[k].y * w_inverse * 0.5f) * height;
+                triangle.depth[slot]    = w_inverse;
+
+                if (k >= 2)
+                {
+                    triangles.emplace_back(triangle);
+                    triangle.x[1]       = triangle.x[2];
+                    triangle.y[1]       = triangle.y[2];
+                    triangle.depth[1]   = triangle.depth[2];
+                }
+            }
+        }
+    }
+
+    void OcclusionCuller::RasterizeBand(const uint32_t band)
+    {
+        vector<float>& depth        = m_levels[0];
+        const uint32_t band_first   = band * band_height;
+        const uint32_t band_last    = band_first + band_height - 1;
+
+        for (const vector<Triangle>& triangles : m_triangles)
+        {
+            for (const Triangle& triangle : triangles)
+            {
+                const float* x = triangle.x;
+                const float* y = triangle.y;
+                const float* d = triangle.depth;
+
+                // Pixels whose centers could be inside, restricted to the band
+                const float x_min = Helper::Min(x[0], Helper::Min(x[1], x[2]));
+                const float x_max = Helper::Max(x[0], Helper::Max(x[1], x[2]));
+                const float y_min = Helper::Min(y[0], Helper::Min(y[1], y[2]));
+                const float y_max = Helper::Max(y[0], Helper::Max(y[1], y[2]));
+                if (x_max < 0.0f || x_min >= width || y_max < static_cast<float>(band_first) || y_min > static_cast<float>(band_last + 1))
+                    continue;
+
+                const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if (Helper::Abs(area) < Helper::M_EPSILON)
+                    continue;
+
+                // Edge functions, positive inside whatever the winding
+                float edge_a[3], edge_b[3], edge_c[3];
+                const float sign = area > 0.0f ? 1.0f : -1.0f;
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    const uint32_t k_next   = (k + 1) % 3;
+                    edge_a[k]               = (y[k_next] - y[k]) * -sign;
+                    edge_b[k]               = (x[k_next] - x[k]) * sign;
+                    edge_c[k]               = -(edge_a[k] * x[k] + edge_b[k] * y[k]);
+                }
+
+                // Depth plane, lowered to the farthest point of each pixel
+                const float depth_dx    = ((d[1] - d[0]) * (y[2] - y[0]) - (d[2] - d[0]) * (y[1] - y[0])) / area;
+                const float depth_dy    = ((d[2] - d[0]) * (x[1] - x[0]) - (d[1] - d[0]) * (x[2] - x[0])) / area;
+                const float depth_c     = d[0] - depth_dx * x[0] - depth_dy * y[0] - (Helper::Abs(depth_dx) + Helper::Abs(depth_dy)) * 0.5f;
+                const float depth_min   = Helper::Min(d[0], Helper::Min(d[1], d[2]));
+
+                // Columns are processed four at a time
+                const uint32_t column_first = static_cast<uint32_t>(Helper::Max(x_min, 0.0f)) & ~3u;
+                const uint32_t column_end   = Helper::Min(static_cast<uint32_t>(Helper::Max(x_max, 0.0f)) + 4, width) & ~3u;
+                const uint32_t row_first    = Helper::Max(static_cast<uint32_t>(Helper::Max(y_min, 0.0f)), band_first);
+                const uint32_t row_last     = Helper::Min(static_cast<uint32_t>(Helper::Min(y_max, static_cast<float>(height - 1))), band_last);
+
+                for (uint32_t row = row_first; row <= row_last; row++)
+                {
+                    const float center_y = row + 0.5f;
+                    float* depth_row = &depth[row * width];
+
+#if defined(OCCLUSION_SSE)
+                    const __m128 step       = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+                    const __m128 zero       = _mm_setzero_ps();
+                    const __m128 floor      = _mm_set1_ps(depth_min);
+                    for (uint32_t column = column_first; column < column_end; column += 4)
+                    {
+                        const __m128 center_x   = _mm_add_ps(_mm_set1_ps(static_cast<float>(column)), step);
+                        const __m128 e0         = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_a[0]), center_x), _mm_set1_ps(edge_b[0] * center_y + edge_c[0]));
+                        const __m128 e1         = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_a[1]), center_x), _mm_set1_ps(edge_b[1] * center_y + edge_c[1]));
+                        const __m128 e2         = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_a[2]), center_x), _mm_set1_ps(edge_b[2] * center_y + edge_c[2]));
+                        const __m128 inside     = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+                        if (_mm_movemask_ps(inside) == 0)
+                            continue;
+
+                        __m128 value            = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depth_dx), center_x), _mm_set1_ps(depth_dy * center_y + depth_c));
+                        value                   = _mm_max_ps(value, floor);
+                        const __m128 current    = _mm_loadu_ps(&depth_row[column]);
+                        const __m128 closer     = _mm_max_ps(current, value);
+                        _mm_storeu_ps(&depth_row[column], _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, current)));
+                    }
+#else
+                    for (uint32_t column = column_first; column < column_end; column++)
+                    {
+                        const float center_x = column + 0.5f;
+                        if (edge_a[0] * center_x + edge_b[0] * center_y + edge_c[0] < 0.0f ||
+                            edge_a[1] * center_x + edge_b[1] * center_y + edge_c[1] < 0.0f ||
+                            edge_a[2] * center_x + edge_b[2] * center_y + edge_c[2] < 0.0f)
+                            continue;
+
+                        const float value   = Helper::Max(depth_dx * center_x + depth_dy * center_y + depth_c, depth_min);
+                        depth_row[column]   = Helper::Max(depth_row[column], value);
+                    }
+#endif
+                }
+            }
+        }
+    }
+
+    void OcclusionCuller::BuildPyramid()
+    {
+        // Every texel keeps the farthest of the four below it
+        for (uint32_t level = 1; level < static_cast<uint32_t>(m_levels.size()); level++)
+        {
+            const vector<float>& source     = m_levels[level - 1];
+            vector<float>& destination      = m_levels[level];
+            const uint32_t source_width     = width >> (level - 1);
+            const uint32_t level_width      = width >> level;
+            const uint32_t level_height     = height >> level;
+
+            for (uint32_t y = 0; y < level_height; y++)
+            {
+                const float* row_0 = &source[(y * 2) * source_width];
+                const float* row_1 = &source[(y * 2 + 1) * source_width];
+                for (uint32_t x = 0; x < level_width; x++)
+                {
+                    destination[y * level_width + x] = Helper::Min(Helper::Min(row_0[x * 2], row_0[x * 2 + 1]), Helper::Min(row_1[x * 2], row_1[x * 2 + 1]));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <vector>
+#include "../Math/Matrix.h"
+#include "../Math/Vector3.h"
+#include "../Math/BoundingBox.h"
+#include "../Core/Spartan_Definitions.h"
+//=================================
+
+namespace Spartan
+{
+    class Threading;
+    struct RHI_Vertex_PosTexNorTan;
+
+    // Rasterizes a few large meshes (occluders) into a small depth buffer on the CPU, then tests bounding boxes
+    // against a min depth pyramid of it, so that whatever is hidden behind them can be skipped before any draw.
+    // Depth is stored as 1/w (bigger is closer, empty is zero), which is linear in screen space and doesn't care
+    // about reverse-z. The test is conservative, occluders fill the pixels with the farthest depth they have in them,
+    // and boxes are tested against a ring of extra pixels, as the pixels along the edges of occluders are partially
+    // covered. So a visible box is never reported as hidden.
+    class SPARTAN_CLASS OcclusionCuller
+    {
+    public:
+        static constexpr uint32_t width         = 256;
+        static constexpr uint32_t height        = 128;
+        static constexpr uint32_t band_height   = 8; // rows rasterized by a single thread
+
+        struct Occluder
+        {
+            const RHI_Vertex_PosTexNorTan* vertices = nullptr;
+            const uint32_t* indices                 = nullptr; // relative to vertices
+            uint32_t index_count                    = 0;
+            Math::Matrix transform;                             // to world space
+        };
+
+        OcclusionCuller() = default;
+        ~OcclusionCuller() = default;
+
+        // Only works with perspective projections, near_plane is the view space depth of the near plane
+        void Rasterize(const Math::Matrix& view_projection, float near_plane, const std::vector<Occluder>& occluders, Threading* threading = nullptr);
+        bool IsVisible(const Math::BoundingBox& aabb) const;
+
+        uint32_t GetLevelCount()                            const { return static_cast<uint32_t>(m_levels.size()); }
+        const std::vector<float>& GetLevel(uint32_t level)  const { return m_levels[level]; } // (width >> level) x (height >> level), top row first
+
+    private:
+        struct Triangle
+        {
+            float x[3];
+            float y[3];
+            float depth[3];
+        };
+
+        void Transform(const Occluder& occluder, std::vector<Triangle>& triangles) const;
+        void RasterizeBand(uint32_t band);
+        void BuildPyramid();
+
+        Math::Matrix m_view_projection;
+        float m_near_plane = 0.0f;
+        std::vector<std::vector<Triangle>> m_triangles; // per occluder
+        std::vector<std::vector<float>> m_levels;       // the depth buffer and then every mip of it
+    };
+}
@@ -0,0 +1,88 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===========
+#include "Spartan.h"
+#include "RenderQueue.h"
+#include <array>
+//======================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    void RenderQueue::Sort()
+    {
+        const uint32_t count = static_cast<uint32_t>(m_items.size());
+        if (count < 2)
+            return;
+
+        m_items_scratch.resize(count);
+        Item* source        = m_items.data();
+        Item* destination   = m_items_scratch.data();
+
+        // Least significant byte first, each pass is stable so the order of the previous ones is kept
+        for (uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            array<uint32_t, 256> offsets = {};
+            for (uint32_t i = 0; i < count; i++)
+            {
+                offsets[(source[i].key >> shift) & 0xFF]++;
+            }
+
+            // All the keys share this byte, so the pass wouldn't change anything
+            if (offsets[(source[0].key >> shift) & 0xFF] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (uint32_t& bucket : offsets)
+            {
+                const uint32_t bucket_count = bucket;
+                bucket = offset;
+                offset += bucket_count;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+            }
+
+            swap(source, destination);
+        }
+
+        // The last pass might have written into the scratch buffer
+        if (source != m_items.data())
+        {
+            m_items.swap(m_items_scratch);
+        }
+    }
+
+    void RenderQueue::GetIndices(vector<uint32_t>& indices) const
+    {
+        indices.resize(m_items.size());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_items.size()); i++)
+        {
+            indices[i] = m_items[i].index;
+        }
+    }
+}
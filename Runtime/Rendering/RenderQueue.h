@@ -0,0 +1,80 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <vector>
+#include "../Core/Spartan_Definitions.h"
+//=================================
+
+namespace Spartan
+{
+    // A list of draws, each one identified by the index of a renderable and described by a 64-bit key.
+    // Keys are composed so that sorting them groups the draws which share a shader, a material and geometry,
+    // which keeps rebinding to a minimum when the passes walk through them in order.
+    class SPARTAN_CLASS RenderQueue
+    {
+    public:
+        RenderQueue() = default;
+        ~RenderQueue() = default;
+
+        void Clear()                                        { m_items.clear(); }
+        void Add(const uint64_t key, const uint32_t index)  { m_items.push_back({ key, index }); }
+
+        // Radix sort (stable), bytes which are the same for all the keys are skipped
+        void Sort();
+
+        // Writes the renderable indices in the sorted order
+        void GetIndices(std::vector<uint32_t>& indices) const;
+
+        //= KEYS ===================================================================================================================
+        // State first, then front to back (opaque)
+        static uint64_t KeyState(const uint16_t shader, const uint16_t material, const uint16_t geometry, const uint16_t depth)
+        {
+            return (static_cast<uint64_t>(shader) << 48) | (static_cast<uint64_t>(material) << 32) | (static_cast<uint64_t>(geometry) << 16) | depth;
+        }
+
+        // Back to front first, then state (transparent)
+        static uint64_t KeyDepth(const uint16_t depth, const uint16_t shader, const uint16_t material, const uint16_t geometry)
+        {
+            return (static_cast<uint64_t>(0xFFFF - depth) << 48) | (static_cast<uint64_t>(shader) << 32) | (static_cast<uint64_t>(material) << 16) | geometry;
+        }
+
+        // Maps a distance in [0, distance_max] to 16 bits
+        static uint16_t QuantizeDepth(const float distance, const float distance_max)
+        {
+            const float depth = distance_max > 0.0f ? distance / distance_max : 0.0f;
+            return static_cast<uint16_t>((depth <= 0.0f ? 0.0f : depth >= 1.0f ? 1.0f : depth) * 65535.0f);
+        }
+        //==========================================================================================================================
+
+    private:
+        struct Item
+        {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        std::vector<Item> m_items;
+        std::vector<Item> m_items_scratch;
+    };
+}
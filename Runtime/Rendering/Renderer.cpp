@@ -23,13 +23,17 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "Renderer.h"
 #include "Model.h"
+#include "Mesh.h"
 #include "ShaderGBuffer.h"
+#include "ShaderLight.h"
 #include "Font/Font.h"
 #include "Gizmos/Grid.h"
 #include "Gizmos/Transform_Gizmo.h"
 #include "../Utilities/Sampling.h"
 #include "../Profiling/Profiler.h"
 #include "../Resource/ResourceCache.h"
+#include "../World/World.h"
+#include "../World/TransformHierarchy.h"
 #include "../World/Entity.h"
 #include "../World/Components/Transform.h"
 #include "../World/Components/Renderable.h"
@@ -38,6 +42,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Device.h"
 #include "../RHI/RHI_PipelineCache.h"
 #include "../RHI/RHI_ConstantBuffer.h"
+#include "../RHI/RHI_StructuredBuffer.h"
 #include "../RHI/RHI_CommandList.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_SwapChain.h"
@@ -72,25 +77,30 @@ namespace Spartan
         m_options |= Render_Sharpening_LumaSharpen;
         m_options |= Render_FilmGrain;
         m_options |= Render_ChromaticAberration;
+        m_options |= Render_ClusteredLighting;
+        m_options |= Render_OcclusionCulling;
+        m_options |= Render_TextureStreaming;
 
         // Option values
-        m_option_values[Option_Value_Anisotropy]        = 16.0f;
-        m_option_values[Option_Value_ShadowResolution]  = 2048.0f;
-        m_option_values[Option_Value_Tonemapping]       = static_cast<float>(Renderer_ToneMapping_ACES);
-        m_option_values[Option_Value_Gamma]             = 2.2f;
-        m_option_values[Option_Value_Sharpen_Strength]  = 1.0f;
-        m_option_values[Option_Value_Sharpen_Clamp]     = 0.35f;
-        m_option_values[Option_Value_Bloom_Intensity]   = 0.1f;
+        m_option_values[Option_Value_Anisotropy]              = 16.0f;
+        m_option_values[Option_Value_ShadowResolution]        = 2048.0f;
+        m_option_values[Option_Value_Tonemapping]             = static_cast<float>(Renderer_ToneMapping_ACES);
+        m_option_values[Option_Value_Gamma]                   = 2.2f;
+        m_option_values[Option_Value_Sharpen_Strength]        = 1.0f;
+        m_option_values[Option_Value_Sharpen_Clamp]           = 0.35f;
+        m_option_values[Option_Value_Bloom_Intensity]         = 0.1f;
+        m_option_values[Option_Value_TextureStreaming_Budget] = 1024.0f;
 
 		// Subscribe to events
-		SUBSCRIBE_TO_EVENT(Event_World_Resolve_Complete,    EVENT_HANDLER_VARIANT(RenderablesAcquire));
-        SUBSCRIBE_TO_EVENT(Event_World_Unload,              EVENT_HANDLER(ClearEntities));
+		m_event_world_resolve_complete  = SUBSCRIBE_TO_EVENT(Event_World_Resolve_Complete,  EVENT_HANDLER_DATA(RenderablesAcquire));
+        m_event_world_unload            = SUBSCRIBE_TO_EVENT(Event_World_Unload,            EVENT_HANDLER(ClearEntities));
 	}
 
 	Renderer::~Renderer()
 	{
 		// Unsubscribe from events
-		UNSUBSCRIBE_FROM_EVENT(Event_World_Resolve_Complete, EVENT_HANDLER_VARIANT(RenderablesAcquire));
+		UNSUBSCRIBE_FROM_EVENT(m_event_world_resolve_complete);
+		UNSUBSCRIBE_FROM_EVENT(m_event_world_unload);
 
 		m_entities.clear();
 		m_camera = nullptr;
@@ -104,6 +114,7 @@ namespace Spartan
         // Get required systems		
         m_resource_cache    = m_context->GetSubsystem<ResourceCache>();
         m_profiler          = m_context->GetSubsystem<Profiler>();
+        m_threading         = m_context->GetSubsystem<Threading>();
 
         // Resolution, viewport and swapchain default to whatever the window size is
         const WindowData& window_data = m_context->m_engine->GetWindowData();
@@ -195,17 +206,339 @@ namespace Spartan
         if (m_swap_chain && !m_swap_chain->IsPresenting())
             return;
 
+        // Capture into the snapshot which is not being recorded
+        m_snapshot_index = (m_snapshot_index + 1) % static_cast<uint32_t>(m_snapshots.size());
+        RendererSnapshot& snapshot = m_snapshots[m_snapshot_index];
+        SnapshotCapture(snapshot);
+
+        // When pipelined, the snapshot is recorded while the next frame is simulated (see RecordAsync())
+        m_snapshot_pending = m_context->m_engine->EngineMode_IsSet(Engine_Pipelined);
+        if (!m_snapshot_pending)
+        {
+            RecordWait(); // in case pipelining was just disabled
+            SnapshotRecord(snapshot);
+        }
+	}
+
+    void Renderer::RecordAsync()
+    {
+        if (!m_snapshot_pending)
+            return;
+
+        m_snapshot_pending          = false;
+        RendererSnapshot* snapshot  = &m_snapshots[m_snapshot_index];
+        m_record_task               = m_threading->AddTask([this, snapshot]() { SnapshotRecord(*snapshot); });
+    }
+
+    void Renderer::RecordWait()
+    {
+        // Don't help, the calling thread could pick up a task which waits for the simulation (e.g. world loading)
+        m_threading->Wait(m_record_task, false);
+        m_record_task = TaskHandle();
+    }
+
+    // Converts luminous power to luminous intensity
+    static float get_luminous_intensity(const Light* light, const float exposure)
+    {
+        float luminous_intensity = light->GetIntensity() * exposure;
+        if (light->GetLightType() == Light_Point)
+        {
+            luminous_intensity /= Math::Helper::PI_4; // lumens to candelas
+            luminous_intensity *= 255.0f; // this is a hack, must fix whats my color units
+        }
+        else if (light->GetLightType() == Light_Spot)
+        {
+            luminous_intensity /= Math::Helper::PI; // lumens to candelas
+            luminous_intensity *= 255.0f; // this is a hack, must fix whats my color units
+        }
+
+        return luminous_intensity;
+    }
+
+    void Renderer::SnapshotCapture(RendererSnapshot& snapshot)
+    {
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        snapshot.Clear();
+
+        // Entities and camera
+        {
+            lock_guard<mutex> lock(m_mutex_entities);
+
+            // Keep the bounding volume hierarchy up to date with whatever moved since the last capture
+            TransformHierarchy* transform_hierarchy = m_context->GetSubsystem<World>()->GetTransformHierarchy();
+            transform_hierarchy->ConsumeMoved(m_transforms_moved);
+            const unordered_map<const Entity*, uint32_t>& slots = m_entity_slots[Renderer_Object_Opaque];
+            for (const uint32_t index : m_transforms_moved)
+            {
+                const Transform* transform = transform_hierarchy->GetOwner(index);
+                if (!transform)
+                    continue;
+
+                const auto it = slots.find(transform->GetEntity());
+                if (it != slots.end())
+                {
+                    // A static renderable which starts moving has to be taken out of the shadow caches which contain it
+                    const uint32_t slot = it->second;
+                    if (m_renderable_static_countdown[slot] == 0)
+                    {
+                        m_shadow_static_changes.emplace_back(m_aabb_tree.GetBox(m_aabb_tree_proxies[slot]));
+                    }
+                    m_renderable_static_countdown[slot] = m_shadow_static_frames;
+
+                    m_aabb_tree.Move(m_aabb_tree_proxies[slot], transform->GetEntity()->GetRenderable()->GetAabb());
+                }
+            }
+
+            // Renderables which stopped moving a while ago are added to the shadow caches which contain them
+            for (uint32_t slot = 0; slot < static_cast<uint32_t>(m_renderable_static_countdown.size()); slot++)
+            {
+                uint8_t& countdown = m_renderable_static_countdown[slot];
+                if (countdown != 0 && --countdown == 0)
+                {
+                    m_shadow_static_changes.emplace_back(m_aabb_tree.GetBox(m_aabb_tree_proxies[slot]));
+                }
+            }
+
+            for (const auto& it : m_entities)
+            {
+                vector<Entity*>& entities = snapshot.entities[it.first];
+                entities = it.second;
+
+                for (Entity* entity : entities)
+                {
+                    snapshot.references.emplace_back(entity->GetPtrShared());
+                }
+            }
+
+            if (m_camera)
+            {
+                snapshot.camera               = m_camera;
+                snapshot.camera_view          = m_camera->GetViewMatrix();
+                snapshot.camera_projection    = m_camera->GetProjectionMatrix();
+                snapshot.camera_position      = m_camera->GetTransform()->GetPosition();
+                snapshot.camera_direction     = m_camera->GetTransform()->GetForward();
+                snapshot.camera_frustum       = m_camera->GetFrustum();
+                snapshot.camera_near          = m_camera->GetNearPlane();
+                snapshot.camera_far           = m_camera->GetFarPlane();
+                snapshot.camera_aperture      = m_camera->GetAperture();
+                snapshot.camera_shutter_speed = m_camera->GetShutterSpeed();
+                snapshot.camera_iso           = m_camera->GetIso();
+                snapshot.camera_exposure      = m_camera->GetExposure();
+            }
+        }
+
+        // Capture transforms, bounding boxes, materials and levels of detail, in the same order as the renderables
+        const bool perspective = snapshot.camera && snapshot.camera->GetProjectionType() == Projection_Perspective;
+        m_material_slots.clear();
+        for (Entity* entity : snapshot.entities[Renderer_Object_Opaque])
+        {
+            Renderable* renderable = entity->GetRenderable();
+            snapshot.transforms.emplace_back(entity->GetTransform()->GetMatrix());
+            snapshot.renderable_materials.emplace_back(SnapshotCaptureMaterial(snapshot, renderable ? renderable->GetMaterial() : nullptr));
+            const BoundingBox& aabb = snapshot.aabbs.emplace_back(renderable ? renderable->GetAabb() : BoundingBox());
+
+            // The projected diameter of the bounding sphere over the screen height
+            uint32_t lod = 0;
+            if (renderable && snapshot.camera && renderable->GeometryLodCount() > 1)
+            {
+                const float radius      = aabb.GetExtents().Length();
+                const float distance    = perspective ? Helper::Max(Vector3::Distance(aabb.GetCenter(), snapshot.camera_position), Helper::M_EPSILON) : 1.0f;
+                lod                     = renderable->LodSelect(radius * snapshot.camera_projection.m11 / distance);
+            }
+            snapshot.lods.emplace_back(static_cast<uint8_t>(lod));
+            snapshot.lods_shadow.emplace_back(static_cast<uint8_t>(renderable ? Helper::Min(lod + m_lod_shadow_bias, renderable->GeometryLodCount() - 1) : 0));
+        }
+
+        // Lights
+        for (Entity* entity : snapshot.entities[Renderer_Object_Light])
+        {
+            RendererSnapshot::LightData& light_data = snapshot.lights.emplace_back();
+
+            if (Light* light = entity->GetComponent<Light>())
+            {
+                light_data.light                = light;
+                light_data.shadow_map           = light->GetShadowMap();
+                light_data.position             = light->GetTransform()->GetPosition();
+                light_data.direction            = light->GetDirection();
+                light_data.type                 = light->GetLightType();
+                light_data.color                = light->GetColor();
+                light_data.intensity            = light->GetIntensity();
+                light_data.luminous_intensity   = get_luminous_intensity(light, snapshot.camera_exposure);
+                light_data.range                = light->GetRange();
+                light_data.angle                = light->GetAngle();
+                light_data.bias                 = light->GetBias();
+                light_data.normal_bias          = light->GetNormalBias();
+                light_data.shadow_array_size    = light->GetShadowArraySize();
+                light_data.shadows              = light->GetShadowsEnabled();
+                light_data.shadows_transparent  = light->GetShadowsTransparentEnabled();
+                light_data.shader_flags         = ShaderLight::GetFlags(light, m_options);
+                light_data.position_screen      = m_camera ? m_camera->Project(light_data.position) : Vector2::Zero;
+
+                for (uint32_t i = 0; i < light->GetShadowArraySize(); i++)
+                {
+                    light_data.view_projection[i] = light->GetViewMatrix(i) * light->GetProjectionMatrix(i);
+                }
+            }
+        }
+
+        // Point and spot lights without shadows don't need a pass of their own, they are binned into the camera's clusters instead
+        if (GetOption(Render_ClusteredLighting) && snapshot.camera && snapshot.camera->GetProjectionType() == Projection_Perspective)
+        {
+            m_cluster_spheres.clear();
+            for (uint32_t i = 0; i < static_cast<uint32_t>(snapshot.lights.size()); i++)
+            {
+                RendererSnapshot::LightData& light_data = snapshot.lights[i];
+                if (!light_data.light || light_data.type == Light_Directional || light_data.shadows || light_data.intensity == 0)
+                    continue;
+
+                // A spot light is bounded by the sphere of its range
+                light_data.clustered = true;
+                snapshot.lights_clustered.emplace_back(i);
+                m_cluster_spheres.push_back({ light_data.position, light_data.range });
+            }
+
+            snapshot.light_clusters.Build(snapshot.camera_view, snapshot.camera_projection, snapshot.camera_near, snapshot.camera_far, m_cluster_spheres);
+        }
+
+        ShadowsPrepare(snapshot);
+        RenderablesCull(snapshot);
+
+        // Texture streaming, the captured materials of the visible renderables request mips from their size on the screen
+        {
+            const bool streaming = GetOption(Render_TextureStreaming);
+            if (streaming && snapshot.camera)
+            {
+                for (const Renderer_Object_Type type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+                {
+                    for (const uint32_t index : snapshot.visible[type])
+                    {
+                        const uint32_t material_index = snapshot.renderable_materials[index];
+                        if (material_index == RendererSnapshot::material_none)
+                            continue;
+
+                        // The projected diameter of the bounding sphere, in pixels
+                        const BoundingBox& aabb     = snapshot.aabbs[index];
+                        const float radius          = aabb.GetExtents().Length();
+                        const float distance        = perspective ? Helper::Max(Vector3::Distance(aabb.GetCenter(), snapshot.camera_position), Helper::M_EPSILON) : 1.0f;
+                        const float screen_size     = radius * snapshot.camera_projection.m11 / distance * m_resolution.y;
+
+                        const RendererSnapshot::MaterialData& material = snapshot.materials[material_index];
+                        for (const shared_ptr<RHI_Texture>& texture : material.textures)
+                        {
+                            m_texture_streamer.Request(texture, material.tiling, screen_size);
+                        }
+                    }
+                }
+            }
+
+            // When it's disabled, the textures which are streaming go back to full resolution
+            const uint64_t budget = static_cast<uint64_t>(GetOptionValue<double>(Option_Value_TextureStreaming_Budget) * 1000.0 * 1000.0);
+            m_texture_streamer.Update(streaming ? budget : numeric_limits<uint64_t>::max(), m_threading, !streaming);
+        }
+
+        // Debug primitives read from the world, so they are generated here instead of during recording
+        if (m_camera)
+        {
+            if (GetOption(Render_Debug_PickingRay))
+            {
+                const auto& ray = m_camera->GetPickingRay();
+                DrawLine(ray.GetStart(), ray.GetStart() + ray.GetDirection() * m_camera->GetFarPlane(), Vector4(0, 1, 0, 1));
+            }
+
+            if (GetOption(Render_Debug_Lights))
+            {
+                for (const RendererSnapshot::LightData& light_data : snapshot.lights)
+                {
+                    if (light_data.light && light_data.light->GetLightType() == Light_Spot)
+                    {
+                        const Vector3 end = light_data.light->GetTransform()->GetForward() * light_data.light->GetRange();
+                        DrawLine(light_data.position, light_data.position + end, Vector4(0, 1, 0, 1));
+                    }
+                }
+            }
+
+            if (GetOption(Render_Debug_Aabb))
+            {
+                for (const BoundingBox& aabb : snapshot.aabbs)
+                {
+                    DrawBox(aabb, Vector4(0.41f, 0.86f, 1.0f, 1.0f));
+                }
+            }
+
+            // The gizmo reads input and the selected entity, it can also draw lines
+            snapshot.transform_gizmo_visible = GetOption(Render_Debug_Transform) && m_gizmo_transform->Update(m_camera.get(), m_gizmo_transform_size, m_gizmo_transform_speed);
+        }
+
+        // Hand over the lines (the empty snapshot lists are recycled)
+        snapshot.lines_depth_enabled.swap(m_lines_list_depth_enabled);
+        snapshot.lines_depth_disabled.swap(m_lines_list_depth_disabled);
+    }
+
+    uint32_t Renderer::SnapshotCaptureMaterial(RendererSnapshot& snapshot, Material* material)
+    {
+        if (!material)
+            return RendererSnapshot::material_none;
+
+        // Renderables which share a material share its copy
+        const auto it = m_material_slots.find(material);
+        if (it != m_material_slots.end())
+            return it->second;
+
+        const uint32_t slot = static_cast<uint32_t>(snapshot.materials.size());
+        m_material_slots[material] = slot;
+
+        RendererSnapshot::MaterialData& material_data = snapshot.materials.emplace_back();
+        material_data.id                    = material->GetId();
+        material_data.flags                 = material->GetFlags();
+        material_data.albedo                = material->GetColorAlbedo();
+        material_data.tiling                = material->GetTiling();
+        material_data.offset                = material->GetOffset();
+        material_data.roughness             = material->GetProperty(Material_Roughness);
+        material_data.metallic              = material->GetProperty(Material_Metallic);
+        material_data.normal                = material->GetProperty(Material_Normal);
+        material_data.height                = material->GetProperty(Material_Height);
+        material_data.clearcoat             = material->GetProperty(Material_Clearcoat);
+        material_data.clearcoat_roughness   = material->GetProperty(Material_Clearcoat_Roughness);
+        material_data.anisotropic           = material->GetProperty(Material_Anisotropic);
+        material_data.anisotropic_rotation  = material->GetProperty(Material_Anisotropic_Rotation);
+        material_data.sheen                 = material->GetProperty(Material_Sheen);
+        material_data.sheen_tint            = material->GetProperty(Material_Sheen_Tint);
+
+        // The references keep the textures alive while recording, even if the material lets go of them
+        static const array<Material_Property, 8> texture_types =
+        {
+            Material_Color, Material_Roughness, Material_Metallic, Material_Normal, Material_Height, Material_Occlusion, Material_Emission, Material_Mask
+        };
+        for (uint32_t i = 0; i < static_cast<uint32_t>(texture_types.size()); i++)
+        {
+            material_data.textures[i] = material->GetTexture_PtrShared(texture_types[i]);
+        }
+
+        return slot;
+    }
+
+    void Renderer::SnapshotRecord(RendererSnapshot& snapshot)
+    {
+        m_snapshot = &snapshot;
+
+        // Release what streaming replaced, once no frame in flight can be sampling it anymore (the extra frame covers the command list which hasn't been waited on yet)
+        m_rhi_device->ReleaseRetired(m_frame_num, m_swap_chain->GetBufferCount() + 1);
+
+        // Swap in the mips which have been read since the last frame, before anything gets to bind the textures
+        m_texture_streamer.Apply();
+
 		// If there is no camera, clear
-		if (!m_camera)
+		if (!snapshot.camera)
 		{
             //cmd_list->Clear(m_render_targets[RenderTarget_Composition_Ldr].get(), Vector4(0.0f, 0.0f, 0.0f, 1.0f));
 			return;
 		}
 
 		// If there are no entities, clear to the camera's clear color
-		if (m_entities.empty())
+		if (snapshot.references.empty())
 		{
-            //cmd_list->Clear(m_render_targets[RenderTarget_Composition_Ldr].get(), m_camera->GetClearColor());
+            //cmd_list->Clear(m_render_targets[RenderTarget_Composition_Ldr].get(), snapshot.camera->GetClearColor());
 			return;
 		}
 
@@ -218,17 +551,17 @@ namespace Spartan
 
 		// Get camera matrices
 		{
-            if (m_update_ortho_proj || m_near_plane != m_camera->GetNearPlane() || m_far_plane != m_camera->GetFarPlane())
+            if (m_update_ortho_proj || m_near_plane != snapshot.camera_near || m_far_plane != snapshot.camera_far)
             {
                 m_buffer_frame_cpu.projection_ortho         = Matrix::CreateOrthographicLH(m_viewport.width, m_viewport.height, m_near_plane, m_far_plane);
                 m_buffer_frame_cpu.view_projection_ortho    = Matrix::CreateLookAtLH(Vector3(0, 0, -m_near_plane), Vector3::Forward, Vector3::Up) * m_buffer_frame_cpu.projection_ortho;
                 m_update_ortho_proj                         = false;
             }
 
-            m_near_plane	                = m_camera->GetNearPlane();
-            m_far_plane		                = m_camera->GetFarPlane();
-            m_buffer_frame_cpu.view		    = m_camera->GetViewMatrix();
-            m_buffer_frame_cpu.projection   = m_camera->GetProjectionMatrix();
+            m_near_plane	                = snapshot.camera_near;
+            m_far_plane		                = snapshot.camera_far;
+            m_buffer_frame_cpu.view		    = snapshot.camera_view;
+            m_buffer_frame_cpu.projection   = snapshot.camera_projection;
 
 			// TAA - Generate jitter
 			if (GetOption(Render_AntiAliasing_Taa))
@@ -252,12 +585,10 @@ namespace Spartan
             // Compute some TAA affected matrices
             m_buffer_frame_cpu.view_projection              = m_buffer_frame_cpu.view * m_buffer_frame_cpu.projection;
             m_buffer_frame_cpu.view_projection_inv          = Matrix::Invert(m_buffer_frame_cpu.view_projection);   
-            m_buffer_frame_cpu.view_projection_unjittered   = m_buffer_frame_cpu.view * m_camera->GetProjectionMatrix();
+            m_buffer_frame_cpu.view_projection_unjittered   = m_buffer_frame_cpu.view * snapshot.camera_projection;
 		}
 
-        m_is_rendering = true;
         Pass_Main(m_swap_chain->GetCmdList());
-        m_is_rendering = false;
 
         m_frame_num++;
         m_is_odd_frame = (m_frame_num % 2) == 1;
@@ -374,13 +705,13 @@ namespace Spartan
         }
 
         // Struct is updated automatically here as per frame data are (by definition) known ahead of time
-        m_buffer_frame_cpu.camera_aperture              = m_camera->GetAperture();
-        m_buffer_frame_cpu.camera_shutter_speed         = m_camera->GetShutterSpeed();
-        m_buffer_frame_cpu.camera_iso                   = m_camera->GetIso();
-        m_buffer_frame_cpu.camera_near                  = m_camera->GetNearPlane();
-        m_buffer_frame_cpu.camera_far                   = m_camera->GetFarPlane();
-        m_buffer_frame_cpu.camera_position              = m_camera->GetTransform()->GetPosition();
-        m_buffer_frame_cpu.camera_direction             = m_camera->GetTransform()->GetForward();
+        m_buffer_frame_cpu.camera_aperture              = m_snapshot->camera_aperture;
+        m_buffer_frame_cpu.camera_shutter_speed         = m_snapshot->camera_shutter_speed;
+        m_buffer_frame_cpu.camera_iso                   = m_snapshot->camera_iso;
+        m_buffer_frame_cpu.camera_near                  = m_snapshot->camera_near;
+        m_buffer_frame_cpu.camera_far                   = m_snapshot->camera_far;
+        m_buffer_frame_cpu.camera_position              = m_snapshot->camera_position;
+        m_buffer_frame_cpu.camera_direction             = m_snapshot->camera_direction;
         m_buffer_frame_cpu.bloom_intensity              = m_option_values[Option_Value_Bloom_Intensity];
         m_buffer_frame_cpu.sharpen_strength             = m_option_values[Option_Value_Sharpen_Strength];
         m_buffer_frame_cpu.sharpen_clamp                = m_option_values[Option_Value_Sharpen_Clamp];
@@ -395,12 +726,12 @@ namespace Spartan
         m_buffer_frame_cpu.frame                        = static_cast<uint32_t>(m_frame_num);
 
         // Update directional light intensity, just grab the first one
-        for (const auto& entity : m_entities[Renderer_Object_Light])
-            if (Light* light = entity->GetComponent<Light>())
+        for (const RendererSnapshot::LightData& light_data : m_snapshot->lights)
+            if (light_data.light)
             {
-                if (light->GetLightType() == Light_Directional)
+                if (light_data.type == Light_Directional)
                 {
-                    m_buffer_frame_cpu.directional_light_intensity = light->GetIntensity();
+                    m_buffer_frame_cpu.directional_light_intensity = light_data.intensity;
                 }
             }
 
@@ -424,16 +755,16 @@ namespace Spartan
         // Update
         for (uint32_t i = 0; i < m_max_material_instances; i++)
         {
-            Material* material = m_material_instances[i];
+            const RendererSnapshot::MaterialData* material = m_material_instances[i];
             if (!material)
                 continue;
 
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].x = material->GetProperty(Material_Clearcoat);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].y = material->GetProperty(Material_Clearcoat_Roughness);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].z = material->GetProperty(Material_Anisotropic);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].w = material->GetProperty(Material_Anisotropic_Rotation);
-            buffer->mat_sheen_sheenTint_pad[i].x                   = material->GetProperty(Material_Sheen);
-            buffer->mat_sheen_sheenTint_pad[i].y                   = material->GetProperty(Material_Sheen_Tint);
+            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].x = material->clearcoat;
+            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].y = material->clearcoat_roughness;
+            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].z = material->anisotropic;
+            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].w = material->anisotropic_rotation;
+            buffer->mat_sheen_sheenTint_pad[i].x                   = material->sheen;
+            buffer->mat_sheen_sheenTint_pad[i].y                   = material->sheen_tint;
         }
 
         // Unmap
@@ -528,9 +859,104 @@ namespace Spartan
         return cmd_list->SetConstantBuffer(3, RHI_Shader_Vertex, m_buffer_object_gpu);
     }
 
-    bool Renderer::UpdateLightBuffer(const Light* light)
+    // Re-allocates a structured buffer with double size (if needed)
+    template<typename T>
+    static bool reserve_structured_buffer(RHI_StructuredBuffer* buffer, const uint32_t element_count)
+    {
+        if (element_count <= buffer->GetElementCount())
+            return true;
+
+        const uint32_t new_size = Math::Helper::NextPowerOfTwo(element_count);
+        if (!buffer->Create<T>(new_size))
+        {
+            LOG_ERROR("Failed to re-allocate %s buffer with %d elements", buffer->GetName().c_str(), new_size);
+            return false;
+        }
+        LOG_INFO("Increased %s buffer size to %d, that's %d kb", buffer->GetName().c_str(), new_size, (new_size * buffer->GetStride()) / 1000);
+
+        return true;
+    }
+
+    bool Renderer::UpdateInstanceBuffer()
+    {
+        const uint32_t instance_count = m_snapshot->instance_count;
+        if (instance_count == 0)
+            return true;
+
+        if (!reserve_structured_buffer<BufferInstance>(m_buffer_instance_gpu.get(), instance_count))
+            return false;
+
+        // Map
+        BufferInstance* instances = static_cast<BufferInstance*>(m_buffer_instance_gpu->Map());
+        if (!instances)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        const auto& entities    = m_snapshot->entities[Renderer_Object_Opaque];
+        const auto& transforms  = m_snapshot->transforms;
+
+        // Camera, the G-Buffer also needs last frame's matrix to compute velocity
+        for (const Renderer_Object_Type object_type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+        {
+            const vector<uint32_t>& visible = m_snapshot->visible[object_type];
+            for (const RendererSnapshot::Batch& batch : m_snapshot->batches[object_type])
+            {
+                for (uint32_t i = 0; i < batch.count; i++)
+                {
+                    const uint32_t index        = visible[batch.first + i];
+                    BufferInstance& instance    = instances[batch.instance_offset + i];
+                    const Matrix wvp_current    = transforms[index] * m_buffer_frame_cpu.view_projection;
+
+                    instance.transform      = transforms[index];
+                    instance.wvp_previous   = wvp_current;
+                    if (Transform* transform = entities[index]->GetTransform())
+                    {
+                        instance.wvp_previous = transform->GetWvpLastFrame();
+
+                        // Save matrix for velocity computation (only the renderer touches it)
+                        transform->SetWvpLastFrame(wvp_current);
+                    }
+                }
+            }
+        }
+
+        // Shadow casters, the light's view projection comes from the object buffer
+        for (const RendererSnapshot::LightData& light_data : m_snapshot->lights)
+        {
+            for (uint32_t slice = 0; slice < static_cast<uint32_t>(light_data.casters.size()); slice++)
+            {
+                for (uint32_t object_type = 0; object_type < 2; object_type++)
+                {
+                    const vector<uint32_t>& casters = light_data.casters[slice][object_type];
+                    for (const RendererSnapshot::Batch& batch : light_data.caster_batches[slice][object_type])
+                    {
+                        for (uint32_t i = 0; i < batch.count; i++)
+                        {
+                            instances[batch.instance_offset + i].transform = transforms[casters[batch.first + i]];
+                        }
+                    }
+                }
+
+                const vector<uint32_t>& casters_static = light_data.casters_static[slice];
+                for (const RendererSnapshot::Batch& batch : light_data.caster_static_batches[slice])
+                {
+                    for (uint32_t i = 0; i < batch.count; i++)
+                    {
+                        instances[batch.instance_offset + i].transform = transforms[casters_static[batch.first + i]];
+                    }
+                }
+            }
+        }
+
+        // Unmap
+        return m_buffer_instance_gpu->Unmap();
+    }
+
+    bool Renderer::UpdateLightBuffer(const RendererSnapshot::LightData& light_data)
     {
-        if (!light)
+        if (!light_data.light)
             return false;
 
         // Only update if needed
@@ -548,29 +974,16 @@ namespace Spartan
         const bool volumetric         = static_cast<float>(m_options & Render_VolumetricLighting);
         const bool contact_shadows    = static_cast<float>(m_options & Render_ScreenSpaceShadows);
 
-        for (uint32_t i = 0; i < light->GetShadowArraySize(); i++)
-        {
-            m_buffer_light_cpu.view_projection[i] = light->GetViewMatrix(i) * light->GetProjectionMatrix(i);
-        }
-
-        // Convert luminous power to luminous intensity
-        float luminous_intensity = light->GetIntensity() * m_camera->GetExposure();
-        if (light->GetLightType() == Light_Point)
+        for (uint32_t i = 0; i < light_data.shadow_array_size; i++)
         {
-            luminous_intensity /= Math::Helper::PI_4; // lumens to candelas
-            luminous_intensity *= 255.0f; // this is a hack, must fix whats my color units
-        }
-        else if (light->GetLightType() == Light_Spot)
-        {
-            luminous_intensity /= Math::Helper::PI; // lumens to candelas
-            luminous_intensity *= 255.0f; // this is a hack, must fix whats my color units
+            m_buffer_light_cpu.view_projection[i] = light_data.view_projection[i];
         }
 
-        m_buffer_light_cpu.intensity_range_angle_bias   = Vector4(luminous_intensity, light->GetRange(), light->GetAngle(), GetOption(Render_ReverseZ) ? light->GetBias() : -light->GetBias());
-        m_buffer_light_cpu.color                        = light->GetColor();
-        m_buffer_light_cpu.normal_bias                  = light->GetNormalBias();
-        m_buffer_light_cpu.position                     = light->GetTransform()->GetPosition();
-        m_buffer_light_cpu.direction                    = light->GetDirection();
+        m_buffer_light_cpu.intensity_range_angle_bias   = Vector4(light_data.luminous_intensity, light_data.range, light_data.angle, GetOption(Render_ReverseZ) ? light_data.bias : -light_data.bias);
+        m_buffer_light_cpu.color                        = light_data.color;
+        m_buffer_light_cpu.normal_bias                  = light_data.normal_bias;
+        m_buffer_light_cpu.position                     = light_data.position;
+        m_buffer_light_cpu.direction                    = light_data.direction;
 
         // Update
         *buffer = m_buffer_light_cpu;
@@ -580,86 +993,653 @@ namespace Spartan
         return m_buffer_light_gpu->Unmap();
     }
 
-	void Renderer::RenderablesAcquire(const Variant& entities_variant)
+    bool Renderer::UpdateClusterBuffers()
+    {
+        const vector<uint32_t>& lights_clustered = m_snapshot->lights_clustered;
+        if (lights_clustered.empty())
+            return true;
+
+        const LightClusters& clusters           = m_snapshot->light_clusters;
+        const vector<uint32_t>& light_indices   = clusters.GetLightIndices();
+
+        if (!reserve_structured_buffer<BufferClusterLight>(m_buffer_cluster_lights_gpu.get(), static_cast<uint32_t>(lights_clustered.size())))
+            return false;
+
+        if (!reserve_structured_buffer<uint32_t>(m_buffer_cluster_light_indices_gpu.get(), Math::Helper::Max(static_cast<uint32_t>(light_indices.size()), 1u)))
+            return false;
+
+        // Lights
+        {
+            BufferClusterLight* buffer = static_cast<BufferClusterLight*>(m_buffer_cluster_lights_gpu->Map());
+            if (!buffer)
+            {
+                LOG_ERROR("Failed to map buffer");
+                return false;
+            }
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(lights_clustered.size()); i++)
+            {
+                const RendererSnapshot::LightData& light_data   = m_snapshot->lights[lights_clustered[i]];
+                const Vector4& color                            = light_data.color;
+
+                buffer[i].position  = light_data.position;
+                buffer[i].range     = light_data.range;
+                buffer[i].color     = Vector3(color.x, color.y, color.z) * light_data.luminous_intensity;
+                buffer[i].angle     = light_data.angle;
+                buffer[i].direction = light_data.direction;
+                buffer[i].spot      = light_data.type == Light_Spot ? 1 : 0;
+            }
+
+            if (!m_buffer_cluster_lights_gpu->Unmap())
+                return false;
+        }
+
+        // Clusters
+        {
+            void* buffer = m_buffer_clusters_gpu->Map();
+            if (!buffer)
+            {
+                LOG_ERROR("Failed to map buffer");
+                return false;
+            }
+
+            memcpy(buffer, clusters.GetClusters().data(), LightClusters::cluster_count * sizeof(LightClusters::Cluster));
+
+            if (!m_buffer_clusters_gpu->Unmap())
+                return false;
+        }
+
+        // Light indices
+        {
+            void* buffer = m_buffer_cluster_light_indices_gpu->Map();
+            if (!buffer)
+            {
+                LOG_ERROR("Failed to map buffer");
+                return false;
+            }
+
+            if (!light_indices.empty())
+            {
+                memcpy(buffer, light_indices.data(), light_indices.size() * sizeof(uint32_t));
+            }
+
+            return m_buffer_cluster_light_indices_gpu->Unmap();
+        }
+    }
+
+	void Renderer::RenderablesAcquire(const WorldResolve& resolve)
 	{
         SCOPED_TIME_BLOCK(m_profiler);
 
-		// Clear previous state
-		m_entities.clear();
-		m_camera = nullptr;
+        lock_guard<mutex> lock(m_mutex_entities);
 
-		vector<shared_ptr<Entity>> entities = entities_variant.Get<vector<shared_ptr<Entity>>>();
-		for (const auto& entity : entities)
-		{
-			if (!entity || !entity->IsActive())
-				continue;
+        // Rebuild everything
+        if (resolve.reset)
+        {
+            m_entities.clear();
+            m_entity_slots.clear();
+            m_aabb_tree.Clear();
+            m_aabb_tree_proxies.clear();
+            m_renderable_static_countdown.clear();
+            m_shadow_static_changes.clear();
+            m_shadow_static_reset = true;
+            m_camera = nullptr;
+
+            for (const auto& entity : *resolve.entities)
+            {
+                RenderablesAdd(entity.get());
+            }
 
-			// Get all the components we are interested in
-            Renderable* renderable  = entity->GetComponent<Renderable>();
-            Light* light            = entity->GetComponent<Light>();
-            Camera* camera          = entity->GetComponent<Camera>();
+            return;
+        }
 
-			if (renderable)
-			{
-                bool is_transparent = false;
+        // Or only what changed
+        for (const Entity* entity : *resolve.removed)
+        {
+            RenderablesRemove(entity);
+        }
+
+        for (Entity* entity : *resolve.changed)
+        {
+            RenderablesRemove(entity);
+            RenderablesAdd(entity);
+        }
+	}
+
+    void Renderer::RenderablesAdd(Entity* entity)
+    {
+        if (!entity->IsActive())
+            return;
+
+        auto add = [this, entity](const Renderer_Object_Type object_type)
+        {
+            vector<Entity*>& entities = m_entities[object_type];
+            m_entity_slots[object_type][entity] = static_cast<uint32_t>(entities.size());
+            entities.emplace_back(entity);
+        };
+
+        // Opaque and transparent are separated during culling, as materials can change without the world resolving
+        if (Renderable* renderable = entity->GetRenderable())
+        {
+            const uint32_t slot = static_cast<uint32_t>(m_entities[Renderer_Object_Opaque].size());
+            m_aabb_tree_proxies.emplace_back(m_aabb_tree.Insert(renderable->GetAabb(), slot));
+            m_renderable_static_countdown.emplace_back(m_shadow_static_frames); // dynamic, until it proves otherwise
+            add(Renderer_Object_Opaque);
+        }
+
+        if (entity->HasComponent<Light>())
+        {
+            add(Renderer_Object_Light);
+        }
+
+        if (Camera* camera = entity->GetComponent<Camera>())
+        {
+            add(Renderer_Object_Camera);
+            m_camera = camera->GetPtrShared<Camera>();
+        }
+    }
 
-                if (const Material* material = renderable->GetMaterial())
+    void Renderer::RenderablesRemove(const Entity* entity)
+    {
+        // The entity might be destroyed already, so it's only used as a key
+        for (auto& it : m_entity_slots)
+        {
+            unordered_map<const Entity*, uint32_t>& slots = it.second;
+            const auto it_slot = slots.find(entity);
+            if (it_slot == slots.end())
+                continue;
+
+            // Swap with the last one and pop
+            vector<Entity*>& entities   = m_entities[it.first];
+            const uint32_t slot         = it_slot->second;
+            slots.erase(it_slot);
+            if (slot != entities.size() - 1)
+            {
+                entities[slot]          = entities.back();
+                slots[entities[slot]]   = slot;
+            }
+            entities.pop_back();
+
+            // The renderables also have an entry in the bounding volume hierarchy, which moves along
+            if (it.first == Renderer_Object_Opaque)
+            {
+                // A static one leaves a hole in the shadow caches which contain it
+                if (m_renderable_static_countdown[slot] == 0)
                 {
-                    is_transparent = material->GetColorAlbedo().w < 1.0f;
+                    m_shadow_static_changes.emplace_back(m_aabb_tree.GetBox(m_aabb_tree_proxies[slot]));
                 }
+                m_renderable_static_countdown[slot] = m_renderable_static_countdown.back();
+                m_renderable_static_countdown.pop_back();
 
-                m_entities[is_transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque].emplace_back(entity.get());
-			}
+                m_aabb_tree.Remove(m_aabb_tree_proxies[slot]);
+                m_aabb_tree_proxies[slot] = m_aabb_tree_proxies.back();
+                m_aabb_tree_proxies.pop_back();
+                if (slot != m_aabb_tree_proxies.size())
+                {
+                    m_aabb_tree.SetUserData(m_aabb_tree_proxies[slot], slot);
+                }
+            }
+        }
 
-			if (light)
-			{
-				m_entities[Renderer_Object_Light].emplace_back(entity.get());
-			}
+        // Fall back to any other camera
+        if (m_camera && m_camera->GetEntity() == entity)
+        {
+            const vector<Entity*>& cameras = m_entities[Renderer_Object_Camera];
+            m_camera = cameras.empty() ? nullptr : cameras.back()->GetComponent<Camera>()->GetPtrShared<Camera>();
+        }
+    }
 
-			if (camera)
-			{
-				m_entities[Renderer_Object_Camera].emplace_back(entity.get());
-				m_camera = camera->GetPtrShared<Camera>();
-			}
-		}
+    void Renderer::RenderablesCull(RendererSnapshot& snapshot)
+    {
+        SCOPED_TIME_BLOCK(m_profiler);
 
-		RenderablesSort(&m_entities[Renderer_Object_Opaque]);
-		RenderablesSort(&m_entities[Renderer_Object_Transparent]);
-	}
+        // Views, the camera and then every shadow map slice
+        m_cull_frustums.clear();
+        m_cull_views.clear();
+        if (snapshot.camera)
+        {
+            m_cull_frustums.emplace_back(snapshot.camera_frustum);
+            m_cull_views.push_back({ { &snapshot.visible[Renderer_Object_Opaque], &snapshot.visible[Renderer_Object_Transparent], nullptr }, false, false, false });
+        }
 
-	void Renderer::RenderablesSort(vector<Entity*>* renderables)
-	{
-		if (!m_camera || renderables->size() <= 2)
-			return;
+        for (RendererSnapshot::LightData& light_data : snapshot.lights)
+        {
+            if (!light_data.light || !light_data.light->GetShadowsEnabled())
+                continue;
 
-		auto comparison_op = [this](Entity* entity)
-		{
-			auto renderable = entity->GetRenderable();
-			if (!renderable)
-				return 0.0f;
+            // Ensure that potential shadow casters from behind the near plane (or past the far plane) are not rejected
+            const bool ignore_depth = light_data.light->GetLightType() == Light_Directional;
 
-			return (renderable->GetAabb().GetCenter() - m_camera->GetTransform()->GetPosition()).LengthSquared();
-		};
+            const uint32_t slice_count = Helper::Min(static_cast<uint32_t>(light_data.shadow_map.slices.size()), static_cast<uint32_t>(light_data.casters.size()));
+            for (uint32_t i = 0; i < slice_count; i++)
+            {
+                // With a cache, the static casters are only needed when it's re-rendered
+                array<vector<uint32_t>, 2>& casters = light_data.casters[i];
+                vector<uint32_t>* casters_static    = (light_data.shadow_update[i] & Shadow_Update_Static) ? &light_data.casters_static[i] : nullptr;
+                m_cull_frustums.emplace_back(light_data.shadow_map.slices[i].frustum);
+                m_cull_views.push_back({ { &casters[Renderer_Object_Opaque], &casters[Renderer_Object_Transparent], casters_static }, ignore_depth, true, light_data.shadow_cached });
+            }
+        }
 
-		// Sort by depth (front to back)
-		sort(renderables->begin(), renderables->end(), [&comparison_op](Entity* a, Entity* b)
-		{
-            return comparison_op(a) < comparison_op(b);
-		});
-	}
+        const vector<Entity*>& renderables  = snapshot.entities[Renderer_Object_Opaque];
+        const uint32_t renderable_count     = static_cast<uint32_t>(renderables.size());
+        const uint32_t view_count           = static_cast<uint32_t>(m_cull_views.size());
 
-    void Renderer::ClearEntities()
+        // The tree can only be traversed while nobody modifies it
+        lock_guard<mutex> lock(m_mutex_entities);
+
+        // A few subtrees per thread, so that uneven ones balance out
+        m_aabb_tree.GetSubtrees((m_threading->GetThreadCount() + 1) * 4, m_cull_subtrees);
+        const uint32_t subtree_count = static_cast<uint32_t>(m_cull_subtrees.size());
+        if (m_cull_results.size() < subtree_count)
+        {
+            m_cull_results.resize(subtree_count);
+        }
+
+        // The tree tests up to 64 views per traversal
+        for (uint32_t view_start = 0; view_start < view_count; view_start += 64)
+        {
+            const uint32_t batch_count = Helper::Min(view_count - view_start, 64u);
+
+            uint64_t ignore_depth_mask = 0;
+            for (uint32_t i = 0; i < batch_count; i++)
+            {
+                ignore_depth_mask |= static_cast<uint64_t>(m_cull_views[view_start + i].ignore_depth) << i;
+            }
+
+            // Each subtree is traversed by one thread, which writes to its own lists
+            m_threading->ParallelFor(subtree_count, 1, [this, &renderables, renderable_count, view_start, batch_count, ignore_depth_mask](uint32_t start, uint32_t end)
+            {
+                for (uint32_t subtree = start; subtree < end; subtree++)
+                {
+                    vector<array<vector<uint32_t>, 3>>& results = m_cull_results[subtree];
+                    results.resize(batch_count);
+                    for (array<vector<uint32_t>, 3>& lists : results)
+                    {
+                        for (vector<uint32_t>& list : lists)
+                        {
+                            list.clear();
+                        }
+                    }
+
+                    m_aabb_tree.Query(&m_cull_frustums[view_start], batch_count, ignore_depth_mask, [this, &results, &renderables, renderable_count, view_start](const uint32_t view, const uint32_t index)
+                    {
+                        if (index >= renderable_count)
+                            return;
+
+                        const CullView& cull_view       = m_cull_views[view_start + view];
+                        const Renderable* renderable    = renderables[index]->GetRenderable();
+                        if (!renderable || (cull_view.shadow_casters && !renderable->GetCastShadows()))
+                            return;
+
+                        // Opaque and transparent are decided by the current material
+                        const Material* material    = renderable->GetMaterial();
+                        const bool transparent      = material && material->GetColorAlbedo().w < 1.0f;
+                        const bool is_static        = !transparent && cull_view.split_static && index < m_renderable_static_countdown.size() && m_renderable_static_countdown[index] == 0;
+                        results[view][is_static ? 2 : (transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque)].emplace_back(index);
+                    }, m_cull_subtrees[subtree]);
+                }
+            }, false); // don't help, this thread could end up running a task which waits for the simulation
+
+            // Merge in subtree order, so that the lists don't depend on scheduling
+            for (uint32_t view = 0; view < batch_count; view++)
+            {
+                for (uint32_t list = 0; list < 3; list++)
+                {
+                    vector<uint32_t>* output = m_cull_views[view_start + view].output[list];
+                    if (!output)
+                        continue;
+
+                    for (uint32_t subtree = 0; subtree < subtree_count; subtree++)
+                    {
+                        const vector<uint32_t>& result = m_cull_results[subtree][view][list];
+                        output->insert(output->end(), result.begin(), result.end());
+                    }
+                }
+            }
+        }
+
+        if (GetOption(Render_OcclusionCulling))
+        {
+            RenderablesOcclude(snapshot);
+        }
+
+        ShadowsResolve(snapshot);
+        RenderablesSort(snapshot);
+    }
+
+    void Renderer::RenderablesOcclude(RendererSnapshot& snapshot)
     {
-        m_rhi_device->Queue_WaitAll();
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        // Depth is compared as 1/w, which only means something with a perspective projection
+        if (!snapshot.camera || snapshot.camera->GetProjectionType() != Projection_Perspective)
+            return;
+
+        const vector<Entity*>& renderables  = snapshot.entities[Renderer_Object_Opaque];
+        const vector<BoundingBox>& aabbs    = snapshot.aabbs;
 
-        // light depth buffers might be used by the command list
-        if (!m_swap_chain->GetCmdList()->Reset())
+        // Candidates are opaque (and not alpha tested) renderables which cover enough of the screen
+        m_occluder_candidates.clear();
+        for (const uint32_t index : snapshot.visible[Renderer_Object_Opaque])
         {
-            LOG_ERROR("Failed to reset command pool");
+            const Renderable* renderable    = renderables[index]->GetRenderable();
+            const Material* material        = renderable->GetMaterial();
+            const Model* model              = renderable->GeometryModel();
+            if (!material || (material->GetFlags() & Material_Mask) || !model || !model->GetMesh())
+                continue;
+
+            const float radius      = aabbs[index].GetExtents().Length();
+            const float distance    = Helper::Max(Vector3::Distance(aabbs[index].GetCenter(), snapshot.camera_position), Helper::M_EPSILON);
+            const float screen_size = radius * snapshot.camera_projection.m11 / distance;
+            if (screen_size >= m_occluder_screen_size)
+            {
+                m_occluder_candidates.emplace_back(screen_size, index);
+            }
+        }
+
+        // The biggest ones, at the level of detail which is drawn
+        sort(m_occluder_candidates.begin(), m_occluder_candidates.end(), [](const pair<float, uint32_t>& a, const pair<float, uint32_t>& b) { return a.first > b.first; });
+        m_occluders.clear();
+        uint32_t triangle_count = 0;
+        for (const pair<float, uint32_t>& candidate : m_occluder_candidates)
+        {
+            const uint32_t index            = candidate.second;
+            const Renderable* renderable    = renderables[index]->GetRenderable();
+            const RenderableLod& lod        = renderable->GeometryLod(snapshot.lods[index]);
+            if (m_occluders.size() >= m_occluder_count_max || triangle_count + lod.index_count / 3 > m_occluder_triangle_max)
+                break;
+
+            const shared_ptr<Mesh>& mesh = renderable->GeometryModel()->GetMesh();
+            OcclusionCuller::Occluder& occluder = m_occluders.emplace_back();
+            occluder.vertices       = mesh->Vertices_Get().data() + renderable->GeometryVertexOffset();
+            occluder.indices        = mesh->Indices_Get().data() + lod.index_offset;
+            occluder.index_count    = lod.index_count;
+            occluder.transform      = snapshot.transforms[index];
+            triangle_count         += lod.index_count / 3;
+        }
+
+        if (m_occluders.empty())
             return;
+
+        m_occlusion_culler.Rasterize(snapshot.camera_view * snapshot.camera_projection, snapshot.camera_near, m_occluders, m_threading);
+
+        // Drop what's hidden, keeping the order of the rest
+        auto occlude = [this, &aabbs](vector<uint32_t>& indices)
+        {
+            const uint32_t count = static_cast<uint32_t>(indices.size());
+            m_occlusion_visible.resize(count);
+            m_threading->ParallelFor(count, 0, [this, &aabbs, &indices](uint32_t start, uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    m_occlusion_visible[i] = m_occlusion_culler.IsVisible(aabbs[indices[i]]) ? 1 : 0;
+                }
+            }, false);
+
+            uint32_t count_visible = 0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (m_occlusion_visible[i])
+                {
+                    indices[count_visible++] = indices[i];
+                }
+            }
+            indices.resize(count_visible);
+        };
+
+        occlude(snapshot.visible[Renderer_Object_Opaque]);
+        occlude(snapshot.visible[Renderer_Object_Transparent]);
+    }
+
+    void Renderer::RenderablesSort(RendererSnapshot& snapshot)
+    {
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        const vector<Entity*>& renderables  = snapshot.entities[Renderer_Object_Opaque];
+        const vector<BoundingBox>& aabbs    = snapshot.aabbs;
+        const uint32_t renderable_count     = static_cast<uint32_t>(renderables.size());
+
+        // Number the geometry which every renderable draws, identical draws (same model, range and level of detail) share an id and end up next to each other.
+        // Ids are handed out in order of appearance, they only wrap around (and share keys, which batch() tells apart) past 65535 distinct draws.
+        m_geometry_ids.clear();
+        for (uint32_t lod_set = 0; lod_set < 2; lod_set++)
+        {
+            const vector<uint8_t>& lods = lod_set == 0 ? snapshot.lods : snapshot.lods_shadow;
+            vector<uint16_t>& ids       = m_renderable_geometry[lod_set];
+            ids.resize(renderable_count);
+
+            for (uint32_t i = 0; i < renderable_count; i++)
+            {
+                const Renderable* renderable    = renderables[i]->GetRenderable();
+                const Model* model              = renderable ? renderable->GeometryModel() : nullptr;
+                if (!model)
+                {
+                    ids[i] = 0;
+                    continue;
+                }
+
+                const RenderableLod& lod    = renderable->GeometryLod(lods[i]);
+                const GeometryKey key       = { model, lod.index_offset, lod.index_count, renderable->GeometryVertexOffset() };
+                ids[i]                      = m_geometry_ids.emplace(key, static_cast<uint16_t>(m_geometry_ids.size() + 1)).first->second;
+            }
+        }
+
+        // Orders the renderables by their key, shadows don't bind materials unless they are transparent and they don't need a depth order
+        auto sort = [this, &renderables, &aabbs](vector<uint32_t>& indices, const Vector3& position, const float depth_max, const bool transparent, const bool shadow)
+        {
+            if (indices.size() <= 1)
+                return;
+
+            const vector<uint16_t>& geometry_ids = m_renderable_geometry[shadow ? 1 : 0];
+
+            m_render_queue.Clear();
+            for (const uint32_t index : indices)
+            {
+                const Renderable* renderable    = renderables[index]->GetRenderable();
+                const Material* material        = renderable->GetMaterial();
+
+                const uint16_t shader       = (!shadow && material) ? material->GetFlags() : 0;
+                const uint16_t material_id  = (material && (!shadow || transparent)) ? static_cast<uint16_t>(material->GetId()) : 0;
+                const uint16_t geometry     = geometry_ids[index];
+                const uint16_t depth        = shadow ? 0 : RenderQueue::QuantizeDepth((aabbs[index].GetCenter() - position).Length(), depth_max);
+
+                m_render_queue.Add((transparent && !shadow) ? RenderQueue::KeyDepth(depth, shader, material_id, geometry) : RenderQueue::KeyState(shader, material_id, geometry, depth), index);
+            }
+            m_render_queue.Sort();
+            m_render_queue.GetIndices(indices);
+        };
+
+        // Splits a sorted list into runs which can be drawn as instances of a single draw, and reserves their instances
+        uint32_t& instance_count = snapshot.instance_count;
+        auto batch = [&renderables, &instance_count, &snapshot](const vector<uint32_t>& indices, vector<RendererSnapshot::Batch>& batches, const bool match_material, const bool shadow)
+        {
+            batches.clear();
+
+            const vector<uint8_t>& lods = shadow ? snapshot.lods_shadow : snapshot.lods;
+
+            const Renderable* first         = nullptr;
+            const RenderableLod* lod_first  = nullptr;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(indices.size()); i++)
+            {
+                const Renderable* renderable    = renderables[indices[i]]->GetRenderable();
+                const RenderableLod& lod        = renderable->GeometryLod(lods[indices[i]]);
+
+                const bool same_draw = first &&
+                    renderable->GeometryModel()         == first->GeometryModel()           &&
+                    lod.index_offset                    == lod_first->index_offset          &&
+                    lod.index_count                     == lod_first->index_count           &&
+                    renderable->GeometryVertexOffset()  == first->GeometryVertexOffset()    &&
+                    (match_material ? renderable->GetMaterial() == first->GetMaterial() : (renderable->GetMaterial() != nullptr) == (first->GetMaterial() != nullptr));
+
+                if (same_draw)
+                {
+                    batches.back().count++;
+                }
+                else
+                {
+                    batches.emplace_back(RendererSnapshot::Batch{ i, 1, instance_count });
+                    first       = renderable;
+                    lod_first   = &lod;
+                }
+
+                instance_count++;
+            }
+        };
+
+        // Camera, grouped by shader, material and geometry, then front to back. Transparent objects are back to front first.
+        if (snapshot.camera)
+        {
+            sort(snapshot.visible[Renderer_Object_Opaque],      snapshot.camera_position, snapshot.camera_far, false, false);
+            sort(snapshot.visible[Renderer_Object_Transparent], snapshot.camera_position, snapshot.camera_far, true,  false);
+
+            batch(snapshot.visible[Renderer_Object_Opaque],         snapshot.batches[Renderer_Object_Opaque],       true, false);
+            batch(snapshot.visible[Renderer_Object_Transparent],    snapshot.batches[Renderer_Object_Transparent],  true, false);
+        }
+
+        // Shadow casters, opaque ones only need the same geometry to be instanced
+        for (RendererSnapshot::LightData& light_data : snapshot.lights)
+        {
+            for (uint32_t slice = 0; slice < static_cast<uint32_t>(light_data.casters.size()); slice++)
+            {
+                array<vector<uint32_t>, 2>& casters = light_data.casters[slice];
+
+                sort(casters[Renderer_Object_Opaque],      light_data.position, 0.0f, false, true);
+                sort(casters[Renderer_Object_Transparent], light_data.position, 0.0f, true,  true);
+
+                batch(casters[Renderer_Object_Opaque],      light_data.caster_batches[slice][Renderer_Object_Opaque],       false, true);
+                batch(casters[Renderer_Object_Transparent], light_data.caster_batches[slice][Renderer_Object_Transparent],  true,  true);
+
+                sort(light_data.casters_static[slice], light_data.position, 0.0f, false, true);
+                batch(light_data.casters_static[slice], light_data.caster_static_batches[slice], false, true);
+            }
+        }
+    }
+
+    void Renderer::ShadowsPrepare(RendererSnapshot& snapshot)
+    {
+        lock_guard<mutex> lock(m_mutex_entities);
+
+        // The caches are rendered while recording, which skips the light depth pass until its shaders compile
+        const bool shaders_compiled =
+            m_shaders[Shader_Depth_Instanced_V]->IsCompiled()           &&
+            m_shaders[Shader_Quad_V]->IsCompiled()                      &&
+            m_shaders[Shader_Depth_Copy_Directional_P]->IsCompiled()    &&
+            m_shaders[Shader_Depth_Copy_Point_P]->IsCompiled()          &&
+            m_shaders[Shader_Depth_Copy_Spot_P]->IsCompiled();
+
+        for (RendererSnapshot::LightData& light_data : snapshot.lights)
+        {
+            Light* light = light_data.light;
+            if (!light || !light->GetShadowsEnabled())
+                continue;
+
+            ShadowMap& shadow_map       = light->GetShadowMap();
+            light_data.shadow_cached    = shaders_compiled && shadow_map.texture_depth_static;
+
+            // Distant point lights don't have to update every frame, with or without a cache
+            bool throttled = false;
+            if (light->GetLightType() == Light_Point && snapshot.camera && light->GetRange() > 0.0f)
+            {
+                const float distance    = Vector3::Distance(light_data.position, snapshot.camera_position) / (light->GetRange() * m_shadow_throttle_distance);
+                const uint32_t interval = static_cast<uint32_t>(Helper::Clamp(distance, 1.0f, static_cast<float>(m_shadow_throttle_max)));
+                throttled               = ++shadow_map.frames_skipped < interval;
+                if (!throttled)
+                {
+                    shadow_map.frames_skipped = 0;
+                }
+            }
+
+            // Ensure that potential shadow casters from behind the near plane (or past the far plane) are not rejected
+            const bool ignore_depth = light->GetLightType() == Light_Directional;
+
+            const uint32_t slice_count = Helper::Min(static_cast<uint32_t>(shadow_map.slices.size()), static_cast<uint32_t>(light_data.casters.size()));
+            for (uint32_t i = 0; i < slice_count; i++)
+            {
+                ShadowSlice& slice  = shadow_map.slices[i];
+                uint8_t& update     = light_data.shadow_update[i];
+
+                // Without a cache, everything is drawn whenever the slice updates
+                if (!light_data.shadow_cached)
+                {
+                    update              = throttled ? Shadow_Update_None : Shadow_Update_Dynamic;
+                    slice.cache_valid   = false;
+                    continue;
+                }
+
+                // The cache has to be re-rendered when the slice moved or static renderables appeared or disappeared inside of it
+                bool cache_dirty = m_shadow_static_reset || !slice.cache_valid || slice.view_projection_cached != light_data.view_projection[i];
+                for (uint32_t j = 0; j < static_cast<uint32_t>(m_shadow_static_changes.size()) && !cache_dirty; j++)
+                {
+                    const BoundingBox& box  = m_shadow_static_changes[j];
+                    cache_dirty             = slice.frustum.IsVisible(box.GetCenter(), box.GetExtents(), ignore_depth);
+                }
+
+                if (cache_dirty)
+                {
+                    update                          = Shadow_Update_Static | Shadow_Update_Dynamic;
+                    slice.cache_valid               = true;
+                    slice.view_projection_cached    = light_data.view_projection[i];
+                }
+                else
+                {
+                    // Decided after culling, once it's known whether there is anything dynamic to draw
+                    update = throttled ? Shadow_Update_None : Shadow_Update_Dynamic;
+                }
+            }
+        }
+
+        m_shadow_static_changes.clear();
+        m_shadow_static_reset = false;
+    }
+
+    void Renderer::ShadowsResolve(RendererSnapshot& snapshot)
+    {
+        for (RendererSnapshot::LightData& light_data : snapshot.lights)
+        {
+            if (!light_data.light || !light_data.light->GetShadowsEnabled())
+                continue;
+
+            vector<ShadowSlice>& slices = light_data.light->GetShadowMap().slices;
+            const uint32_t slice_count  = Helper::Min(static_cast<uint32_t>(slices.size()), static_cast<uint32_t>(light_data.casters.size()));
+            for (uint32_t i = 0; i < slice_count; i++)
+            {
+                ShadowSlice& slice                  = slices[i];
+                uint8_t& update                     = light_data.shadow_update[i];
+                array<vector<uint32_t>, 2>& casters = light_data.casters[i];
+                const bool has_dynamic_casters      = !casters[Renderer_Object_Opaque].empty() || !casters[Renderer_Object_Transparent].empty();
+
+                // Nothing dynamic to draw and nothing dynamic to erase, the slice already holds exactly what's cached
+                if (light_data.shadow_cached && update == Shadow_Update_Dynamic && !has_dynamic_casters && !slice.dynamic_drawn)
+                {
+                    update = Shadow_Update_None;
+                }
+
+                // The slice keeps last frame's depth and color (transparent shadows included), so nothing gets drawn into it
+                if (update == Shadow_Update_None)
+                {
+                    casters[Renderer_Object_Opaque].clear();
+                    casters[Renderer_Object_Transparent].clear();
+                }
+                else
+                {
+                    slice.dynamic_drawn = has_dynamic_casters;
+                }
+            }
         }
+    }
 
+    void Renderer::ClearEntities()
+    {
+        // Snapshots hold their own references (light depth buffers included), so a frame which is being recorded is not affected
+        lock_guard<mutex> lock(m_mutex_entities);
         m_entities.clear();
+        m_entity_slots.clear();
+        m_aabb_tree.Clear();
+        m_aabb_tree_proxies.clear();
+        m_renderable_static_countdown.clear();
+        m_shadow_static_changes.clear();
+        m_shadow_static_reset = true;
     }
 
     const shared_ptr<Spartan::RHI_Texture>& Renderer::GetEnvironmentTexture()
@@ -713,6 +1693,7 @@ namespace Spartan
         // Shadow resolution handling
         if (option == Option_Value_ShadowResolution)
         {
+            lock_guard<mutex> lock(m_mutex_entities);
             const auto& light_entities = m_entities[Renderer_Object_Light];
             for (const auto& light_entity : light_entities)
             {
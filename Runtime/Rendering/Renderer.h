@@ -24,14 +24,26 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ========================
 #include <unordered_map>
 #include <array>
-#include <atomic>
+#include <mutex>
+#include <limits>
 #include "Renderer_ConstantBuffers.h"
 #include "Material.h"
 #include "../Core/ISubsystem.h"
+#include "../Core/EventSystem.h"
 #include "../Math/Rectangle.h"
+#include "../Math/Frustum.h"
+#include "../Math/BoundingBox.h"
+#include "../Math/AabbTree.h"
+#include "RenderQueue.h"
+#include "LightClusters.h"
+#include "OcclusionCuller.h"
+#include "TextureStreamer.h"
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Viewport.h"
 #include "../RHI/RHI_Vertex.h"
+#include "../Threading/Threading.h"
+#include "../Utilities/Hash.h"
+#include "../World/Components/Light.h"
 //===================================
 
 namespace Spartan
@@ -42,16 +54,11 @@ namespace Spartan
 	class Light;
 	class ResourceCache;
 	class Font;
-	class Variant;
+	struct WorldResolve;
 	class Grid;
 	class Transform_Gizmo;
 	class Profiler;
-
-	namespace Math
-	{
-		class BoundingBox;
-		class Frustum;
-	}
+	class Model;
 
 	enum Renderer_Option : uint64_t
 	{
@@ -79,7 +86,10 @@ namespace Spartan
 		Render_ChromaticAberration	    = 1 << 21,
 		Render_Dithering			    = 1 << 22,
         Render_ReverseZ                 = 1 << 23,
-        Render_DepthPrepass             = 1 << 24
+        Render_DepthPrepass             = 1 << 24,
+        Render_ClusteredLighting        = 1 << 25,
+        Render_OcclusionCulling         = 1 << 26,
+        Render_TextureStreaming         = 1 << 27
 	};
 
     enum Renderer_Option_Value
@@ -90,7 +100,8 @@ namespace Spartan
         Option_Value_Gamma,
         Option_Value_Bloom_Intensity,
         Option_Value_Sharpen_Strength,
-        Option_Value_Sharpen_Clamp // Limits maximum amount of sharpening a pixel receives - Algorithm's default: 0.035f
+        Option_Value_Sharpen_Clamp, // Limits maximum amount of sharpening a pixel receives - Algorithm's default: 0.035f
+        Option_Value_TextureStreaming_Budget // Megabytes which the mips of streamed textures can take
     };
 
     enum Renderer_ToneMapping_Type
@@ -109,12 +120,149 @@ namespace Spartan
 		Renderer_Object_Camera
 	};
 
+    // What a shadow map slice needs this frame
+    enum Shadow_Update : uint8_t
+    {
+        Shadow_Update_None      = 0,        // it's up to date
+        Shadow_Update_Static    = 1 << 0,   // re-render the cached depth of the static casters
+        Shadow_Update_Dynamic   = 1 << 1    // copy the cached depth and draw the dynamic casters on top (or draw everything, without a cache)
+    };
+
+    // Everything the passes need from the world, captured by the simulation at the end of a frame.
+    // Recording only reads from a snapshot, so the simulation is free to modify the world while the previous frame is recorded.
+    struct RendererSnapshot
+    {
+        // A run of consecutive entries of a draw list which share geometry and material, drawn with a single instanced draw
+        struct Batch
+        {
+            uint32_t first              = 0; // position of the first entry in the draw list
+            uint32_t count              = 0;
+            uint32_t instance_offset    = 0; // where the instances of the batch start in the instance buffer
+        };
+
+        struct LightData
+        {
+            Light* light = nullptr;
+            ShadowMap shadow_map; // keeps the shadow textures alive while recording
+            std::array<Math::Matrix, 6> view_projection;
+            std::array<std::array<std::vector<uint32_t>, 2>, 6> casters; // per array slice, opaque and transparent shadow casters (indices into the renderables, in draw order)
+            std::array<std::array<std::vector<Batch>, 2>, 6> caster_batches;
+            std::array<std::vector<uint32_t>, 6> casters_static; // per array slice, opaque casters which go into the cached depth (only when it's re-rendered), the above has the rest
+            std::array<std::vector<Batch>, 6> caster_static_batches;
+            std::array<uint8_t, 6> shadow_update = {}; // per array slice, see Shadow_Update
+            bool shadow_cached = false; // the static casters are drawn into shadow_map.texture_depth_static
+            Math::Vector3 position  = Math::Vector3::Zero;
+            Math::Vector3 direction = Math::Vector3::Zero;
+            bool clustered          = false; // shaded by the clustered pass, along with the other lights which don't need one of their own
+
+            // Properties, the recording reads these instead of the light (which the simulation can change meanwhile)
+            Light_Type type                 = Light_Directional;
+            Math::Vector4 color             = Math::Vector4::One;
+            float intensity                 = 0.0f;
+            float luminous_intensity        = 0.0f; // with the camera's exposure
+            float range                     = 0.0f;
+            float angle                     = 0.0f;
+            float bias                      = 0.0f;
+            float normal_bias               = 0.0f;
+            uint32_t shadow_array_size      = 0;
+            bool shadows                    = false;
+            bool shadows_transparent        = false;
+            uint16_t shader_flags           = 0; // see Shader_Light_Branch
+            Math::Vector2 position_screen   = Math::Vector2::Zero; // for the gizmo
+        };
+
+        // The properties of a material which the recording reads
+        struct MaterialData
+        {
+            uint32_t id                 = 0;
+            uint16_t flags              = 0;
+            Math::Vector4 albedo        = Math::Vector4::One;
+            Math::Vector2 tiling        = Math::Vector2::One;
+            Math::Vector2 offset        = Math::Vector2::Zero;
+            float roughness             = 0.0f;
+            float metallic              = 0.0f;
+            float normal                = 0.0f;
+            float height                = 0.0f;
+            float clearcoat             = 0.0f;
+            float clearcoat_roughness   = 0.0f;
+            float anisotropic           = 0.0f;
+            float anisotropic_rotation  = 0.0f;
+            float sheen                 = 0.0f;
+            float sheen_tint            = 0.0f;
+            std::array<std::shared_ptr<RHI_Texture>, 8> textures; // color, roughness, metallic, normal, height, occlusion, emission and mask, in the order of their slots
+        };
+
+        void Clear()
+        {
+            for (auto& it : entities)   it.second.clear();
+            for (auto& it : visible)    it.second.clear();
+            for (auto& it : batches)    it.second.clear();
+            instance_count = 0;
+            transforms.clear();
+            aabbs.clear();
+            lods.clear();
+            lods_shadow.clear();
+            materials.clear();
+            renderable_materials.clear();
+            lights.clear();
+            lights_clustered.clear();
+            light_clusters.Clear();
+            references.clear();
+            lines_depth_enabled.clear();
+            lines_depth_disabled.clear();
+            camera = nullptr;
+            transform_gizmo_visible = false;
+        }
+
+        // Entities, all the renderables are kept under Renderer_Object_Opaque
+        std::unordered_map<Renderer_Object_Type, std::vector<Entity*>> entities;
+        // World matrices and bounding boxes of the renderables (same order)
+        std::vector<Math::Matrix> transforms;
+        std::vector<Math::BoundingBox> aabbs;
+        std::vector<uint8_t> lods;          // levels of detail, picked from the size on the camera's screen
+        std::vector<uint8_t> lods_shadow;   // coarser ones, for shadow casters
+        std::vector<MaterialData> materials;
+        std::vector<uint32_t> renderable_materials; // per renderable, an index into the above or material_none
+        static constexpr uint32_t material_none = std::numeric_limits<uint32_t>::max();
+        // Renderables which the camera can see (indices into the above), opaque and transparent, in draw order (see RenderQueue)
+        std::unordered_map<Renderer_Object_Type, std::vector<uint32_t>> visible;
+        std::unordered_map<Renderer_Object_Type, std::vector<Batch>> batches; // the above, batched
+        uint32_t instance_count = 0; // the instances of all the batches, camera and lights
+        std::vector<LightData> lights; // same order as entities[Renderer_Object_Light]
+        std::vector<uint32_t> lights_clustered; // point and spot lights without shadows (indices into the above)
+        LightClusters light_clusters; // the above, binned into the camera's clusters
+        std::vector<std::shared_ptr<Entity>> references; // keeps the entities alive while recording
+
+        // Camera
+        std::shared_ptr<Camera> camera;
+        Math::Matrix camera_view;
+        Math::Matrix camera_projection;
+        Math::Vector3 camera_position   = Math::Vector3::Zero;
+        Math::Vector3 camera_direction  = Math::Vector3::Zero;
+        Math::Frustum camera_frustum;
+        float camera_near               = 0.0f;
+        float camera_far                = 0.0f;
+        float camera_aperture           = 0.0f;
+        float camera_shutter_speed      = 0.0f;
+        float camera_iso                = 0.0f;
+        float camera_exposure           = 0.0f;
+
+        // Debug
+        std::vector<RHI_Vertex_PosCol> lines_depth_enabled;
+        std::vector<RHI_Vertex_PosCol> lines_depth_disabled;
+        bool transform_gizmo_visible = false;
+    };
+
 	enum Renderer_Shader_Type
 	{
 		Shader_Gbuffer_V,
         Shader_Gbuffer_P,
 		Shader_Depth_V,
         Shader_Depth_P,
+        Shader_Depth_Instanced_V,
+        Shader_Depth_Copy_Directional_P,
+        Shader_Depth_Copy_Point_P,
+        Shader_Depth_Copy_Spot_P,
 		Shader_Quad_V,
 		Shader_Texture_P,
         Shader_Copy_C,
@@ -144,6 +292,7 @@ namespace Spartan
         Shader_DebugChannelRgbGammaCorrect_P,
         Shader_BrdfSpecularLut,
         Shader_Light_P,
+        Shader_Light_Clustered_P,
 		Shader_Composition_P,
         Shader_Composition_IndirectBounce_P,
 		Shader_Color_V,
@@ -245,6 +394,10 @@ namespace Spartan
         bool Present();
         bool Flush();
 
+        // Pipelining (Engine_Pipelined), records the snapshot captured by the previous frame on another thread
+        void RecordAsync();
+        void RecordWait();
+
         // Misc
         const std::shared_ptr<RHI_Device>& GetRhiDevice()   const { return m_rhi_device; } 
         RHI_PipelineCache* GetPipelineCache()               const { return m_pipeline_cache.get(); }
@@ -254,7 +407,6 @@ namespace Spartan
         const auto& GetCamera()                             const { return m_camera; }
         auto IsInitialized()                                const { return m_initialized; }
         auto& GetShaders()                                  const { return m_shaders; }
-        bool IsRendering()                                  const { return m_is_rendering; }
         uint32_t GetMaxResolution() const;
 
         // Globals
@@ -316,11 +468,24 @@ namespace Spartan
         bool UpdateMaterialBuffer();
         bool UpdateUberBuffer(RHI_CommandList* cmd_list);
         bool UpdateObjectBuffer(RHI_CommandList* cmd_list);
-        bool UpdateLightBuffer(const Light* light);
+        bool UpdateInstanceBuffer();
+        bool UpdateLightBuffer(const RendererSnapshot::LightData& light_data);
+        bool UpdateClusterBuffers();
+
+        // Snapshots
+        void SnapshotCapture(RendererSnapshot& snapshot);
+        uint32_t SnapshotCaptureMaterial(RendererSnapshot& snapshot, Material* material);
+        void SnapshotRecord(RendererSnapshot& snapshot);
 
         // Misc
-        void RenderablesAcquire(const Variant& renderables);
-        void RenderablesSort(std::vector<Entity*>* renderables);
+        void RenderablesAcquire(const WorldResolve& resolve);
+        void RenderablesAdd(Entity* entity);
+        void RenderablesRemove(const Entity* entity);
+        void RenderablesSort(RendererSnapshot& snapshot);
+        void RenderablesCull(RendererSnapshot& snapshot);
+        void RenderablesOcclude(RendererSnapshot& snapshot);
+        void ShadowsPrepare(RendererSnapshot& snapshot);
+        void ShadowsResolve(RendererSnapshot& snapshot);
         void ClearEntities();
 
         // Render textures
@@ -346,6 +511,7 @@ namespace Spartan
 		std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_off_w;
         std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_off_r;
         std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_on_w;
+        std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_always_off_w;
 
         // Blend states 
         std::shared_ptr<RHI_BlendState> m_blend_disabled;
@@ -400,7 +566,6 @@ namespace Spartan
         float m_far_plane                           = 0.0f;
         uint64_t m_frame_num                        = 0;
         bool m_is_odd_frame                         = false;
-        std::atomic<bool> m_is_rendering            = false;
         bool m_brdf_specular_lut_rendered           = false;      
         const float m_gizmo_size_max                = 2.0f;
         const float m_gizmo_size_min                = 0.1f;
@@ -425,14 +590,101 @@ namespace Spartan
         BufferLight m_buffer_light_cpu;
         BufferLight m_buffer_light_cpu_previous;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_light_gpu;
+
+        std::shared_ptr<RHI_StructuredBuffer> m_buffer_instance_gpu;
+
+        std::shared_ptr<RHI_StructuredBuffer> m_buffer_cluster_lights_gpu;
+        std::shared_ptr<RHI_StructuredBuffer> m_buffer_clusters_gpu;
+        std::shared_ptr<RHI_StructuredBuffer> m_buffer_cluster_light_indices_gpu;
         //========================================================
 
         // Entities and material references
-        std::unordered_map<Renderer_Object_Type, std::vector<Entity*>> m_entities;
-        std::array<Material*, m_max_material_instances> m_material_instances;
+        std::unordered_map<Renderer_Object_Type, std::vector<Entity*>> m_entities; // all renderables are kept under Renderer_Object_Opaque
+        std::unordered_map<Renderer_Object_Type, std::unordered_map<const Entity*, uint32_t>> m_entity_slots; // where each entity is in m_entities
+        Math::AabbTree m_aabb_tree; // the bounds of all the renderables, the user data is their slot
+        std::vector<uint32_t> m_aabb_tree_proxies; // the tree entry of each renderable (same order as m_entities[Renderer_Object_Opaque])
+        std::vector<uint32_t> m_transforms_moved;
+
+        // Shadow caches, renderables which haven't moved for a while are drawn once into the cached depth of each light
+        std::vector<uint8_t> m_renderable_static_countdown;     // captures left until a renderable counts as static (same order as m_entities[Renderer_Object_Opaque])
+        std::vector<Math::BoundingBox> m_shadow_static_changes; // where static renderables appeared or disappeared since the last capture
+        bool m_shadow_static_reset              = true;         // invalidates every cache
+        const uint8_t m_shadow_static_frames    = 30;
+        const float m_shadow_throttle_distance  = 4.0f;         // point lights further away than this many times their range update less often
+        const uint32_t m_shadow_throttle_max    = 8;            // but at least every n frames
+
+        // Levels of detail
+        const uint32_t m_lod_shadow_bias        = 1;            // shadow casters are drawn this many levels coarser than what the camera sees
+
+        // Culling, all the views are tested during a single traversal of the tree, which is split across threads
+        struct CullView
+        {
+            std::array<std::vector<uint32_t>*, 3> output; // where the opaque, transparent and static opaque results go (can be null)
+            bool ignore_depth;                            // only test the side planes (keeps shadow casters outside of the depth range)
+            bool shadow_casters;                          // only keep renderables which cast shadows
+            bool split_static;                            // static opaque renderables go to the third output instead of the first
+        };
+        std::vector<Math::Frustum> m_cull_frustums;       // same order as m_cull_views
+        std::vector<CullView> m_cull_views;
+        std::vector<LightClusters::Sphere> m_cluster_spheres; // scratch, same order as RendererSnapshot::lights_clustered
+        std::unordered_map<const Material*, uint32_t> m_material_slots; // scratch, where each material went in RendererSnapshot::materials
+        std::vector<uint32_t> m_cull_subtrees;
+        std::vector<std::vector<std::array<std::vector<uint32_t>, 3>>> m_cull_results; // per subtree, per view, same as CullView::output
+        RenderQueue m_render_queue; // reused for every view
+
+        // Render queue keys, every distinct geometry (model, range and level of detail) of a frame is numbered densely, so different draws never share a key
+        struct GeometryKey
+        {
+            const Model* model      = nullptr;
+            uint32_t index_offset   = 0;
+            uint32_t index_count    = 0;
+            uint32_t vertex_offset  = 0;
+
+            bool operator==(const GeometryKey& other) const
+            {
+                return model == other.model && index_offset == other.index_offset && index_count == other.index_count && vertex_offset == other.vertex_offset;
+            }
+        };
+        struct GeometryKeyHash
+        {
+            size_t operator()(const GeometryKey& key) const
+            {
+                size_t hash = 0;
+                Utility::Hash::hash_combine(hash, key.model);
+                Utility::Hash::hash_combine(hash, key.index_offset);
+                Utility::Hash::hash_combine(hash, key.index_count);
+                Utility::Hash::hash_combine(hash, key.vertex_offset);
+                return hash;
+            }
+        };
+        std::unordered_map<GeometryKey, uint16_t, GeometryKeyHash> m_geometry_ids;  // scratch
+        std::array<std::vector<uint16_t>, 2> m_renderable_geometry;                 // per renderable, the geometry id with the camera's and with the shadows' level of detail
+
+        // Occlusion culling, the biggest opaque renderables on the camera's screen hide what's behind them
+        OcclusionCuller m_occlusion_culler;
+        std::vector<OcclusionCuller::Occluder> m_occluders;
+        std::vector<std::pair<float, uint32_t>> m_occluder_candidates; // scratch, screen size and renderable
+        std::vector<uint8_t> m_occlusion_visible;                       // scratch, same order as the list being tested
+        const float m_occluder_screen_size      = 0.2f;                 // projected diameter over the screen height
+        const uint32_t m_occluder_count_max     = 32;
+        const uint32_t m_occluder_triangle_max  = 65536;
+
+        // Texture streaming, the mips which the visible renderables need are requested while capturing and swapped in while recording
+        TextureStreamer m_texture_streamer;
+        std::array<const RendererSnapshot::MaterialData*, m_max_material_instances> m_material_instances;
+        std::mutex m_mutex_entities;
+        EventToken m_event_world_resolve_complete;
+        EventToken m_event_world_unload;
         
         std::shared_ptr<Camera> m_camera;
 
+        // Snapshots, one is captured while the other one is recorded
+        std::array<RendererSnapshot, 2> m_snapshots;
+        RendererSnapshot* m_snapshot    = nullptr; // the one being recorded
+        uint32_t m_snapshot_index       = 0;       // the one captured last
+        bool m_snapshot_pending         = false;
+        TaskHandle m_record_task;
+
         // RHI Core
         std::shared_ptr<RHI_Device> m_rhi_device;
         std::shared_ptr<RHI_SwapChain> m_swap_chain;
@@ -442,5 +694,6 @@ namespace Spartan
         // Dependencies
         Profiler* m_profiler            = nullptr;
         ResourceCache* m_resource_cache = nullptr;
+        Threading* m_threading          = nullptr;
     };
 }
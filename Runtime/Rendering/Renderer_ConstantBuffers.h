@@ -101,7 +101,8 @@ namespace Spartan
         float mat_height_mul;
 
         float mat_id;
-        Math::Vector3 padding;
+        uint32_t shadow_slice;
+        Math::Vector2 padding;
 
         bool operator==(const BufferUber& rhs) const
         {
@@ -119,7 +120,8 @@ namespace Spartan
                 transform_axis      == rhs.transform_axis       &&
                 blur_sigma          == rhs.blur_sigma           &&
                 blur_direction      == rhs.blur_direction       &&
-                resolution          == rhs.resolution;
+                resolution          == rhs.resolution           &&
+                shadow_slice        == rhs.shadow_slice;
         }
 
         bool operator!=(const BufferUber& rhs) const { return !(*this == rhs); }
@@ -131,17 +133,39 @@ namespace Spartan
         Math::Matrix object;
         Math::Matrix wvp_current;
         Math::Matrix wvp_previous;
+
+        uint32_t instance_offset = 0;
+        Math::Vector3 padding;
     
         bool operator==(const BufferObject& rhs) const
         {
             return
                 object          == rhs.object       &&
                 wvp_current     == rhs.wvp_current  &&
-                wvp_previous    == rhs.wvp_previous;
+                wvp_previous    == rhs.wvp_previous &&
+                instance_offset == rhs.instance_offset;
         }
 
         bool operator!=(const BufferObject& rhs) const { return !(*this == rhs); }
     };
+
+    // High frequency - Written once per frame, one element per instance of an instanced draw (a structured buffer)
+    struct BufferInstance
+    {
+        Math::Matrix transform;
+        Math::Matrix wvp_previous;
+    };
+
+    // High frequency - Written once per frame, one element per point or spot light of the clustered pass (a structured buffer)
+    struct BufferClusterLight
+    {
+        Math::Vector3 position;
+        float range;
+        Math::Vector3 color; // multiplied by the intensity
+        float angle;
+        Math::Vector3 direction;
+        uint32_t spot;
+    };
     
     // Light buffer
     struct BufferLight
@@ -76,11 +76,17 @@ namespace Spartan
 
         // Updates onces, used almost everywhere
         UpdateFrameBuffer();
+
+        // Updates once, the instances of every batch which the camera and the lights draw (needs the frame's view projection)
+        UpdateInstanceBuffer();
+
+        // Updates once, the clustered lights and which clusters they reach
+        UpdateClusterBuffers();
         
         // Runs only once
         Pass_BrdfSpecularLut(cmd_list);
         
-        const bool draw_transparent_objects = !m_entities[Renderer_Object_Transparent].empty();
+        const bool draw_transparent_objects = !m_snapshot->visible[Renderer_Object_Transparent].empty();
         
         // Depth
         {
@@ -136,37 +142,117 @@ namespace Spartan
         // All opaque objects are rendered from the lights point of view.
         // Opaque objects write their depth information to a depth buffer, using just a vertex shader.
         // Transparent objects, read the opaque depth but don't write their own, instead, they write their color information using a pixel shader.
+        // Opaque objects which don't move are rendered once into a cache, which is then copied into the depth buffer before the rest are rendered on top.
 
 		// Acquire shader
-		RHI_Shader* shader_v = m_shaders[Shader_Depth_V].get();
+		RHI_Shader* shader_v = m_shaders[Shader_Depth_Instanced_V].get();
         RHI_Shader* shader_p = m_shaders[Shader_Depth_P].get();
 		if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
 			return;
 
         // Get entities
-        const auto& entities = m_entities[object_type];
+        const auto& entities = m_snapshot->entities[Renderer_Object_Opaque];
         if (entities.empty())
             return;
 
         const bool transparent_pass = object_type == Renderer_Object_Transparent;
 
-        // Go through all of the lights
-		const auto& entities_light = m_entities[Renderer_Object_Light];
-        for (uint32_t light_index = 0; light_index < entities_light.size(); light_index++)
+        // Draws batches of casters, the render pass only begins if there is something to draw (unless it has to clear)
+        const auto draw_casters = [this, cmd_list, &entities, transparent_pass](RHI_PipelineState& pipeline_state, const Matrix& view_projection, const vector<uint32_t>& casters, const vector<RendererSnapshot::Batch>& batches, const bool clear)
         {
-            const Light* light = entities_light[light_index]->GetComponent<Light>();
+            // State tracking
+            bool render_pass_active     = false;
+            uint32_t m_set_material_id  = 0;
+
+            if (clear)
+            {
+                render_pass_active = cmd_list->BeginRenderPass(pipeline_state);
+                cmd_list->SetStructuredBuffer(33, RHI_Shader_Vertex, m_buffer_instance_gpu);
+            }
+
+            for (const RendererSnapshot::Batch& batch : batches)
+            {
+                Entity* entity = entities[casters[batch.first]];
+
+                // Acquire renderable component
+                const auto& renderable = entity->GetRenderable();
+                if (!renderable)
+                    continue;
+
+                // Skip meshes that don't cast shadows
+                if (!renderable->GetCastShadows())
+                    continue;
 
+                // Acquire geometry
+                const auto& model = renderable->GeometryModel();
+                if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+                    continue;
+
+                // Acquire material
+                const uint32_t material_slot = m_snapshot->renderable_materials[casters[batch.first]];
+                if (material_slot == RendererSnapshot::material_none)
+                    continue;
+                const RendererSnapshot::MaterialData& material = m_snapshot->materials[material_slot];
+
+                if (!render_pass_active)
+                {
+                    render_pass_active = cmd_list->BeginRenderPass(pipeline_state);
+                    cmd_list->SetStructuredBuffer(33, RHI_Shader_Vertex, m_buffer_instance_gpu);
+                }
+
+                // Bind material
+                if (transparent_pass && m_set_material_id != material.id)
+                {
+                    // Bind material textures
+                    RHI_Texture* tex_albedo = material.textures[0].get();
+                    cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
+
+                    // Update uber buffer with material properties
+                    m_buffer_uber_cpu.mat_albedo    = material.albedo;
+                    m_buffer_uber_cpu.mat_tiling_uv = material.tiling;
+                    m_buffer_uber_cpu.mat_offset_uv = material.offset;
+
+                    // Update constant buffer
+                    UpdateUberBuffer(cmd_list);
+
+                    m_set_material_id = material.id;
+                }
+
+                // Bind geometry
+                cmd_list->SetBufferIndex(model->GetIndexBuffer());
+                cmd_list->SetBufferVertex(model->GetVertexBuffer());
+
+                // Update object buffer with the cascade transform, the instances provide the world transforms
+                m_buffer_object_cpu.object          = view_projection;
+                m_buffer_object_cpu.instance_offset = batch.instance_offset;
+                if (!UpdateObjectBuffer(cmd_list))
+                    continue;
+
+                const RenderableLod& lod = renderable->GeometryLod(m_snapshot->lods_shadow[casters[batch.first]]);
+                cmd_list->DrawIndexedInstanced(lod.index_count, batch.count, lod.index_offset, renderable->GeometryVertexOffset());
+            }
+
+            if (render_pass_active)
+            {
+                cmd_list->EndRenderPass();
+            }
+        };
+
+        // Go through all of the lights
+        for (const RendererSnapshot::LightData& light_data : m_snapshot->lights)
+        {
             // Skip some obvious cases
-            if (!light || !light->GetShadowsEnabled())
+            if (!light_data.light || !light_data.shadows)
                 continue;
 
             // Skip lights that don't cast transparent shadows (if this is a transparent pass)
-            if (transparent_pass && !light->GetShadowsTransparentEnabled())
+            if (transparent_pass && !light_data.shadows_transparent)
                 continue;
 
             // Acquire light's shadow maps
-            RHI_Texture* tex_depth = light->GetDepthTexture();
-            RHI_Texture* tex_color = light->GetColorTexture();
+            RHI_Texture* tex_depth          = light_data.shadow_map.texture_depth.get();
+            RHI_Texture* tex_depth_static   = light_data.shadow_cached ? light_data.shadow_map.texture_depth_static.get() : nullptr;
+            RHI_Texture* tex_color          = light_data.shadow_map.texture_color.get();
             if (!tex_depth)
                 continue;
 
@@ -177,27 +263,41 @@ namespace Spartan
             pipeline_state.shader_pixel                     = transparent_pass ? shader_p : nullptr;
             pipeline_state.blend_state                      = transparent_pass ? m_blend_alpha.get() : m_blend_disabled.get();
             pipeline_state.depth_stencil_state              = transparent_pass ? m_depth_stencil_on_off_r.get() : m_depth_stencil_on_off_w.get();
-            pipeline_state.render_target_color_textures[0]  = tex_color; // always bind so we can clear to white (in case there are now transparent objects)
-            pipeline_state.render_target_depth_texture      = tex_depth;
             pipeline_state.clear_stencil                    = state_stencil_dont_care;
             pipeline_state.viewport                         = tex_depth->GetViewport();
             pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
-            pipeline_state.pass_name                        = transparent_pass ? "Pass_LightDepthTransparent" : "Pass_LightDepth";
+
+            // The cached depth is copied with a full screen quad
+            static RHI_PipelineState pipeline_state_copy;
+            pipeline_state_copy.shader_vertex                   = m_shaders[Shader_Quad_V].get();
+            pipeline_state_copy.shader_pixel                    = m_shaders[light_data.type == Light_Directional ? Shader_Depth_Copy_Directional_P : light_data.type == Light_Point ? Shader_Depth_Copy_Point_P : Shader_Depth_Copy_Spot_P].get();
+            pipeline_state_copy.vertex_buffer_stride            = m_viewport_quad.GetVertexBuffer()->GetStride();
+            pipeline_state_copy.rasterizer_state                = m_rasterizer_cull_back_solid.get();
+            pipeline_state_copy.blend_state                     = m_blend_disabled.get();
+            pipeline_state_copy.depth_stencil_state             = m_depth_stencil_always_off_w.get();
+            pipeline_state_copy.render_target_color_textures[0] = tex_color; // always bind so we can clear to white (in case there are now transparent objects)
+            pipeline_state_copy.render_target_depth_texture     = tex_depth;
+            pipeline_state_copy.clear_stencil                   = state_stencil_dont_care;
+            pipeline_state_copy.viewport                        = tex_depth->GetViewport();
+            pipeline_state_copy.primitive_topology              = RHI_PrimitiveTopology_TriangleList;
+            pipeline_state_copy.pass_name                       = "Pass_LightDepthCopy";
 
             for (uint32_t array_index = 0; array_index < tex_depth->GetArraySize(); array_index++)
             {
+                const uint8_t update = light_data.shadow_update[array_index];
+
+                // Slices which are up to date (or throttled) are left as they are, their color holds last frame's transparent shadows too
+                if (update == Shadow_Update_None)
+                    continue;
+
                 // Set render target texture array index
                 pipeline_state.render_target_color_texture_array_index          = array_index;
                 pipeline_state.render_target_depth_stencil_texture_array_index  = array_index;
 
-                // Set clear values
-                pipeline_state.clear_color[0] = Vector4::One;
-                pipeline_state.clear_depth    = transparent_pass ? state_depth_load : GetClearDepth();
-
-                const Matrix& view_projection = light->GetViewMatrix(array_index) * light->GetProjectionMatrix(array_index);
+                const Matrix& view_projection = light_data.view_projection[array_index];
 
                 // Set appropriate rasterizer state
-                if (light->GetLightType() == Light_Directional)
+                if (light_data.type == Light_Directional)
                 {
                     // "Pancaking" - https://www.gamedev.net/forums/topic/639036-shadow-mapping-and-high-up-objects/
                     // It's basically a way to capture the silhouettes of potential shadow casters behind the light's view point.
@@ -209,81 +309,65 @@ namespace Spartan
                     pipeline_state.rasterizer_state = m_rasterizer_cull_back_solid.get();
                 }
 
-                // State tracking
-                bool render_pass_active     = false;
-                uint32_t m_set_material_id  = 0;
-
-                for (uint32_t entity_index = 0; entity_index < static_cast<uint32_t>(entities.size()); entity_index++)
+                if (transparent_pass)
                 {
-                    Entity* entity = entities[entity_index];
+                    pipeline_state.render_target_color_textures[0]  = tex_color;
+                    pipeline_state.render_target_depth_texture      = tex_depth;
+                    pipeline_state.clear_color[0]                   = Vector4::One;
+                    pipeline_state.clear_depth                      = state_depth_load;
+                    pipeline_state.pass_name                        = "Pass_LightDepthTransparent";
 
-                    // Acquire renderable component
-                    const auto& renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
-
-                    // Skip meshes that don't cast shadows
-                    if (!renderable->GetCastShadows())
-                        continue;
-
-                    // Acquire geometry
-                    const auto& model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                        continue;
+                    draw_casters(pipeline_state, view_projection, light_data.casters[array_index][Renderer_Object_Transparent], light_data.caster_batches[array_index][Renderer_Object_Transparent], false);
+                    continue;
+                }
 
-                    // Acquire material
-                    const auto& material = renderable->GetMaterial();
-                    if (!material)
-                        continue;
+                // Re-render the cached depth of the static casters
+                if ((update & Shadow_Update_Static) && tex_depth_static)
+                {
+                    pipeline_state.render_target_color_textures[0]  = nullptr;
+                    pipeline_state.render_target_depth_texture      = tex_depth_static;
+                    pipeline_state.clear_depth                      = GetClearDepth();
+                    pipeline_state.pass_name                        = "Pass_LightDepthStatic";
 
-                    // Skip objects outside of the view frustum
-                    if (!light->IsInViewFrustrum(renderable, array_index))
-                        continue;
+                    draw_casters(pipeline_state, view_projection, light_data.casters_static[array_index], light_data.caster_static_batches[array_index], true);
+                }
 
-                    if (!render_pass_active)
-                    {
-                        render_pass_active = cmd_list->BeginRenderPass(pipeline_state);
-                    }
+                // Copy the cache into the slice
+                bool copied = false;
+                if (tex_depth_static && pipeline_state_copy.shader_pixel->IsCompiled())
+                {
+                    pipeline_state_copy.render_target_color_texture_array_index         = array_index;
+                    pipeline_state_copy.render_target_depth_stencil_texture_array_index = array_index;
+                    pipeline_state_copy.clear_color[0]                                  = Vector4::One;
+                    pipeline_state_copy.clear_depth                                     = state_depth_dont_care;
 
-                    // Bind material
-                    if (transparent_pass && m_set_material_id != material->GetId())
+                    if (cmd_list->BeginRenderPass(pipeline_state_copy))
                     {
-                        // Bind material textures
-                        RHI_Texture* tex_albedo = material->GetTexture_Ptr(Material_Color);
-                        cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
-
-                        // Update uber buffer with material properties
-                        m_buffer_uber_cpu.mat_albedo    = material->GetColorAlbedo();
-                        m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
-                        m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
-
-                        // Update constant buffer
+                        m_buffer_uber_cpu.resolution    = Vector2(static_cast<float>(tex_depth->GetWidth()), static_cast<float>(tex_depth->GetHeight()));
+                        m_buffer_uber_cpu.shadow_slice  = array_index;
                         UpdateUberBuffer(cmd_list);
 
-                        m_set_material_id = material->GetId();
-                    }
-
-                    // Bind geometry
-                    cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                    cmd_list->SetBufferVertex(model->GetVertexBuffer());
-
-                    // Update uber buffer with cascade transform
-                    m_buffer_object_cpu.object = entity->GetTransform()->GetMatrix() * view_projection;
-                    if (!UpdateObjectBuffer(cmd_list))
-                        continue;
-
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                        cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+                        cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+                        cmd_list->SetTexture(light_data.type == Light_Directional ? 13 : light_data.type == Light_Point ? 15 : 17, tex_depth_static);
+                        cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+                        cmd_list->EndRenderPass();
 
+                        copied = true;
+                    }
                 }
 
-                if (render_pass_active)
-                {
-                    cmd_list->EndRenderPass();
-                }
+                // The dynamic casters on top (or everything, without a cache)
+                pipeline_state.render_target_color_textures[0]  = tex_color; // always bind so we can clear to white (in case there are now transparent objects)
+                pipeline_state.render_target_depth_texture      = tex_depth;
+                pipeline_state.clear_color[0]                   = copied ? state_color_load : Vector4::One;
+                pipeline_state.clear_depth                      = copied ? state_depth_load : GetClearDepth();
+                pipeline_state.pass_name                        = "Pass_LightDepth";
+
+                draw_casters(pipeline_state, view_projection, light_data.casters[array_index][Renderer_Object_Opaque], light_data.caster_batches[array_index][Renderer_Object_Opaque], !copied);
             }
         }
 	}
-
     void Renderer::Pass_DepthPrePass(RHI_CommandList* cmd_list)
     {
         // Description: All the opaque meshes are rendered, outputting
@@ -292,7 +376,9 @@ namespace Spartan
         // Acquire required resources/data
         const auto& shader_depth    = m_shaders[Shader_Depth_V];
         const auto& tex_depth       = m_render_targets[RenderTarget_Gbuffer_Depth];
-        const auto& entities        = m_entities[Renderer_Object_Opaque];
+        const auto& entities        = m_snapshot->entities[Renderer_Object_Opaque];
+        const auto& transforms      = m_snapshot->transforms;
+        const auto& visible         = m_snapshot->visible[Renderer_Object_Opaque];
 
         // Ensure the shader has compiled
         if (!shader_depth->IsCompiled())
@@ -314,14 +400,16 @@ namespace Spartan
         // Record commands
         if (cmd_list->BeginRenderPass(pipeline_state))
         { 
-            if (!entities.empty())
+            if (!visible.empty())
             {
                 // Variables that help reduce state changes
                 uint32_t currently_bound_geometry = 0;
 
                 // Draw opaque
-                for (const auto& entity : entities)
+                for (const uint32_t i : visible)
                 {
+                    Entity* entity = entities[i];
+
                     // Get renderable
                     const auto& renderable = entity->GetRenderable();
                     if (!renderable)
@@ -332,10 +420,6 @@ namespace Spartan
                     if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
                         continue;
 
-                    // Skip objects outside of the view frustum
-                    if (!m_camera->IsInViewFrustrum(renderable))
-                        continue;
-
                     // Bind geometry
                     if (currently_bound_geometry != model->GetId())
                     {
@@ -345,15 +429,12 @@ namespace Spartan
                     }
 
                     // Update uber buffer with entity transform
-                    if (Transform* transform = entity->GetTransform())
-                    {
-                        // Update uber buffer with cascade transform
-                        m_buffer_uber_cpu.transform = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                        UpdateUberBuffer(cmd_list);
-                    }
+                    m_buffer_uber_cpu.transform = transforms[i] * m_buffer_frame_cpu.view_projection;
+                    UpdateUberBuffer(cmd_list);
 
-                    // Draw	
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                    // Draw, with the same level of detail as the G-Buffer
+                    const RenderableLod& lod = renderable->GeometryLod(m_snapshot->lods[i]);
+                    cmd_list->DrawIndexed(lod.index_count, lod.index_offset, renderable->GeometryVertexOffset());
                 }
             }
             cmd_list->EndRenderPass();
@@ -404,141 +485,131 @@ namespace Spartan
         uint32_t material_bound_id = 0;
         m_material_instances.fill(nullptr);
 
-        // Iterate through all the G-Buffer shader variations
-        for (const auto& it : ShaderGBuffer::GetVariations())
-        {
-            // Skip the shader until it compiles or the users spots a compilation error
-            if (!it.second->IsCompiled())
-                continue;
-
-            // Set pixel shader
-            pso.shader_pixel = static_cast<RHI_Shader*>(it.second.get());
-
-            // Set pass name
-            pso.pass_name = pso.shader_pixel->GetName().c_str();
+        bool render_pass_active = false;
+        const auto& entities    = m_snapshot->entities[Renderer_Object_Opaque];
+        const auto& visible     = m_snapshot->visible[object_type];
+        const auto& variations  = ShaderGBuffer::GetVariations();
 
-            bool render_pass_active = false;
-            auto& entities = m_entities[object_type];
-
-            // Record commands
-            for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
-            {
-                Entity* entity = entities[i];
-
-                // Get renderable
-                const auto& renderable = entity->GetRenderable();
-                if (!renderable)
-                    continue;
+        // Record commands, only for what the camera can see. The list is sorted by shader variation,
+        // material and geometry (see RenderQueue), so a single walk visits every state change once,
+        // and identical draws next to each other are batched into a single instanced draw.
+        for (const RendererSnapshot::Batch& batch : m_snapshot->batches[object_type])
+        {
+            Entity* entity = entities[visible[batch.first]];
 
-                // Get material
-                Material* material = renderable->GetMaterial();
-                if (!material)
-                    continue;
+            // Get renderable
+            const auto& renderable = entity->GetRenderable();
+            if (!renderable)
+                continue;
 
-                // Skip objects with different shader requirements
-                if (!static_cast<ShaderGBuffer*>(pso.shader_pixel)->IsSuitable(material->GetFlags()))
-                    continue;
+            // Get material
+            const uint32_t material_slot = m_snapshot->renderable_materials[visible[batch.first]];
+            if (material_slot == RendererSnapshot::material_none)
+                continue;
+            const RendererSnapshot::MaterialData* material = &m_snapshot->materials[material_slot];
 
-                // Skip transparent objects that won't contribute
-                if (material->GetColorAlbedo().w == 0 && is_transparent)
-                    continue;
+            // Skip transparent objects that won't contribute
+            if (material->albedo.w == 0 && is_transparent)
+                continue;
 
-                // Get geometry
-                const auto& model = renderable->GeometryModel();
-                if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                    continue;
+            // Get geometry
+            const auto& model = renderable->GeometryModel();
+            if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+                continue;
 
-                // Skip objects outside of the view frustum
-                if (!m_camera->IsInViewFrustrum(renderable))
-                    continue;
+            // Get the shader variation for the material, skip it until it compiles or the users spots a compilation error
+            const auto it = variations.find(material->flags);
+            if (it == variations.end() || !it->second->IsCompiled())
+                continue;
 
-                if (!render_pass_active)
+            // The draws are grouped by shader variation, a new one needs a new render pass
+            RHI_Shader* shader_variation = static_cast<RHI_Shader*>(it->second.get());
+            if (pso.shader_pixel != shader_variation)
+            {
+                if (render_pass_active)
                 {
-                    render_pass_active = cmd_list->BeginRenderPass(pso);
+                    cmd_list->EndRenderPass();
+                    render_pass_active = false;
                 }
 
-                // Set geometry (will only happen if not already set)
-                cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                cmd_list->SetBufferVertex(model->GetVertexBuffer());
+                pso.shader_pixel    = shader_variation;
+                pso.pass_name       = pso.shader_pixel->GetName().c_str();
+            }
 
-                // Bind material
-                bool firs_run       = material_index == 0;
-                bool new_material   = material_bound_id != material->GetId();
-                if (firs_run || new_material)
-                {
-                    material_bound_id = material->GetId();
+            if (!render_pass_active)
+            {
+                render_pass_active = cmd_list->BeginRenderPass(pso);
+                cmd_list->SetStructuredBuffer(33, RHI_Shader_Vertex, m_buffer_instance_gpu);
+            }
 
-                    // Keep track of used material instances (they get mapped to shaders)
-                    if (material_index + 1 < m_material_instances.size())
-                    {
-                        // Advance index (0 is reserved for the sky)
-                        material_index++;
+            // Set geometry (will only happen if not already set)
+            cmd_list->SetBufferIndex(model->GetIndexBuffer());
+            cmd_list->SetBufferVertex(model->GetVertexBuffer());
 
-                        // Keep reference
-                        m_material_instances[material_index] = material;
-                    }
-                    else
-                    {
-                        LOG_ERROR("Material instance array has reached it's maximum capacity of %d elements. Consider increasing the size.", m_max_material_instances);
-                    }
+            // Bind material
+            bool firs_run       = material_index == 0;
+            bool new_material   = material_bound_id != material->id;
+            if (firs_run || new_material)
+            {
+                material_bound_id = material->id;
 
-                    // Bind material textures		
-                    cmd_list->SetTexture(0, material->GetTexture_Ptr(Material_Color));
-                    cmd_list->SetTexture(1, material->GetTexture_Ptr(Material_Roughness));
-                    cmd_list->SetTexture(2, material->GetTexture_Ptr(Material_Metallic));
-                    cmd_list->SetTexture(3, material->GetTexture_Ptr(Material_Normal));
-                    cmd_list->SetTexture(4, material->GetTexture_Ptr(Material_Height));
-                    cmd_list->SetTexture(5, material->GetTexture_Ptr(Material_Occlusion));
-                    cmd_list->SetTexture(6, material->GetTexture_Ptr(Material_Emission));
-                    cmd_list->SetTexture(7, material->GetTexture_Ptr(Material_Mask));
-                
-                    // Update uber buffer with material properties
-                    m_buffer_uber_cpu.mat_id            = static_cast<float>(material_index);
-                    m_buffer_uber_cpu.mat_albedo        = material->GetColorAlbedo();
-                    m_buffer_uber_cpu.mat_tiling_uv     = material->GetTiling();
-                    m_buffer_uber_cpu.mat_offset_uv     = material->GetOffset();
-                    m_buffer_uber_cpu.mat_roughness_mul = material->GetProperty(Material_Roughness);
-                    m_buffer_uber_cpu.mat_metallic_mul  = material->GetProperty(Material_Metallic);
-                    m_buffer_uber_cpu.mat_normal_mul    = material->GetProperty(Material_Normal);
-                    m_buffer_uber_cpu.mat_height_mul    = material->GetProperty(Material_Height);
+                // Keep track of used material instances (they get mapped to shaders)
+                if (material_index + 1 < m_material_instances.size())
+                {
+                    // Advance index (0 is reserved for the sky)
+                    material_index++;
 
-                    // Update constant buffer
-                    UpdateUberBuffer(cmd_list);
+                    // Keep reference
+                    m_material_instances[material_index] = material;
                 }
-                
-                // Update uber buffer with entity transform
-                if (Transform* transform = entity->GetTransform())
+                else
                 {
-                    m_buffer_object_cpu.object          = transform->GetMatrix();
-                    m_buffer_object_cpu.wvp_current     = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                    m_buffer_object_cpu.wvp_previous    = transform->GetWvpLastFrame();
-
-                    // Save matrix for velocity computation
-                    transform->SetWvpLastFrame(m_buffer_object_cpu.wvp_current);
-
-                    // Update object buffer
-                    if (!UpdateObjectBuffer(cmd_list))
-                        continue;
+                    LOG_ERROR("Material instance array has reached it's maximum capacity of %d elements. Consider increasing the size.", m_max_material_instances);
                 }
-                
-                // Render	
-                cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
-                m_profiler->m_renderer_meshes_rendered++;
 
-                // Clear only on first pass
-                if (!cleared)
+                // Bind material textures		
+                for (uint32_t slot = 0; slot < static_cast<uint32_t>(material->textures.size()); slot++)
                 {
-                    pso.ResetClearValues();
-                    cleared = true;
+                    cmd_list->SetTexture(slot, material->textures[slot].get());
                 }
+            
+                // Update uber buffer with material properties
+                m_buffer_uber_cpu.mat_id            = static_cast<float>(material_index);
+                m_buffer_uber_cpu.mat_albedo        = material->albedo;
+                m_buffer_uber_cpu.mat_tiling_uv     = material->tiling;
+                m_buffer_uber_cpu.mat_offset_uv     = material->offset;
+                m_buffer_uber_cpu.mat_roughness_mul = material->roughness;
+                m_buffer_uber_cpu.mat_metallic_mul  = material->metallic;
+                m_buffer_uber_cpu.mat_normal_mul    = material->normal;
+                m_buffer_uber_cpu.mat_height_mul    = material->height;
+
+                // Update constant buffer
+                UpdateUberBuffer(cmd_list);
             }
+            
+            // Update object buffer with where the instances of this batch are (they carry the transforms)
+            m_buffer_object_cpu.instance_offset = batch.instance_offset;
+            if (!UpdateObjectBuffer(cmd_list))
+                continue;
 
-            if (render_pass_active)
+            // Render
+            const RenderableLod& lod = renderable->GeometryLod(m_snapshot->lods[visible[batch.first]]);
+            cmd_list->DrawIndexedInstanced(lod.index_count, batch.count, lod.index_offset, renderable->GeometryVertexOffset());
+            m_profiler->m_renderer_meshes_rendered += batch.count;
+
+            // Clear only on first pass
+            if (!cleared)
             {
-                cmd_list->EndRenderPass();
+                pso.ResetClearValues();
+                cleared = true;
             }
         }
 
+        if (render_pass_active)
+        {
+            cmd_list->EndRenderPass();
+        }
+
         // Update constant buffer (light pass will access it using material IDs)
         UpdateMaterialBuffer();
 	}
@@ -692,8 +763,8 @@ namespace Spartan
     void Renderer::Pass_Light(RHI_CommandList* cmd_list, const bool use_stencil)
     {
         // Acquire lights
-        const vector<Entity*>& entities = m_entities[Renderer_Object_Light];
-        if (entities.empty())
+        const vector<RendererSnapshot::LightData>& lights = m_snapshot->lights;
+        if (lights.empty())
             return;
 
         // Acquire shaders
@@ -738,15 +809,52 @@ namespace Spartan
 
         bool cleared = false;
 
-        // Iterate through all the light entities
-        for (const auto& entity : entities)
+        // The G-Buffer and the other inputs which every light reads
+        const auto set_textures = [this, cmd_list, tex_depth]()
+        {
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(8, m_render_targets[RenderTarget_Gbuffer_Albedo]);
+            cmd_list->SetTexture(9, m_render_targets[RenderTarget_Gbuffer_Normal]);
+            cmd_list->SetTexture(10, m_render_targets[RenderTarget_Gbuffer_Material]);
+            cmd_list->SetTexture(12, tex_depth);
+            cmd_list->SetTexture(22, (m_options & Render_Hbao) ? m_render_targets[RenderTarget_Hbao] : m_tex_black_opaque);
+            cmd_list->SetTexture(26, (m_options & Render_ScreenSpaceReflections) ? m_render_targets[RenderTarget_Ssr] : m_tex_black_transparent);
+            cmd_list->SetTexture(27, m_render_targets[RenderTarget_Hdr_2]); // previous frame before post-processing
+            cmd_list->SetTexture(31, m_tex_blue_noise);
+        };
+
+        // Point and spot lights without shadows, all of them in a single pass where each pixel only loops through the lights of its cluster
+        if (!m_snapshot->lights_clustered.empty())
+        {
+            pipeline_state.shader_pixel = m_shaders[Shader_Light_Clustered_P].get();
+            if (pipeline_state.shader_pixel->IsCompiled() && cmd_list->BeginRenderPass(pipeline_state))
+            {
+                set_textures();
+                cmd_list->SetStructuredBuffer(34, RHI_Shader_Pixel, m_buffer_cluster_lights_gpu);
+                cmd_list->SetStructuredBuffer(35, RHI_Shader_Pixel, m_buffer_clusters_gpu);
+                cmd_list->SetStructuredBuffer(36, RHI_Shader_Pixel, m_buffer_cluster_light_indices_gpu);
+                cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+                cmd_list->EndRenderPass();
+
+                // Clear only on first pass
+                if (!use_stencil)
+                {
+                    pipeline_state.ResetClearValues();
+                    cleared = true;
+                }
+            }
+        }
+
+        // Iterate through all the lights
+        for (const RendererSnapshot::LightData& light_data : lights)
         {
-            if (Light* light = entity->GetComponent<Light>())
+            if (light_data.light)
             {
-                if (light->GetIntensity() != 0)
+                if (light_data.intensity != 0 && !light_data.clustered)
                 {
                     // Set pixel shader
-                    pipeline_state.shader_pixel = static_cast<RHI_Shader*>(ShaderLight::GetVariation(m_context, light, m_options));
+                    pipeline_state.shader_pixel = static_cast<RHI_Shader*>(ShaderLight::GetVariation(m_context, light_data.shader_flags));
 
                     // Skip the shader until it compiles or the users spots a compilation error
                     if (!pipeline_state.shader_pixel->IsCompiled())
@@ -754,37 +862,28 @@ namespace Spartan
 
                     if (cmd_list->BeginRenderPass(pipeline_state))
                     {
-                        cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
-                        cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-                        cmd_list->SetTexture(8, m_render_targets[RenderTarget_Gbuffer_Albedo]);
-                        cmd_list->SetTexture(9, m_render_targets[RenderTarget_Gbuffer_Normal]);
-                        cmd_list->SetTexture(10, m_render_targets[RenderTarget_Gbuffer_Material]);
-                        cmd_list->SetTexture(12, tex_depth);
-                        cmd_list->SetTexture(22, (m_options & Render_Hbao) ? m_render_targets[RenderTarget_Hbao] : m_tex_black_opaque);
-                        cmd_list->SetTexture(26, (m_options & Render_ScreenSpaceReflections) ? m_render_targets[RenderTarget_Ssr] : m_tex_black_transparent);
-                        cmd_list->SetTexture(27, m_render_targets[RenderTarget_Hdr_2]); // previous frame before post-processing
-                        cmd_list->SetTexture(31, m_tex_blue_noise);
+                        set_textures();
 
                         // Update light buffer
-                        UpdateLightBuffer(light);
+                        UpdateLightBuffer(light_data);
 
                         // Set shadow map
-                        if (light->GetShadowsEnabled())
+                        if (light_data.shadows)
                         {
-                            RHI_Texture* tex_depth = light->GetDepthTexture();
-                            RHI_Texture* tex_color = light->GetShadowsTransparentEnabled() ? light->GetColorTexture() : m_tex_white.get();
+                            RHI_Texture* tex_depth = light_data.shadow_map.texture_depth.get();
+                            RHI_Texture* tex_color = light_data.shadows_transparent ? light_data.shadow_map.texture_color.get() : m_tex_white.get();
 
-                            if (light->GetLightType() == Light_Directional)
+                            if (light_data.type == Light_Directional)
                             {
                                 cmd_list->SetTexture(13, tex_depth);
                                 cmd_list->SetTexture(14, tex_color);
                             }
-                            else if (light->GetLightType() == Light_Point)
+                            else if (light_data.type == Light_Point)
                             {
                                 cmd_list->SetTexture(15, tex_depth);
                                 cmd_list->SetTexture(16, tex_color);
                             }
-                            else if (light->GetLightType() == Light_Spot)
+                            else if (light_data.type == Light_Spot)
                             {
                                 cmd_list->SetTexture(17, tex_depth);
                                 cmd_list->SetTexture(18, tex_color);
@@ -1923,12 +2022,12 @@ namespace Spartan
 
 	void Renderer::Pass_Lines(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_out)
 	{
-		const bool draw_picking_ray = m_options & Render_Debug_PickingRay;
-		const bool draw_aabb		= m_options & Render_Debug_Aabb;
+        // Debug primitives (picking ray, aabbs, etc.) were added to the lines when the snapshot was captured
+        auto& lines_depth_enabled   = m_snapshot->lines_depth_enabled;
+        auto& lines_depth_disabled  = m_snapshot->lines_depth_disabled;
 		const bool draw_grid		= m_options & Render_Debug_Grid;
-        const bool draw_lights      = m_options & Render_Debug_Lights;
-		const auto draw_lines		= !m_lines_list_depth_enabled.empty() || !m_lines_list_depth_disabled.empty(); // Any kind of lines, physics, user debug, etc.
-		const auto draw				= draw_picking_ray || draw_aabb || draw_grid || draw_lines || draw_lights;
+		const auto draw_lines		= !lines_depth_enabled.empty() || !lines_depth_disabled.empty(); // Any kind of lines, physics, user debug, etc.
+		const auto draw				= draw_grid || draw_lines;
 		if (!draw)
 			return;
 
@@ -1938,53 +2037,6 @@ namespace Spartan
         if (!shader_color_v->IsCompiled() || !shader_color_p->IsCompiled())
             return;
 
-        // Generate lines for debug primitives offered by the renderer
-        {
-            // Picking ray
-            if (draw_picking_ray)
-            {
-                const auto& ray = m_camera->GetPickingRay();
-                DrawLine(ray.GetStart(), ray.GetStart() + ray.GetDirection() * m_camera->GetFarPlane(), Vector4(0, 1, 0, 1));
-            }
-
-            // Lights
-            if (draw_lights)
-            {
-                auto& lights = m_entities[Renderer_Object_Light];
-                for (const auto& entity : lights)
-                {
-                    Light* light = entity->GetComponent<Light>();
-
-                    if (light->GetLightType() == Light_Spot)
-                    {
-                        Vector3 start = light->GetTransform()->GetPosition();
-                        Vector3 end = light->GetTransform()->GetForward() * light->GetRange();
-                        DrawLine(start, start + end, Vector4(0, 1, 0, 1));
-                    }
-                }
-            }
-
-            // AABBs
-            if (draw_aabb)
-            {
-                for (const auto& entity : m_entities[Renderer_Object_Opaque])
-                {
-                    if (auto renderable = entity->GetRenderable())
-                    {
-                        DrawBox(renderable->GetAabb(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
-                    }
-                }
-
-                for (const auto& entity : m_entities[Renderer_Object_Transparent])
-                {
-                    if (auto renderable = entity->GetRenderable())
-                    {
-                        DrawBox(renderable->GetAabb(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
-                    }
-                }
-            }
-        }
-
         // Draw lines with depth
         {
             // Grid
@@ -2009,7 +2061,7 @@ namespace Spartan
                 {
                     // Update uber buffer
                     m_buffer_uber_cpu.resolution    = m_resolution;
-                    m_buffer_uber_cpu.transform     = m_gizmo_grid->ComputeWorldMatrix(m_camera->GetTransform()) * m_buffer_frame_cpu.view_projection_unjittered;
+                    m_buffer_uber_cpu.transform     = m_gizmo_grid->ComputeWorldMatrix(m_snapshot->camera_position) * m_buffer_frame_cpu.view_projection_unjittered;
                     UpdateUberBuffer(cmd_list);
 
                     cmd_list->SetBufferIndex(m_gizmo_grid->GetIndexBuffer().get());
@@ -2020,7 +2072,7 @@ namespace Spartan
             }
 
             // Lines
-            const auto line_vertex_buffer_size = static_cast<uint32_t>(m_lines_list_depth_enabled.size());
+            const auto line_vertex_buffer_size = static_cast<uint32_t>(lines_depth_enabled.size());
             if (line_vertex_buffer_size != 0)
             {
                 // Grow vertex buffer (if needed)
@@ -2031,9 +2083,9 @@ namespace Spartan
 
                 // Update vertex buffer
                 const auto buffer = static_cast<RHI_Vertex_PosCol*>(m_vertex_buffer_lines->Map());
-                copy(m_lines_list_depth_enabled.begin(), m_lines_list_depth_enabled.end(), buffer);
+                copy(lines_depth_enabled.begin(), lines_depth_enabled.end(), buffer);
                 m_vertex_buffer_lines->Unmap();
-                m_lines_list_depth_enabled.clear();
+                lines_depth_enabled.clear();
 
                 // Set render state
                 static RHI_PipelineState pipeline_state;
@@ -2060,7 +2112,7 @@ namespace Spartan
         }
 
         // Draw lines without depth
-        const auto line_vertex_buffer_size = static_cast<uint32_t>(m_lines_list_depth_disabled.size());
+        const auto line_vertex_buffer_size = static_cast<uint32_t>(lines_depth_disabled.size());
         if (line_vertex_buffer_size != 0)
         {
             // Grow vertex buffer (if needed)
@@ -2071,9 +2123,9 @@ namespace Spartan
 
             // Update vertex buffer
             const auto buffer = static_cast<RHI_Vertex_PosCol*>(m_vertex_buffer_lines->Map());
-            copy(m_lines_list_depth_disabled.begin(), m_lines_list_depth_disabled.end(), buffer);
+            copy(lines_depth_disabled.begin(), lines_depth_disabled.end(), buffer);
             m_vertex_buffer_lines->Unmap();
-            m_lines_list_depth_disabled.clear();
+            lines_depth_disabled.clear();
 
             // Set render state
             static RHI_PipelineState pipeline_state;
@@ -2104,7 +2156,7 @@ namespace Spartan
             return;
 
         // Acquire resources
-        auto& lights                    = m_entities[Renderer_Object_Light];
+        const auto& lights              = m_snapshot->lights;
 		const auto& shader_quad_v       = m_shaders[Shader_Quad_V];
         const auto& shader_texture_p    = m_shaders[Shader_Texture_P];
 		if (lights.empty() || !shader_quad_v->IsCompiled() || !shader_texture_p->IsCompiled())
@@ -2124,30 +2176,30 @@ namespace Spartan
         pipeline_state.pass_name                        = "Pass_Gizmos_Lights";
 
         // For each light
-        for (const auto& entity : lights)
+        for (const RendererSnapshot::LightData& light_data : lights)
         {
             if (cmd_list->BeginRenderPass(pipeline_state))
             {
                 // Light can be null if it just got removed and our buffer doesn't update till the next frame
-                if (Light* light = entity->GetComponent<Light>())
+                if (light_data.light)
                 {
-                    auto position_light_world       = entity->GetTransform()->GetPosition();
-                    auto position_camera_world      = m_camera->GetTransform()->GetPosition();
+                    auto position_light_world       = light_data.position;
+                    auto position_camera_world      = m_snapshot->camera_position;
                     auto direction_camera_to_light  = (position_light_world - position_camera_world).Normalized();
-                    const auto v_dot_l                    = Vector3::Dot(m_camera->GetTransform()->GetForward(), direction_camera_to_light);
+                    const auto v_dot_l                    = Vector3::Dot(m_snapshot->camera_direction, direction_camera_to_light);
         
                     // Only draw if it's inside our view
                     if (v_dot_l > 0.5f)
                     {
                         // Compute light screen space position and scale (based on distance from the camera)
-                        const auto position_light_screen    = m_camera->Project(position_light_world);
+                        const auto position_light_screen    = light_data.position_screen;
                         const auto distance                 = (position_camera_world - position_light_world).Length() + Helper::M_EPSILON;
                         auto scale                          = m_gizmo_size_max / distance;
                         scale                               = Helper::Clamp(scale, m_gizmo_size_min, m_gizmo_size_max);
         
                         // Choose texture based on light type
                         shared_ptr<RHI_Texture> light_tex = nullptr;
-                        const auto type = light->GetLightType();
+                        const auto type = light_data.type;
                         if (type == Light_Directional)	light_tex = m_gizmo_tex_light_directional;
                         else if (type == Light_Point)	light_tex = m_gizmo_tex_light_point;
                         else if (type == Light_Spot)	light_tex = m_gizmo_tex_light_spot;
@@ -2196,7 +2248,7 @@ namespace Spartan
             return;
 
         // Transform
-        if (m_gizmo_transform->Update(m_camera.get(), m_gizmo_transform_size, m_gizmo_transform_speed))
+        if (m_snapshot->transform_gizmo_visible)
         {
             // Set render state
             static RHI_PipelineState pipeline_state;
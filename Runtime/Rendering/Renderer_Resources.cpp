@@ -31,6 +31,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Sampler.h"
 #include "../RHI/RHI_BlendState.h"
 #include "../RHI/RHI_ConstantBuffer.h"
+#include "../RHI/RHI_StructuredBuffer.h"
 #include "../RHI/RHI_RasterizerState.h"
 #include "../RHI/RHI_DepthStencilState.h"
 #include "../RHI/RHI_SwapChain.h"
@@ -62,6 +63,18 @@ namespace Spartan
 
         m_buffer_light_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "light");
         m_buffer_light_gpu->Create<BufferLight>();
+
+        m_buffer_instance_gpu = make_shared<RHI_StructuredBuffer>(m_rhi_device, "instance");
+        m_buffer_instance_gpu->Create<BufferInstance>(1024);
+
+        m_buffer_cluster_lights_gpu = make_shared<RHI_StructuredBuffer>(m_rhi_device, "cluster_lights");
+        m_buffer_cluster_lights_gpu->Create<BufferClusterLight>(256);
+
+        m_buffer_clusters_gpu = make_shared<RHI_StructuredBuffer>(m_rhi_device, "clusters");
+        m_buffer_clusters_gpu->Create<LightClusters::Cluster>(LightClusters::cluster_count);
+
+        m_buffer_cluster_light_indices_gpu = make_shared<RHI_StructuredBuffer>(m_rhi_device, "cluster_light_indices");
+        m_buffer_cluster_light_indices_gpu->Create<uint32_t>(4096);
     }
 
     void Renderer::CreateDepthStencilStates()
@@ -72,6 +85,7 @@ namespace Spartan
         m_depth_stencil_on_off_r    = make_shared<RHI_DepthStencilState>(m_rhi_device, true,    false,  GetComparisonFunction(), false, false);                         // depth
         m_depth_stencil_off_on_r    = make_shared<RHI_DepthStencilState>(m_rhi_device, false,   false,  GetComparisonFunction(), true,  false,  RHI_Comparison_Equal);  // depth + stencil
         m_depth_stencil_on_on_w     = make_shared<RHI_DepthStencilState>(m_rhi_device, true,    true,   GetComparisonFunction(), true,  true,   RHI_Comparison_Always); // depth + stencil
+        m_depth_stencil_always_off_w = make_shared<RHI_DepthStencilState>(m_rhi_device, true,   true,   RHI_Comparison_Always,   false, false);                         // depth, overwrites whatever is there
     }
 
     void Renderer::CreateRasterizerStates()
@@ -196,6 +210,28 @@ namespace Spartan
         m_shaders[Shader_Depth_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
         m_shaders[Shader_Depth_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Depth_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Instanced_V]->AddDefine("INSTANCING");
+        m_shaders[Shader_Depth_Instanced_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+
+        // Depth Copy - Cached static shadow casters into a shadow map slice
+        m_shaders[Shader_Depth_Copy_Directional_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Copy_Directional_P]->AddDefine("COPY");
+        m_shaders[Shader_Depth_Copy_Directional_P]->AddDefine("DIRECTIONAL");
+        m_shaders[Shader_Depth_Copy_Directional_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Copy_Point_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Copy_Point_P]->AddDefine("COPY");
+        m_shaders[Shader_Depth_Copy_Point_P]->AddDefine("POINT");
+        m_shaders[Shader_Depth_Copy_Point_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Copy_Spot_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Copy_Spot_P]->AddDefine("COPY");
+        m_shaders[Shader_Depth_Copy_Spot_P]->AddDefine("SPOT");
+        m_shaders[Shader_Depth_Copy_Spot_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Depth.hlsl");
+
+        // Light - Point and spot lights without shadows, in a single pass
+        m_shaders[Shader_Light_Clustered_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Light_Clustered_P]->AddDefine("CLUSTERED");
+        m_shaders[Shader_Light_Clustered_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Light.hlsl");
 
         // BRDF - Specular Lut
         m_shaders[Shader_BrdfSpecularLut] = make_shared<RHI_Shader>(m_context);
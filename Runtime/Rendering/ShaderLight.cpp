@@ -40,9 +40,8 @@ namespace Spartan
         m_flags = flags;
     }
 
-    ShaderLight* ShaderLight::GetVariation(Context* context, const Light* light, const uint64_t renderer_flags)
+    uint16_t ShaderLight::GetFlags(const Light* light, const uint64_t renderer_flags)
     {
-        // Compute flags
         uint16_t flags = 0;
         flags |= light->GetLightType() == Light_Directional                                             ? Shader_Light_Directional              : flags;
         flags |= light->GetLightType() == Light_Point                                                   ? Shader_Light_Point                    : flags;
@@ -53,6 +52,11 @@ namespace Spartan
         flags |= (light->GetVolumetricEnabled() && (renderer_flags & Render_VolumetricLighting))            ? Shader_Light_Volumetric               : flags;
         flags |= (renderer_flags & Render_ScreenSpaceReflections)                                           ? Shader_Light_ScreenSpaceReflections   : flags;
 
+        return flags;
+    }
+
+    ShaderLight* ShaderLight::GetVariation(Context* context, const uint16_t flags)
+    {
         // Return existing shader, if it's already compiled
         if (m_variations.find(flags) != m_variations.end())
             return m_variations.at(flags).get();
@@ -51,7 +51,8 @@ namespace Spartan
         ShaderLight(Context* context, const uint16_t flags = 0);
         ~ShaderLight() = default;
 
-        static ShaderLight* GetVariation(Context* context, const Light* light, const uint64_t renderer_flags);
+        static uint16_t GetFlags(const Light* light, const uint64_t renderer_flags);
+        static ShaderLight* GetVariation(Context* context, const uint16_t flags);
         static auto& GetVariations() { return m_variations; }
 
     private:
@@ -0,0 +1,211 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "Spartan.h"
+#include "TextureStreamer.h"
+#include "../RHI/RHI_Texture.h"
+#include "../Threading/Threading.h"
+//=================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    TextureStreamer::TextureStreamer()
+    {
+        m_inbox = make_shared<Inbox>();
+    }
+
+    void TextureStreamer::Request(const shared_ptr<RHI_Texture>& texture, const Vector2& tiling, const float screen_size)
+    {
+        if (!texture || !texture->IsStreamed() || texture->GetLoadState() != LoadState_Completed)
+            return;
+
+        auto it = m_entries.find(texture->GetId());
+        if (it == m_entries.end())
+        {
+            // Nothing else touches a texture which isn't streaming yet
+            Entry entry;
+            entry.texture       = texture;
+            entry.mip_needed    = texture->GetMipTail();
+            entry.mip_target    = texture->GetMipResident();
+            entry.mip_requested = texture->GetMipResident();
+            entry.mip_tail      = texture->GetMipTail();
+            entry.mip_count     = texture->GetMipCount();
+            entry.frame_target  = m_frame;
+            it = m_entries.emplace(texture->GetId(), entry).first;
+        }
+
+        // How many times the texture repeats across the surface
+        const float repeat = Helper::Max(Helper::Abs(tiling.x), Helper::Abs(tiling.y));
+
+        // The mip whose texels are about the size of a pixel
+        const float texels      = static_cast<float>(Helper::Max(texture->GetWidth(), texture->GetHeight())) * repeat;
+        const float ratio       = texels / Helper::Max(screen_size, 1.0f);
+        const uint32_t mip      = ratio > 1.0f ? static_cast<uint32_t>(log2(ratio)) : 0;
+        Entry& entry            = it->second;
+        entry.mip_needed        = Helper::Min(entry.mip_needed, Helper::Min(mip, entry.mip_tail));
+    }
+
+    void TextureStreamer::Update(const uint64_t budget, Threading* threading, const bool full_resolution /*= false*/)
+    {
+        // Textures which have been swapped in since the last update
+        {
+            lock_guard<mutex> lock(m_inbox->mutex);
+            for (const Inbox::Applied& applied : m_inbox->applied)
+            {
+                m_loading--;
+
+                const auto it = m_entries.find(applied.id);
+                if (it != m_entries.end())
+                {
+                    it->second.mip_requested    = applied.mip_resident;
+                    it->second.loading          = false;
+                    it->second.failed           = !applied.success;
+                }
+            }
+            m_inbox->applied.clear();
+        }
+
+        // Work out the targets, more detail is taken right away, less only once it hasn't been needed for a while
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            Entry& entry = it->second;
+            if (entry.texture.expired())
+            {
+                it = m_entries.erase(it);
+                continue;
+            }
+
+            const uint32_t mip_needed = full_resolution ? 0 : entry.mip_needed;
+            if (mip_needed <= entry.mip_target || m_frame - entry.frame_target > m_frames_keep)
+            {
+                entry.mip_target    = mip_needed;
+                entry.frame_target  = m_frame;
+            }
+            entry.mip_needed = entry.mip_tail;
+
+            it++;
+        }
+
+        // Drop the same number of mips from every texture until they fit in the budget
+        m_bias = 0;
+        while (true)
+        {
+            m_size_resident = 0;
+            bool reducible  = false;
+            for (const auto& it : m_entries)
+            {
+                const Entry& entry  = it.second;
+                const uint32_t mip  = Helper::Min(entry.mip_target + m_bias, entry.mip_tail);
+                reducible           |= !entry.failed && mip < entry.mip_tail;
+
+                if (shared_ptr<RHI_Texture> texture = entry.texture.lock())
+                {
+                    m_size_resident += GetSize(texture.get(), entry.failed ? entry.mip_requested : mip, entry.mip_count);
+                }
+            }
+
+            if (full_resolution || m_size_resident <= budget || !reducible)
+                break;
+
+            m_bias++;
+        }
+
+        // Evictions go first, as they free memory, then the textures which are missing the most mips
+        m_candidates.clear();
+        for (auto& it : m_entries)
+        {
+            Entry& entry = it.second;
+            if (entry.loading || entry.failed)
+                continue;
+
+            const uint32_t mip = Helper::Min(entry.mip_target + m_bias, entry.mip_tail);
+            if (mip != entry.mip_requested)
+            {
+                m_candidates.emplace_back(mip > entry.mip_requested ? numeric_limits<uint32_t>::max() : entry.mip_requested - mip, &entry);
+            }
+        }
+        sort(m_candidates.begin(), m_candidates.end(), [](const pair<uint32_t, Entry*>& a, const pair<uint32_t, Entry*>& b) { return a.first > b.first; });
+
+        // Read the mips, the worker only touches what it captures, so the streamer can go away while it runs
+        for (const pair<uint32_t, Entry*>& candidate : m_candidates)
+        {
+            if (m_loading >= m_loading_max)
+                break;
+
+            Entry& entry = *candidate.second;
+            shared_ptr<RHI_Texture> texture = entry.texture.lock();
+            if (!texture)
+                continue;
+
+            const uint32_t mip  = Helper::Min(entry.mip_target + m_bias, entry.mip_tail);
+            entry.mip_requested = mip;
+            entry.loading       = true;
+            m_loading++;
+
+            threading->AddTask([texture, inbox = m_inbox, mip]()
+            {
+                Inbox::Result result;
+                result.texture  = texture;
+                result.mip      = mip;
+                texture->ReadMips(mip, result.data);
+
+                lock_guard<mutex> lock(inbox->mutex);
+                inbox->results.emplace_back(move(result));
+            });
+        }
+
+        m_frame++;
+    }
+
+    void TextureStreamer::Apply()
+    {
+        vector<Inbox::Result> results;
+        {
+            lock_guard<mutex> lock(m_inbox->mutex);
+            results.swap(m_inbox->results);
+        }
+
+        for (Inbox::Result& result : results)
+        {
+            const bool success = !result.data.empty() && result.texture->StreamMips(result.mip, result.data);
+
+            lock_guard<mutex> lock(m_inbox->mutex);
+            m_inbox->applied.push_back({ result.texture->GetId(), result.texture->GetMipResident(), success });
+        }
+    }
+
+    uint64_t TextureStreamer::GetSize(const RHI_Texture* texture, const uint32_t mip_top, const uint32_t mip_count)
+    {
+        uint64_t size = 0;
+        for (uint32_t mip = mip_top; mip < mip_count; mip++)
+        {
+            size += texture->GetMipSize(mip);
+        }
+
+        return size;
+    }
+}
@@ -0,0 +1,108 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include "../Core/Spartan_Definitions.h"
+#include "../Math/Vector2.h"
+//=================================
+
+namespace Spartan
+{
+    class RHI_Texture;
+    class Threading;
+
+    // Streamed textures are created with their tail mips only (see RHI_Texture_Streamable). Every frame, the renderer tells the
+    // streamer which textures its snapshot of the visible materials uses and how big they are on the screen, from which the mip that each texture needs is worked
+    // out (the one whose texels are about the size of a pixel). If the textures need more memory than the budget allows, they all
+    // drop the same number of mips until they fit. A texture which needs less detail than it has keeps it for a while, so turning
+    // the camera back and forth doesn't thrash. The mips are read by workers, then swapped into the textures by the thread which
+    // records, before anything is drawn, which recreates the GPU resource of the texture with its new top mip.
+    class SPARTAN_CLASS TextureStreamer
+    {
+    public:
+        TextureStreamer();
+        ~TextureStreamer() = default;
+
+        // Simulation thread, tiling is the material's and screen_size is the projected size of what the material is on, in pixels
+        void Request(const std::shared_ptr<RHI_Texture>& texture, const Math::Vector2& tiling, float screen_size);
+        void Update(uint64_t budget, Threading* threading, bool full_resolution = false);
+
+        // Recording thread
+        void Apply();
+
+        uint64_t GetSizeResident()  const { return m_size_resident; } // what Update() asked for, once all of it is applied
+        uint32_t GetBias()          const { return m_bias; }          // mips every texture is missing because of the budget
+
+    private:
+        struct Entry
+        {
+            std::weak_ptr<RHI_Texture> texture;
+            uint32_t mip_needed     = 0;    // this frame
+            uint32_t mip_target     = 0;    // needed lately
+            uint32_t mip_requested  = 0;    // asked for, resident once it's applied
+            uint32_t mip_tail       = 0;    // copies of the texture's, which can change while it's recorded
+            uint32_t mip_count      = 0;
+            uint64_t frame_target   = 0;    // the last frame which needed the target
+            bool loading            = false;
+            bool failed             = false; // left as it is
+        };
+
+        // Where the workers leave the mips they read, it outlives the streamer
+        struct Inbox
+        {
+            struct Result
+            {
+                std::shared_ptr<RHI_Texture> texture;
+                uint32_t mip = 0;
+                std::vector<std::vector<std::byte>> data;
+            };
+
+            struct Applied
+            {
+                uint64_t id             = 0;
+                uint32_t mip_resident   = 0;
+                bool success            = false;
+            };
+
+            std::mutex mutex;
+            std::vector<Result> results;
+            std::vector<Applied> applied;
+        };
+
+        static uint64_t GetSize(const RHI_Texture* texture, uint32_t mip_top, uint32_t mip_count);
+
+        std::unordered_map<uint64_t, Entry> m_entries; // by texture id
+        std::shared_ptr<Inbox> m_inbox;
+        std::vector<std::pair<uint32_t, Entry*>> m_candidates; // scratch, missing mips and entry
+        uint64_t m_frame                = 0;
+        uint64_t m_size_resident        = 0;
+        uint32_t m_bias                 = 0;
+        uint32_t m_loading              = 0;
+        const uint32_t m_loading_max    = 4;
+        const uint64_t m_frames_keep    = 120; // frames a texture keeps detail it no longer needs
+    };
+}
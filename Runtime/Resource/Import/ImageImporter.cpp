@@ -25,6 +25,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define FREEIMAGE_LIB
 #include <FreeImage.h>
 #include <Utilities.h>
+#include "MipGenerator.h"
+#include "TextureCompressor.h"
+#include "../../Core/Stopwatch.h"
 #include "../../Threading/Threading.h"
 #include "../../RHI/RHI_Texture2D.h"
 //====================================
@@ -36,23 +39,7 @@ using namespace std;
 namespace Spartan::freeimage_helper
 {
 	static FREE_IMAGE_FILTER rescale_filter = FILTER_LANCZOS3;
-
-	// A struct that rescaling threads will work with
-	struct RescaleJob
-	{
-		uint32_t width		    = 0;
-		uint32_t height		    = 0;
-		uint32_t channel_count	= 0;
-		vector<std::byte>* data	= nullptr;
-		bool done			    = false;
-
-		RescaleJob(const uint32_t width, const uint32_t height, const uint32_t channel_count)
-		{
-			this->width		    = width;
-			this->height	    = height;
-			this->channel_count	= channel_count;
-		}
-	};
+	static Mip_Filter mip_filter            = Mip_Filter_Lanczos;
 
     inline uint32_t get_bytes_per_channel(FIBITMAP* bitmap)
     {
@@ -212,12 +199,6 @@ namespace Spartan
 		const auto mip = texture->AddMipmap();
 		GetBitsFromFibitmap(mip, bitmap, image_width, image_height, image_channel_count);
 
-		// If the texture supports mipmaps, generate them
-		if (generate_mipmaps)
-		{
-			GenerateMipmaps(bitmap, texture, image_width, image_height, image_channel_count);
-		}
-
 		// Free memory 
 		FreeImage_Unload(bitmap);
 
@@ -230,6 +211,33 @@ namespace Spartan
 		texture->SetFormat(image_format);
 		texture->SetGrayscale(image_is_grayscale);
 
+		// If the texture supports mipmaps, generate them
+		if (generate_mipmaps)
+		{
+			if (!MipGenerator::Generate(texture, freeimage_helper::mip_filter, m_context->GetSubsystem<Threading>()))
+			{
+				LOG_ERROR("Failed to generate mipmaps for \"%s\"", file_path.c_str());
+			}
+		}
+
+        // Block compress (if requested and possible)
+        if (texture->GetFlags() & RHI_Texture_CompressWhenLoading)
+        {
+            const RHI_Format format_compressed = TextureCompressor::GetFormat(texture);
+            if (format_compressed != RHI_Format_Undefined)
+            {
+                Stopwatch timer;
+                float psnr = 0.0f;
+                if (!TextureCompressor::Compress(texture, format_compressed, m_context->GetSubsystem<Threading>(), &psnr))
+                {
+                    LOG_ERROR("Failed to compress \"%s\"", file_path.c_str());
+                    return false;
+                }
+
+                LOG_INFO("Compressed \"%s\" to %s in %.2f ms (%.2f dB)", file_path.c_str(), rhi_format_to_string(format_compressed), timer.GetElapsedTimeMs(), psnr);
+            }
+        }
+
 		return true;
 	}
 
@@ -257,67 +265,6 @@ namespace Spartan
 		return true;
 	}
 
-	void ImageImporter::GenerateMipmaps(FIBITMAP* bitmap, RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels)
-	{
-		if (!texture)
-		{
-			LOG_ERROR_INVALID_PARAMETER();
-			return;
-		}
-	
-		// Create a RescaleJob for every mip that we need
-		vector<freeimage_helper::RescaleJob> jobs;
-		while (width > 1 && height > 1)
-		{
-			width	= Math::Helper::Max(width / 2, static_cast<uint32_t>(1));
-			height	= Math::Helper::Max(height / 2, static_cast<uint32_t>(1));
-			jobs.emplace_back(width, height, channels);
-			
-			// Resize the RHI_Texture vector accordingly
-			const auto size = width * height * channels;
-			auto mip		= texture->AddMipmap();
-			mip->reserve(size);
-			mip->resize(size);
-		}
-
-		// Pass data pointers (now that the RHI_Texture mip vector has been constructed)
-		for (uint32_t i = 0; i < jobs.size(); i++)
-		{
-			// reminder: i + 1 because the 0 mip is the default image size
-			jobs[i].data = texture->GetData(i + 1);
-		}
-
-		// Parallelize mipmap generation using multiple threads (because FreeImage_Rescale() using FILTER_LANCZOS3 is expensive)
-		auto threading = m_context->GetSubsystem<Threading>();
-		for (auto& job : jobs)
-		{
-			threading->AddTask([this, &job, &bitmap]()
-			{
-				const auto bitmap_scaled = FreeImage_Rescale(bitmap, job.width, job.height, freeimage_helper::rescale_filter);
-				if (!GetBitsFromFibitmap(job.data, bitmap_scaled, job.width, job.height, job.channel_count))
-				{
-					LOG_ERROR("Failed to create mip level %dx%d", job.width, job.height);
-				}
-				FreeImage_Unload(bitmap_scaled);
-				job.done = true;
-			});
-		}
-
-		// Wait until all mipmaps have been generated
-		auto ready = false;
-		while (!ready)
-		{
-			ready = true;
-			for (const auto& job : jobs)
-			{
-				if (!job.done)
-				{
-					ready = false;
-				}
-			}
-		}
-	}
-
 	FIBITMAP* ImageImporter::ApplyBitmapCorrections(FIBITMAP* bitmap) const
 	{
 		if (!bitmap)
@@ -0,0 +1,353 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =====================
+#include "Spartan.h"
+#include "MipGenerator.h"
+#include "../../RHI/RHI_Texture.h"
+#include "../../Threading/Threading.h"
+//================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan::mip_generator
+{
+    // Output rows per band, a band filters the source rows it needs on its own, so larger bands redo less work at their edges
+    static constexpr uint32_t band_rows = 32;
+
+    inline float sinc(const float x)
+    {
+        if (Helper::Abs(x) < Helper::M_EPSILON)
+            return 1.0f;
+
+        const float pi_x = Helper::PI * x;
+        return sin(pi_x) / pi_x;
+    }
+
+    // Modified Bessel function of the first kind, which shapes the Kaiser window
+    inline float bessel_i0(const float x)
+    {
+        float sum   = 1.0f;
+        float term  = 1.0f;
+        for (uint32_t k = 1; k < 16; k++)
+        {
+            term    *= x / (2.0f * k);
+            sum     += term * term;
+        }
+
+        return sum;
+    }
+
+    // In destination texels
+    inline float filter_radius(const Mip_Filter filter)
+    {
+        return filter == Mip_Filter_Box ? 0.5f : 3.0f;
+    }
+
+    inline float filter_weight(const Mip_Filter filter, float x)
+    {
+        x = Helper::Abs(x);
+
+        if (filter == Mip_Filter_Box)
+            return x <= 0.5f ? 1.0f : 0.0f;
+
+        if (x >= 3.0f)
+            return 0.0f;
+
+        if (filter == Mip_Filter_Kaiser)
+        {
+            static const float alpha    = 4.0f;
+            static const float i0_alpha = bessel_i0(alpha);
+            const float t               = x / 3.0f;
+            return sinc(x) * bessel_i0(alpha * sqrt(1.0f - t * t)) / i0_alpha;
+        }
+
+        return sinc(x) * sinc(x / 3.0f);
+    }
+
+    // The source texels (clamped to the edges) and their weights for every destination texel along an axis, all with the same tap count
+    struct Taps
+    {
+        uint32_t count = 0;
+        vector<uint32_t> indices;
+        vector<float> weights;
+    };
+
+    inline Taps compute_taps(const uint32_t size_source, const uint32_t size_destination, const Mip_Filter filter)
+    {
+        const float scale   = static_cast<float>(size_source) / static_cast<float>(size_destination);
+        const float radius  = filter_radius(filter) * scale;
+
+        Taps taps;
+        taps.count = static_cast<uint32_t>(ceil(radius * 2.0f)) + 1;
+        taps.indices.resize(static_cast<size_t>(size_destination) * taps.count);
+        taps.weights.resize(static_cast<size_t>(size_destination) * taps.count);
+
+        for (uint32_t i = 0; i < size_destination; i++)
+        {
+            const float center  = (i + 0.5f) * scale;
+            const int64_t first = static_cast<int64_t>(floor(center - radius));
+            uint32_t* indices   = &taps.indices[static_cast<size_t>(i) * taps.count];
+            float* weights      = &taps.weights[static_cast<size_t>(i) * taps.count];
+
+            float sum = 0.0f;
+            for (uint32_t t = 0; t < taps.count; t++)
+            {
+                const int64_t index = first + t;
+                indices[t]          = static_cast<uint32_t>(Helper::Clamp<int64_t>(index, 0, size_source - 1));
+                weights[t]          = filter_weight(filter, (index + 0.5f - center) / scale);
+                sum                 += weights[t];
+            }
+
+            for (uint32_t t = 0; t < taps.count; t++)
+            {
+                weights[t] /= sum;
+            }
+        }
+
+        return taps;
+    }
+
+    struct Tables
+    {
+        float srgb_to_linear[256];
+        float unorm_to_float[256];
+        uint8_t linear_to_srgb[4096];
+
+        Tables()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                const float value   = i / 255.0f;
+                srgb_to_linear[i]   = value <= 0.04045f ? value / 12.92f : pow((value + 0.055f) / 1.055f, 2.4f);
+                unorm_to_float[i]   = value;
+            }
+
+            for (uint32_t i = 0; i < 4096; i++)
+            {
+                const float value   = i / 4095.0f;
+                const float srgb    = value <= 0.0031308f ? value * 12.92f : 1.055f * pow(value, 1.0f / 2.4f) - 0.055f;
+                linear_to_srgb[i]   = static_cast<uint8_t>(Helper::Saturate(srgb) * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    inline const Tables& get_tables()
+    {
+        static const Tables tables;
+        return tables;
+    }
+}
+
+namespace Spartan
+{
+    bool MipGenerator::Generate(RHI_Texture* texture, const Mip_Filter filter, Threading* threading /*= nullptr*/)
+    {
+        if (!texture || texture->GetData().size() != 1)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        const uint32_t channel_count        = texture->GetChannelCount();
+        const uint32_t bytes_per_channel    = texture->GetBytesPerChannel();
+        if ((bytes_per_channel != 1 && bytes_per_channel != 4) || channel_count == 0 || channel_count > 4)
+        {
+            LOG_ERROR("Unsupported texel, %d channels of %d bytes", channel_count, bytes_per_channel);
+            return false;
+        }
+
+        // 8 bit color is gamma encoded (but not alpha), everything else is linear
+        const uint16_t flags        = texture->GetFlags();
+        const bool is_normal_map    = (flags & RHI_Texture_NormalMap) && channel_count >= 3;
+        const bool is_srgb          = bytes_per_channel == 1 && channel_count >= 3 && !(flags & (RHI_Texture_NormalMap | RHI_Texture_SingleChannel));
+
+        const mip_generator::Tables& tables = mip_generator::get_tables();
+        const float* decode_tables[4];
+        bool encode_srgb[4];
+        for (uint32_t channel = 0; channel < 4; channel++)
+        {
+            encode_srgb[channel]    = is_srgb && channel < 3;
+            decode_tables[channel]  = encode_srgb[channel] ? tables.srgb_to_linear : tables.unorm_to_float;
+        }
+
+        const uint32_t bytes_per_texel = channel_count * bytes_per_channel;
+        uint32_t width  = texture->GetWidth();
+        uint32_t height = texture->GetHeight();
+        for (uint32_t mip_index = 0; width > 1 || height > 1; mip_index++)
+        {
+            const uint32_t width_destination    = Helper::Max(width / 2, 1u);
+            const uint32_t height_destination   = Helper::Max(height / 2, 1u);
+
+            // Adding a mip can move the others, so the source is acquired after
+            vector<std::byte>* mip_destination = texture->AddMipmap();
+            mip_destination->resize(static_cast<size_t>(width_destination) * height_destination * bytes_per_texel);
+            const std::byte* source = texture->GetData(mip_index)->data();
+            std::byte* destination  = mip_destination->data();
+
+            const mip_generator::Taps taps_x = mip_generator::compute_taps(width, width_destination, filter);
+            const mip_generator::Taps taps_y = mip_generator::compute_taps(height, height_destination, filter);
+
+            const auto downsample_bands = [&](const uint32_t band_start, const uint32_t band_end)
+            {
+                vector<float> row_source(static_cast<size_t>(width) * channel_count);
+                vector<float> row_destination(static_cast<size_t>(width_destination) * channel_count);
+                vector<float> rows_filtered;
+
+                for (uint32_t band = band_start; band < band_end; band++)
+                {
+                    const uint32_t y_first  = band * mip_generator::band_rows;
+                    const uint32_t y_end    = Helper::Min(y_first + mip_generator::band_rows, height_destination);
+
+                    // The source rows which the band reads
+                    uint32_t source_first   = numeric_limits<uint32_t>::max();
+                    uint32_t source_last    = 0;
+                    for (size_t i = static_cast<size_t>(y_first) * taps_y.count; i < static_cast<size_t>(y_end) * taps_y.count; i++)
+                    {
+                        source_first    = Helper::Min(source_first, taps_y.indices[i]);
+                        source_last     = Helper::Max(source_last, taps_y.indices[i]);
+                    }
+
+                    // Horizontal pass, over the source rows
+                    const size_t row_filtered_size = static_cast<size_t>(width_destination) * channel_count;
+                    rows_filtered.resize((source_last - source_first + 1) * row_filtered_size);
+                    for (uint32_t y = source_first; y <= source_last; y++)
+                    {
+                        const std::byte* row = source + static_cast<size_t>(y) * width * bytes_per_texel;
+                        if (bytes_per_channel == 4)
+                        {
+                            memcpy(row_source.data(), row, row_source.size() * sizeof(float));
+                        }
+                        else
+                        {
+                            const uint8_t* texels = reinterpret_cast<const uint8_t*>(row);
+                            for (uint32_t x = 0; x < width; x++)
+                            {
+                                for (uint32_t channel = 0; channel < channel_count; channel++)
+                                {
+                                    row_source[x * channel_count + channel] = decode_tables[channel][texels[x * channel_count + channel]];
+                                }
+                            }
+                        }
+
+                        float* row_filtered = &rows_filtered[(y - source_first) * row_filtered_size];
+                        for (uint32_t x = 0; x < width_destination; x++)
+                        {
+                            const uint32_t* indices = &taps_x.indices[static_cast<size_t>(x) * taps_x.count];
+                            const float* weights    = &taps_x.weights[static_cast<size_t>(x) * taps_x.count];
+
+                            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                            for (uint32_t t = 0; t < taps_x.count; t++)
+                            {
+                                const float* texel = &row_source[indices[t] * channel_count];
+                                for (uint32_t channel = 0; channel < channel_count; channel++)
+                                {
+                                    sum[channel] += weights[t] * texel[channel];
+                                }
+                            }
+
+                            for (uint32_t channel = 0; channel < channel_count; channel++)
+                            {
+                                row_filtered[x * channel_count + channel] = sum[channel];
+                            }
+                        }
+                    }
+
+                    // Vertical pass, over the destination rows
+                    for (uint32_t y = y_first; y < y_end; y++)
+                    {
+                        fill(row_destination.begin(), row_destination.end(), 0.0f);
+                        for (uint32_t t = 0; t < taps_y.count; t++)
+                        {
+                            const size_t tap    = static_cast<size_t>(y) * taps_y.count + t;
+                            const float weight  = taps_y.weights[tap];
+                            if (weight == 0.0f)
+                                continue;
+
+                            const float* row_filtered = &rows_filtered[(taps_y.indices[tap] - source_first) * row_filtered_size];
+                            for (size_t i = 0; i < row_filtered_size; i++)
+                            {
+                                row_destination[i] += weight * row_filtered[i];
+                            }
+                        }
+
+                        std::byte* row = destination + static_cast<size_t>(y) * width_destination * bytes_per_texel;
+                        if (bytes_per_channel == 4)
+                        {
+                            // The negative lobes of the filter can ring below zero
+                            float* texels = reinterpret_cast<float*>(row);
+                            for (size_t i = 0; i < row_filtered_size; i++)
+                            {
+                                texels[i] = Helper::Max(row_destination[i], 0.0f);
+                            }
+                            continue;
+                        }
+
+                        uint8_t* texels = reinterpret_cast<uint8_t*>(row);
+                        for (uint32_t x = 0; x < width_destination; x++)
+                        {
+                            float* texel = &row_destination[x * channel_count];
+
+                            // Filtering shortens the normals
+                            if (is_normal_map)
+                            {
+                                const float normal_x    = texel[0] * 2.0f - 1.0f;
+                                const float normal_y    = texel[1] * 2.0f - 1.0f;
+                                const float normal_z    = texel[2] * 2.0f - 1.0f;
+                                const float length      = Helper::Sqrt(normal_x * normal_x + normal_y * normal_y + normal_z * normal_z);
+                                if (length > Helper::M_EPSILON)
+                                {
+                                    texel[0] = normal_x / length * 0.5f + 0.5f;
+                                    texel[1] = normal_y / length * 0.5f + 0.5f;
+                                    texel[2] = normal_z / length * 0.5f + 0.5f;
+                                }
+                            }
+
+                            for (uint32_t channel = 0; channel < channel_count; channel++)
+                            {
+                                const float value = Helper::Saturate(texel[channel]);
+                                texels[x * channel_count + channel] = encode_srgb[channel] ? tables.linear_to_srgb[static_cast<uint32_t>(value * 4095.0f + 0.5f)] : static_cast<uint8_t>(value * 255.0f + 0.5f);
+                            }
+                        }
+                    }
+                }
+            };
+
+            const uint32_t band_count = (height_destination + mip_generator::band_rows - 1) / mip_generator::band_rows;
+            if (threading)
+            {
+                threading->ParallelFor(band_count, 1, downsample_bands);
+            }
+            else
+            {
+                downsample_bands(0, band_count);
+            }
+
+            width   = width_destination;
+            height  = height_destination;
+        }
+
+        return true;
+    }
+}
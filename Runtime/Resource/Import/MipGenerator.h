@@ -0,0 +1,49 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==============================
+#include "../../RHI/RHI_Definition.h"
+#include "../../Core/Spartan_Definitions.h"
+//=========================================
+
+namespace Spartan
+{
+    class Threading;
+
+    enum Mip_Filter
+    {
+        Mip_Filter_Box,     // Averages 2x2 texels, fast but blurry
+        Mip_Filter_Kaiser,  // Kaiser windowed sinc, sharp with little ringing
+        Mip_Filter_Lanczos  // Lanczos 3, the sharpest but it can ring around hard edges
+    };
+
+    // Generates the mip chain of a texture, where every mip is downsampled from the one above instead of from the top mip. The filter
+    // is separable, the horizontal pass runs over the source rows which a band of output rows needs and the vertical pass over the band,
+    // with the bands spread across the job system. 8 bit color is filtered in linear space and normal maps are renormalized.
+    class SPARTAN_CLASS MipGenerator
+    {
+    public:
+        // Appends the mips below the top one (which has to be there already) until both dimensions are 1
+        static bool Generate(RHI_Texture* texture, Mip_Filter filter, Threading* threading = nullptr);
+    };
+}
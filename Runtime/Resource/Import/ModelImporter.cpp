@@ -28,9 +28,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Rendering/Model.h"
 #include "../../Rendering/Animation.h"
 #include "../../Rendering/Material.h"
+#include "../../Rendering/MeshSimplifier.h"
 #include "../../World/World.h"
 #include "../../World/Components/Renderable.h"
 #include "../../RHI/RHI_Vertex.h"
+#include "../../Utilities/Geometry.h"
 //============================================
 
 //= NAMESPACES ================
@@ -41,6 +43,11 @@ using namespace Assimp;
 
 namespace Spartan
 {
+    // Meshes with fewer triangles than this are cheap enough as they are
+    static const uint32_t lod_triangle_min  = 256;
+    // How far the surface of the first level of detail can move, relative to the size of the mesh (it doubles with every level)
+    static const float lod_error_max        = 0.01f;
+
 	ModelImporter::ModelImporter(Context* context)
 	{
 		m_context	= context;
@@ -120,6 +127,7 @@ namespace Spartan
 		// Read the 3D model file from disk
 		if (const aiScene* scene = importer.ReadFile(file_path, importer_flags))
 		{
+			// Blocks until the world has stopped ticking, the entities are built right here (on whatever thread imports)
 			FIRE_EVENT(Event_World_Stop);
 
             params.scene            = scene;
@@ -330,6 +338,12 @@ namespace Spartan
 			}
 		}
 
+		// Fill in whatever the file and assimp didn't provide (e.g. tangents of meshes without texture coordinates)
+		if (!assimp_mesh->mNormals || !assimp_mesh->mTangents)
+		{
+			Utility::Geometry::GenerateNormalsTangents(indices, vertices, !assimp_mesh->mNormals, !assimp_mesh->mTangents, m_context->GetSubsystem<Threading>());
+		}
+
 		// Compute AABB (before doing move operation on vertices)
 		const auto aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
 
@@ -352,6 +366,29 @@ namespace Spartan
             params.model
 		);
 
+        // Levels of detail, every one is simplified from the previous one and draws from the same vertices
+        if (params.generate_lods && indices.size() >= lod_triangle_min * 3)
+        {
+            MeshSimplifier simplifier;
+            vector<uint32_t> lod_indices = indices;
+            vector<uint32_t> lod_indices_simplified;
+            for (uint32_t lod = 1; lod < Renderable::lod_count_max; lod++)
+            {
+                const uint32_t index_target = static_cast<uint32_t>(lod_indices.size() / 6) * 3;
+                const float error_max       = lod_error_max * static_cast<float>(1 << (lod - 1));
+                simplifier.Simplify(vertices.data(), vertex_count, lod_indices, index_target, error_max, lod_indices_simplified);
+
+                // Stop once the error limit (or locked borders and seams) prevent any meaningful reduction
+                if (lod_indices_simplified.empty() || lod_indices_simplified.size() > lod_indices.size() * 3 / 4)
+                    break;
+
+                uint32_t lod_index_offset = 0;
+                params.model->AppendIndices(lod_indices_simplified, &lod_index_offset);
+                renderable->GeometryAddLod(lod_index_offset, static_cast<uint32_t>(lod_indices_simplified.size()));
+                lod_indices.swap(lod_indices_simplified);
+            }
+        }
+
 		// Material
 		if (params.scene->HasMaterials())
 		{
@@ -49,6 +49,7 @@ namespace Spartan
         std::string file_path;
         std::string name;
         bool has_animation;
+        bool generate_lods      = true;
         Model* model            = nullptr;
         const aiScene* scene    = nullptr;
     };
@@ -0,0 +1,986 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =========================
+#include "Spartan.h"
+#include "TextureCompressor.h"
+#include "../../RHI/RHI_Texture.h"
+#include "../../Threading/Threading.h"
+//====================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan::block_compression
+{
+    // Color endpoints are stored as 5:6:5
+    inline uint16_t pack_565(const float* color)
+    {
+        const uint32_t r = static_cast<uint32_t>(Helper::Clamp(color[0] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f));
+        const uint32_t g = static_cast<uint32_t>(Helper::Clamp(color[1] * (63.0f / 255.0f) + 0.5f, 0.0f, 63.0f));
+        const uint32_t b = static_cast<uint32_t>(Helper::Clamp(color[2] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f));
+
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    inline void unpack_565(const uint16_t value, float* color)
+    {
+        const uint32_t r = (value >> 11) & 31;
+        const uint32_t g = (value >> 5) & 63;
+        const uint32_t b = value & 31;
+
+        color[0] = static_cast<float>((r << 3) | (r >> 2));
+        color[1] = static_cast<float>((g << 2) | (g >> 4));
+        color[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+    // The four colors of a block, the encoder always uses the four color mode
+    inline void color_palette(const uint16_t color_0, const uint16_t color_1, float palette[4][3])
+    {
+        unpack_565(color_0, palette[0]);
+        unpack_565(color_1, palette[1]);
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            palette[2][i] = (2.0f * palette[0][i] + palette[1][i]) / 3.0f;
+            palette[3][i] = (palette[0][i] + 2.0f * palette[1][i]) / 3.0f;
+        }
+    }
+
+    // Picks the closest palette color for every texel, returns the squared error
+    inline float color_indices(const float colors[16][3], const float palette[4][3], uint8_t* indices)
+    {
+        float error = 0.0f;
+
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            float distance_min = numeric_limits<float>::max();
+            for (uint8_t p = 0; p < 4; p++)
+            {
+                const float r           = colors[t][0] - palette[p][0];
+                const float g           = colors[t][1] - palette[p][1];
+                const float b           = colors[t][2] - palette[p][2];
+                const float distance    = r * r + g * g + b * b;
+
+                if (distance < distance_min)
+                {
+                    distance_min    = distance;
+                    indices[t]      = p;
+                }
+            }
+
+            error += distance_min;
+        }
+
+        return error;
+    }
+
+    // Least squares fit of the endpoints which best reproduce the colors with the given indices
+    inline bool color_fit(const float colors[16][3], const uint8_t* indices, float* endpoint_0, float* endpoint_1)
+    {
+        static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+        float ax[3] = { 0.0f, 0.0f, 0.0f };
+        float bx[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            const float a = weights[indices[t]];
+            const float b = 1.0f - a;
+
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                ax[i] += a * colors[t][i];
+                bx[i] += b * colors[t][i];
+            }
+        }
+
+        // All the texels use the same endpoint, so the other one is unconstrained
+        const float determinant = aa * bb - ab * ab;
+        if (Helper::Abs(determinant) < Helper::M_EPSILON)
+            return false;
+
+        const float determinant_inverse = 1.0f / determinant;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            endpoint_0[i] = (ax[i] * bb - bx[i] * ab) * determinant_inverse;
+            endpoint_1[i] = (bx[i] * aa - ax[i] * ab) * determinant_inverse;
+        }
+
+        return true;
+    }
+
+    inline void write_color(const uint16_t color_0, const uint16_t color_1, const uint8_t* indices, uint8_t* block)
+    {
+        block[0] = static_cast<uint8_t>(color_0 & 0xFF);
+        block[1] = static_cast<uint8_t>(color_0 >> 8);
+        block[2] = static_cast<uint8_t>(color_1 & 0xFF);
+        block[3] = static_cast<uint8_t>(color_1 >> 8);
+
+        uint32_t bits = 0;
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            bits |= static_cast<uint32_t>(indices[t]) << (t * 2);
+        }
+        memcpy(block + 4, &bits, sizeof(uint32_t));
+    }
+
+    // BC1, which is also the color half of BC3
+    inline void encode_color(const uint8_t* texels, uint8_t* block)
+    {
+        float colors[16][3];
+        float mean[3]   = { 0.0f, 0.0f, 0.0f };
+        float min[3]    = { 255.0f, 255.0f, 255.0f };
+        float max[3]    = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                colors[t][i]    = static_cast<float>(texels[t * 4 + i]);
+                mean[i]         += colors[t][i] / 16.0f;
+                min[i]          = Helper::Min(min[i], colors[t][i]);
+                max[i]          = Helper::Max(max[i], colors[t][i]);
+            }
+        }
+
+        uint8_t indices[16] = { 0 };
+
+        // A single color, both endpoints are the same
+        if (min[0] == max[0] && min[1] == max[1] && min[2] == max[2])
+        {
+            const uint16_t color = pack_565(mean);
+            write_color(color, color, indices, block);
+            return;
+        }
+
+        // Covariance of the colors
+        float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            const float r = colors[t][0] - mean[0];
+            const float g = colors[t][1] - mean[1];
+            const float b = colors[t][2] - mean[2];
+
+            covariance[0] += r * r;
+            covariance[1] += r * g;
+            covariance[2] += r * b;
+            covariance[3] += g * g;
+            covariance[4] += g * b;
+            covariance[5] += b * b;
+        }
+
+        // Principal axis, with a few power iterations starting from the covariance of the channel which varies the most
+        // (the diagonal of the bounding box can be orthogonal to it, e.g. when one channel rises while another falls)
+        const float variance[3]     = { covariance[0], covariance[3], covariance[5] };
+        const uint32_t row[3][3]    = { { 0, 1, 2 }, { 1, 3, 4 }, { 2, 4, 5 } };
+        uint32_t channel            = 0;
+        for (uint32_t i = 1; i < 3; i++)
+        {
+            channel = variance[i] > variance[channel] ? i : channel;
+        }
+        float axis[3] = { covariance[row[channel][0]], covariance[row[channel][1]], covariance[row[channel][2]] };
+        for (uint32_t iteration = 0; iteration < 4; iteration++)
+        {
+            const float r = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+            const float g = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+            const float b = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+
+            const float scale = Helper::Max(Helper::Abs(r), Helper::Max(Helper::Abs(g), Helper::Abs(b)));
+            if (scale < Helper::M_EPSILON)
+                break;
+
+            axis[0] = r / scale;
+            axis[1] = g / scale;
+            axis[2] = b / scale;
+        }
+
+        const float length = Helper::Sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            axis[i] = length > Helper::M_EPSILON ? axis[i] / length : 0.57735f;
+        }
+
+        // The extents of the colors along the axis, inset a little since the end texels are rarely worth hitting exactly
+        float t_min = numeric_limits<float>::max();
+        float t_max = -numeric_limits<float>::max();
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            const float projection = (colors[t][0] - mean[0]) * axis[0] + (colors[t][1] - mean[1]) * axis[1] + (colors[t][2] - mean[2]) * axis[2];
+            t_min = Helper::Min(t_min, projection);
+            t_max = Helper::Max(t_max, projection);
+        }
+        const float inset = (t_max - t_min) / 16.0f;
+        t_min += inset;
+        t_max -= inset;
+
+        float endpoint_0[3];
+        float endpoint_1[3];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            endpoint_0[i] = mean[i] + axis[i] * t_max;
+            endpoint_1[i] = mean[i] + axis[i] * t_min;
+        }
+
+        uint16_t color_0 = pack_565(endpoint_0);
+        uint16_t color_1 = pack_565(endpoint_1);
+        float palette[4][3];
+        color_palette(color_0, color_1, palette);
+        float error = color_indices(colors, palette, indices);
+
+        // Refine the endpoints for the indices they produced, as long as that helps
+        for (uint32_t iteration = 0; iteration < 2; iteration++)
+        {
+            if (!color_fit(colors, indices, endpoint_0, endpoint_1))
+                break;
+
+            const uint16_t refined_0 = pack_565(endpoint_0);
+            const uint16_t refined_1 = pack_565(endpoint_1);
+            if (refined_0 == color_0 && refined_1 == color_1)
+                break;
+
+            uint8_t refined_indices[16];
+            color_palette(refined_0, refined_1, palette);
+            const float refined_error = color_indices(colors, palette, refined_indices);
+            if (refined_error >= error)
+                break;
+
+            color_0 = refined_0;
+            color_1 = refined_1;
+            error   = refined_error;
+            memcpy(indices, refined_indices, sizeof(indices));
+        }
+
+        // The four color mode requires the first endpoint to be the larger one
+        if (color_0 < color_1)
+        {
+            swap(color_0, color_1);
+            for (uint8_t& index : indices)
+            {
+                index ^= 1;
+            }
+        }
+        else if (color_0 == color_1)
+        {
+            memset(indices, 0, sizeof(indices));
+        }
+
+        write_color(color_0, color_1, indices, block);
+    }
+
+    inline void decode_color(const uint8_t* block, uint8_t* texels, const bool four_color_mode_only)
+    {
+        const uint16_t color_0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        const uint16_t color_1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+        float palette[4][3];
+        color_palette(color_0, color_1, palette);
+        if (color_0 <= color_1 && !four_color_mode_only)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                palette[2][i] = (palette[0][i] + palette[1][i]) / 2.0f;
+                palette[3][i] = 0.0f;
+            }
+        }
+
+        uint32_t bits;
+        memcpy(&bits, block + 4, sizeof(uint32_t));
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            const uint32_t index = (bits >> (t * 2)) & 3;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                texels[t * 4 + i] = static_cast<uint8_t>(palette[index][i] + 0.5f);
+            }
+        }
+    }
+
+    // The eight values of a single channel block, six interpolated ones plus 0 and 255 if the first endpoint isn't the larger one
+    inline void channel_palette(const uint8_t value_0, const uint8_t value_1, float palette[8])
+    {
+        palette[0] = static_cast<float>(value_0);
+        palette[1] = static_cast<float>(value_1);
+
+        if (value_0 > value_1)
+        {
+            for (uint32_t i = 2; i < 8; i++)
+            {
+                palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7.0f;
+            }
+        }
+        else
+        {
+            for (uint32_t i = 2; i < 6; i++)
+            {
+                palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1]) / 5.0f;
+            }
+            palette[6] = 0.0f;
+            palette[7] = 255.0f;
+        }
+    }
+
+    inline float channel_indices(const uint8_t* values, const float palette[8], uint8_t* indices)
+    {
+        float error = 0.0f;
+
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            float distance_min = numeric_limits<float>::max();
+            for (uint8_t p = 0; p < 8; p++)
+            {
+                const float distance = Helper::Abs(static_cast<float>(values[t]) - palette[p]);
+                if (distance < distance_min)
+                {
+                    distance_min    = distance;
+                    indices[t]      = p;
+                }
+            }
+
+            error += distance_min * distance_min;
+        }
+
+        return error;
+    }
+
+    // BC4, which is also the alpha half of BC3 and either half of BC5
+    inline void encode_channel(const uint8_t* texels, const uint32_t channel, uint8_t* block)
+    {
+        uint8_t values[16];
+        uint8_t min = 255;
+        uint8_t max = 0;
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            values[t]   = texels[t * 4 + channel];
+            min         = Helper::Min(min, values[t]);
+            max         = Helper::Max(max, values[t]);
+        }
+
+        uint8_t value_0         = max;
+        uint8_t value_1         = min;
+        uint8_t indices[16]     = { 0 };
+
+        if (min != max)
+        {
+            float palette[8];
+            channel_palette(value_0, value_1, palette);
+            const float error = channel_indices(values, palette, indices);
+
+            // Blocks which touch 0 or 255 can get these for free, leaving all six interpolated values to the rest
+            if (min == 0 || max == 255)
+            {
+                uint8_t inner_min = 255;
+                uint8_t inner_max = 0;
+                for (const uint8_t value : values)
+                {
+                    if (value != 0 && value != 255)
+                    {
+                        inner_min = Helper::Min(inner_min, value);
+                        inner_max = Helper::Max(inner_max, value);
+                    }
+                }
+                if (inner_min > inner_max)
+                {
+                    inner_min = inner_max = 0;
+                }
+
+                uint8_t inner_indices[16];
+                channel_palette(inner_min, inner_max, palette);
+                if (channel_indices(values, palette, inner_indices) < error)
+                {
+                    value_0 = inner_min;
+                    value_1 = inner_max;
+                    memcpy(indices, inner_indices, sizeof(indices));
+                }
+            }
+        }
+
+        block[0] = value_0;
+        block[1] = value_1;
+
+        uint64_t bits = 0;
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            bits |= static_cast<uint64_t>(indices[t]) << (t * 3);
+        }
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            block[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+    inline void decode_channel(const uint8_t* block, uint8_t* texels, const uint32_t channel)
+    {
+        float palette[8];
+        channel_palette(block[0], block[1], palette);
+
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            bits |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+        }
+
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            texels[t * 4 + channel] = static_cast<uint8_t>(palette[(bits >> (t * 3)) & 7] + 0.5f);
+        }
+    }
+
+    // The interpolation weights of BC7's 4 bit indices, out of 64
+    static const uint32_t rgba_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // BC7 blocks are bit streams, least significant bit first
+    inline void write_bits(uint8_t* block, uint32_t& position, const uint32_t value, const uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++, position++)
+        {
+            block[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (position & 7));
+        }
+    }
+
+    inline uint32_t read_bits(const uint8_t* block, uint32_t& position, const uint32_t count)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < count; i++, position++)
+        {
+            value |= static_cast<uint32_t>((block[position >> 3] >> (position & 7)) & 1) << i;
+        }
+
+        return value;
+    }
+
+    // Mode 6 endpoints are 7 bits per channel plus a p-bit, which all four channels share as their lowest bit
+    inline void rgba_quantize(const float* endpoint, uint8_t* quantized, uint8_t& p_bit)
+    {
+        float error_min = numeric_limits<float>::max();
+        for (uint8_t p = 0; p < 2; p++)
+        {
+            uint8_t candidate[4];
+            float error = 0.0f;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                candidate[i]            = static_cast<uint8_t>(Helper::Clamp((endpoint[i] - p) * 0.5f + 0.5f, 0.0f, 127.0f));
+                const float difference  = endpoint[i] - static_cast<float>((candidate[i] << 1) | p);
+                error                   += difference * difference;
+            }
+
+            if (error < error_min)
+            {
+                error_min = error;
+                p_bit     = p;
+                memcpy(quantized, candidate, sizeof(candidate));
+            }
+        }
+    }
+
+    // The sixteen colors of a block, computed exactly like the hardware does
+    inline void rgba_palette(const uint8_t* quantized_0, const uint8_t p_bit_0, const uint8_t* quantized_1, const uint8_t p_bit_1, float palette[16][4])
+    {
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            const uint32_t value_0 = (quantized_0[i] << 1) | p_bit_0;
+            const uint32_t value_1 = (quantized_1[i] << 1) | p_bit_1;
+
+            for (uint32_t p = 0; p < 16; p++)
+            {
+                palette[p][i] = static_cast<float>(((64 - rgba_weights[p]) * value_0 + rgba_weights[p] * value_1 + 32) >> 6);
+            }
+        }
+    }
+
+    inline float rgba_indices(const float colors[16][4], const float palette[16][4], uint8_t* indices)
+    {
+        float error = 0.0f;
+
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            float distance_min = numeric_limits<float>::max();
+            for (uint8_t p = 0; p < 16; p++)
+            {
+                const float r           = colors[t][0] - palette[p][0];
+                const float g           = colors[t][1] - palette[p][1];
+                const float b           = colors[t][2] - palette[p][2];
+                const float a           = colors[t][3] - palette[p][3];
+                const float distance    = r * r + g * g + b * b + a * a;
+
+                if (distance < distance_min)
+                {
+                    distance_min    = distance;
+                    indices[t]      = p;
+                }
+            }
+
+            error += distance_min;
+        }
+
+        return error;
+    }
+
+    // Least squares fit of the endpoints which best reproduce the colors with the given indices
+    inline bool rgba_fit(const float colors[16][4], const uint8_t* indices, float* endpoint_0, float* endpoint_1)
+    {
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+        float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            const float b = static_cast<float>(rgba_weights[indices[t]]) / 64.0f;
+            const float a = 1.0f - b;
+
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                ax[i] += a * colors[t][i];
+                bx[i] += b * colors[t][i];
+            }
+        }
+
+        const float determinant = aa * bb - ab * ab;
+        if (Helper::Abs(determinant) < Helper::M_EPSILON)
+            return false;
+
+        const float determinant_inverse = 1.0f / determinant;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            endpoint_0[i] = (ax[i] * bb - bx[i] * ab) * determinant_inverse;
+            endpoint_1[i] = (bx[i] * aa - ax[i] * ab) * determinant_inverse;
+        }
+
+        return true;
+    }
+
+    // BC7 mode 6, a single subset with RGBA endpoints and 16 levels between them. It's the one mode which
+    // covers both opaque and transparent color, the other modes mostly help blocks with several distinct colors.
+    inline void encode_rgba(const uint8_t* texels, uint8_t* block)
+    {
+        float colors[16][4];
+        float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                colors[t][i]    = static_cast<float>(texels[t * 4 + i]);
+                mean[i]         += colors[t][i] / 16.0f;
+            }
+        }
+
+        // Covariance of the colors, the upper half of a 4x4 matrix
+        float covariance[10] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            const float r = colors[t][0] - mean[0];
+            const float g = colors[t][1] - mean[1];
+            const float b = colors[t][2] - mean[2];
+            const float a = colors[t][3] - mean[3];
+
+            covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b; covariance[3] += r * a;
+            covariance[4] += g * g; covariance[5] += g * b; covariance[6] += g * a;
+            covariance[7] += b * b; covariance[8] += b * a;
+            covariance[9] += a * a;
+        }
+
+        // Principal axis, with a few power iterations starting from the covariance of the channel which varies the most
+        // (the diagonal of the bounding box can be orthogonal to it, e.g. when one channel rises while another falls)
+        const float variance[4]     = { covariance[0], covariance[4], covariance[7], covariance[9] };
+        const uint32_t row[4][4]    = { { 0, 1, 2, 3 }, { 1, 4, 5, 6 }, { 2, 5, 7, 8 }, { 3, 6, 8, 9 } };
+        uint32_t channel            = 0;
+        for (uint32_t i = 1; i < 4; i++)
+        {
+            channel = variance[i] > variance[channel] ? i : channel;
+        }
+        float axis[4] = { covariance[row[channel][0]], covariance[row[channel][1]], covariance[row[channel][2]], covariance[row[channel][3]] };
+        for (uint32_t iteration = 0; iteration < 4; iteration++)
+        {
+            const float r = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2] + axis[3] * covariance[3];
+            const float g = axis[0] * covariance[1] + axis[1] * covariance[4] + axis[2] * covariance[5] + axis[3] * covariance[6];
+            const float b = axis[0] * covariance[2] + axis[1] * covariance[5] + axis[2] * covariance[7] + axis[3] * covariance[8];
+            const float a = axis[0] * covariance[3] + axis[1] * covariance[6] + axis[2] * covariance[8] + axis[3] * covariance[9];
+
+            const float scale = Helper::Max(Helper::Max(Helper::Abs(r), Helper::Abs(g)), Helper::Max(Helper::Abs(b), Helper::Abs(a)));
+            if (scale < Helper::M_EPSILON)
+                break;
+
+            axis[0] = r / scale;
+            axis[1] = g / scale;
+            axis[2] = b / scale;
+            axis[3] = a / scale;
+        }
+
+        const float length = Helper::Sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            axis[i] = length > Helper::M_EPSILON ? axis[i] / length : 0.5f;
+        }
+
+        // The extents of the colors along the axis
+        float t_min = numeric_limits<float>::max();
+        float t_max = -numeric_limits<float>::max();
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            float projection = 0.0f;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                projection += (colors[t][i] - mean[i]) * axis[i];
+            }
+            t_min = Helper::Min(t_min, projection);
+            t_max = Helper::Max(t_max, projection);
+        }
+
+        float endpoint_0[4];
+        float endpoint_1[4];
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            endpoint_0[i] = mean[i] + axis[i] * t_min;
+            endpoint_1[i] = mean[i] + axis[i] * t_max;
+        }
+
+        uint8_t quantized_0[4], quantized_1[4];
+        uint8_t p_bit_0 = 0, p_bit_1 = 0;
+        rgba_quantize(endpoint_0, quantized_0, p_bit_0);
+        rgba_quantize(endpoint_1, quantized_1, p_bit_1);
+
+        float palette[16][4];
+        uint8_t indices[16] = { 0 };
+        rgba_palette(quantized_0, p_bit_0, quantized_1, p_bit_1, palette);
+        float error = rgba_indices(colors, palette, indices);
+
+        // Refine the endpoints for the indices they produced, as long as that helps
+        for (uint32_t iteration = 0; iteration < 2 && error > 0.0f; iteration++)
+        {
+            if (!rgba_fit(colors, indices, endpoint_0, endpoint_1))
+                break;
+
+            uint8_t refined_0[4], refined_1[4];
+            uint8_t refined_p_bit_0 = 0, refined_p_bit_1 = 0;
+            rgba_quantize(endpoint_0, refined_0, refined_p_bit_0);
+            rgba_quantize(endpoint_1, refined_1, refined_p_bit_1);
+
+            uint8_t refined_indices[16];
+            rgba_palette(refined_0, refined_p_bit_0, refined_1, refined_p_bit_1, palette);
+            const float refined_error = rgba_indices(colors, palette, refined_indices);
+            if (refined_error >= error)
+                break;
+
+            memcpy(quantized_0, refined_0, sizeof(refined_0));
+            memcpy(quantized_1, refined_1, sizeof(refined_1));
+            p_bit_0 = refined_p_bit_0;
+            p_bit_1 = refined_p_bit_1;
+            error   = refined_error;
+            memcpy(indices, refined_indices, sizeof(indices));
+        }
+
+        // The first texel's index drops its top bit, so it has to be in the lower half
+        if (indices[0] >= 8)
+        {
+            swap(quantized_0, quantized_1);
+            swap(p_bit_0, p_bit_1);
+            for (uint8_t& index : indices)
+            {
+                index = 15 - index;
+            }
+        }
+
+        memset(block, 0, 16);
+        uint32_t position = 0;
+        write_bits(block, position, 1 << 6, 7); // mode 6
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            write_bits(block, position, quantized_0[i], 7);
+            write_bits(block, position, quantized_1[i], 7);
+        }
+        write_bits(block, position, p_bit_0, 1);
+        write_bits(block, position, p_bit_1, 1);
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            write_bits(block, position, indices[t], t == 0 ? 3 : 4);
+        }
+    }
+
+    // Only mode 6 is decoded, it's the only mode the encoder writes
+    inline bool decode_rgba(const uint8_t* block, uint8_t* texels)
+    {
+        if ((block[0] & 0x7F) != (1 << 6))
+            return false;
+
+        uint32_t position = 7;
+        uint8_t quantized_0[4], quantized_1[4];
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            quantized_0[i] = static_cast<uint8_t>(read_bits(block, position, 7));
+            quantized_1[i] = static_cast<uint8_t>(read_bits(block, position, 7));
+        }
+        const uint8_t p_bit_0 = static_cast<uint8_t>(read_bits(block, position, 1));
+        const uint8_t p_bit_1 = static_cast<uint8_t>(read_bits(block, position, 1));
+
+        float palette[16][4];
+        rgba_palette(quantized_0, p_bit_0, quantized_1, p_bit_1, palette);
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            const uint32_t index = read_bits(block, position, t == 0 ? 3 : 4);
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                texels[t * 4 + i] = static_cast<uint8_t>(palette[index][i]);
+            }
+        }
+
+        return true;
+    }
+
+    // The channels which a format stores, the rest don't count towards the error
+    inline uint32_t stored_channel_count(const RHI_Format format)
+    {
+        switch (format)
+        {
+            case RHI_Format_BC1_Unorm:  return 3;
+            case RHI_Format_BC3_Unorm:  return 4;
+            case RHI_Format_BC4_Unorm:  return 1;
+            case RHI_Format_BC5_Unorm:  return 2;
+            case RHI_Format_BC7_Unorm:  return 4;
+            default:                    return 0;
+        }
+    }
+}
+
+namespace Spartan
+{
+    RHI_Format TextureCompressor::GetFormat(const RHI_Texture* texture)
+    {
+        // The top mip has to be made out of whole blocks, the smaller mips are padded
+        if (!texture || !texture->HasData() || texture->GetFormat() != RHI_Format_R8G8B8A8_Unorm || texture->GetWidth() % 4 != 0 || texture->GetHeight() % 4 != 0)
+            return RHI_Format_Undefined;
+
+        const uint16_t flags = texture->GetFlags();
+
+        if (flags & RHI_Texture_NormalMap)
+            return RHI_Format_BC5_Unorm;
+
+        if (flags & RHI_Texture_SingleChannel)
+            return RHI_Format_BC4_Unorm;
+
+        // Plenty of images have an alpha channel which is opaque everywhere, only keep it if it's actually used.
+        // Where it is, BC3 encodes it on its own, BC7's mode 6 ties it to the color and does poorly on cut-outs.
+        if (flags & RHI_Texture_Transparent)
+        {
+            const vector<std::byte>& texels = texture->GetData()[0];
+            for (size_t i = 3; i < texels.size(); i += 4)
+            {
+                if (texels[i] != std::byte{ 255 })
+                    return RHI_Format_BC3_Unorm;
+            }
+        }
+
+        // Same size as BC3, but all of it goes to the color (7 bit endpoints and 16 levels per block instead of 5:6:5 and 4)
+        return RHI_Format_BC7_Unorm;
+    }
+
+    bool TextureCompressor::Compress(RHI_Texture* texture, const RHI_Format format, Threading* threading /*= nullptr*/, float* psnr /*= nullptr*/)
+    {
+        const uint32_t block_size = RHI_Texture::GetBlockSize(format);
+        if (!texture || !texture->HasData() || texture->GetFormat() != RHI_Format_R8G8B8A8_Unorm || block_size == 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // The rows of blocks of all the mips are processed as a single range
+        struct Mip
+        {
+            uint32_t width;
+            uint32_t height;
+            uint32_t blocks_x;
+            uint32_t blocks_y;
+            uint32_t row_first;
+        };
+
+        const vector<vector<std::byte>>& texels = texture->GetData();
+        vector<Mip> mips;
+        vector<vector<std::byte>> blocks(texels.size());
+        uint32_t row_count = 0;
+        for (uint32_t mip_index = 0; mip_index < static_cast<uint32_t>(texels.size()); mip_index++)
+        {
+            Mip& mip        = mips.emplace_back();
+            mip.width       = Helper::Max(texture->GetWidth() >> mip_index, 1u);
+            mip.height      = Helper::Max(texture->GetHeight() >> mip_index, 1u);
+            mip.blocks_x    = (mip.width + 3) / 4;
+            mip.blocks_y    = (mip.height + 3) / 4;
+            mip.row_first   = row_count;
+            row_count       += mip.blocks_y;
+
+            if (texels[mip_index].size() != static_cast<size_t>(mip.width) * mip.height * 4)
+            {
+                LOG_ERROR("Mip %d is %dx%d but has %d bytes", mip_index, mip.width, mip.height, static_cast<uint32_t>(texels[mip_index].size()));
+                return false;
+            }
+
+            blocks[mip_index].resize(static_cast<size_t>(mip.blocks_x) * mip.blocks_y * block_size);
+        }
+
+        // Encodes a range of rows, the error of the top mip is measured against the decoded blocks
+        const auto encode_rows = [&](const uint32_t start, const uint32_t end, double& error)
+        {
+            uint8_t block_texels[64];
+            uint8_t block_decoded[64];
+
+            for (uint32_t row = start; row < end; row++)
+            {
+                uint32_t mip_index = 0;
+                while (row >= mips[mip_index].row_first + mips[mip_index].blocks_y)
+                {
+                    mip_index++;
+                }
+
+                const Mip& mip          = mips[mip_index];
+                const uint8_t* source   = reinterpret_cast<const uint8_t*>(texels[mip_index].data());
+                uint8_t* destination    = reinterpret_cast<uint8_t*>(blocks[mip_index].data()) + static_cast<size_t>(row - mip.row_first) * mip.blocks_x * block_size;
+                const uint32_t y_first  = (row - mip.row_first) * 4;
+
+                for (uint32_t block_x = 0; block_x < mip.blocks_x; block_x++)
+                {
+                    // Mips which are smaller than a block repeat their edge texels
+                    for (uint32_t y = 0; y < 4; y++)
+                    {
+                        const uint32_t source_y = Helper::Min(y_first + y, mip.height - 1);
+                        for (uint32_t x = 0; x < 4; x++)
+                        {
+                            const uint32_t source_x = Helper::Min(block_x * 4 + x, mip.width - 1);
+                            memcpy(&block_texels[(y * 4 + x) * 4], &source[(static_cast<size_t>(source_y) * mip.width + source_x) * 4], 4);
+                        }
+                    }
+
+                    uint8_t* block = destination + block_x * block_size;
+                    EncodeBlock(format, block_texels, block);
+
+                    if (psnr && mip_index == 0)
+                    {
+                        DecodeBlock(format, block, block_decoded);
+
+                        const uint32_t channel_count = block_compression::stored_channel_count(format);
+                        for (uint32_t t = 0; t < 16; t++)
+                        {
+                            for (uint32_t i = 0; i < channel_count; i++)
+                            {
+                                const double difference = static_cast<double>(block_texels[t * 4 + i]) - static_cast<double>(block_decoded[t * 4 + i]);
+                                error += difference * difference;
+                            }
+                        }
+                    }
+                }
+            }
+        };
+
+        double error = 0.0;
+        if (threading)
+        {
+            error = threading->ParallelReduce(row_count, 1, 0.0, encode_rows, [](double& result, const double local) { result += local; });
+        }
+        else
+        {
+            encode_rows(0, row_count, error);
+        }
+
+        if (psnr)
+        {
+            const double mse    = error / (static_cast<double>(mips[0].width) * mips[0].height * block_compression::stored_channel_count(format));
+            *psnr               = mse > 0.0 ? static_cast<float>(10.0 * log10(255.0 * 255.0 / mse)) : numeric_limits<float>::infinity();
+        }
+
+        // Replace the texels with the blocks
+        for (uint32_t mip_index = 0; mip_index < static_cast<uint32_t>(blocks.size()); mip_index++)
+        {
+            texture->GetData(mip_index)->swap(blocks[mip_index]);
+        }
+        texture->SetFormat(format);
+        texture->SetChannelCount(format == RHI_Format_BC4_Unorm ? 1 : (format == RHI_Format_BC5_Unorm ? 2 : 4));
+
+        return true;
+    }
+
+    void TextureCompressor::EncodeBlock(const RHI_Format format, const uint8_t* texels, uint8_t* block)
+    {
+        switch (format)
+        {
+            case RHI_Format_BC1_Unorm:
+                block_compression::encode_color(texels, block);
+                break;
+            case RHI_Format_BC3_Unorm:
+                block_compression::encode_channel(texels, 3, block);
+                block_compression::encode_color(texels, block + 8);
+                break;
+            case RHI_Format_BC4_Unorm:
+                block_compression::encode_channel(texels, 0, block);
+                break;
+            case RHI_Format_BC5_Unorm:
+                block_compression::encode_channel(texels, 0, block);
+                block_compression::encode_channel(texels, 1, block + 8);
+                break;
+            case RHI_Format_BC7_Unorm:
+                block_compression::encode_rgba(texels, block);
+                break;
+            default:
+                LOG_ERROR("Unsupported format %s", rhi_format_to_string(format));
+                break;
+        }
+    }
+
+    void TextureCompressor::DecodeBlock(const RHI_Format format, const uint8_t* block, uint8_t* texels)
+    {
+        for (uint32_t t = 0; t < 16; t++)
+        {
+            texels[t * 4 + 0] = 0;
+            texels[t * 4 + 1] = 0;
+            texels[t * 4 + 2] = 0;
+            texels[t * 4 + 3] = 255;
+        }
+
+        switch (format)
+        {
+            case RHI_Format_BC1_Unorm:
+                block_compression::decode_color(block, texels, false);
+                break;
+            case RHI_Format_BC3_Unorm:
+                block_compression::decode_channel(block, texels, 3);
+                block_compression::decode_color(block + 8, texels, true);
+                break;
+            case RHI_Format_BC4_Unorm:
+                block_compression::decode_channel(block, texels, 0);
+                break;
+            case RHI_Format_BC5_Unorm:
+                block_compression::decode_channel(block, texels, 0);
+                block_compression::decode_channel(block + 8, texels, 1);
+                break;
+            case RHI_Format_BC7_Unorm:
+                if (!block_compression::decode_rgba(block, texels))
+                {
+                    LOG_ERROR("Only BC7 mode 6 blocks can be decoded");
+                }
+                break;
+            default:
+                LOG_ERROR("Unsupported format %s", rhi_format_to_string(format));
+                break;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==============================
+#include <vector>
+#include "../../RHI/RHI_Definition.h"
+#include "../../Core/Spartan_Definitions.h"
+//=========================================
+
+namespace Spartan
+{
+    class Threading;
+
+    // A CPU encoder for the BC1, BC3, BC4, BC5 and BC7 (mode 6 only) block compressed formats. Every 4x4 block of texels is encoded on its own
+    // and the blocks of all the mips are spread across the job system. The endpoints of a block are fitted along the principal axis of
+    // its colors and then refined with a least squares pass, which gets most of the quality of an exhaustive search at a fraction of its cost.
+    class SPARTAN_CLASS TextureCompressor
+    {
+    public:
+        // Picks a format based on the usage flags and the contents of an 8 bit RGBA texture, RHI_Format_Undefined if it can't be compressed
+        static RHI_Format GetFormat(const RHI_Texture* texture);
+
+        // Replaces the mips of an 8 bit RGBA texture with blocks of the given format, optionally measuring the quality of the top mip (in dB)
+        static bool Compress(RHI_Texture* texture, RHI_Format format, Threading* threading = nullptr, float* psnr = nullptr);
+
+        // A block is 16 RGBA texels in row order, the channels which a format doesn't store decode to 0 (and alpha to 255)
+        static void EncodeBlock(RHI_Format format, const uint8_t* texels, uint8_t* block);
+        static void DecodeBlock(RHI_Format format, const uint8_t* block, uint8_t* texels);
+    };
+}
@@ -59,15 +59,17 @@ namespace Spartan
 		SetProjectDirectory("Project/");
 
 		// Subscribe to events
-		SUBSCRIBE_TO_EVENT(Event_World_Save,	EVENT_HANDLER(SaveResourcesToFiles));
-		SUBSCRIBE_TO_EVENT(Event_World_Load,	EVENT_HANDLER(LoadResourcesFromFiles));
-		SUBSCRIBE_TO_EVENT(Event_World_Unload,	EVENT_HANDLER(Clear));
+		m_event_world_save		= SUBSCRIBE_TO_EVENT(Event_World_Save,		EVENT_HANDLER(SaveResourcesToFiles));
+		m_event_world_load		= SUBSCRIBE_TO_EVENT(Event_World_Load,		EVENT_HANDLER(LoadResourcesFromFiles));
+		m_event_world_unload	= SUBSCRIBE_TO_EVENT(Event_World_Unload,	EVENT_HANDLER(Clear));
 	}
 
 	ResourceCache::~ResourceCache()
 	{
-		// Unsubscribe from event
-		UNSUBSCRIBE_FROM_EVENT(Event_World_Unload, EVENT_HANDLER(Clear));
+		// Unsubscribe from events
+		UNSUBSCRIBE_FROM_EVENT(m_event_world_save);
+		UNSUBSCRIBE_FROM_EVENT(m_event_world_load);
+		UNSUBSCRIBE_FROM_EVENT(m_event_world_unload);
 		Clear();
 	}
 
@@ -252,11 +254,28 @@ namespace Spartan
     {
         uint64_t size = 0;
 
-        for (const auto& resource : m_resource_groups[type])
+        // Streamed textures only count the mips which are currently resident
+        if (type == Resource_Unknown)
         {
-            if (Spartan_Object* object = dynamic_cast<Spartan_Object*>(resource.get()))
+            for (const auto& group : m_resource_groups)
             {
-                size += object->GetSizeGpu();
+                for (const auto& resource : group.second)
+                {
+                    if (Spartan_Object* object = dynamic_cast<Spartan_Object*>(resource.get()))
+                    {
+                        size += object->GetSizeGpu();
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (const auto& resource : m_resource_groups[type])
+            {
+                if (Spartan_Object* object = dynamic_cast<Spartan_Object*>(resource.get()))
+                {
+                    size += object->GetSizeGpu();
+                }
             }
         }
 
@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <unordered_map>
 #include "IResource.h"
 #include "../Core/ISubsystem.h"
+#include "../Core/EventSystem.h"
 //=============================
 
 namespace Spartan
@@ -210,5 +211,10 @@ namespace Spartan
 		std::shared_ptr<ModelImporter> m_importer_model;
 		std::shared_ptr<ImageImporter> m_importer_image;
 		std::shared_ptr<FontImporter> m_importer_font;
+
+		// Events
+		EventToken m_event_world_save;
+		EventToken m_event_world_load;
+		EventToken m_event_world_unload;
 	};
 }
@@ -30,16 +30,91 @@ using namespace std;
 
 namespace Spartan
 {
+    // Index into m_thread_data, threads which don't belong to the subsystem have an invalid index
+    static constexpr uint32_t thread_index_invalid = numeric_limits<uint32_t>::max();
+    static thread_local uint32_t thread_index       = thread_index_invalid;
+
+    static constexpr uint32_t task_block_size       = 256;  // tasks allocated at once when a pool runs dry
+    static constexpr uint32_t spin_count_max        = 64;   // failed attempts to find work before a worker goes to sleep
+
+    bool TaskQueue::Push(Task* task)
+    {
+        const int64_t bottom    = m_bottom.load(memory_order_relaxed);
+        const int64_t top       = m_top.load(memory_order_acquire);
+
+        if (bottom - top >= capacity)
+            return false;
+
+        m_tasks[bottom & mask].store(task, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        m_bottom.store(bottom + 1, memory_order_relaxed);
+
+        return true;
+    }
+
+    Task* TaskQueue::Pop()
+    {
+        const int64_t bottom = m_bottom.load(memory_order_relaxed) - 1;
+        m_bottom.store(bottom, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t top = m_top.load(memory_order_relaxed);
+
+        // Empty
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, memory_order_relaxed);
+            return nullptr;
+        }
+
+        Task* task = m_tasks[bottom & mask].load(memory_order_relaxed);
+
+        // Last task, race against thieves for it
+        if (top == bottom)
+        {
+            if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+            {
+                task = nullptr;
+            }
+            m_bottom.store(bottom + 1, memory_order_relaxed);
+        }
+
+        return task;
+    }
+
+    Task* TaskQueue::Steal()
+    {
+        int64_t top = m_top.load(memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(memory_order_acquire);
+
+        if (top >= bottom)
+            return nullptr;
+
+        Task* task = m_tasks[top & mask].load(memory_order_relaxed);
+
+        // Another thief or the owner got it first
+        if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+            return nullptr;
+
+        return task;
+    }
+
 	Threading::Threading(Context* context) : ISubsystem(context)
 	{
-		m_stopping	                            = false;
-        m_thread_count_support                  = thread::hardware_concurrency();
+        m_thread_count_support                  = Math::Helper::Max(thread::hardware_concurrency(), 1u);
 		m_thread_count                          = m_thread_count_support - 1; // exclude the main (this) thread
         m_thread_names[this_thread::get_id()]   = "main";
 
+        // Every thread, including this one, gets a queue and a task pool
+        for (uint32_t i = 0; i < m_thread_count + 1; i++)
+        {
+            m_thread_data.emplace_back(make_unique<ThreadData>());
+        }
+        thread_index = 0;
+
 		for (uint32_t i = 0; i < m_thread_count; i++)
 		{
-			m_threads.emplace_back(thread(&Threading::ThreadLoop, this));
+			m_threads.emplace_back(thread(&Threading::ThreadLoop, this, i + 1));
             m_thread_names[m_threads.back().get_id()] = "worker_" + to_string(i);
 		}
 
@@ -50,38 +125,80 @@ namespace Spartan
     {
         Flush(true);
 
-        // Put unique lock on task mutex.
-        unique_lock<mutex> lock(m_mutex_tasks);
-
-        // Set termination flag to true.
-        m_stopping = true;
-
-        // Unlock the mutex
-        lock.unlock();
+        // Set termination flag to true
+        {
+            lock_guard<mutex> lock(m_mutex_sleep);
+            m_stopping = true;
+        }
 
-        // Wake up all threads.
+        // Wake up all threads
         m_condition_var.notify_all();
 
-        // Join all threads.
+        // Join all threads
         for (auto& thread : m_threads)
         {
             thread.join();
         }
 
-        // Empty worker threads.
+        // Empty worker threads
         m_threads.clear();
+        thread_index = thread_index_invalid;
     }
 
-    uint32_t Threading::GetThreadsAvailable() const
+    void Threading::Run(const TaskHandle& handle)
     {
-        uint32_t available_threads = m_thread_count;
+        Task* task = handle.GetTask();
+        if (!task)
+            return;
+
+        m_tasks_active++;
+        m_tasks_queued++;
+
+        // Threads we own push to their own queue, anyone else goes through the (locked) foreign queue
+        if (thread_index != thread_index_invalid)
+        {
+            if (!m_thread_data[thread_index]->queue.Push(task))
+            {
+                // The queue is full, execute the task right here
+                m_tasks_queued--;
+                TaskExecute(task);
+                return;
+            }
+        }
+        else
+        {
+            lock_guard<mutex> lock(m_mutex_foreign);
+            m_tasks_foreign.push_back(task);
+            m_tasks_foreign_count++;
+        }
+
+        // Wake up a thread, but only take the lock if someone is actually sleeping
+        if (m_threads_sleeping.load() != 0)
+        {
+            lock_guard<mutex> lock(m_mutex_sleep);
+            m_condition_var.notify_one();
+        }
+    }
 
-        for (const auto& task : m_tasks)
+    void Threading::Wait(const TaskHandle& handle, bool help /*= true*/)
+    {
+        while (!handle.IsCompleted())
         {
-            available_threads -= task->IsExecuting() ? 1 : 0;
+            if (!help || !RunPending())
+            {
+                this_thread::yield();
+            }
         }
+    }
 
-        return available_threads;
+    bool Threading::RunPending()
+    {
+        Task* task = TaskAcquire();
+        if (!task)
+            return false;
+
+        TaskExecute(task);
+        return true;
     }
 
     void Threading::Flush(bool removed_queued /*= false*/)
@@ -89,42 +206,238 @@ namespace Spartan
         // Clear any queued tasks
         if (removed_queued)
         {
-            m_tasks.clear();
+            vector<Task*> tasks_discarded;
+
+            for (const auto& thread_data : m_thread_data)
+            {
+                while (!thread_data->queue.IsEmpty())
+                {
+                    if (Task* task = thread_data->queue.Steal())
+                    {
+                        tasks_discarded.emplace_back(task);
+                    }
+                }
+            }
+
+            {
+                lock_guard<mutex> lock(m_mutex_foreign);
+                tasks_discarded.insert(tasks_discarded.end(), m_tasks_foreign.begin(), m_tasks_foreign.end());
+                m_tasks_foreign.clear();
+                m_tasks_foreign_count = 0;
+            }
+
+            for (Task* task : tasks_discarded)
+            {
+                m_tasks_queued--;
+                task->Discard();
+                TaskFinish(task);
+            }
         }
 
-        // If so, wait for them
+        // Wait for the remaining tasks, helping out while there is work to take
         while (AreTasksRunning())
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            if (Task* task = TaskAcquire())
+            {
+                TaskExecute(task);
+            }
+            else
+            {
+                unique_lock<mutex> lock(m_mutex_sleep);
+                m_condition_var_idle.wait(lock, [this] { return !AreTasksRunning(); });
+            }
         }
     }
 
-    void Threading::ThreadLoop()
+    void Threading::ThreadLoop(uint32_t index)
     {
-        shared_ptr<Task> task;
+        thread_index = index;
+
+        uint32_t spin_count = 0;
         while (true)
         {
-            // Lock tasks mutex
-            unique_lock<mutex> lock(m_mutex_tasks);
+            if (Task* task = TaskAcquire())
+            {
+                TaskExecute(task);
+                spin_count = 0;
+                continue;
+            }
+
+            // Nothing to do, try a few more times before going to sleep
+            if (++spin_count < spin_count_max)
+            {
+                this_thread::yield();
+                continue;
+            }
+            spin_count = 0;
 
-            // Check condition on notification
-            m_condition_var.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+            unique_lock<mutex> lock(m_mutex_sleep);
+            m_threads_sleeping++;
+            m_condition_var.wait(lock, [this] { return m_tasks_queued.load() > 0 || m_stopping; });
+            m_threads_sleeping--;
 
             // If m_stopping is true, it's time to shut everything down
-            if (m_stopping && m_tasks.empty())
+            if (m_stopping)
                 return;
+        }
+    }
 
-            // Get next task in the queue.
-            task = m_tasks.front();
+    Task* Threading::TaskAcquire()
+    {
+        Task* task = nullptr;
 
-            // Remove it from the queue.
-            m_tasks.pop_front();
+        // Own queue first (most recent task, it's likely still in the cache)
+        if (thread_index != thread_index_invalid)
+        {
+            task = m_thread_data[thread_index]->queue.Pop();
+        }
+
+        // Tasks from foreign threads
+        if (!task && m_tasks_foreign_count.load() != 0)
+        {
+            lock_guard<mutex> lock(m_mutex_foreign);
+            if (!m_tasks_foreign.empty())
+            {
+                task = m_tasks_foreign.front();
+                m_tasks_foreign.pop_front();
+                m_tasks_foreign_count--;
+            }
+        }
+
+        // Steal from the other threads, starting with our neighbour so that thieves spread out
+        if (!task)
+        {
+            const uint32_t thread_data_count    = static_cast<uint32_t>(m_thread_data.size());
+            const uint32_t offset               = thread_index != thread_index_invalid ? thread_index + 1 : 0;
+            for (uint32_t i = 0; i < thread_data_count && !task; i++)
+            {
+                const uint32_t victim = (offset + i) % thread_data_count;
+                if (victim != thread_index)
+                {
+                    task = m_thread_data[victim]->queue.Steal();
+                }
+            }
+        }
+
+        if (task)
+        {
+            m_tasks_queued--;
+        }
+
+        return task;
+    }
+
+    void Threading::TaskExecute(Task* task)
+    {
+        m_tasks_executing++;
+        task->Execute();
+        m_tasks_executing--;
+
+        TaskFinish(task);
+    }
+
+    void Threading::TaskFinish(Task* task)
+    {
+        // Still waiting on children
+        if (task->m_unfinished.fetch_sub(1) != 1)
+            return;
+
+        Task* parent = task->m_parent;
+        TaskRelease(task);
+
+        if (parent)
+        {
+            TaskFinish(parent);
+        }
 
-            // Unlock the mutex
-            lock.unlock();
+        // Wake up anyone flushing once the last task is done
+        if (m_tasks_active.fetch_sub(1) == 1)
+        {
+            lock_guard<mutex> lock(m_mutex_sleep);
+            m_condition_var_idle.notify_all();
+        }
+    }
+
+    Task* Threading::TaskAllocate()
+    {
+        Task* task = nullptr;
 
-            // Execute the task.
-            task->Execute();
+        if (thread_index != thread_index_invalid)
+        {
+            ThreadData& thread_data = *m_thread_data[thread_index];
+
+            // Reclaim tasks which other threads have released
+            if (!thread_data.free_list)
+            {
+                thread_data.free_list = thread_data.free_list_remote.exchange(nullptr);
+            }
+
+            if (!thread_data.free_list)
+            {
+                thread_data.free_list = TaskAllocateBlock(thread_index);
+            }
+
+            task = thread_data.free_list;
+            thread_data.free_list = task->m_next_free;
+        }
+        else
+        {
+            lock_guard<mutex> lock(m_mutex_foreign);
+
+            if (!m_free_list_foreign)
+            {
+                m_free_list_foreign = TaskAllocateBlock(thread_index_invalid);
+            }
+
+            task = m_free_list_foreign;
+            m_free_list_foreign = task->m_next_free;
+        }
+
+        task->m_next_free = nullptr;
+        return task;
+    }
+
+    Task* Threading::TaskAllocateBlock(const uint32_t owner)
+    {
+        lock_guard<mutex> lock(m_mutex_task_blocks);
+
+        m_task_blocks.emplace_back(make_unique<Task[]>(task_block_size));
+        Task* block = m_task_blocks.back().get();
+
+        // Link them into a free list
+        for (uint32_t i = 0; i < task_block_size; i++)
+        {
+            block[i].m_owner        = owner;
+            block[i].m_next_free    = i + 1 < task_block_size ? &block[i + 1] : nullptr;
+        }
+
+        return block;
+    }
+
+    void Threading::TaskRelease(Task* task)
+    {
+        // Invalidates any outstanding handles
+        task->m_generation.fetch_add(1);
+
+        const uint32_t owner = task->m_owner;
+        if (owner == thread_index_invalid)
+        {
+            lock_guard<mutex> lock(m_mutex_foreign);
+            task->m_next_free   = m_free_list_foreign;
+            m_free_list_foreign = task;
+        }
+        else if (owner == thread_index)
+        {
+            ThreadData& thread_data = *m_thread_data[owner];
+            task->m_next_free       = thread_data.free_list;
+            thread_data.free_list   = task;
+        }
+        else
+        {
+            // Hand it back to the owning thread's pool (push only, so no ABA concerns)
+            atomic<Task*>& free_list_remote = m_thread_data[owner]->free_list_remote;
+            task->m_next_free = free_list_remote.load(memory_order_relaxed);
+            while (!free_list_remote.compare_exchange_weak(task->m_next_free, task, memory_order_release, memory_order_relaxed)) {}
         }
     }
 }
@@ -26,114 +26,307 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <thread>
 #include <mutex>
 #include <deque>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <new>
+#include <cstddef>
+#include <condition_variable>
 #include <unordered_map>
-#include <functional>
 #include "../Logging/Log.h"
 #include "../Core/ISubsystem.h"
+#include "../Math/MathHelper.h"
 //=============================
 
 namespace Spartan
 {
-	class Task
-	{
-	public:
-		typedef std::function<void()> function_type;
-
-		Task(function_type&& function)  { m_function = std::forward<function_type>(function); }
-        void Execute()                  { m_is_executing = true; m_function(); m_is_executing = false; }
-        bool IsExecuting() const { return m_is_executing; }
-
-	private:
-        bool m_is_executing = false;
-		function_type m_function;
-	};
-
-	class Threading : public ISubsystem
-	{
-	public:
-		Threading(Context* context);
-        ~Threading();
+    // A unit of work. Tasks are pooled and recycled by the Threading subsystem, they are never allocated by the caller.
+    class Task
+    {
+    public:
+        // Callables that fit in here are stored inline, larger ones fall back to the heap
+        static constexpr size_t storage_size = 64;
+
+        template <typename Function>
+        void Set(Function&& function, Task* parent)
+        {
+            using function_type = typename std::decay<Function>::type;
+
+            if constexpr (sizeof(function_type) <= storage_size && alignof(function_type) <= alignof(std::max_align_t))
+            {
+                new (m_storage) function_type(std::forward<Function>(function));
+                m_invoke    = [](void* storage) { (*static_cast<function_type*>(storage))(); };
+                m_destroy   = [](void* storage) { static_cast<function_type*>(storage)->~function_type(); };
+            }
+            else
+            {
+                *reinterpret_cast<function_type**>(m_storage) = new function_type(std::forward<Function>(function));
+                m_invoke    = [](void* storage) { (**static_cast<function_type**>(storage))(); };
+                m_destroy   = [](void* storage) { delete *static_cast<function_type**>(storage); };
+            }
+
+            m_parent = parent;
+            m_unfinished.store(1);
+        }
+
+        void Execute()
+        {
+            m_invoke(m_storage);
+            m_destroy(m_storage);
+        }
+
+        void Discard() { m_destroy(m_storage); }
+
+    private:
+        friend class Threading;
+        friend class TaskHandle;
+
+        alignas(std::max_align_t) unsigned char m_storage[storage_size];
+        void (*m_invoke)(void*)                 = nullptr;
+        void (*m_destroy)(void*)                = nullptr;
+        Task* m_parent                          = nullptr;
+        Task* m_next_free                       = nullptr;
+        uint32_t m_owner                        = 0; // the thread whose pool this task belongs to
+        std::atomic<uint32_t> m_unfinished      = 0; // this task plus any children which haven't completed
+        std::atomic<uint32_t> m_generation      = 0; // incremented every time the task is recycled
+    };
+
+    // A lightweight reference to a submitted task, remains valid (and reports completion) after the task is recycled
+    class TaskHandle
+    {
+    public:
+        TaskHandle() = default;
+        TaskHandle(Task* task) : m_task(task), m_generation(task ? task->m_generation.load() : 0) {}
+
+        bool IsValid()      const { return m_task != nullptr; }
+        bool IsCompleted()  const { return !m_task || m_task->m_generation.load() != m_generation || m_task->m_unfinished.load() == 0; }
+        Task* GetTask()     const { return m_task; }
 
-		// Add a task
-		template <typename Function>
-		void AddTask(Function&& function)
-		{
-			if (m_threads.empty())
-			{
-				LOG_WARNING("No available threads, function will execute in the same thread");
-				function();
-				return;
-			}
+    private:
+        Task* m_task            = nullptr;
+        uint32_t m_generation   = 0;
+    };
 
-			// Lock tasks mutex
-			std::unique_lock<std::mutex> lock(m_mutex_tasks);
+    // Chase-Lev work stealing deque. The owning thread pushes and pops at the bottom, any other thread steals from the top.
+    class TaskQueue
+    {
+    public:
+        static constexpr int64_t capacity = 4096;
 
-			// Save the task
-			m_tasks.push_back(std::make_shared<Task>(std::bind(std::forward<Function>(function))));
+        bool Push(Task* task);
+        Task* Pop();
+        Task* Steal();
+        bool IsEmpty() const { return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed); }
 
-			// Unlock the mutex
-			lock.unlock();
+    private:
+        static constexpr int64_t mask = capacity - 1;
+        static_assert((capacity & mask) == 0, "Capacity must be a power of two");
 
-			// Wake up a thread
-			m_condition_var.notify_one();
-		}
+        alignas(64) std::atomic<int64_t> m_top      = 0;
+        alignas(64) std::atomic<int64_t> m_bottom   = 0;
+        std::array<std::atomic<Task*>, capacity> m_tasks;
+    };
 
-        // Adds a task which is a loop and executes chunks of it in parallel
+    class SPARTAN_CLASS Threading : public ISubsystem
+    {
+    public:
+        Threading(Context* context);
+        ~Threading();
+
+        // Create a task without running it, optionally as a child of another task (the parent only completes once all of its children have)
         template <typename Function>
-        void AddTaskLoop(Function&& function, uint32_t range)
+        TaskHandle CreateTask(Function&& function, const TaskHandle& parent = TaskHandle())
         {
-            uint32_t available_threads  = GetThreadsAvailable();
-            vector<bool> tasks_done     = vector<bool>(available_threads, false);
-            const uint32_t task_count   = available_threads + 1; // plus one for the current thread
+            Task* task = TaskAllocate();
+            task->Set(std::forward<Function>(function), parent.GetTask());
 
-            uint32_t start  = 0;
-            uint32_t end    = 0;
-            for (uint32_t i = 0; i < available_threads; i++)
+            if (Task* task_parent = parent.GetTask())
             {
-                start   = (range / task_count) * i;
-                end     = start + (range / task_count);
+                task_parent->m_unfinished.fetch_add(1);
+            }
+
+            return TaskHandle(task);
+        }
 
-                // Kick off task
-                AddTask([&function, &tasks_done, i, start, end] { function(start, end); tasks_done[i] = true; });
+        // Queue a task created with CreateTask()
+        void Run(const TaskHandle& handle);
+
+        // Add a task, optionally as a child of another task
+        template <typename Function>
+        TaskHandle AddTask(Function&& function, const TaskHandle& parent = TaskHandle())
+        {
+            if (m_threads.empty())
+            {
+                LOG_WARNING("No available threads, function will execute in the same thread");
+                function();
+                return TaskHandle();
             }
 
-            // Do last task in the current thread
-            function(end, range);
+            const TaskHandle handle = CreateTask(std::forward<Function>(function), parent);
+            Run(handle);
+            return handle;
+        }
 
-            // Wait till the threads are done
-            uint32_t tasks = 0;
-            while (tasks != tasks_done.size())
+        // Executes function(start, end) over [0, range) on all threads. Chunks are handed out on demand and shrink as the range runs
+        // out, so threads which finish early take over the remaining work. A grain of 0 derives the chunk size from the measured cost.
+        // When the work is done, the calling thread executes other tasks until the rest of the threads are done (if help is true).
+        template <typename Function>
+        void ParallelFor(uint32_t range, uint32_t grain, Function&& function, bool help = true)
+        {
+            ParallelForChunks(range, grain, [&function](uint32_t start, uint32_t end, uint32_t) { function(start, end); }, help);
+        }
+
+        // Like ParallelFor(), but each participating thread accumulates into its own copy of identity via function(start, end, local).
+        // The copies are combined with reduce(result, local) on the calling thread once the whole range has been processed.
+        template <typename T, typename Function, typename Reduce>
+        T ParallelReduce(uint32_t range, uint32_t grain, const T& identity, Function&& function, Reduce&& reduce)
+        {
+            std::vector<T> locals(GetThreadCount() + 1, identity);
+            ParallelForChunks(range, grain, [&function, &locals](uint32_t start, uint32_t end, uint32_t participant) { function(start, end, locals[participant]); });
+
+            T result = identity;
+            for (const T& local : locals)
             {
-                tasks = 0;
-                for (const bool job_done : tasks_done)
-                {
-                    tasks += job_done ? 1 : 0;
-                }
+                reduce(result, local);
             }
+
+            return result;
         }
 
+        // Blocks until the task (and all of its children) have completed, executing other tasks in the meantime (if help is true).
+        // Don't help when waiting on a thread which other long running tasks depend on, as it could end up running one of them.
+        void Wait(const TaskHandle& handle, bool help = true);
+
+        // Executes one queued task on the calling thread, returns false if there was none
+        bool RunPending();
+
         // Get the number of threads used
         uint32_t GetThreadCount()           const { return m_thread_count; }
         // Get the maximum number of threads the hardware supports
         uint32_t GetThreadCountSupport()    const { return m_thread_count_support; }
         // Get the number of threads which are not doing any work
-        uint32_t GetThreadsAvailable()      const;
-        // Returns true if at least one task is running
-        bool AreTasksRunning()              const { return GetThreadsAvailable() != GetThreadCount(); }
-        // Waits for all executing (and queued if requested) tasks to finish
+        uint32_t GetThreadsAvailable()      const { return m_thread_count - Math::Helper::Min(m_thread_count, m_tasks_executing.load()); }
+        // Returns true if at least one task is running or queued
+        bool AreTasksRunning()              const { return m_tasks_active.load() != 0; }
+        // Waits for all executing (and queued if requested) tasks to finish. Must not be called from within a task.
         void Flush(bool removed_queued = false);
 
-	private:
+    private:
+        template <typename Function>
+        void ParallelForChunks(uint32_t range, uint32_t grain, Function&& function, bool help = true)
+        {
+            // Chunk durations which are long enough to hide the scheduling overhead but short enough to balance uneven work
+            static constexpr std::chrono::nanoseconds probe_duration = std::chrono::microseconds(20);
+            static constexpr std::chrono::nanoseconds chunk_duration = std::chrono::microseconds(100);
+
+            std::atomic<uint64_t> cursor = 0;
+
+            // Measure the cost by running exponentially larger chunks on this thread, small loops never leave it
+            if (grain == 0)
+            {
+                const auto time_start   = std::chrono::high_resolution_clock::now();
+                auto time_elapsed       = std::chrono::nanoseconds(0);
+                uint32_t probe_size     = 1;
+                uint32_t start          = 0;
+
+                while (start < range && time_elapsed < probe_duration)
+                {
+                    const uint32_t end = start + Math::Helper::Min(probe_size, range - start);
+                    function(start, end, 0);
+                    start           = end;
+                    probe_size      *= 2;
+                    time_elapsed    = std::chrono::high_resolution_clock::now() - time_start;
+                }
+
+                cursor  = start;
+                grain   = static_cast<uint32_t>(Math::Helper::Clamp<uint64_t>((start * chunk_duration.count()) / Math::Helper::Max<int64_t>(time_elapsed.count(), 1), 1, range));
+            }
+
+            const uint64_t remaining = range - cursor.load();
+            if (remaining == 0)
+                return;
+
+            // Only involve as many threads as there are chunks
+            const uint32_t participant_count = static_cast<uint32_t>(Math::Helper::Min<uint64_t>(GetThreadCount() + 1, (remaining + grain - 1) / grain));
+
+            const auto work = [&function, &cursor, range, grain, participant_count](uint32_t participant)
+            {
+                while (true)
+                {
+                    const uint64_t left     = range - Math::Helper::Min<uint64_t>(cursor.load(std::memory_order_relaxed), range);
+                    const uint64_t chunk    = Math::Helper::Max<uint64_t>(grain, left / (participant_count * 2));
+                    const uint64_t start    = cursor.fetch_add(chunk);
+
+                    if (start >= range)
+                        return;
+
+                    function(static_cast<uint32_t>(start), static_cast<uint32_t>(Math::Helper::Min<uint64_t>(start + chunk, range)), participant);
+                }
+            };
+
+            if (participant_count <= 1 || m_threads.empty())
+            {
+                work(0);
+                return;
+            }
+
+            // The parent does nothing by itself, it's only used to wait on the helpers
+            const TaskHandle parent = CreateTask([]() {});
+            for (uint32_t i = 1; i < participant_count; i++)
+            {
+                AddTask([&work, i]() { work(i); }, parent);
+            }
+            Run(parent);
+
+            // The calling thread participates too, then helps out with anything else until the helpers are done
+            work(0);
+            Wait(parent, help);
+        }
+
         // This function is invoked by the threads
-        void ThreadLoop();
+        void ThreadLoop(uint32_t thread_index);
+
+        Task* TaskAllocate();
+        Task* TaskAllocateBlock(uint32_t owner);
+        void TaskExecute(Task* task);
+        void TaskFinish(Task* task);
+        void TaskRelease(Task* task);
+        Task* TaskAcquire();
 
-		uint32_t m_thread_count         = 0;
+        struct ThreadData
+        {
+            TaskQueue queue;
+            Task* free_list = nullptr;                      // only touched by the owning thread
+            std::atomic<Task*> free_list_remote = nullptr;  // tasks released by other threads
+        };
+
+        uint32_t m_thread_count         = 0;
         uint32_t m_thread_count_support = 0;
-		std::vector<std::thread> m_threads;
-		std::deque<std::shared_ptr<Task>> m_tasks;
-		std::mutex m_mutex_tasks;
-		std::condition_variable m_condition_var;
+        std::vector<std::thread> m_threads;
+        std::vector<std::unique_ptr<ThreadData>> m_thread_data; // index 0 is the thread which created the subsystem (main)
         std::unordered_map<std::thread::id, std::string> m_thread_names;
-		bool m_stopping;
-	};
+
+        // Tasks submitted from threads we don't own, and their free list
+        std::deque<Task*> m_tasks_foreign;
+        std::atomic<uint32_t> m_tasks_foreign_count = 0;
+        Task* m_free_list_foreign = nullptr;
+        std::mutex m_mutex_foreign;
+
+        // Task pool
+        std::vector<std::unique_ptr<Task[]>> m_task_blocks;
+        std::mutex m_mutex_task_blocks;
+
+        // Sleeping
+        std::mutex m_mutex_sleep;
+        std::condition_variable m_condition_var;
+        std::condition_variable m_condition_var_idle;
+        std::atomic<int64_t> m_tasks_queued     = 0;
+        std::atomic<uint32_t> m_threads_sleeping = 0;
+
+        // Stats
+        std::atomic<uint32_t> m_tasks_active    = 0;
+        std::atomic<uint32_t> m_tasks_executing = 0;
+
+        std::atomic<bool> m_stopping = false;
+    };
 }
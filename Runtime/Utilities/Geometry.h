@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Vertex.h"
+#include "../Threading/Threading.h"
 //================================
 
 namespace Spartan::Utility::Geometry
@@ -287,4 +288,129 @@ namespace Spartan::Utility::Geometry
 	{
 		CreateCylinder(vertices, indices, 0.0f, radius, height);
 	}
+
+	// Averages the (area weighted) normals and tangents of the faces around each vertex, in linear time. The faces around each vertex
+	// are gathered into an adjacency list first, so every vertex is written by a single thread and the work can be split with no locks.
+	// Pass a threading subsystem to split it, leave it null when the caller is already a worker with plenty of company (or the mesh is small).
+	static void GenerateNormalsTangents(
+		const std::vector<uint32_t>& indices,
+		std::vector<RHI_Vertex_PosTexNorTan>& vertices,
+		bool normals		= true,
+		bool tangents		= true,
+		Threading* threading	= nullptr
+	)
+	{
+		using namespace Math;
+
+		const uint32_t face_count	= static_cast<uint32_t>(indices.size() / 3);
+		const uint32_t vertex_count	= static_cast<uint32_t>(vertices.size());
+		if (face_count == 0 || vertex_count == 0 || (!normals && !tangents))
+			return;
+
+		const auto parallel_for = [threading](const uint32_t range, const auto& function)
+		{
+			if (threading)
+			{
+				threading->ParallelFor(range, 0, function);
+			}
+			else
+			{
+				function(0, range);
+			}
+		};
+
+		// Face normals and tangents, unnormalized so that bigger faces weigh more
+		std::vector<Vector3> face_normals(face_count);
+		std::vector<Vector3> face_tangents(face_count);
+		parallel_for(face_count, [&indices, &vertices, &face_normals, &face_tangents](const uint32_t start, const uint32_t end)
+		{
+			for (uint32_t i = start; i < end; i++)
+			{
+				const RHI_Vertex_PosTexNorTan& v0 = vertices[indices[i * 3]];
+				const RHI_Vertex_PosTexNorTan& v1 = vertices[indices[i * 3 + 1]];
+				const RHI_Vertex_PosTexNorTan& v2 = vertices[indices[i * 3 + 2]];
+
+				const Vector3 edge_a = Vector3(v1.pos[0] - v0.pos[0], v1.pos[1] - v0.pos[1], v1.pos[2] - v0.pos[2]);
+				const Vector3 edge_b = Vector3(v2.pos[0] - v0.pos[0], v2.pos[1] - v0.pos[1], v2.pos[2] - v0.pos[2]);
+				face_normals[i] = Vector3::Cross(edge_a, edge_b);
+
+				const float du_a	= v1.tex[0] - v0.tex[0];
+				const float dv_a	= v1.tex[1] - v0.tex[1];
+				const float du_b	= v2.tex[0] - v0.tex[0];
+				const float dv_b	= v2.tex[1] - v0.tex[1];
+				const float det		= du_a * dv_b - du_b * dv_a;
+
+				// Faces without a texture mapping don't contribute a tangent
+				if (Helper::Abs(det) > Helper::M_EPSILON)
+				{
+					face_tangents[i] = (edge_a * dv_b - edge_b * dv_a) * (face_normals[i].Length() / det);
+				}
+			}
+		});
+
+		// Faces around each vertex (compressed, the faces of vertex i are face_ids[offsets[i]] to face_ids[offsets[i + 1]])
+		std::vector<uint32_t> offsets(vertex_count + 1, 0);
+		std::vector<uint32_t> face_ids(face_count * 3);
+		{
+			for (uint32_t i = 0; i < face_count * 3; i++)
+			{
+				offsets[indices[i] + 1]++;
+			}
+
+			for (uint32_t i = 0; i < vertex_count; i++)
+			{
+				offsets[i + 1] += offsets[i];
+			}
+
+			std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+			for (uint32_t i = 0; i < face_count * 3; i++)
+			{
+				face_ids[cursor[indices[i]]++] = i / 3;
+			}
+		}
+
+		// Vertex normals and tangents
+		parallel_for(vertex_count, [&vertices, &offsets, &face_ids, &face_normals, &face_tangents, normals, tangents](const uint32_t start, const uint32_t end)
+		{
+			for (uint32_t i = start; i < end; i++)
+			{
+				RHI_Vertex_PosTexNorTan& vertex = vertices[i];
+
+				Vector3 normal	= Vector3::Zero;
+				Vector3 tangent	= Vector3::Zero;
+				for (uint32_t k = offsets[i]; k < offsets[i + 1]; k++)
+				{
+					normal	+= face_normals[face_ids[k]];
+					tangent	+= face_tangents[face_ids[k]];
+				}
+
+				if (normals)
+				{
+					normal.Normalize();
+					vertex.nor[0] = normal.x;
+					vertex.nor[1] = normal.y;
+					vertex.nor[2] = normal.z;
+				}
+				else
+				{
+					normal = Vector3(vertex.nor[0], vertex.nor[1], vertex.nor[2]);
+				}
+
+				if (tangents)
+				{
+					// Orthogonalize, and when there is no tangent (no texture mapping) any direction on the surface will do
+					tangent = tangent - normal * Vector3::Dot(normal, tangent);
+					if (tangent.LengthSquared() <= Helper::M_EPSILON)
+					{
+						tangent = Vector3::Cross(normal, Helper::Abs(normal.y) < 0.99f ? Vector3::Up : Vector3::Right);
+					}
+					tangent.Normalize();
+
+					vertex.tan[0] = tangent.x;
+					vertex.tan[1] = tangent.y;
+					vertex.tan[2] = tangent.z;
+				}
+			}
+		});
+	}
 }
@@ -29,4 +29,16 @@ namespace Spartan::Utility::Hash
         std::hash<T> hasher;
         seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
+
+    // FNV-1a, for checksums
+    inline uint32_t fnv1a(const void* data, const uint64_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint32_t hash = 2166136261u;
+        for (uint64_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
 }
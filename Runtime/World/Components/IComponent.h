@@ -114,6 +114,11 @@ namespace Spartan
         // Entity
         Entity* GetEntity()	const { return m_entity; }
         std::string GetEntityName() const;
+
+        // Position in the World's array of components of the same type
+        static constexpr uint32_t pool_index_invalid = 0xFFFFFFFF;
+        uint32_t GetPoolIndex() const           { return m_pool_index; }
+        void SetPoolIndex(uint32_t pool_index)  { m_pool_index = pool_index; }
 		//========================================================================================
 
 	protected:
@@ -150,5 +155,7 @@ namespace Spartan
 	private:
 		// The attributes of the component
 		std::vector<Attribute> m_attributes;
+		// Not in the World's arrays until registered
+		uint32_t m_pool_index = pool_index_invalid;
 	};
 }
@@ -91,7 +91,8 @@ namespace Spartan
 			m_is_dirty = true;
 		}
 
-		// Camera dirty check (needed for directional light cascade computations)
+		// Camera dirty check (needed for directional light cascade computations), the cascades are snapped
+		// to their texels, so the renderer only re-renders them when they actually move (see Renderer::ShadowsPrepare)
 		if (m_light_type == Light_Directional)
 		{
 			if (auto& camera = m_renderer->GetCamera())
@@ -420,6 +421,19 @@ namespace Spartan
                 }
                 radius = Helper::Ceil(radius * 16.0f) / 16.0f;
 
+                // Snap the center to the texels of the shadow map (in light space), so that small camera movements don't
+                // move the cascade, this keeps the edges from shimmering and the cached static casters valid.
+                if (m_shadow_map.texture_depth)
+                {
+                    const float texel_size      = (radius * 2.0f) / static_cast<float>(m_shadow_map.texture_depth->GetWidth());
+                    const Matrix light_rotation = Matrix::CreateLookAtLH(Vector3::Zero, GetDirection(), Vector3::Up);
+                    Vector3 center              = shadow_slice.center * light_rotation;
+                    center.x                    = Helper::Floor(center.x / texel_size) * texel_size;
+                    center.y                    = Helper::Floor(center.y / texel_size) * texel_size;
+                    center.z                    = Helper::Floor(center.z / texel_size) * texel_size;
+                    shadow_slice.center         = center * Matrix::Invert(light_rotation);
+                }
+
                 // Compute min and max
                 shadow_slice.max = radius;
                 shadow_slice.min = -radius;
@@ -447,7 +461,8 @@ namespace Spartan
         // Early exit if this light casts no shadows
         if (!m_shadows_enabled)
         {
-            m_shadow_map.texture_depth = nullptr;
+            m_shadow_map.texture_depth          = nullptr;
+            m_shadow_map.texture_depth_static   = nullptr;
             return;
         }
 
@@ -458,7 +473,8 @@ namespace Spartan
 
 		if (GetLightType() == Light_Directional)
 		{
-            m_shadow_map.texture_depth = make_unique<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float, m_cascade_count);
+            m_shadow_map.texture_depth          = make_unique<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float, m_cascade_count);
+            m_shadow_map.texture_depth_static   = make_unique<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float, m_cascade_count);
 
             if (m_shadows_transparent_enabled)
             {
@@ -469,7 +485,8 @@ namespace Spartan
 		}
 		else if (GetLightType() == Light_Point)
 		{
-            m_shadow_map.texture_depth = make_unique<RHI_TextureCube>(m_context, resolution, resolution, RHI_Format_D32_Float);
+            m_shadow_map.texture_depth          = make_unique<RHI_TextureCube>(m_context, resolution, resolution, RHI_Format_D32_Float);
+            m_shadow_map.texture_depth_static   = make_unique<RHI_TextureCube>(m_context, resolution, resolution, RHI_Format_D32_Float);
 
             if (m_shadows_transparent_enabled)
             {
@@ -480,7 +497,8 @@ namespace Spartan
 		}
 		else if (GetLightType() == Light_Spot)
 		{
-            m_shadow_map.texture_depth  = make_unique<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float, 1);
+            m_shadow_map.texture_depth          = make_unique<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float, 1);
+            m_shadow_map.texture_depth_static   = make_unique<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float, 1);
 
             if (m_shadows_transparent_enabled)
             {
@@ -497,9 +515,9 @@ namespace Spartan
         const auto center       = box.GetCenter();
         const auto extents      = box.GetExtents();
 
-        // ensure that potential shadow casters from behind the near plane are not rejected
-        const bool ignore_near_plane = (m_light_type == Light_Directional) ? true : false; 
+        // ensure that potential shadow casters from behind the near plane (or past the far plane) are not rejected
+        const bool ignore_depth = (m_light_type == Light_Directional) ? true : false; 
 
-        return m_shadow_map.slices[index].frustum.IsVisible(center, extents, ignore_near_plane);
+        return m_shadow_map.slices[index].frustum.IsVisible(center, extents, ignore_depth);
     }
 }  
@@ -51,13 +51,20 @@ namespace Spartan
         Math::Vector3 max       = Math::Vector3::Zero;
         Math::Vector3 center    = Math::Vector3::Zero;
         Math::Frustum frustum;
+
+        // Static caster cache, maintained by the renderer
+        Math::Matrix view_projection_cached;    // what the cached depth was rendered with
+        bool cache_valid    = false;
+        bool dynamic_drawn  = false;            // the depth has dynamic casters on top of the cached ones
     };
 
     struct ShadowMap
     {
         std::shared_ptr<RHI_Texture> texture_color;
         std::shared_ptr<RHI_Texture> texture_depth;
+        std::shared_ptr<RHI_Texture> texture_depth_static; // depth of the casters which don't move, copied into texture_depth before the rest are drawn
         std::vector<ShadowSlice> slices;
+        uint32_t frames_skipped = 0; // distant point lights don't update every frame
     };
 
 	class SPARTAN_CLASS Light : public IComponent
@@ -118,6 +125,8 @@ namespace Spartan
 
 		RHI_Texture* GetDepthTexture() const { return m_shadow_map.texture_depth.get(); }
         RHI_Texture* GetColorTexture() const { return m_shadow_map.texture_color.get(); }
+        const ShadowMap& GetShadowMap() const { return m_shadow_map; }
+        ShadowMap& GetShadowMap() { return m_shadow_map; }
         uint32_t GetShadowArraySize() const;
         void CreateShadowMap();
 
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "Renderable.h"
 #include "Transform.h"
+#include "../World.h"
 #include "../../IO/FileStream.h"
 #include "../../Resource/ResourceCache.h"
 #include "../../Utilities/Geometry.h"
@@ -38,6 +39,11 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+	// Screen size (fraction of the screen height) under which the first coarser level kicks in, every following level halves it
+	static const float lod_screen_size	= 0.5f;
+	// How far past a threshold the screen size has to go before the level changes, so that it doesn't flip back and forth
+	static const float lod_hysteresis	= 0.1f;
+
 	inline void build(const Geometry_Type type, Renderable* renderable)
 	{	
 		auto model = make_shared<Model>(renderable->GetContext());
@@ -109,6 +115,8 @@ namespace Spartan
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryIndexCount,    uint32_t);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryVertexOffset,  uint32_t);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryVertexCount,   uint32_t);
+		REGISTER_ATTRIBUTE_VALUE_VALUE(m_lods,                  Lods);
+		REGISTER_ATTRIBUTE_VALUE_VALUE(m_lod_count,             uint32_t);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryName,          string);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_model,                 shared_ptr<Model>);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_bounding_box,          BoundingBox);
@@ -123,6 +131,12 @@ namespace Spartan
 		stream->Write(m_geometryIndexCount);
 		stream->Write(m_geometryVertexOffset);
 		stream->Write(m_geometryVertexCount);
+		stream->Write(m_lod_count);
+		for (uint32_t i = 1; i < m_lod_count; i++)
+		{
+			stream->Write(m_lods[i].index_offset);
+			stream->Write(m_lods[i].index_count);
+		}
 		stream->Write(m_bounding_box);
 		stream->Write(m_model ? m_model->GetResourceName() : "");
 
@@ -144,6 +158,14 @@ namespace Spartan
 		m_geometryIndexCount	= stream->ReadAs<uint32_t>();
 		m_geometryVertexOffset	= stream->ReadAs<uint32_t>();
 		m_geometryVertexCount	= stream->ReadAs<uint32_t>();
+		m_lods[0]				= { m_geometryIndexOffset, m_geometryIndexCount };
+		m_lod_count				= Helper::Clamp<uint32_t>(stream->ReadAs<uint32_t>(), 1, lod_count_max);
+		for (uint32_t i = 1; i < m_lod_count; i++)
+		{
+			m_lods[i].index_offset	= stream->ReadAs<uint32_t>();
+			m_lods[i].index_count	= stream->ReadAs<uint32_t>();
+		}
+		m_lod					= 0;
 		stream->Read(&m_bounding_box);
 		string model_name;
 		stream->Read(&model_name);
@@ -179,7 +201,14 @@ namespace Spartan
 		m_geometryVertexOffset	= vertex_offset;
 		m_geometryVertexCount	= vertex_count;
 		m_bounding_box			= bounding_box;
+		m_lods[0]				= { index_offset, index_count };
+		m_lod_count				= 1;
+		m_lod					= 0;
 		m_model					= model ? model->GetSharedPtr() : nullptr;
+		m_aabb_version			= 0;
+
+		// The bounds changed, so the renderer has to pick them up
+		m_context->GetSubsystem<World>()->EntityOnChange(m_entity);
 	}
 
 	void Renderable::GeometrySet(const Geometry_Type type)
@@ -208,13 +237,42 @@ namespace Spartan
 		m_model->GetGeometry(m_geometryIndexOffset, m_geometryIndexCount, m_geometryVertexOffset, m_geometryVertexCount, indices, vertices);
 	}
 
+	void Renderable::GeometryAddLod(const uint32_t index_offset, const uint32_t index_count)
+	{
+		if (m_lod_count >= lod_count_max || index_count == 0)
+		{
+			LOG_ERROR_INVALID_PARAMETER();
+			return;
+		}
+
+		m_lods[m_lod_count++] = { index_offset, index_count };
+	}
+
+	uint32_t Renderable::LodSelect(const float screen_size)
+	{
+		uint32_t lod = 0;
+		for (uint32_t i = 1; i < m_lod_count; i++)
+		{
+			// Going to a coarser level takes a smaller size than coming back from it
+			const float threshold = lod_screen_size / static_cast<float>(1 << (i - 1)) * (i > m_lod ? 1.0f - lod_hysteresis : 1.0f + lod_hysteresis);
+			if (screen_size >= threshold)
+				break;
+
+			lod = i;
+		}
+
+		m_lod = lod;
+		return m_lod;
+	}
+
     const BoundingBox& Renderable::GetAabb()
 	{
-        // Updated if dirty
-        if (m_last_transform != GetTransform()->GetMatrix())
+        // Updated if the transform changed, comparing versions is cheaper than comparing matrices
+        const uint32_t version = GetTransform()->GetVersion();
+        if (m_aabb_version != version)
         {
-            m_aabb = m_bounding_box.Transform(GetTransform()->GetMatrix());
-            m_last_transform = GetTransform()->GetMatrix();
+            m_aabb          = m_bounding_box.Transform(GetTransform()->GetMatrix());
+            m_aabb_version  = version;
         }
 
 		return m_aabb;
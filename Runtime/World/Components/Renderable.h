@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ======================
 #include "IComponent.h"
+#include <array>
 #include <vector>
 #include "../../Math/BoundingBox.h"
 #include "../../Math/Matrix.h"
@@ -49,9 +50,19 @@ namespace Spartan
 		Geometry_Default_Cone
 	};
 
+	// A level of detail, a range of the model's indices which draws from the same vertices as the full geometry
+	struct RenderableLod
+	{
+		uint32_t index_offset	= 0;
+		uint32_t index_count	= 0;
+	};
+
 	class SPARTAN_CLASS Renderable : public IComponent
 	{
 	public:
+		static constexpr uint32_t lod_count_max = 5; // including the full geometry
+		using Lods = std::array<RenderableLod, lod_count_max>;
+
 		Renderable(Context* context, Entity* entity, uint32_t id = 0);
 		~Renderable() = default;
 
@@ -84,6 +95,15 @@ namespace Spartan
         const Math::BoundingBox& GetAabb();
 		//=====================================================================================================
 
+		//= LOD ===============================================================================================
+		void GeometryAddLod(uint32_t index_offset, uint32_t index_count);
+		uint32_t GeometryLodCount()                     const { return m_lod_count; }
+		const RenderableLod& GeometryLod(uint32_t lod)  const { return m_lods[lod < m_lod_count ? lod : m_lod_count - 1]; }
+
+		// Picks a level of detail from the fraction of the screen height which the bounding sphere covers
+		uint32_t LodSelect(float screen_size);
+		//=====================================================================================================
+
 		//= MATERIAL ============================================================
 		// Sets a material from memory (adds it to the resource cache by default)
 		void SetMaterial(const std::shared_ptr<Material>& material);
@@ -114,7 +134,10 @@ namespace Spartan
 		Geometry_Type m_geometry_type;
 		Math::BoundingBox m_bounding_box;
 		Math::BoundingBox m_aabb;
-        Math::Matrix m_last_transform   = Math::Matrix::Identity;
+		Lods m_lods;                                // the first one is the full geometry
+		uint32_t m_lod_count            = 1;
+		uint32_t m_lod                  = 0;        // the last selected one, for hysteresis
+        uint32_t m_aabb_version         = 0; // the transform version m_aabb was computed with
         bool m_castShadows              = true;
         bool m_receiveShadows           = true;
 		bool m_material_default;
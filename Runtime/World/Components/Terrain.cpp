@@ -23,14 +23,21 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "Terrain.h"
 #include "Renderable.h"
+#include "Transform.h"
+#include "Camera.h"
 #include "..\Entity.h"
+#include "..\World.h"
 #include "..\..\RHI\RHI_Texture2D.h"
 #include "..\..\RHI\RHI_Vertex.h"
 #include "..\..\Rendering\Model.h"
+#include "..\..\Rendering\Renderer.h"
+#include "..\..\Rendering\Material.h"
 #include "..\..\IO\FileStream.h"
 #include "..\..\Resource\ResourceCache.h"
-#include "..\..\Rendering\Mesh.h"
+#include "..\..\RHI\RHI_IndexBuffer.h"
+#include "..\..\RHI\RHI_VertexBuffer.h"
 #include "..\..\Threading\Threading.h"
+#include "..\..\Utilities\Geometry.h"
 //=======================================
 
 //= NAMESPACES ===============
@@ -40,9 +47,29 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    static float distance_to_box(const Vector3& point, const BoundingBox& box)
+    {
+        const Vector3 closest = Vector3(
+            Helper::Clamp(point.x, box.GetMin().x, box.GetMax().x),
+            Helper::Clamp(point.y, box.GetMin().y, box.GetMax().y),
+            Helper::Clamp(point.z, box.GetMin().z, box.GetMax().z)
+        );
+
+        return Vector3::Distance(point, closest);
+    }
+
+    float Terrain::HeightField::GetHeight(const int64_t x, const int64_t y) const
+    {
+        // Outside of the height map, the edge continues
+        const int64_t x_clamped = Helper::Clamp<int64_t>(x, 0, static_cast<int64_t>(width) - 1);
+        const int64_t y_clamped = Helper::Clamp<int64_t>(y, 0, static_cast<int64_t>(height) - 1);
+
+        return heights[y_clamped * width + x_clamped];
+    }
+
     Terrain::Terrain(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
     {
-        
+        m_inbox = make_shared<NodeInbox>();
     }
 
     void Terrain::OnInitialize()
@@ -50,12 +77,74 @@ namespace Spartan
         
     }
 
+    void Terrain::OnRemove()
+    {
+        ClearNodes();
+    }
+
+    void Terrain::OnTick(float delta_time)
+    {
+        // Swap in a freshly generated quadtree
+        {
+            lock_guard<mutex> lock(m_generated_mutex);
+            if (m_generated_height_field)
+            {
+                ClearNodes();
+                m_height_field  = move(m_generated_height_field);
+                m_nodes         = move(m_generated_nodes);
+                m_generated_height_field.reset();
+                m_generated_nodes.clear();
+            }
+        }
+
+        ReceiveNodes();
+
+        if (m_nodes.empty())
+            return;
+
+        const shared_ptr<Camera>& camera = m_context->GetSubsystem<Renderer>()->GetCamera();
+        if (!camera)
+            return;
+
+        // Pick the nodes to draw, starting from the root
+        m_tick++;
+        m_nodes_selected.clear();
+        const Vector3 camera_position = camera->GetTransform()->GetPosition() * GetTransform()->GetMatrix().Inverted();
+        SelectNode(0, camera_position);
+
+        // Show them, and hide the ones which were drawn before but not anymore
+        for (const uint32_t index : m_nodes_drawn)
+        {
+            const Node& node = m_nodes[index];
+            if (node.tick_drawn != m_tick && node.entity)
+            {
+                node.entity->SetActive(false);
+            }
+        }
+
+        for (const uint32_t index : m_nodes_selected)
+        {
+            m_nodes[index].entity->SetActive(true);
+        }
+
+        m_nodes_drawn.swap(m_nodes_selected);
+
+        // Release the nodes which haven't been needed for a while, the root is always kept, it's the fallback for everything
+        for (uint32_t i = 1; i < static_cast<uint32_t>(m_nodes.size()); i++)
+        {
+            Node& node = m_nodes[i];
+            if (node.state == Node_Loaded && m_tick - node.tick_used > m_node_release_ticks)
+            {
+                ReleaseNode(node);
+            }
+        }
+    }
+
     void Terrain::Serialize(FileStream* stream)
     {
         const string no_path;
 
         stream->Write(m_height_map ? m_height_map->GetResourceFilePathNative() : no_path);
-        stream->Write(m_model ? m_model->GetResourceName() : no_path);
         stream->Write(m_min_y);
         stream->Write(m_max_y);
     }
@@ -64,11 +153,14 @@ namespace Spartan
     {
         ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
         m_height_map    = resource_cache->GetByPath<RHI_Texture2D>(stream->ReadAs<string>());
-        m_model         = resource_cache->GetByName<Model>(stream->ReadAs<string>());
         stream->Read(&m_min_y);
         stream->Read(&m_max_y);
 
-        UpdateFromModel(m_model);
+        // The nodes are not saved, they are generated again from the height map
+        if (m_height_map)
+        {
+            GenerateAsync();
+        }
     }
 
     void Terrain::SetHeightMap(const shared_ptr<RHI_Texture2D>& height_map)
@@ -88,21 +180,13 @@ namespace Spartan
         if (!m_height_map)
         {
             LOG_WARNING("You need to assign a height map before trying to generate a terrain.");
-
-            m_context->GetSubsystem<ResourceCache>()->Remove(m_model);
-            m_model.reset();
-            if (Renderable* renderable = m_entity->AddComponent<Renderable>())
-            {
-                renderable->GeometryClear();
-            }
-            
+            ClearNodes();
             return;
         }
 
+        m_is_generating = true;
         m_context->GetSubsystem<Threading>()->AddTask([this]()
         {
-            m_is_generating = true;
-
             // Get height map data
             const vector<std::byte> height_map_data = m_height_map->GetMipmap(0);
             if (height_map_data.empty())
@@ -111,37 +195,32 @@ namespace Spartan
             }
 
             // Deduce some stuff
-            m_height                            = m_height_map->GetHeight();
-            m_width                             = m_height_map->GetWidth();
-            m_vertex_count                      = m_height * m_width;
-            m_face_count                        = (m_height - 1) * (m_width - 1) * 2;
-            m_progress_jobs_done                = 0;
-            m_progress_job_count                = m_vertex_count * 2 + m_face_count + m_vertex_count * m_face_count;
-
-            // Pre-allocate memory for the calculations that follow
-            vector<Vector3> positions                 = vector<Vector3>(m_height * m_width);
-            vector<RHI_Vertex_PosTexNorTan> vertices  = vector<RHI_Vertex_PosTexNorTan>(m_vertex_count);
-            vector<uint32_t> indices                  = vector<uint32_t>(m_face_count * 3);
-
-            // Read height map and construct positions
-            m_progress_desc = "Generating positions...";
-            if (GeneratePositions(positions, height_map_data))
+            m_height                = m_height_map->GetHeight();
+            m_width                 = m_height_map->GetWidth();
+            m_progress_jobs_done    = 0;
+            m_progress_job_count    = m_height + 1;
+
+            // Read height map and construct the heights
+            m_progress_desc = "Generating heights...";
+            shared_ptr<HeightField> height_field = make_shared<HeightField>();
+            if (GenerateHeightField(*height_field, height_map_data))
             {
-                // Compute the vertices (without the normals) and the indices
-                m_progress_desc = "Generating terrain vertices and indices...";
-                if (GenerateVerticesIndices(positions, indices, vertices))
+                // Build the quadtree, the root covers the smallest power of two number of chunks which fits the height map
+                m_progress_desc = "Generating quadtree...";
+                uint32_t level_root = 0;
+                while ((chunk_quads << level_root) < Helper::Max(m_width, m_height) - 1)
                 {
-                    m_progress_desc = "Generating normals and tangents...";
-                    positions.clear();
-                    positions.shrink_to_fit();
-
-                    // Compute the normals by doing normal averaging (very expensive)
-                    if (GenerateNormalTangents(indices, vertices))
-                    {
-                        // Create a model and set it to the renderable component
-                        UpdateFromVertices(indices, vertices);
-                    }
+                    level_root++;
                 }
+
+                vector<Node> nodes;
+                BuildNode(nodes, *height_field, 0, 0, level_root);
+                m_progress_jobs_done++;
+
+                // Hand it over to the next tick
+                lock_guard<mutex> lock(m_generated_mutex);
+                m_generated_height_field    = height_field;
+                m_generated_nodes           = move(nodes);
             }
 
             // Clear progress stats
@@ -153,282 +232,382 @@ namespace Spartan
         });
     }
 
-    bool Terrain::GeneratePositions(vector<Vector3>& positions, const vector<std::byte>& height_map)
+    bool Terrain::GenerateHeightField(HeightField& height_field, const vector<std::byte>& height_map)
     {
-        if (height_map.empty())
+        if (height_map.empty() || m_width < 2 || m_height < 2)
         {
             LOG_ERROR("Height map is empty");
             return false;
         }
 
-        uint32_t index  = 0;
-        uint32_t k      = 0;
+        height_field.width  = m_width;
+        height_field.height = m_height;
+        height_field.heights.resize(static_cast<uint64_t>(m_width) * m_height);
 
+        uint32_t k = 0;
         for (uint32_t y = 0; y < m_height; y++)
         {
             for (uint32_t x = 0; x < m_width; x++)
             {
                 // Read height and scale it to a [0, 1] range
                 const float height = (static_cast<float>(height_map[k]) / 255.0f);
-
-                // Construct position
-                const uint32_t index  = y * m_width + x;
-                positions[index].x    = static_cast<float>(x) - m_width * 0.5f;     // center on the X axis
-                positions[index].z    = static_cast<float>(y) - m_height * 0.5f;    // center on the Z axis
-                positions[index].y    = Helper::Lerp(m_min_y, m_max_y, height);
+                height_field.heights[y * m_width + x] = Helper::Lerp(m_min_y, m_max_y, height);
 
                 k += 4;
-
-                // track progress
-                m_progress_jobs_done++;
             }
+
+            // track progress
+            m_progress_jobs_done++;
         }
 
         return true;
     }
 
-    bool Terrain::GenerateVerticesIndices(const vector<Vector3>& positions, vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    uint32_t Terrain::BuildNode(vector<Node>& nodes, const HeightField& height_field, const uint32_t x, const uint32_t y, const uint32_t level)
     {
-        if (positions.empty())
+        // Nothing of the height map is left in this corner
+        if (x >= height_field.width - 1 || y >= height_field.height - 1)
+            return node_invalid;
+
+        const uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes[index].x      = x;
+        nodes[index].y      = y;
+        nodes[index].level  = level;
+
+        // The leaves bound their texels, the rest bound their children
+        BoundingBox aabb;
+        if (level == 0)
         {
-            LOG_ERROR("Positions are empty");
-            return false;
-        }
+            const uint32_t x_end = Helper::Min(x + chunk_quads, height_field.width - 1);
+            const uint32_t y_end = Helper::Min(y + chunk_quads, height_field.height - 1);
 
-        uint32_t index      = 0;
-        uint32_t k          = 0;
-        uint32_t u_index    = 0;
-        uint32_t v_index    = 0;
+            float min_y = numeric_limits<float>::max();
+            float max_y = numeric_limits<float>::lowest();
+            for (uint32_t texel_y = y; texel_y <= y_end; texel_y++)
+            {
+                for (uint32_t texel_x = x; texel_x <= x_end; texel_x++)
+                {
+                    const float height  = height_field.heights[texel_y * height_field.width + texel_x];
+                    min_y               = Helper::Min(min_y, height);
+                    max_y               = Helper::Max(max_y, height);
+                }
+            }
 
-        for (uint32_t y = 0; y < m_height - 1; y++)
+            const float offset_x = height_field.width * 0.5f;
+            const float offset_z = height_field.height * 0.5f;
+            aabb = BoundingBox(
+                Vector3(static_cast<float>(x) - offset_x, min_y, static_cast<float>(y) - offset_z),
+                Vector3(static_cast<float>(x_end) - offset_x, max_y, static_cast<float>(y_end) - offset_z)
+            );
+        }
+        else
         {
-            for (uint32_t x = 0; x < m_width - 1; x++)
+            const uint32_t half = chunk_quads << (level - 1);
+            const uint32_t offsets[4][2] = { { 0, 0 }, { half, 0 }, { 0, half }, { half, half } };
+            for (uint32_t i = 0; i < 4; i++)
             {
-                const uint32_t index_bottom_left  = y * m_width + x;
-                const uint32_t index_bottom_right = y * m_width + x + 1;
-                const uint32_t index_top_left     = (y + 1) * m_width + x;
-                const uint32_t index_top_right    = (y + 1) * m_width + x + 1;
-
-                // Bottom right of quad
-                index           = index_bottom_right;
-                indices[k]      = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 1.0f));
-
-                // Bottom left of quad
-                index           = index_bottom_left;
-                indices[k + 1]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 1.0f));
-
-                // Top left of quad
-                index           = index_top_left;
-                indices[k + 2]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 0.0f));
-
-                // Bottom right of quad
-                index           = index_bottom_right;
-                indices[k + 3]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 1.0f));
-
-                // Top left of quad
-                index           = index_top_left;
-                indices[k + 4]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 0.0f));
-
-                // Top right of quad
-                index           = index_top_right;
-                indices[k + 5]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 0.0f));
-
-                k += 6; // next quad
-
-                u_index++;
-
-                // track progress
-                m_progress_jobs_done++;
+                const uint32_t child = BuildNode(nodes, height_field, x + offsets[i][0], y + offsets[i][1], level - 1);
+                nodes[index].children[i] = child;
+                if (child != node_invalid)
+                {
+                    aabb.Merge(nodes[child].aabb);
+                }
             }
-            u_index = 0;
-            v_index++;
         }
 
-        return true;
+        nodes[index].aabb = aabb;
+        return index;
     }
 
-    bool Terrain::GenerateNormalTangents(const vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    shared_ptr<Model> Terrain::GenerateNode(Context* context, const HeightField& height_field, const Node& node)
     {
-        if (indices.empty())
+        const int64_t stride    = static_cast<int64_t>(1) << node.level;
+        const int64_t last_x    = static_cast<int64_t>(height_field.width) - 1;
+        const int64_t last_y    = static_cast<int64_t>(height_field.height) - 1;
+        const float offset_x    = height_field.width * 0.5f;
+        const float offset_z    = height_field.height * 0.5f;
+
+        // Quads along each side, the last ones are narrower where the height map ends
+        const uint32_t quads_x = static_cast<uint32_t>(Helper::Min<int64_t>(chunk_quads, (last_x - node.x + stride - 1) / stride));
+        const uint32_t quads_y = static_cast<uint32_t>(Helper::Min<int64_t>(chunk_quads, (last_y - node.y + stride - 1) / stride));
+
+        // The texel of each row and column of the grid, along with a ring around it. The ring is only there so that the normals along
+        // the edges account for the triangles of the neighbours, beyond the height map it carries on (the height is clamped instead).
+        auto texel = [stride](const int64_t first, const int64_t last, const uint32_t quads, const uint32_t i)
         {
-            LOG_ERROR("Indices are empty");
-            return false;
-        }
+            if (i == 0)
+                return first - stride;
 
-        if (vertices.empty())
+            const int64_t inner = Helper::Min<int64_t>(first + (i - 1) * stride, last);
+            return i == quads + 2 ? Helper::Min<int64_t>(first + quads * stride, last) + stride : inner;
+        };
+
+        // Vertices and indices of the grid, with the ring
+        const uint32_t ring_x = quads_x + 3;
+        const uint32_t ring_y = quads_y + 3;
+        vector<RHI_Vertex_PosTexNorTan> vertices(ring_x * ring_y);
+        vector<uint32_t> indices;
         {
-            LOG_ERROR("Vertices are empty");
-            return false;
+            for (uint32_t j = 0; j < ring_y; j++)
+            {
+                const int64_t texel_y = texel(node.y, last_y, quads_y, j);
+                for (uint32_t i = 0; i < ring_x; i++)
+                {
+                    const int64_t texel_x = texel(node.x, last_x, quads_x, i);
+
+                    const Vector3 position = Vector3(static_cast<float>(texel_x) - offset_x, height_field.GetHeight(texel_x, texel_y), static_cast<float>(texel_y) - offset_z);
+                    vertices[j * ring_x + i] = RHI_Vertex_PosTexNorTan(position, Vector2(static_cast<float>(texel_x), static_cast<float>(texel_y)));
+                }
+            }
+
+            indices.reserve((ring_x - 1) * (ring_y - 1) * 6);
+            for (uint32_t j = 0; j < ring_y - 1; j++)
+            {
+                for (uint32_t i = 0; i < ring_x - 1; i++)
+                {
+                    const uint32_t bottom_left  = j * ring_x + i;
+                    const uint32_t bottom_right = bottom_left + 1;
+                    const uint32_t top_left     = bottom_left + ring_x;
+                    const uint32_t top_right    = top_left + 1;
+
+                    indices.insert(indices.end(), { bottom_right, bottom_left, top_left, bottom_right, top_left, top_right });
+                }
+            }
         }
 
-        // Normals are computed by normal averaging, which can be crazy slow
-        uint32_t face_count     = static_cast<uint32_t>(indices.size()) / 3;
-        uint32_t vertex_count   = static_cast<uint32_t>(vertices.size());
+        // The nodes are generated by several workers at once, so this one doesn't split the work any further
+        Utility::Geometry::GenerateNormalsTangents(indices, vertices);
 
-        // Compute face normals and tangents
-        vector<Vector3> face_normals(face_count);
-        vector<Vector3> face_tangents(face_count);
+        // Drop the ring
+        const uint32_t grid_x = quads_x + 1;
+        const uint32_t grid_y = quads_y + 1;
         {
-            for (uint32_t i = 0; i < face_count; ++i)
+            vector<RHI_Vertex_PosTexNorTan> grid(grid_x * grid_y);
+            for (uint32_t j = 0; j < grid_y; j++)
             {
-                Vector3 edge_a;
-                Vector3 edge_b;
-
-                // Normal
+                for (uint32_t i = 0; i < grid_x; i++)
                 {
-                    // Get the vector describing one edge of our triangle (edge 0, 1)
-                    edge_a = Vector3(
-                        vertices[indices[(i * 3)]].pos[0] - vertices[indices[(i * 3) + 1]].pos[0],
-                        vertices[indices[(i * 3)]].pos[1] - vertices[indices[(i * 3) + 1]].pos[1],
-                        vertices[indices[(i * 3)]].pos[2] - vertices[indices[(i * 3) + 1]].pos[2]
-                    );
-
-                    // Get the vector describing another edge of our triangle (edge 2,1)
-                    edge_b = Vector3(
-                        vertices[indices[(i * 3) + 1]].pos[0] - vertices[indices[(i * 3) + 2]].pos[0],
-                        vertices[indices[(i * 3) + 1]].pos[1] - vertices[indices[(i * 3) + 2]].pos[1],
-                        vertices[indices[(i * 3) + 1]].pos[2] - vertices[indices[(i * 3) + 2]].pos[2]
-                    );
-
-                    // Cross multiply the two edge vectors to get the unnormalized face normal
-                    face_normals[i] = Vector3::Cross(edge_a, edge_b);
+                    grid[j * grid_x + i] = vertices[(j + 1) * ring_x + i + 1];
                 }
+            }
+            vertices.swap(grid);
 
-                // Tangent
+            indices.clear();
+            for (uint32_t j = 0; j < quads_y; j++)
+            {
+                for (uint32_t i = 0; i < quads_x; i++)
                 {
-                    // find first texture coordinate edge 2d vector
-                    const float tcU1 = vertices[indices[(i * 3)]].tex[0] - vertices[indices[(i * 3) + 1]].tex[0];
-                    const float tcV1 = vertices[indices[(i * 3)]].tex[1] - vertices[indices[(i * 3) + 1]].tex[1];
-
-                    // find second texture coordinate edge 2d vector
-                    const float tcU2 = vertices[indices[(i * 3) + 1]].tex[0] - vertices[indices[(i * 3) + 2]].tex[0];
-                    const float tcV2 = vertices[indices[(i * 3) + 1]].tex[1] - vertices[indices[(i * 3) + 2]].tex[1];
-
-                    // find tangent using both tex coord edges and position edges
-                    face_tangents[i].x = (tcV1 * edge_a.x - tcV2 * edge_b.x * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
-                    face_tangents[i].y = (tcV1 * edge_a.y - tcV2 * edge_b.y * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
-                    face_tangents[i].z = (tcV1 * edge_a.z - tcV2 * edge_b.z * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
-                }
+                    const uint32_t bottom_left  = j * grid_x + i;
+                    const uint32_t bottom_right = bottom_left + 1;
+                    const uint32_t top_left     = bottom_left + grid_x;
+                    const uint32_t top_right    = top_left + 1;
 
-                // track progress
-                m_progress_jobs_done++;
+                    indices.insert(indices.end(), { bottom_right, bottom_left, top_left, bottom_right, top_left, top_right });
+                }
             }
         }
 
-        
-        // Compute vertex normals and tangents (normals averaging) - This is very expensive show we split it into multiple threads below
-        const auto compute_vertex_normals_tangents = [this, &face_normals , &face_tangents, &vertices, &indices, &vertex_count, &face_count](uint32_t i_start, uint32_t i_end)
+        // Skirts, they hang from the edges down to the lowest point of the node, which is as low as the edge of any neighbour can be
         {
-            Vector3 normal_sum  = Vector3::Zero;
-            Vector3 tangent_sum = Vector3::Zero;
-            float faces_using   = 0;
+            const float skirt_y = node.aabb.GetMin().y - static_cast<float>(stride);
 
-            for (uint32_t i = i_start; i < i_end; ++i)
+            auto add_skirt = [&vertices, &indices, skirt_y](const uint32_t first, const uint32_t step, const uint32_t count, const Vector3& outward)
             {
-                // Check which triangles use this vertex
-                for (uint32_t j = 0; j < face_count; ++j)
+                for (uint32_t k = 0; k + 1 < count; k++)
                 {
-                    if (indices[j * 3] == i || indices[(j * 3) + 1] == i || indices[(j * 3) + 2] == i)
+                    const uint32_t a = first + k * step;
+                    const uint32_t b = a + step;
+
+                    // The hanging vertices are copies, so they are lit like the edge
+                    const uint32_t a_skirt = static_cast<uint32_t>(vertices.size());
+                    const uint32_t b_skirt = a_skirt + 1;
+                    RHI_Vertex_PosTexNorTan vertex_a = vertices[a];
+                    RHI_Vertex_PosTexNorTan vertex_b = vertices[b];
+                    vertex_a.pos[1] = skirt_y;
+                    vertex_b.pos[1] = skirt_y;
+                    vertices.emplace_back(vertex_a);
+                    vertices.emplace_back(vertex_b);
+
+                    // Face outwards
+                    const Vector3 p_a = Vector3(vertices[a].pos[0], vertices[a].pos[1], vertices[a].pos[2]);
+                    const Vector3 p_b = Vector3(vertices[b].pos[0], vertices[b].pos[1], vertices[b].pos[2]);
+                    const Vector3 p_b_skirt = Vector3(vertex_b.pos[0], vertex_b.pos[1], vertex_b.pos[2]);
+                    if (Vector3::Dot(Vector3::Cross(p_b - p_a, p_b_skirt - p_a), outward) >= 0.0f)
                     {
-                        // If a face is using the vertex, accumulate the face normal/tangent
-                        normal_sum  += face_normals[j];
-                        tangent_sum += face_tangents[j];
-                        faces_using++;
+                        indices.insert(indices.end(), { a, b, b_skirt, a, b_skirt, a_skirt });
                     }
-
-                    // Track progress but only every time the inner loop (face_count) finished.
-                    // This is because different threads increment the progress tracker which is also an atomic so it locks and unlocks.
-                    if (j == face_count < 1)
+                    else
                     {
-                        m_progress_jobs_done += face_count;
+                        indices.insert(indices.end(), { a, b_skirt, b, a, a_skirt, b_skirt });
                     }
                 }
+            };
 
-                // Compute actual normal
-                normal_sum /= faces_using;
-                normal_sum.Normalize();
+            add_skirt(0,                            1,      grid_x, Vector3(0.0f, 0.0f, -1.0f));
+            add_skirt((grid_y - 1) * grid_x,        1,      grid_x, Vector3(0.0f, 0.0f, 1.0f));
+            add_skirt(0,                            grid_x, grid_y, Vector3(-1.0f, 0.0f, 0.0f));
+            add_skirt(grid_x - 1,                   grid_x, grid_y, Vector3(1.0f, 0.0f, 0.0f));
+        }
 
-                // Compute actual tangent
-                tangent_sum /= faces_using;
-                tangent_sum.Normalize();
+        auto model = make_shared<Model>(context);
+        model->AppendGeometry(indices, vertices);
+        model->UpdateGeometry();
 
-                // Write normal to vertex
-                vertices[i].nor[0] = normal_sum.x;
-                vertices[i].nor[1] = normal_sum.y;
-                vertices[i].nor[2] = normal_sum.z;
+        return model;
+    }
 
-                // Write tangent to vertex
-                vertices[i].tan[0] = tangent_sum.x;
-                vertices[i].tan[1] = tangent_sum.y;
-                vertices[i].tan[2] = tangent_sum.z;
+    void Terrain::SelectNode(const uint32_t index, const Vector3& camera_position)
+    {
+        Node& node      = m_nodes[index];
+        node.tick_used  = m_tick;
+
+        // Split when the camera is close enough, but only once all the children can be drawn, so there are no holes
+        const float size = static_cast<float>(chunk_quads << node.level);
+        if (node.level > 0 && distance_to_box(camera_position, node.aabb) < size * m_split_distance)
+        {
+            bool children_loaded = true;
+            for (const uint32_t child : node.children)
+            {
+                if (child == node_invalid)
+                    continue;
 
-                // Reset
-                normal_sum  = Vector3::Zero;
-                tangent_sum = Vector3::Zero;
-                faces_using = 0;
+                m_nodes[child].tick_used = m_tick;
+                if (m_nodes[child].state != Node_Loaded)
+                {
+                    RequestNode(child);
+                    children_loaded = false;
+                }
             }
-        };
 
-        m_context->GetSubsystem<Threading>()->AddTaskLoop(compute_vertex_normals_tangents, vertex_count);
+            if (children_loaded)
+            {
+                for (const uint32_t child : node.children)
+                {
+                    if (child != node_invalid)
+                    {
+                        SelectNode(child, camera_position);
+                    }
+                }
+
+                return;
+            }
+        }
 
-        return true;
+        // Draw this node, or wait for it
+        if (node.state == Node_Loaded)
+        {
+            node.tick_drawn = m_tick;
+            m_nodes_selected.emplace_back(index);
+        }
+        else
+        {
+            RequestNode(index);
+        }
     }
 
-    void Terrain::UpdateFromModel(const shared_ptr<Model>& model) const
+    void Terrain::RequestNode(const uint32_t index)
     {
-        if (!model)
-        {
-            LOG_ERROR_INVALID_PARAMETER();
+        Node& node = m_nodes[index];
+        if (node.state != Node_Unloaded || m_nodes_loading >= m_nodes_loading_max)
             return;
+
+        node.state = Node_Loading;
+        m_nodes_loading++;
+
+        // The worker only touches what it captures, so the component can go away while it runs
+        m_context->GetSubsystem<Threading>()->AddTask([context = m_context, height_field = m_height_field, inbox = m_inbox, generation = m_generation, node, index]()
+        {
+            shared_ptr<Model> model = GenerateNode(context, *height_field, node);
+
+            lock_guard<mutex> lock(inbox->mutex);
+            inbox->results.push_back({ generation, index, move(model) });
+        });
+    }
+
+    void Terrain::ReceiveNodes()
+    {
+        vector<NodeInbox::Result> results;
+        {
+            lock_guard<mutex> lock(m_inbox->mutex);
+            results.swap(m_inbox->results);
         }
 
-        if (Renderable* renderable = m_entity->AddComponent<Renderable>())
+        World* world = m_context->GetSubsystem<World>();
+        for (NodeInbox::Result& result : results)
         {
+            // Requested before the quadtree was generated again
+            if (result.generation != m_generation)
+                continue;
+
+            m_nodes_loading--;
+            Node& node = m_nodes[result.node];
+            if (!result.model)
+            {
+                node.state = Node_Unloaded;
+                continue;
+            }
+
+            node.state = Node_Loaded;
+            node.model = move(result.model);
+
+            // Every node gets an entity of its own, they are rebuilt from the height map so they are never saved
+            node.entity = world->EntityCreate(false);
+            node.entity->SetName(GetEntityName() + "_node_" + to_string(result.node));
+            node.entity->SetHierarchyVisibility(false);
+            node.entity->SetTransient(true);
+            node.entity->GetTransform()->SetParent(GetTransform());
+
+            Renderable* renderable = node.entity->AddComponent<Renderable>();
             renderable->GeometrySet(
                 "Terrain",
-                0,                                  // index offset
-                model->GetMesh()->Indices_Count(),  // index count
-                0,                                  // vertex offset
-                model->GetMesh()->Vertices_Count(), // vertex count
-                model->GetAabb(),
-                model.get()
+                0,
+                node.model->GetIndexBuffer()->GetIndexCount(),
+                0,
+                node.model->GetVertexBuffer()->GetVertexCount(),
+                node.model->GetAabb(),
+                node.model.get()
             );
 
-            renderable->UseDefaultMaterial();
+            // All the nodes share a material
+            if (!m_material)
+            {
+                renderable->UseDefaultMaterial();
+                m_material = m_context->GetSubsystem<ResourceCache>()->GetByName<Material>(renderable->GetMaterialName());
+            }
+            else
+            {
+                renderable->SetMaterial(m_material);
+            }
         }
     }
 
-    void Terrain::UpdateFromVertices(const vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    void Terrain::ReleaseNode(Node& node) const
     {
-        // Add vertices and indices into a model struct (and cache that)
-        if (!m_model)
+        if (node.entity)
         {
-            // Create new model
-            m_model = make_shared<Model>(m_context);
+            m_context->GetSubsystem<World>()->EntityRemove(node.entity);
+        }
 
-            // Set geometry
-            m_model->AppendGeometry(indices, vertices);
-            m_model->UpdateGeometry();
+        node.entity.reset();
+        node.model.reset();
+        node.state = Node_Unloaded;
+    }
 
-            // Set a file path so the model can be used by the resource cache
-            ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
-            m_model->SetResourceFilePath(resource_cache->GetProjectDirectory() + m_entity->GetName() + "_terrain_" + to_string(m_id) + string(EXTENSION_MODEL));
-            m_model = resource_cache->Cache(m_model);
-        }
-        else
+    void Terrain::ClearNodes()
+    {
+        for (Node& node : m_nodes)
         {
-            // Update with new geometry
-            m_model->Clear();
-            m_model->AppendGeometry(indices, vertices);
-            m_model->UpdateGeometry();
+            ReleaseNode(node);
         }
 
-        UpdateFromModel(m_model);
+        m_nodes.clear();
+        m_nodes_drawn.clear();
+        m_nodes_selected.clear();
+        m_nodes_loading = 0;
+        m_height_field.reset();
+
+        // Nodes which are still being generated are dropped when they arrive
+        m_generation++;
     }
 }
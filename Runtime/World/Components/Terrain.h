@@ -23,18 +23,26 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ========================
 #include "IComponent.h"
+#include <array>
 #include <atomic>
+#include <mutex>
+#include <vector>
+#include "../../Math/Vector3.h"
+#include "../../Math/BoundingBox.h"
 #include "../../RHI/RHI_Definition.h"
 //===================================
 
 namespace Spartan
 {
     class Model;
-    namespace Math
-    {
-        class Vector3;
-    }
+    class Material;
 
+    // The height map is split into a quadtree of chunks (nodes), each one is a grid of chunk_quads x chunk_quads quads.
+    // The leaves sample every texel, every level above samples every other texel of the level below. Each tick, nodes
+    // which are close to the camera are split into their children and the rest are drawn as they are, every drawn node
+    // is a (transient) child entity with a renderable, so it's culled on its own. The geometry of a node is generated
+    // on demand by a worker, until it's ready its parent is drawn instead, and it's released once it hasn't been needed
+    // for a while. Neighbouring nodes of different levels don't line up, skirts hanging down from the edges hide the cracks.
     class SPARTAN_CLASS Terrain : public IComponent
     {
     public:
@@ -43,6 +51,8 @@ namespace Spartan
 
         //= IComponent ===============================
         void OnInitialize() override;
+        void OnRemove() override;
+        void OnTick(float delta_time) override;
         void Serialize(FileStream* stream) override;
         void Deserialize(FileStream* stream) override;
         //============================================
@@ -62,24 +72,93 @@ namespace Spartan
         void GenerateAsync();
 
     private:
-        bool GeneratePositions(std::vector<Math::Vector3>& positions, const std::vector<std::byte>& height_map);
-        bool GenerateVerticesIndices(const std::vector<Math::Vector3>& positions, std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
-        bool GenerateNormalTangents(const std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
-        void UpdateFromModel(const std::shared_ptr<Model>& model) const;
-        void UpdateFromVertices(const std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
+        static constexpr uint32_t chunk_quads   = 64;
+        static constexpr uint32_t node_invalid  = 0xFFFFFFFF;
+
+        enum Node_State : uint8_t
+        {
+            Node_Unloaded,
+            Node_Loading,
+            Node_Loaded
+        };
+
+        struct Node
+        {
+            uint32_t x          = 0;    // first texel
+            uint32_t y          = 0;
+            uint32_t level      = 0;    // leaves are 0
+            std::array<uint32_t, 4> children = { node_invalid, node_invalid, node_invalid, node_invalid };
+            Math::BoundingBox aabb;     // in the terrain's space
+            Node_State state    = Node_Unloaded;
+            uint64_t tick_used  = 0;    // the last tick which drew it or waited for it
+            uint64_t tick_drawn = 0;
+            std::shared_ptr<Model> model;
+            std::shared_ptr<Entity> entity;
+        };
+
+        // The height of every texel, shared with the workers which generate the nodes
+        struct HeightField
+        {
+            uint32_t width  = 0;
+            uint32_t height = 0;
+            std::vector<float> heights;
+
+            float GetHeight(int64_t x, int64_t y) const;
+        };
+
+        // Where the workers leave the nodes they generated, it outlives the component
+        struct NodeInbox
+        {
+            struct Result
+            {
+                uint64_t generation;
+                uint32_t node;
+                std::shared_ptr<Model> model;
+            };
+
+            std::mutex mutex;
+            std::vector<Result> results;
+        };
+
+        // Generation
+        bool GenerateHeightField(HeightField& height_field, const std::vector<std::byte>& height_map);
+        static uint32_t BuildNode(std::vector<Node>& nodes, const HeightField& height_field, uint32_t x, uint32_t y, uint32_t level);
+        static std::shared_ptr<Model> GenerateNode(Context* context, const HeightField& height_field, const Node& node);
+
+        // Streaming
+        void SelectNode(uint32_t index, const Math::Vector3& camera_position);
+        void RequestNode(uint32_t index);
+        void ReceiveNodes();
+        void ReleaseNode(Node& node) const;
+        void ClearNodes();
 
         uint32_t m_width                            = 0;
         uint32_t m_height                           = 0;
         float m_min_y                               = 0.0f;
         float m_max_y                               = 30.0f;
-        float m_vertex_density                      = 1.0f;
-        bool m_is_generating                        = false;
-        uint64_t m_vertex_count                     = 0;
-        uint64_t m_face_count                       = 0;
+        std::atomic<bool> m_is_generating           = false;
         std::atomic<uint64_t> m_progress_jobs_done  = 0;
         uint64_t m_progress_job_count               = 1; // avoid devision by zero in GetProgress()
         std::string m_progress_desc;
         std::shared_ptr<RHI_Texture2D> m_height_map;
-        std::shared_ptr<Model> m_model;
+
+        // Quadtree, the root is the first node
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_nodes_drawn;
+        std::vector<uint32_t> m_nodes_selected;
+        std::shared_ptr<const HeightField> m_height_field;
+        std::shared_ptr<NodeInbox> m_inbox;
+        std::shared_ptr<Material> m_material;
+        uint64_t m_generation                       = 0;    // results of older generations are dropped
+        uint64_t m_tick                             = 0;
+        uint32_t m_nodes_loading                    = 0;
+        const uint32_t m_nodes_loading_max          = 8;
+        const uint64_t m_node_release_ticks         = 600;  // a node which wasn't needed for this many ticks is released
+        const float m_split_distance                = 2.0f; // a node is split when the camera is closer than this many times its size
+
+        // A freshly generated quadtree, swapped in by the next tick
+        std::mutex m_generated_mutex;
+        std::shared_ptr<const HeightField> m_generated_height_field;
+        std::vector<Node> m_generated_nodes;
     };
 }
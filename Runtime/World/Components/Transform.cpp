@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Transform.h"
 #include "../World.h"
 #include "../Entity.h"
+#include "../TransformHierarchy.h"
 #include "../../IO/FileStream.h"
 //==============================
 
@@ -36,22 +37,46 @@ namespace Spartan
 {
 	Transform::Transform(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id, this)
 	{
-		m_positionLocal		= Vector3::Zero;
-		m_rotationLocal		= Quaternion(0, 0, 0, 1);
-		m_scaleLocal		= Vector3::One;
-		m_matrix			= Matrix::Identity;
-		m_matrixLocal		= Matrix::Identity;
+		m_hierarchy			= context->GetSubsystem<World>()->GetTransformHierarchy();
+		m_index				= m_hierarchy->Allocate(this);
 		m_wvp_previous		= Matrix::Identity;
 		m_parent			= nullptr;
 
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_positionLocal,	Vector3);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_rotationLocal,	Quaternion);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_scaleLocal, Vector3);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_matrix, Matrix);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_matrixLocal, Matrix);
+		REGISTER_ATTRIBUTE_GET_SET(GetPositionLocal, SetPositionLocal, Vector3);
+		REGISTER_ATTRIBUTE_GET_SET(GetRotationLocal, SetRotationLocal, Quaternion);
+		REGISTER_ATTRIBUTE_GET_SET(GetScaleLocal, SetScaleLocal, Vector3);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_lookAt, Vector3);
 	}
 
+	Transform::~Transform()
+	{
+		// A parent always outlives its link to a child, see below
+		if (m_parent)
+		{
+			m_parent->RemoveChild(this);
+		}
+
+		// Children which outlive this transform become roots, so they don't point to a reused slot
+		for (Transform* child : m_children)
+		{
+			child->m_parent = nullptr;
+			m_hierarchy->SetParent(child->m_index, TransformHierarchy::index_invalid);
+			child->UpdateTransform();
+		}
+
+		m_hierarchy->Free(m_index);
+	}
+
+	Transform& Transform::operator=(const Transform& rhs)
+	{
+		SetPositionLocal(rhs.GetPositionLocal());
+		SetRotationLocal(rhs.GetRotationLocal());
+		SetScaleLocal(rhs.GetScaleLocal());
+		m_lookAt = rhs.m_lookAt;
+
+		return *this;
+	}
+
 	//= ICOMPONENT ==================================================================================
 	void Transform::OnInitialize()
 	{
@@ -60,19 +85,25 @@ namespace Spartan
 
 	void Transform::Serialize(FileStream* stream)
 	{
-		stream->Write(m_positionLocal);
-		stream->Write(m_rotationLocal);
-		stream->Write(m_scaleLocal);
+		stream->Write(GetPositionLocal());
+		stream->Write(GetRotationLocal());
+		stream->Write(GetScaleLocal());
 		stream->Write(m_lookAt);
 		stream->Write(m_parent ? m_parent->GetEntity()->GetId() : 0);
 	}
 
 	void Transform::Deserialize(FileStream* stream)
 	{
-		stream->Read(&m_positionLocal);
-		stream->Read(&m_rotationLocal);
-		stream->Read(&m_scaleLocal);
+		Vector3 position_local;
+		Quaternion rotation_local;
+		Vector3 scale_local;
+		stream->Read(&position_local);
+		stream->Read(&rotation_local);
+		stream->Read(&scale_local);
 		stream->Read(&m_lookAt);
+		m_hierarchy->SetPositionLocal(m_index, position_local);
+		m_hierarchy->SetRotationLocal(m_index, rotation_local);
+		m_hierarchy->SetScaleLocal(m_index, scale_local);
 		uint32_t parententity_id = 0;
 		stream->Read(&parententity_id);
 
@@ -89,26 +120,59 @@ namespace Spartan
 	//===============================================================================================
 	void Transform::UpdateTransform()
 	{
-		// Compute local transform
-		m_matrixLocal = Matrix(m_positionLocal, m_rotationLocal, m_scaleLocal);
+		m_hierarchy->SetDirty(m_index, Transform_Dirty_Local);
+		MakeDirty();
+	}
 
-		// Compute world transform
-		if (!HasParent())
-		{
-			m_matrix = m_matrixLocal;
-		}
-		else
-		{
-			m_matrix = m_matrixLocal * GetParentTransformMatrix();
-		}
-		
-		// Update children
-		for (const auto& child : m_children)
+	void Transform::MakeDirty()
+	{
+		// A dirty transform always has dirty descendants, so there is nothing left to do
+		if (m_hierarchy->IsDirty(m_index, Transform_Dirty_World))
+			return;
+
+		m_hierarchy->SetDirty(m_index, Transform_Dirty_World);
+
+		for (Transform* child : m_children)
 		{
-			child->UpdateTransform();
+			child->MakeDirty();
 		}
 	}
 
+	Matrix Transform::GetMatrix() const
+	{
+		return m_hierarchy->GetMatrix(m_index);
+	}
+
+	Matrix Transform::GetLocalMatrix() const
+	{
+		return m_hierarchy->GetMatrixLocal(m_index);
+	}
+
+	uint32_t Transform::GetVersion() const
+	{
+		return m_hierarchy->GetVersion(m_index);
+	}
+
+	Vector3 Transform::GetPositionLocal() const
+	{
+		return m_hierarchy->GetPositionLocal(m_index);
+	}
+
+	Quaternion Transform::GetRotation() const
+	{
+		return m_hierarchy->GetRotation(m_index);
+	}
+
+	Quaternion Transform::GetRotationLocal() const
+	{
+		return m_hierarchy->GetRotationLocal(m_index);
+	}
+
+	Vector3 Transform::GetScaleLocal() const
+	{
+		return m_hierarchy->GetScaleLocal(m_index);
+	}
+
 	//= TRANSLATION ==================================================================================
 	void Transform::SetPosition(const Vector3& position)
 	{
@@ -120,11 +184,10 @@ namespace Spartan
 
 	void Transform::SetPositionLocal(const Vector3& position)
 	{
-		if (m_positionLocal == position)
+		if (!m_hierarchy->SetPositionLocal(m_index, position))
 			return;
 
-		m_positionLocal = position;
-		UpdateTransform();
+		MakeDirty();
 	}
 	//================================================================================================
 
@@ -139,11 +202,10 @@ namespace Spartan
 
 	void Transform::SetRotationLocal(const Quaternion& rotation)
 	{
-		if (m_rotationLocal == rotation)
+		if (!m_hierarchy->SetRotationLocal(m_index, rotation))
 			return;
 
-		m_rotationLocal = rotation;
-		UpdateTransform();
+		MakeDirty();
 	}
 	//================================================================================================
 
@@ -158,17 +220,16 @@ namespace Spartan
 
 	void Transform::SetScaleLocal(const Vector3& scale)
 	{
-		if (m_scaleLocal == scale)
-			return;
-
-		m_scaleLocal = scale;
-
 		// A scale of 0 will cause a division by zero when decomposing the world transform matrix.
-		m_scaleLocal.x = (m_scaleLocal.x == 0.0f) ? Helper::M_EPSILON : m_scaleLocal.x;
-		m_scaleLocal.y = (m_scaleLocal.y == 0.0f) ? Helper::M_EPSILON : m_scaleLocal.y;
-		m_scaleLocal.z = (m_scaleLocal.z == 0.0f) ? Helper::M_EPSILON : m_scaleLocal.z;
+		Vector3 scale_local = scale;
+		scale_local.x = (scale_local.x == 0.0f) ? Helper::M_EPSILON : scale_local.x;
+		scale_local.y = (scale_local.y == 0.0f) ? Helper::M_EPSILON : scale_local.y;
+		scale_local.z = (scale_local.z == 0.0f) ? Helper::M_EPSILON : scale_local.z;
 
-		UpdateTransform();
+		if (!m_hierarchy->SetScaleLocal(m_index, scale_local))
+			return;
+
+		MakeDirty();
 	}
 	//================================================================================================
 
@@ -177,11 +238,11 @@ namespace Spartan
 	{
 		if (!HasParent())
 		{
-			SetPositionLocal(m_positionLocal + delta);
+			SetPositionLocal(GetPositionLocal() + delta);
 		}
 		else
 		{
-			SetPositionLocal(m_positionLocal + GetParent()->GetMatrix().Inverted() * delta);
+			SetPositionLocal(GetPositionLocal() + GetParent()->GetMatrix().Inverted() * delta);
 		}
 	}
 
@@ -189,11 +250,11 @@ namespace Spartan
 	{
 		if (!HasParent())
 		{
-			SetRotationLocal((m_rotationLocal * delta).Normalized());
+			SetRotationLocal((GetRotationLocal() * delta).Normalized());
 		}
 		else
 		{
-			SetRotationLocal(m_rotationLocal * GetRotation().Inverse() * delta * GetRotation());
+			SetRotationLocal(GetRotationLocal() * GetRotation().Inverse() * delta * GetRotation());
 		}	
 	}
 
@@ -258,10 +319,13 @@ namespace Spartan
 		if (new_parent->IsDescendantOf(this))
 		{
 			// if this transform already has a parent
+			// iterate over a copy as the children unlink themselves from this transform
+			const vector<Transform*> children = m_children;
+
 			if (this->HasParent())
 			{
 				// assign the parent of this transform to the children
-				for (const auto& child : m_children)
+				for (const auto& child : children)
 				{
 					child->SetParent(GetParent());
 				}
@@ -269,23 +333,21 @@ namespace Spartan
 			else // if this transform doesn't have a parent
 			{
 				// make the children orphans
-				for (const auto& child : m_children)
+				for (const auto& child : children)
 				{
 					child->BecomeOrphan();
 				}
 			}
 		}
 
-		// Switch parent but keep a pointer to the old one
-		auto parent_old = m_parent;
-		m_parent = new_parent;
-		if (parent_old) parent_old->AcquireChildren(); // update the old parent (so it removes this child)
-
-		// make the new parent "aware" of this transform/child
+		// Unlink from the old parent and link to the new one
 		if (m_parent)
 		{
-			m_parent->AcquireChildren();
+			m_parent->RemoveChild(this);
 		}
+		m_parent = new_parent;
+		m_parent->m_children.emplace_back(this);
+		m_hierarchy->SetParent(m_index, m_parent->m_index);
 
 		UpdateTransform();
 	}
@@ -331,53 +393,26 @@ namespace Spartan
 		return nullptr;
 	}
 
-	// Searches the entire hierarchy, finds any children and saves them in m_children.
-	// This is a recursive function, the children will also find their own children and so on...
-	void Transform::AcquireChildren()
+	void Transform::RemoveChild(Transform* child)
 	{
-		m_children.clear();
-		m_children.shrink_to_fit();
-
-		auto entities = GetContext()->GetSubsystem<World>()->EntityGetAll();
-		for (const auto& entity : entities)
+		// Erase (instead of swapping with the last) so the order of the siblings is preserved
+		const auto it = find(m_children.begin(), m_children.end(), child);
+		if (it != m_children.end())
 		{
-			if (!entity)
-				continue;
-
-			// get the possible child
-			auto possible_child = entity->GetTransform();
-
-			// if it doesn't have a parent, forget about it.
-			if (!possible_child->HasParent())
-				continue;
-
-			// if it's parent matches this transform
-			if (possible_child->GetParent()->GetId() == GetId())
-			{
-				// welcome home son
-				m_children.emplace_back(possible_child);
-
-				// make the child do the same thing all over, essentially resolving the entire hierarchy.
-				possible_child->AcquireChildren();
-			}
+			m_children.erase(it);
 		}
 	}
 
 	bool Transform::IsDescendantOf(const Transform* transform) const
 	{
-        for (const Transform* child : transform->GetChildren())
-        {
-            if (GetId() == child->GetId())
-                return true;
-
-            if (child->HasChildren())
-            {
-                if (IsDescendantOf(child))
-                    return true;
-            }
-        }
+		// Walk up the ancestors, this is proportional to the depth instead of the size of the subtree
+		for (const Transform* ancestor = m_parent; ancestor; ancestor = ancestor->m_parent)
+		{
+			if (ancestor == transform)
+				return true;
+		}
 
-        return false;
+		return false;
 	}
 
 	void Transform::GetDescendants(vector<Transform*>* descendants)
@@ -393,11 +428,6 @@ namespace Spartan
 		}
 	}
 
-    Matrix Transform::GetParentTransformMatrix() const
-	{
-		return HasParent() ? GetParent()->GetMatrix() : Matrix::Identity;
-	}
-
 	// Makes this transform have no parent
 	void Transform::BecomeOrphan()
 	{
@@ -410,16 +440,12 @@ namespace Spartan
 
 		// delete the original reference
 		m_parent = nullptr;
+		m_hierarchy->SetParent(m_index, TransformHierarchy::index_invalid);
 
 		// Update the transform without the parent now
 		UpdateTransform();
 
-		// make the parent search for children,
-		// that's indirect way of making the parent "forget"
-		// about this child, since it won't be able to find it
-		if (temp_ref)
-		{
-			temp_ref->AcquireChildren();
-		}
+		// make the parent forget about this child
+		temp_ref->RemoveChild(this);
 	}
 }
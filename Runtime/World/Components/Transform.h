@@ -33,12 +33,16 @@ namespace Spartan
 {
 	class RHI_Device;
 	class RHI_ConstantBuffer;
+	class TransformHierarchy;
 
 	class SPARTAN_CLASS Transform : public IComponent
 	{
 	public:
 		Transform(Context* context, Entity* entity, uint32_t id = 0);
-		~Transform() = default;
+		~Transform();
+
+		// Copies the local position, rotation and scale, each transform keeps its own slot in the hierarchy
+		Transform& operator=(const Transform& rhs);
 
 		//= ICOMPONENT ===============================
 		void OnInitialize() override;
@@ -46,25 +50,26 @@ namespace Spartan
 		void Deserialize(FileStream* stream) override;
 		//============================================
 
+		// Flags this transform and its descendants as dirty, they are resolved on demand or once per frame by the World
 		void UpdateTransform();
 
 		//= POSITION ==============================================================
-		auto GetPosition()              const { return m_matrix.GetTranslation(); }
-		const auto& GetPositionLocal()  const { return m_positionLocal; }
+		auto GetPosition()              const { return GetMatrix().GetTranslation(); }
+		Math::Vector3 GetPositionLocal() const;
 		void SetPosition(const Math::Vector3& position);
 		void SetPositionLocal(const Math::Vector3& position);
 		//=========================================================================
 
 		//= ROTATION ===========================================================
-		Math::Quaternion GetRotation() const { return m_matrix.GetRotation(); }
-		const auto& GetRotationLocal() const { return m_rotationLocal; }
+		Math::Quaternion GetRotation() const;
+		Math::Quaternion GetRotationLocal() const;
 		void SetRotation(const Math::Quaternion& rotation);
 		void SetRotationLocal(const Math::Quaternion& rotation);
 		//======================================================================
 
 		//= SCALE =======================================================
-		auto GetScale()             const { return m_matrix.GetScale(); }
-		const auto& GetScaleLocal() const { return m_scaleLocal; }
+		auto GetScale()             const { return GetMatrix().GetScale(); }
+		Math::Vector3 GetScaleLocal() const;
 		void SetScale(const Math::Vector3& scale);
 		void SetScaleLocal(const Math::Vector3& scale);
 		//===============================================================
@@ -97,27 +102,24 @@ namespace Spartan
 		Transform* GetChildByName(const std::string& name);
 		const std::vector<Transform*>& GetChildren() const	{ return m_children; }
 	
-		void AcquireChildren();
 		bool IsDescendantOf(const Transform* transform) const;
 		void GetDescendants(std::vector<Transform*>* descendants);
 		//======================================================================================
 
 		void LookAt(const Math::Vector3& v)                       { m_lookAt = v; }
-		const Math::Matrix& GetMatrix()                     const { return m_matrix; }     
-		const Math::Matrix& GetLocalMatrix()                const { return m_matrixLocal; }
+		Math::Matrix GetMatrix() const;
+		Math::Matrix GetLocalMatrix() const;
+		uint32_t GetVersion() const; // changes whenever the world matrix changes
         const Math::Matrix& GetWvpLastFrame()               const { return m_wvp_previous; }
         void SetWvpLastFrame(const Math::Matrix& matrix)          { m_wvp_previous = matrix;}
 
 	private:
-		Math::Matrix GetParentTransformMatrix() const;
-
-		// local
-		Math::Vector3 m_positionLocal;
-		Math::Quaternion m_rotationLocal;
-		Math::Vector3 m_scaleLocal;
+		void MakeDirty();
+		void RemoveChild(Transform* child); // only unlinks, the child keeps pointing to this transform
 
-		Math::Matrix m_matrix;
-		Math::Matrix m_matrixLocal;
+		// The position, rotation, scale and matrices live in the hierarchy, this is the slot
+		TransformHierarchy* m_hierarchy	= nullptr;
+		uint32_t m_index				= 0;
 		Math::Vector3 m_lookAt;
 
 		Transform* m_parent; // the parent of this transform
@@ -48,6 +48,7 @@ namespace Spartan
     Entity::Entity(Context* context, uint32_t transform_id /*= 0*/)
     {
         m_context               = context;
+        m_world                 = context->GetSubsystem<World>();
         m_name                  = "Entity";
         m_is_active             = true;
         m_hierarchy_visibility  = true;
@@ -66,12 +67,37 @@ namespace Spartan
 		for (auto it = m_components.begin(); it != m_components.end();)
 		{
 			(*it)->OnRemove();
+			ComponentUnregister((*it).get());
 			(*it).reset();
 			it = m_components.erase(it);
 		}
 		m_components.clear();
 	}
 
+    void Entity::SetActive(const bool active)
+    {
+        if (m_is_active == active)
+            return;
+
+        m_is_active = active;
+        m_world->EntityOnChange(this);
+    }
+
+    void Entity::SetName(const string& name)
+    {
+        if (m_name == name)
+            return;
+
+        const string name_previous = m_name;
+        m_name = name;
+        m_world->EntityOnRename(this, name_previous);
+    }
+
+    void Entity::OnIdChange(const uint32_t id_previous)
+    {
+        m_world->EntityOnIdChange(this, id_previous);
+    }
+
 	void Entity::Clone()
 	{
 		auto scene = m_context->GetSubsystem<World>();
@@ -109,6 +135,9 @@ namespace Spartan
 			// clone children make them call this lambda
 			for (const auto& child_transform : original->GetTransform()->GetChildren())
 			{
+				if (child_transform->GetEntity()->IsTransient())
+					continue;
+
 				const auto clone_child = clone_entity_and_descendants(child_transform->GetEntity());
 				clone_child->GetTransform()->SetParent(clone_self->GetTransform());
 			}
@@ -179,6 +208,7 @@ namespace Spartan
         // CHILDREN
         {
             auto children = GetTransform()->GetChildren();
+            children.erase(remove_if(children.begin(), children.end(), [](const Transform* child) { return child->GetEntity() && child->GetEntity()->IsTransient(); }), children.end());
 
             // Children count
             stream->Write(static_cast<uint32_t>(children.size()));
@@ -211,8 +241,8 @@ namespace Spartan
         {
             stream->Read(&m_is_active);
             stream->Read(&m_hierarchy_visibility);
-            stream->Read(&m_id);
-            stream->Read(&m_name);
+            SetId(stream->ReadAs<uint32_t>());
+            SetName(stream->ReadAs<string>());
         }
 
         // COMPONENTS
@@ -260,15 +290,11 @@ namespace Spartan
             }
 
             // Children
+            // Children link themselves to this transform via SetParent()
             for (const auto& child : children)
             {
                 child.lock()->Deserialize(stream, GetTransform());
             }
-
-            if (m_transform)
-            {
-                m_transform->AcquireChildren();
-            }
         }
 
 		// Make the scene resolve
@@ -313,6 +339,7 @@ namespace Spartan
 			{
                 component_type = component->GetType();
 				component->OnRemove();
+				ComponentUnregister(component.get());
 				it = m_components.erase(it);    
                 break;
 			}
@@ -338,4 +365,57 @@ namespace Spartan
 		// Make the scene resolve
 		FIRE_EVENT(Event_World_Resolve_Pending);
 	}
+
+    void Entity::ComponentsRegister()
+    {
+        for (const auto& component : m_components)
+        {
+            m_world->ComponentAdd(component.get());
+        }
+    }
+
+    void Entity::ComponentsUnregister()
+    {
+        for (const auto& component : m_components)
+        {
+            m_world->ComponentRemove(component.get());
+        }
+    }
+
+    void Entity::ComponentRegister(IComponent* component)
+    {
+        IComponent*& first = m_components_by_type[component->GetType()];
+        if (!first)
+        {
+            first = component;
+        }
+
+        m_world->ComponentAdd(component);
+    }
+
+    void Entity::ComponentUnregister(IComponent* component)
+    {
+        m_world->ComponentRemove(component);
+
+        // If it was the first of it's type, fall back to the next one (scripts can exist multiple times)
+        IComponent*& first = m_components_by_type[component->GetType()];
+        if (first == component)
+        {
+            first = nullptr;
+            for (const auto& other : m_components)
+            {
+                if (other.get() != component && other->GetType() == component->GetType())
+                {
+                    first = other.get();
+                    break;
+                }
+            }
+        }
+
+        // Don't leave the cached renderable dangling
+        if (component->GetType() == ComponentType_Renderable)
+        {
+            m_renderable = static_cast<Renderable*>(first);
+        }
+    }
 }
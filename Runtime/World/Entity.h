@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =====================
 #include <vector>
+#include <array>
 #include "../Core/EventSystem.h"
 #include "Components/IComponent.h"
 //================================
@@ -32,6 +33,7 @@ namespace Spartan
 	class Context;
 	class Transform;
 	class Renderable;
+	class World;
 	
 	class SPARTAN_CLASS Entity : public Spartan_Object, public std::enable_shared_from_this<Entity>
 	{
@@ -48,13 +50,17 @@ namespace Spartan
 
 		//= PROPERTIES ===================================================================================================
 		const std::string& GetName() const								{ return m_name; }
-		void SetName(const std::string& name)							{ m_name = name; }
+		void SetName(const std::string& name);
 
 		bool IsActive() const											{ return m_is_active; }
-		void SetActive(const bool active)								{ m_is_active = active; }
+		void SetActive(bool active);
 
 		bool IsVisibleInHierarchy() const								{ return m_hierarchy_visibility; }
 		void SetHierarchyVisibility(const bool hierarchy_visibility)	{ m_hierarchy_visibility = hierarchy_visibility; }
+
+		// Transient entities are managed by a component of their parent, which recreates them, so they are neither saved nor cloned
+		bool IsTransient() const										{ return m_is_transient; }
+		void SetTransient(const bool transient)							{ m_is_transient = transient; }
 		//================================================================================================================
 
 		// Adds a component of type T
@@ -80,6 +86,7 @@ namespace Spartan
 
             // Initialize component
             component->SetType(type);
+            ComponentRegister(component.get());
             component->OnInitialize();
 
 			// Make the scene resolve
@@ -95,18 +102,7 @@ namespace Spartan
 		template <class T>
         T* GetComponent()
 		{
-            const ComponentType type = IComponent::TypeToEnum<T>();
-
-            if (!HasComponent(type))
-                return nullptr;
-
-			for (const auto& component : m_components)
-			{
-				if (component->GetType() == type)
-					return static_cast<T*>(component.get());
-			}
-
-			return nullptr;
+            return static_cast<T*>(m_components_by_type[IComponent::TypeToEnum<T>()]);
 		}
 
 		// Returns any components of type T (if they exist)
@@ -149,6 +145,7 @@ namespace Spartan
 				if (component->GetType() == type)
 				{
 					component->OnRemove();
+					ComponentUnregister(component.get());
 					it = m_components.erase(it);
                     m_component_mask &= ~GetComponentMask(type);
 				}
@@ -173,18 +170,30 @@ namespace Spartan
 		Renderable* GetRenderable() const	    { return m_renderable; }
 		std::shared_ptr<Entity> GetPtrShared()  { return shared_from_this(); }
 
+        // Adds/removes all the components to/from the World's per type arrays (when the entity joins/leaves the World)
+        void ComponentsRegister();
+        void ComponentsUnregister();
+
 	private:
+        void OnIdChange(uint32_t id_previous) override; // keeps the World's lookups up to date
+        void ComponentRegister(IComponent* component);
+        void ComponentUnregister(IComponent* component);
+
         constexpr uint32_t GetComponentMask(ComponentType type) { return static_cast<uint32_t>(1) << static_cast<uint32_t>(type); }
 
 		std::string m_name			= "Entity";
 		bool m_is_active			= true;
 		bool m_hierarchy_visibility	= true;
+		bool m_is_transient			= false;
 		Transform* m_transform		= nullptr;
 		Renderable* m_renderable	= nullptr;
         bool m_destruction_pending  = false;
 		
+        World* m_world              = nullptr;
+
         // Components
         std::vector<std::shared_ptr<IComponent>> m_components;
+        std::array<IComponent*, ComponentType_Unknown> m_components_by_type = {}; // the first of each type, for constant time lookups
         uint32_t m_component_mask = 0;
 	};
 }
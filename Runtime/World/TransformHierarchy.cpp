@@ -0,0 +1,438 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ================
+#include "Spartan.h"
+#include "TransformHierarchy.h"
+#if defined(_M_X64) || defined(__SSE2__)
+#define TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+//===========================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    // result = local * parent, the matrices are column-major so each column of the result is a combination of the columns of local
+    static void multiply(const Matrix& local, const Matrix& parent, Matrix& result)
+    {
+#if defined(TRANSFORM_SSE)
+        const float* a  = local.Data();
+        const float* b  = parent.Data();
+        float* r        = &result.m00;
+
+        const __m128 a0 = _mm_loadu_ps(a + 0);
+        const __m128 a1 = _mm_loadu_ps(a + 4);
+        const __m128 a2 = _mm_loadu_ps(a + 8);
+        const __m128 a3 = _mm_loadu_ps(a + 12);
+
+        for (uint32_t column = 0; column < 4; column++)
+        {
+            const __m128 b_column = _mm_loadu_ps(b + column * 4);
+            __m128 r_column = _mm_mul_ps(a0, _mm_shuffle_ps(b_column, b_column, _MM_SHUFFLE(0, 0, 0, 0)));
+            r_column        = _mm_add_ps(r_column, _mm_mul_ps(a1, _mm_shuffle_ps(b_column, b_column, _MM_SHUFFLE(1, 1, 1, 1))));
+            r_column        = _mm_add_ps(r_column, _mm_mul_ps(a2, _mm_shuffle_ps(b_column, b_column, _MM_SHUFFLE(2, 2, 2, 2))));
+            r_column        = _mm_add_ps(r_column, _mm_mul_ps(a3, _mm_shuffle_ps(b_column, b_column, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm_storeu_ps(r + column * 4, r_column);
+        }
+#else
+        result = local * parent;
+#endif
+    }
+
+    uint32_t TransformHierarchy::Allocate(Transform* transform)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        uint32_t index = index_invalid;
+        if (!m_free.empty())
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            if ((m_index_end >> page_shift) >= page_count)
+            {
+                LOG_ERROR("Exceeded the maximum of %d transforms", page_count * page_size);
+                SPARTAN_ASSERT(false);
+                return index_invalid;
+            }
+
+            index = m_index_end++;
+
+            // Pages are never released, so existing entries don't move
+            if ((index >> page_shift) >= m_page_allocated_count)
+            {
+                m_pages[m_page_allocated_count++] = make_unique<Page>();
+            }
+        }
+
+        Page& page              = GetPage(index);
+        const uint32_t slot     = index & page_mask;
+        page.position_local[slot]   = Vector3::Zero;
+        page.rotation_local[slot]   = Quaternion::Identity;
+        page.scale_local[slot]      = Vector3::One;
+        page.matrix_local[slot]     = Matrix::Identity;
+        page.matrix[slot]           = Matrix::Identity;
+        page.rotation[slot]         = Quaternion::Identity;
+        page.parent[slot]           = index_invalid;
+        page.dirty[slot]            = Transform_Dirty_Local | Transform_Dirty_World;
+        page.version[slot]          = 0;
+        page.owner[slot]            = transform;
+
+        // A root can go anywhere in the order, so there is no need to sort again
+        m_order.emplace_back(index);
+
+        return index;
+    }
+
+    void TransformHierarchy::Free(const uint32_t index)
+    {
+        if (index == index_invalid)
+            return;
+
+        lock_guard<mutex> lock(m_mutex);
+
+        Page& page          = GetPage(index);
+        const uint32_t slot = index & page_mask;
+        page.parent[slot]   = index_invalid;
+        page.dirty[slot]    = Transform_Clean;
+        page.owner[slot]    = nullptr;
+
+        m_free.emplace_back(index);
+        m_order_dirty = true;
+    }
+
+    void TransformHierarchy::SetParent(const uint32_t index, const uint32_t index_parent)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        GetPage(index).parent[index & page_mask] = index_parent;
+        m_order_dirty = true;
+    }
+
+    uint32_t TransformHierarchy::GetParent(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return GetPage(index).parent[index & page_mask];
+    }
+
+    void TransformHierarchy::SetDirty(const uint32_t index, const uint8_t flags)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        GetPage(index).dirty[index & page_mask] |= flags;
+    }
+
+    bool TransformHierarchy::IsDirty(const uint32_t index, const uint8_t flags /*= Transform_Dirty_Local | Transform_Dirty_World*/)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return GetPage(index).dirty[index & page_mask] & flags;
+    }
+
+    void TransformHierarchy::Resolve(const uint32_t index)
+    {
+        Page& page = GetPage(index);
+        if (!(page.dirty[index & page_mask] & (Transform_Dirty_Local | Transform_Dirty_World)))
+            return;
+
+        // Descendants of a dirty entry are always dirty too, so the ancestors have to be resolved first
+        const uint32_t index_parent = page.parent[index & page_mask];
+        if (index_parent != index_invalid)
+        {
+            Resolve(index_parent);
+        }
+
+        Compute(index);
+    }
+
+    void TransformHierarchy::Update()
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        if (m_order_dirty)
+        {
+            SortByDepth();
+        }
+
+        // Gather the dirty entries, parents come before their children so the order resolves everything.
+        // This also picks up entries which were resolved on demand since the last update.
+        m_dirty.clear();
+        for (const uint32_t index : m_order)
+        {
+            uint8_t& dirty = GetPage(index).dirty[index & page_mask];
+            if (dirty == Transform_Clean)
+                continue;
+
+            if (dirty & (Transform_Dirty_Local | Transform_Dirty_World))
+            {
+                m_dirty.emplace_back(index);
+            }
+            else if (dirty & Transform_Moved)
+            {
+                if (!(dirty & Transform_Moved_Listed))
+                {
+                    m_moved.emplace_back(index);
+                }
+
+                dirty = Transform_Moved_Listed;
+            }
+        }
+
+        // Local matrices, they don't depend on anything
+        for (const uint32_t index : m_dirty)
+        {
+            Page& page          = GetPage(index);
+            const uint32_t slot = index & page_mask;
+            if (page.dirty[slot] & Transform_Dirty_Local)
+            {
+                page.matrix_local[slot] = Matrix(page.position_local[slot], page.rotation_local[slot], page.scale_local[slot]);
+            }
+        }
+
+        // World matrices, in order (a parent is final by the time its children get to it)
+        for (const uint32_t index : m_dirty)
+        {
+            Page& page                  = GetPage(index);
+            const uint32_t slot         = index & page_mask;
+            const uint32_t index_parent = page.parent[slot];
+
+            if (index_parent == index_invalid)
+            {
+                page.matrix[slot]   = page.matrix_local[slot];
+                page.rotation[slot] = page.rotation_local[slot];
+            }
+            else
+            {
+                // The world rotation is composed instead of decomposed from the matrix, which avoids the divisions
+                const Page& page_parent     = GetPage(index_parent);
+                const uint32_t slot_parent  = index_parent & page_mask;
+                multiply(page.matrix_local[slot], page_parent.matrix[slot_parent], page.matrix[slot]);
+                page.rotation[slot]         = page_parent.rotation[slot_parent] * page.rotation_local[slot];
+            }
+
+            page.version[slot]++;
+
+            if (!(page.dirty[slot] & Transform_Moved_Listed))
+            {
+                m_moved.emplace_back(index);
+            }
+            page.dirty[slot] = Transform_Moved_Listed;
+        }
+    }
+
+    void TransformHierarchy::ConsumeMoved(vector<uint32_t>& moved)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        moved.clear();
+        moved.swap(m_moved);
+
+        for (const uint32_t index : moved)
+        {
+            GetPage(index).dirty[index & page_mask] &= ~Transform_Moved_Listed;
+        }
+    }
+
+    Transform* TransformHierarchy::GetOwner(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return GetPage(index).owner[index & page_mask];
+    }
+
+    Vector3 TransformHierarchy::GetPositionLocal(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return GetPage(index).position_local[index & page_mask];
+    }
+
+    Quaternion TransformHierarchy::GetRotationLocal(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return GetPage(index).rotation_local[index & page_mask];
+    }
+
+    Vector3 TransformHierarchy::GetScaleLocal(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return GetPage(index).scale_local[index & page_mask];
+    }
+
+    bool TransformHierarchy::SetPositionLocal(const uint32_t index, const Vector3& position)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        Page& page          = GetPage(index);
+        const uint32_t slot = index & page_mask;
+        if (page.position_local[slot] == position)
+            return false;
+
+        page.position_local[slot]   = position;
+        page.dirty[slot]            |= Transform_Dirty_Local;
+        return true;
+    }
+
+    bool TransformHierarchy::SetRotationLocal(const uint32_t index, const Quaternion& rotation)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        Page& page          = GetPage(index);
+        const uint32_t slot = index & page_mask;
+        if (page.rotation_local[slot] == rotation)
+            return false;
+
+        page.rotation_local[slot]   = rotation;
+        page.dirty[slot]            |= Transform_Dirty_Local;
+        return true;
+    }
+
+    bool TransformHierarchy::SetScaleLocal(const uint32_t index, const Vector3& scale)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        Page& page          = GetPage(index);
+        const uint32_t slot = index & page_mask;
+        if (page.scale_local[slot] == scale)
+            return false;
+
+        page.scale_local[slot]  = scale;
+        page.dirty[slot]        |= Transform_Dirty_Local;
+        return true;
+    }
+
+    Matrix TransformHierarchy::GetMatrixLocal(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        Resolve(index);
+        return GetPage(index).matrix_local[index & page_mask];
+    }
+
+    Matrix TransformHierarchy::GetMatrix(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        Resolve(index);
+        return GetPage(index).matrix[index & page_mask];
+    }
+
+    Quaternion TransformHierarchy::GetRotation(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        Resolve(index);
+        return GetPage(index).rotation[index & page_mask];
+    }
+
+    uint32_t TransformHierarchy::GetVersion(const uint32_t index)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        Resolve(index);
+        return GetPage(index).version[index & page_mask];
+    }
+
+    void TransformHierarchy::Compute(const uint32_t index)
+    {
+        Page& page          = GetPage(index);
+        const uint32_t slot = index & page_mask;
+
+        if (page.dirty[slot] & Transform_Dirty_Local)
+        {
+            page.matrix_local[slot] = Matrix(page.position_local[slot], page.rotation_local[slot], page.scale_local[slot]);
+        }
+
+        const uint32_t index_parent = page.parent[slot];
+        if (index_parent == index_invalid)
+        {
+            page.matrix[slot]   = page.matrix_local[slot];
+            page.rotation[slot] = page.rotation_local[slot];
+        }
+        else
+        {
+            // The world rotation is composed instead of decomposed from the matrix, which avoids the divisions
+            const Page& page_parent         = GetPage(index_parent);
+            const uint32_t slot_parent      = index_parent & page_mask;
+            page.matrix[slot]               = page.matrix_local[slot] * page_parent.matrix[slot_parent];
+            page.rotation[slot]             = page_parent.rotation[slot_parent] * page.rotation_local[slot];
+        }
+
+        page.dirty[slot] = (page.dirty[slot] & Transform_Moved_Listed) | Transform_Moved;
+        page.version[slot]++;
+    }
+
+    void TransformHierarchy::SortByDepth()
+    {
+        // Compute the depth of every live entry, each entry is visited once
+        m_depth.assign(m_index_end, index_invalid);
+        vector<uint32_t> chain;
+        uint32_t depth_max = 0;
+        for (uint32_t index = 0; index < m_index_end; index++)
+        {
+            if (!GetPage(index).owner[index & page_mask] || m_depth[index] != index_invalid)
+                continue;
+
+            // Walk up until an entry with a known depth (or a root) is found
+            uint32_t current = index;
+            while (current != index_invalid && m_depth[current] == index_invalid)
+            {
+                chain.emplace_back(current);
+                current = GetPage(current).parent[current & page_mask];
+            }
+
+            // Walk back down, assigning depths
+            uint32_t depth = current == index_invalid ? 0 : m_depth[current] + 1;
+            while (!chain.empty())
+            {
+                m_depth[chain.back()] = depth++;
+                chain.pop_back();
+            }
+
+            depth_max = Helper::Max(depth_max, depth);
+        }
+
+        // Counting sort by depth, a stable sort which keeps registration order within a level
+        vector<uint32_t> offsets(depth_max + 1, 0);
+        for (uint32_t index = 0; index < m_index_end; index++)
+        {
+            if (GetPage(index).owner[index & page_mask])
+            {
+                offsets[m_depth[index] + 1]++;
+            }
+        }
+
+        for (uint32_t i = 1; i < static_cast<uint32_t>(offsets.size()); i++)
+        {
+            offsets[i] += offsets[i - 1];
+        }
+
+        m_order.resize(offsets.back());
+        for (uint32_t index = 0; index < m_index_end; index++)
+        {
+            if (GetPage(index).owner[index & page_mask])
+            {
+                m_order[offsets[m_depth[index]]++] = index;
+            }
+        }
+
+        m_order_dirty = false;
+    }
+}
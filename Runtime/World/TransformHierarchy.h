@@ -0,0 +1,131 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "../Math/Vector3.h"
+#include "../Math/Quaternion.h"
+#include "../Math/Matrix.h"
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan
+{
+    class Transform;
+
+    enum Transform_Dirty : uint8_t
+    {
+        Transform_Clean         = 0,
+        Transform_Dirty_Local   = 1 << 0, // local position, rotation or scale changed
+        Transform_Dirty_World   = 1 << 1, // the world matrix has to be recomputed
+        Transform_Moved         = 1 << 2, // the world matrix was recomputed since the last Update()
+        Transform_Moved_Listed  = 1 << 3  // the entry is waiting in the moved list
+    };
+
+    // Owns the data of every Transform as flat arrays (structure of arrays). Setters only flag entries
+    // as dirty, Update() then resolves them in a single pass which visits parents before their children.
+    // Storage is paged so an entry never moves once allocated. Transforms are created and set up on loading
+    // threads while the world ticks, so every access goes through the mutex and data is returned by value.
+    class SPARTAN_CLASS TransformHierarchy
+    {
+    public:
+        static constexpr uint32_t index_invalid = 0xFFFFFFFF;
+
+        TransformHierarchy() = default;
+        ~TransformHierarchy() = default;
+
+        // Slots
+        uint32_t Allocate(Transform* transform);
+        void Free(uint32_t index);
+
+        // Hierarchy
+        void SetParent(uint32_t index, uint32_t index_parent);
+        uint32_t GetParent(uint32_t index);
+
+        // Dirty flags
+        void SetDirty(uint32_t index, uint8_t flags);
+        bool IsDirty(uint32_t index, uint8_t flags = Transform_Dirty_Local | Transform_Dirty_World);
+
+        // Resolves all the dirty entries, once per frame
+        void Update();
+
+        // Hands over the entries which moved since the last call, so that spatial structures can be updated incrementally
+        void ConsumeMoved(std::vector<uint32_t>& moved);
+        Transform* GetOwner(uint32_t index);
+
+        //= DATA ================================================================================================
+        // The local values only flag the entry as dirty when they change (returning true)
+        Math::Vector3 GetPositionLocal(uint32_t index);
+        Math::Quaternion GetRotationLocal(uint32_t index);
+        Math::Vector3 GetScaleLocal(uint32_t index);
+        bool SetPositionLocal(uint32_t index, const Math::Vector3& position);
+        bool SetRotationLocal(uint32_t index, const Math::Quaternion& rotation);
+        bool SetScaleLocal(uint32_t index, const Math::Vector3& scale);
+
+        // The rest resolve the entry (and any dirty ancestors) first, for when it's needed before the next Update()
+        Math::Matrix GetMatrixLocal(uint32_t index);
+        Math::Matrix GetMatrix(uint32_t index);
+        Math::Quaternion GetRotation(uint32_t index);
+        uint32_t GetVersion(uint32_t index);
+        //=======================================================================================================
+
+    private:
+        static constexpr uint32_t page_shift    = 10;
+        static constexpr uint32_t page_size     = 1 << page_shift;
+        static constexpr uint32_t page_mask     = page_size - 1;
+        static constexpr uint32_t page_count    = 1024; // 1M transforms
+
+        struct Page
+        {
+            std::array<Math::Vector3, page_size> position_local;
+            std::array<Math::Quaternion, page_size> rotation_local;
+            std::array<Math::Vector3, page_size> scale_local;
+            std::array<Math::Matrix, page_size> matrix_local;
+            std::array<Math::Matrix, page_size> matrix;
+            std::array<Math::Quaternion, page_size> rotation;
+            std::array<uint32_t, page_size> parent;
+            std::array<uint8_t, page_size> dirty;
+            std::array<uint32_t, page_size> version; // incremented every time the world matrix is recomputed
+            std::array<Transform*, page_size> owner;
+        };
+
+        Page& GetPage(uint32_t index) const { return *m_pages[index >> page_shift]; }
+        void Resolve(uint32_t index);
+        void Compute(uint32_t index);
+        void SortByDepth();
+
+        std::array<std::unique_ptr<Page>, page_count> m_pages;
+        uint32_t m_page_allocated_count = 0;
+        uint32_t m_index_end            = 0;    // one past the highest slot ever allocated
+        std::vector<uint32_t> m_free;           // released slots, reused before growing
+        std::vector<uint32_t> m_order;          // live slots, parents before children
+        std::vector<uint32_t> m_depth;          // scratch for SortByDepth()
+        std::vector<uint32_t> m_moved;          // entries which moved, until ConsumeMoved()
+        std::vector<uint32_t> m_dirty;          // scratch for Update(), the dirty entries in order
+        bool m_order_dirty              = false;
+        std::mutex m_mutex;
+    };
+}
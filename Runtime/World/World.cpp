@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "World.h"
 #include "Entity.h"
+#include "TransformHierarchy.h"
 #include "Components/Transform.h"
 #include "Components/Camera.h"
 #include "Components/Light.h"
@@ -32,7 +33,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Resource/ProgressReport.h"
 #include "../IO/FileStream.h"
 #include "../Profiling/Profiler.h"
-#include "../Rendering/Renderer.h"
 #include "../Input/Input.h"
 #include "../RHI/RHI_Device.h"
 //=====================================
@@ -46,10 +46,15 @@ namespace Spartan
 {
 	World::World(Context* context) : ISubsystem(context)
 	{
+        m_transform_hierarchy = make_unique<TransformHierarchy>();
+
 		// Subscribe to events
-		SUBSCRIBE_TO_EVENT(Event_World_Resolve_Pending, [this](Variant) { m_is_dirty = true; });
-		SUBSCRIBE_TO_EVENT(Event_World_Stop,	        [this](Variant)	{ m_state = Idle; });
-		SUBSCRIBE_TO_EVENT(Event_World_Start,	        [this](Variant)	{ m_state = Ticking; });
+		SUBSCRIBE_TO_EVENT(Event_World_Resolve_Pending, [this]() { m_is_dirty = true; });
+		SUBSCRIBE_TO_EVENT(Event_World_Stop,	        EVENT_HANDLER(TickStop));
+		SUBSCRIBE_TO_EVENT(Event_World_Start,	        EVENT_HANDLER(TickStart));
+
+        // Subsystems are created by the main thread
+        m_thread_id = this_thread::get_id();
 	}
 
 	World::~World()
@@ -79,6 +84,13 @@ namespace Spartan
 			return;
 		}
 
+        // Acknowledge a stop, the thread which requested it can now modify the entities
+        if (m_state == Request_Idle)
+        {
+            m_state = Idle;
+            return;
+        }
+
 		if (m_state != Ticking)
 			return;
 
@@ -109,44 +121,136 @@ namespace Spartan
                 }
             }
 
-            // Tick
-            for (const auto& entity : m_entities)
+            // Tick, one packed array per component type. Transforms, renderables and colliders don't tick.
+            static const array<ComponentType, 10> tick_order =
+            {
+                ComponentType_Script,
+                ComponentType_RigidBody,
+                ComponentType_SoftBody,
+                ComponentType_Constraint,
+                ComponentType_Camera,
+                ComponentType_Light,
+                ComponentType_Environment,
+                ComponentType_AudioListener,
+                ComponentType_AudioSource,
+                ComponentType_Terrain
+            };
+
+            for (const ComponentType type : tick_order)
             {
-                entity->Tick(delta_time);
+                // Indexed as components can add/remove other components while ticking
+                for (uint32_t i = 0; i < static_cast<uint32_t>(m_components[type].size()); i++)
+                {
+                    IComponent* component = m_components[type][i];
+                    if (component->GetEntity()->IsActive())
+                    {
+                        component->OnTick(delta_time);
+                    }
+                }
             }
 		}
 
-        if (m_is_dirty)
+        // Resolve the transforms which were modified since the last tick (this frame's physics, scripts, etc.)
+        m_transform_hierarchy->Update();
+
+        // Cleared before resolving, so a change which is reported meanwhile (by another thread) triggers the next resolve
+        if (m_is_dirty.exchange(false))
         {
-            // Update dirty entities
+            // Remove entities pending destruction, collect them first so we can iterate while removing.
+            // Removing an entity marks it's children, so repeat until there is nothing left to remove.
             {
-                // Make a copy so we can iterate while removing entities
-                auto entities_copy = m_entities;
-
-                for (const auto& entity : entities_copy)
+                vector<shared_ptr<Entity>> entities_pending;
+                do
                 {
-                    if (entity->IsPendingDestruction())
+                    entities_pending.clear();
+                    for (const auto& entity : m_entities)
+                    {
+                        if (entity->IsPendingDestruction())
+                        {
+                            entities_pending.emplace_back(entity);
+                        }
+                    }
+
+                    for (const auto& entity : entities_pending)
                     {
                         _EntityRemove(entity);
                     }
-                }
+                } while (!entities_pending.empty());
             }
 
-            // Notify Renderer
-            FIRE_EVENT_DATA(Event_World_Resolve_Complete, m_entities);
-            m_is_dirty = false;
+            // Publish a view of the entities along with what changed since the last resolve (nothing gets copied)
+            m_resolve_changed_list.assign(m_resolve_changed.begin(), m_resolve_changed.end());
+            m_resolve.version++;
+            m_resolve.reset     = m_resolve_reset;
+            m_resolve.entities  = &m_entities;
+            m_resolve.changed   = &m_resolve_changed_list;
+            m_resolve.removed   = &m_resolve_removed;
+            FIRE_EVENT_DATA(Event_World_Resolve_Complete, m_resolve);
+
+            m_resolve_changed.clear();
+            m_resolve_changed_list.clear();
+            m_resolve_removed.clear();
+            m_resolve_reset = false;
         }
 	}
 
+    void World::TickStop()
+    {
+        const bool is_main_thread = this_thread::get_id() == m_thread_id;
+
+        {
+            lock_guard<mutex> lock(m_stop_mutex);
+
+            // The main thread can't be in the middle of a tick, so it stops the world right away, anyone else has to wait for the tick to acknowledge.
+            // A world which is loading isn't ticking either, so it's left alone.
+            if (m_stop_count++ == 0)
+            {
+                Scene_State state = Ticking;
+                m_state.compare_exchange_strong(state, is_main_thread ? Idle : Request_Idle);
+            }
+        }
+
+        // Off the main thread (e.g. a model import), wait for the tick which might be in progress to finish
+        if (!is_main_thread)
+        {
+            while (m_state == Request_Idle)
+            {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        }
+    }
+
+    void World::TickStart()
+    {
+        lock_guard<mutex> lock(m_stop_mutex);
+
+        // Resume once every stop has been matched with a start
+        if (m_stop_count == 0 || --m_stop_count != 0)
+            return;
+
+        Scene_State state = Idle;
+        m_state.compare_exchange_strong(state, Ticking);
+    }
+
 	void World::Unload()
     {
         // Notify any systems that the entities are about to be cleared
 		FIRE_EVENT(Event_World_Unload);
 
+        for (const auto& entity : m_entities)
+        {
+            entity->ComponentsUnregister();
+        }
+
         m_entities.clear();
         m_entities.shrink_to_fit();
+        m_entity_index_by_id.clear();
+        m_entity_ids_by_name.clear();
 
-		m_is_dirty = true;
+        m_resolve_changed.clear();
+        m_resolve_removed.clear();
+        m_resolve_reset = true;
+		m_is_dirty      = true;
 	}
 
 	bool World::SaveToFile(const string& filePathIn)
@@ -202,8 +306,8 @@ namespace Spartan
 		ProgressReport::Get().SetIsLoading(g_progress_world, false);
 		LOG_INFO("Saving took %.2f ms", timer.GetElapsedTimeMs());
 
-		// Notify subsystems waiting for us to finish
-		FIRE_EVENT(Event_World_Saved);
+		// Notify subsystems waiting for us to finish, saving runs on a worker so they are notified on the main thread
+		FIRE_EVENT_DEFERRED(Event_World_Saved);
 
 		return true;
 	}
@@ -216,8 +320,8 @@ namespace Spartan
 			return false;
 		}
 
-		// Thread safety: Wait for the world and the renderer to stop using entities
-		while (m_state != Loading || m_context->GetSubsystem<Renderer>()->IsRendering())
+		// Thread safety: Wait for the world to stop using entities (the renderer keeps its own references)
+		while (m_state != Loading)
         {
             m_state = Request_Loading;
             this_thread::sleep_for(chrono::milliseconds(16));
@@ -266,7 +370,8 @@ namespace Spartan
 		ProgressReport::Get().SetIsLoading(g_progress_world, false);	
 		LOG_INFO("Loading took %.2f ms", timer.GetElapsedTimeMs());
 
-		FIRE_EVENT(Event_World_Loaded);
+		// Loading runs on a worker, the subscribers are notified on the main thread
+		FIRE_EVENT_DEFERRED(Event_World_Loaded);
 		return true;
 	}
 
@@ -274,6 +379,8 @@ namespace Spartan
     {
         auto& entity = m_entities.emplace_back(make_shared<Entity>(m_context));
         entity->SetActive(is_active);
+        EntityIndex(static_cast<uint32_t>(m_entities.size()) - 1);
+        EntityOnChange(entity.get());
         return entity;
     }
 
@@ -284,7 +391,17 @@ namespace Spartan
 		if (!entity)
 			return empty;
 
-		return m_entities.emplace_back(entity);
+        if (EntityGetIndex(entity.get()) != m_entity_index_invalid)
+        {
+            LOG_WARNING("%s is already in the world", entity->GetName().c_str());
+            return m_entities[EntityGetIndex(entity.get())];
+        }
+
+		auto& entity_added = m_entities.emplace_back(entity);
+        EntityIndex(static_cast<uint32_t>(m_entities.size()) - 1);
+        entity->ComponentsRegister();
+        EntityOnChange(entity.get());
+        return entity_added;
 	}
 
 	bool World::EntityExists(const shared_ptr<Entity>& entity)
@@ -322,11 +439,9 @@ namespace Spartan
 
 	const shared_ptr<Entity>& World::EntityGetByName(const string& name)
 	{
-		for (const auto& entity : m_entities)
-		{
-			if (entity->GetName() == name)
-				return entity;
-		}
+        const auto it = m_entity_ids_by_name.find(name);
+        if (it != m_entity_ids_by_name.end() && !it->second.empty())
+            return EntityGetById(it->second.front());
 
         static shared_ptr<Entity> empty;
 		return empty;
@@ -334,16 +449,78 @@ namespace Spartan
 
 	const shared_ptr<Entity>& World::EntityGetById(const uint32_t id)
 	{
-		for (const auto& entity : m_entities)
-		{
-			if (entity->GetId() == id)
-				return entity;
-		}
+        const auto it = m_entity_index_by_id.find(id);
+        if (it != m_entity_index_by_id.end())
+            return m_entities[it->second];
 
         static shared_ptr<Entity> empty;
 		return empty;
 	}
 
+    void World::EntityOnRename(Entity* entity, const string& name_previous)
+    {
+        if (EntityGetIndex(entity) == m_entity_index_invalid)
+            return;
+
+        EntityUnindexName(name_previous, entity->GetId());
+        m_entity_ids_by_name[entity->GetName()].emplace_back(entity->GetId());
+    }
+
+    void World::EntityOnIdChange(Entity* entity, const uint32_t id_previous)
+    {
+        const auto it = m_entity_index_by_id.find(id_previous);
+        if (it == m_entity_index_by_id.end() || m_entities[it->second].get() != entity)
+            return;
+
+        const uint32_t index = it->second;
+        m_entity_index_by_id.erase(it);
+        m_entity_index_by_id[entity->GetId()] = index;
+
+        // Replace the id in place, so the entity keeps it's position among entities with the same name
+        vector<uint32_t>& ids = m_entity_ids_by_name[entity->GetName()];
+        replace(ids.begin(), ids.end(), id_previous, entity->GetId());
+    }
+
+    void World::EntityOnChange(Entity* entity)
+    {
+        // Entities which are not in the world are not tracked, they will be reported when added
+        if (EntityGetIndex(entity) == m_entity_index_invalid)
+            return;
+
+        m_resolve_changed.insert(entity);
+        m_is_dirty = true;
+    }
+
+    uint32_t World::EntityGetIndex(const Entity* entity) const
+    {
+        const auto it = m_entity_index_by_id.find(entity->GetId());
+        if (it == m_entity_index_by_id.end() || m_entities[it->second].get() != entity)
+            return m_entity_index_invalid;
+
+        return it->second;
+    }
+
+    void World::EntityIndex(const uint32_t index)
+    {
+        const Entity* entity = m_entities[index].get();
+        m_entity_index_by_id[entity->GetId()] = index;
+        m_entity_ids_by_name[entity->GetName()].emplace_back(entity->GetId());
+    }
+
+    void World::EntityUnindexName(const string& name, const uint32_t id)
+    {
+        const auto it = m_entity_ids_by_name.find(name);
+        if (it == m_entity_ids_by_name.end())
+            return;
+
+        vector<uint32_t>& ids = it->second;
+        ids.erase(remove(ids.begin(), ids.end(), id), ids.end());
+        if (ids.empty())
+        {
+            m_entity_ids_by_name.erase(it);
+        }
+    }
+
     // Removes an entity and all of it's children
     void World::_EntityRemove(const std::shared_ptr<Entity>& entity)
     {
@@ -354,26 +531,71 @@ namespace Spartan
             EntityRemove(child->GetEntity()->GetPtrShared());
         }
 
-        // Keep a reference to it's parent (in case it has one)
-        auto parent = entity->GetTransform()->GetParent();
+        // Unlink it from it's parent (in case it has one) and from the component arrays,
+        // it might outlive the removal if the renderer still references it
+        entity->GetTransform()->BecomeOrphan();
+        entity->ComponentsUnregister();
 
-        // Remove this entity
-        for (auto it = m_entities.begin(); it < m_entities.end();)
+        // Remove this entity, by swapping it with the last one
+        const uint32_t index = EntityGetIndex(entity.get());
+        if (index == m_entity_index_invalid)
+            return;
+
+        const uint32_t index_last = static_cast<uint32_t>(m_entities.size()) - 1;
+        if (index != index_last)
         {
-            const auto temp = *it;
-            if (temp->GetId() == entity->GetId())
-            {
-                it = m_entities.erase(it);
-                break;
-            }
-            ++it;
+            m_entities[index] = move(m_entities[index_last]);
+            m_entity_index_by_id[m_entities[index]->GetId()] = index;
         }
+        m_entities.pop_back();
+
+        m_entity_index_by_id.erase(entity->GetId());
+        EntityUnindexName(entity->GetName(), entity->GetId());
+
+        m_resolve_changed.erase(entity.get());
+        m_resolve_removed.emplace_back(entity.get());
+    }
+
+    void World::ComponentAdd(IComponent* component)
+    {
+        // Entities outside of the world register their components when they are added
+        if (EntityGetIndex(component->GetEntity()) == m_entity_index_invalid)
+            return;
 
-        // If there was a parent, update it
-        if (parent)
         {
-            parent->AcquireChildren();
+            lock_guard<mutex> lock(m_components_mutex);
+
+            if (component->GetPoolIndex() != IComponent::pool_index_invalid)
+                return;
+
+            vector<IComponent*>& components = m_components[component->GetType()];
+            component->SetPoolIndex(static_cast<uint32_t>(components.size()));
+            components.emplace_back(component);
         }
+
+        EntityOnChange(component->GetEntity());
+    }
+
+    void World::ComponentRemove(IComponent* component)
+    {
+        {
+            lock_guard<mutex> lock(m_components_mutex);
+
+            const uint32_t index = component->GetPoolIndex();
+            if (index == IComponent::pool_index_invalid)
+                return;
+
+            // Swap with the last one and pop, so the array stays packed
+            vector<IComponent*>& components = m_components[component->GetType()];
+            IComponent* last                = components.back();
+            components[index]               = last;
+            last->SetPoolIndex(index);
+            components.pop_back();
+
+            component->SetPoolIndex(IComponent::pool_index_invalid);
+        }
+
+        EntityOnChange(component->GetEntity());
     }
 
 	shared_ptr<Entity>& World::CreateEnvironment()
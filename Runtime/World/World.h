@@ -25,6 +25,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include <memory>
 #include <string>
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include "Entity.h"
 #include "../Core/ISubsystem.h"
 #include "../Core/Spartan_Definitions.h"
 //======================================
@@ -35,11 +42,23 @@ namespace Spartan
 	class Light;
 	class Input;
 	class Profiler;
+	class TransformHierarchy;
+
+	// Published with Event_World_Resolve_Complete, it's a read-only view which is only valid during the event
+	struct WorldResolve
+	{
+		uint64_t version									= 0;		// increments with every resolve
+		bool reset											= false;	// everything changed (e.g. the world was unloaded), rebuild from entities
+		const std::vector<std::shared_ptr<Entity>>* entities	= nullptr;	// all the entities
+		const std::vector<Entity*>* changed					= nullptr;	// added, activated/deactivated or had components added/removed since the last resolve
+		const std::vector<Entity*>* removed					= nullptr;	// left the world since the last resolve, might be destroyed so only use them as keys
+	};
 
 	enum Scene_State
 	{
 		Ticking,
 		Idle,
+		Request_Idle,
 		Request_Loading,
 		Loading
 	};
@@ -60,6 +79,7 @@ namespace Spartan
 		bool LoadFromFile(const std::string& file_path);
 		const auto& GetName() const { return m_name; }
         void MakeDirty() { m_is_dirty = true; }
+        TransformHierarchy* GetTransformHierarchy() const { return m_transform_hierarchy.get(); }
 
 		//= Entities ===========================================================================
 		std::shared_ptr<Entity>& EntityCreate(bool is_active = true);
@@ -71,10 +91,45 @@ namespace Spartan
 		const std::shared_ptr<Entity>& EntityGetById(uint32_t id);
 		const auto& EntityGetAll() const    { return m_entities; }
 		auto EntityGetCount() const         { return static_cast<uint32_t>(m_entities.size()); }
+
+		// Keep the lookups up to date, called by the entities themselves
+		void EntityOnRename(Entity* entity, const std::string& name_previous);
+		void EntityOnIdChange(Entity* entity, uint32_t id_previous);
+		void EntityOnChange(Entity* entity);
+		//======================================================================================
+
+		//= Components =========================================================================
+		void ComponentAdd(IComponent* component);
+		void ComponentRemove(IComponent* component);
+		const auto& ComponentGetAll(ComponentType type) const { return m_components[type]; }
+
+		// Calls function(T*, Others*...) for every component of type T whose entity also has all of Others.
+		// Iterates the packed pointer array of T, so put the rarest component type first. Main thread only.
+		template <typename T, typename... Others, typename Function>
+		void Each(Function&& function)
+		{
+			for (IComponent* component : m_components[IComponent::TypeToEnum<T>()])
+			{
+				Entity* entity = component->GetEntity();
+
+				if constexpr (sizeof...(Others) != 0)
+				{
+					if (!(entity->HasComponent<Others>() && ...))
+						continue;
+				}
+
+				function(static_cast<T*>(component), entity->GetComponent<Others>()...);
+			}
+		}
 		//======================================================================================
 
 	private:
         void _EntityRemove(const std::shared_ptr<Entity>& entity);
+        void TickStop();
+        void TickStart();
+        uint32_t EntityGetIndex(const Entity* entity) const;
+        void EntityIndex(uint32_t index);
+        void EntityUnindexName(const std::string& name, uint32_t id);
 
 		//= COMMON ENTITY CREATION ========================
 		std::shared_ptr<Entity>& CreateEnvironment();
@@ -84,11 +139,31 @@ namespace Spartan
 
         std::string m_name;
         bool m_was_in_editor_mode   = false;
-        bool m_is_dirty             = true;
-        Scene_State m_state         = Ticking;	
+        std::atomic<bool> m_is_dirty = true; // entities report changes from loader threads too
+        std::atomic<Scene_State> m_state    = Ticking;
+        uint32_t m_stop_count               = 0; // importers on different threads can stop the world at the same time
+        std::mutex m_stop_mutex;                // not held while waiting, the main thread can stop the world too
+        std::thread::id m_thread_id;            // the main thread, which ticks the world
         Input* m_input              = nullptr;
         Profiler* m_profiler        = nullptr;
 
+        // Declared before the entities so they outlive their components
+        std::unique_ptr<TransformHierarchy> m_transform_hierarchy;
+        // Pointers to the components of the entities in the world, packed per type.
+        // The components themselves stay owned (and allocated) by their entities.
+        std::array<std::vector<IComponent*>, ComponentType_Unknown> m_components;
+        std::mutex m_components_mutex; // entities can get components from loader threads
+
         std::vector<std::shared_ptr<Entity>> m_entities;
+        static constexpr uint32_t m_entity_index_invalid = 0xFFFFFFFF;
+
+        // Resolve deltas
+        WorldResolve m_resolve;
+        std::unordered_set<Entity*> m_resolve_changed;
+        std::vector<Entity*> m_resolve_changed_list;
+        std::vector<Entity*> m_resolve_removed;
+        bool m_resolve_reset = true;
+        std::unordered_map<uint32_t, uint32_t> m_entity_index_by_id;                        // id -> index in m_entities
+        std::unordered_map<std::string, std::vector<uint32_t>> m_entity_ids_by_name; // name -> ids in insertion order (names don't have to be unique)
 	};
 }
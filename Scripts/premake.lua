@@ -20,10 +20,14 @@
 SOLUTION_NAME		= "Spartan"
 EDITOR_NAME			= "Editor"
 RUNTIME_NAME		= "Runtime"
+BENCHMARK_NAME		= "Benchmark"
+TEST_NAME			= "Test"
 TARGET_NAME			= "Spartan" -- Name of executable
 DEBUG_FORMAT		= "c7"
 EDITOR_DIR			= "../" .. EDITOR_NAME
 RUNTIME_DIR			= "../" .. RUNTIME_NAME
+BENCHMARK_DIR		= "../" .. BENCHMARK_NAME
+TEST_DIR			= "../" .. TEST_NAME
 IGNORE_FILES		= {}
 LIBRARY_DIR			= "../ThirdParty/libraries"
 INTERMEDIATE_DIR	= "../Binaries/Intermediate"
@@ -177,6 +181,74 @@ project (EDITOR_NAME)
 	-- Libraries
 	libdirs (LIBRARY_DIR)
 
+	-- "Debug"
+	filter "configurations:Debug"
+		targetdir (TARGET_DIR_DEBUG)	
+		debugdir (TARGET_DIR_DEBUG)
+		debugformat (DEBUG_FORMAT)		
+				
+	-- "Release"
+	filter "configurations:Release"
+		targetdir (TARGET_DIR_RELEASE)
+		debugdir (TARGET_DIR_RELEASE)
+
+-- Benchmark -----------------------------------------------------------------------------------------------
+project (BENCHMARK_NAME)
+	location (BENCHMARK_DIR)
+	links { RUNTIME_NAME }
+	dependson { RUNTIME_NAME }
+	objdir (INTERMEDIATE_DIR)
+	kind "ConsoleApp"
+	staticruntime "On"
+	defines{ API_GRAPHICS }
+	
+	-- Files
+	files 
+	{ 
+		BENCHMARK_DIR .. "/**.h",
+		BENCHMARK_DIR .. "/**.cpp"
+	}
+	
+	-- Includes
+	includedirs { "../" .. RUNTIME_NAME }
+	
+	-- Libraries
+	libdirs (LIBRARY_DIR)
+
+	-- "Debug"
+	filter "configurations:Debug"
+		targetdir (TARGET_DIR_DEBUG)	
+		debugdir (TARGET_DIR_DEBUG)
+		debugformat (DEBUG_FORMAT)		
+				
+	-- "Release"
+	filter "configurations:Release"
+		targetdir (TARGET_DIR_RELEASE)
+		debugdir (TARGET_DIR_RELEASE)
+
+-- Test ----------------------------------------------------------------------------------------------------
+project (TEST_NAME)
+	location (TEST_DIR)
+	links { RUNTIME_NAME }
+	dependson { RUNTIME_NAME }
+	objdir (INTERMEDIATE_DIR)
+	kind "ConsoleApp"
+	staticruntime "On"
+	defines{ API_GRAPHICS }
+	
+	-- Files
+	files 
+	{ 
+		TEST_DIR .. "/**.h",
+		TEST_DIR .. "/**.cpp"
+	}
+	
+	-- Includes
+	includedirs { "../" .. RUNTIME_NAME }
+	
+	-- Libraries
+	libdirs (LIBRARY_DIR)
+
 	-- "Debug"
 	filter "configurations:Debug"
 		targetdir (TARGET_DIR_DEBUG)	
@@ -0,0 +1,75 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==
+#include <cstring>
+#include "Test.h"
+//=============
+
+namespace
+{
+    struct Entry
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    const Entry tests[] =
+    {
+        { "light_clusters",     Test::LightClusters },
+        { "occlusion_culler",   Test::OcclusionCuller }
+    };
+
+    uint32_t failure_count = 0;
+}
+
+bool Test::Check(const bool condition, const char* expression, const char* file, const int line)
+{
+    if (!condition)
+    {
+        printf("  %s(%d): check failed: %s\n", file, line, expression);
+        failure_count++;
+    }
+
+    return condition;
+}
+
+// Runs every test, or only the ones named on the command line, and returns non-zero if any check failed
+int main(int argc, char** argv)
+{
+    for (const Entry& test : tests)
+    {
+        bool selected = argc <= 1;
+        for (int i = 1; i < argc; i++)
+        {
+            selected |= strcmp(argv[i], test.name) == 0;
+        }
+
+        if (!selected)
+            continue;
+
+        const uint32_t failure_count_previous = failure_count;
+        test.run();
+        printf("%-24s %s\n", test.name, failure_count == failure_count_previous ? "passed" : "failed");
+    }
+
+    return failure_count == 0 ? 0 : 1;
+}
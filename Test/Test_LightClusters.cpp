@@ -0,0 +1,101 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =======================
+#include <vector>
+#include "Test.h"
+#include "Rendering/LightClusters.h"
+//==================================
+
+//= NAMESPACES ==========
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//=======================
+
+// Bins a handful of lights, placed by hand, into the grid of a camera at the origin looking down +z and compares every
+// cluster against the expected light list. The projection has a 90 degree vertical field of view and a 16:9 aspect ratio,
+// so a tile is 2/9 of the depth tall and 2/9 of the depth wide. Slice k starts at 0.5 * 1000^(k / 24).
+void Test::LightClusters()
+{
+    const float near_plane  = 0.5f;
+    const float far_plane   = 500.0f;
+    const Matrix projection = Matrix::CreatePerspectiveFieldOfViewLH(Helper::PI_DIV_2, 16.0f / 9.0f, near_plane, far_plane);
+
+    const vector<Spartan::LightClusters::Sphere> lights =
+    {
+        { Vector3(0.0f, 0.0f, 10.0f),   0.1f },  // 0: on the center line between tile x 7 and 8, tile y 4, slice 10 (9.6 to 11.0)
+        { Vector3(40.0f, 17.78f, 40.0f), 0.5f }, // 1: the middle of tile 12, 2 in slice 15 (37.5 to 50.0)
+        { Vector3(0.0f, 0.0f, -5.0f),   1.0f },  // 2: behind the camera
+        { Vector3(0.0f, 0.0f, 600.0f),  1.0f },  // 3: beyond the far plane
+        { Vector3(0.0f, 0.0f, 0.0f),    0.4f },  // 4: around the camera, short of the near plane
+        { Vector3(0.0f, 0.0f, 10.0f),   0.2f },  // 5: shares the clusters of light 0
+        { Vector3(0.0f, 0.0f, 50.0f),   0.5f }   // 6: straddles the boundary of slice 15 and 16
+    };
+
+    struct Expected
+    {
+        uint32_t x;
+        uint32_t y;
+        uint32_t z;
+        vector<uint32_t> lights;
+    };
+
+    const vector<Expected> expected =
+    {
+        { 7,  4, 10, { 0, 5 } },
+        { 8,  4, 10, { 0, 5 } },
+        { 12, 2, 15, { 1 } },
+        { 7,  4, 15, { 6 } },
+        { 8,  4, 15, { 6 } },
+        { 7,  4, 16, { 6 } },
+        { 8,  4, 16, { 6 } }
+    };
+
+    Spartan::LightClusters clusters;
+    clusters.Build(Matrix::Identity, projection, near_plane, far_plane, lights);
+
+    // Every cluster not listed above has to be empty
+    vector<const Expected*> expected_per_cluster(Spartan::LightClusters::cluster_count, nullptr);
+    for (const Expected& entry : expected)
+    {
+        expected_per_cluster[Spartan::LightClusters::GetClusterIndex(entry.x, entry.y, entry.z)] = &entry;
+    }
+
+    uint32_t index_count = 0;
+    for (uint32_t cluster_index = 0; cluster_index < Spartan::LightClusters::cluster_count; cluster_index++)
+    {
+        const Spartan::LightClusters::Cluster& cluster = clusters.GetClusters()[cluster_index];
+        const vector<uint32_t> lights_binned(clusters.GetLightIndices().begin() + cluster.offset, clusters.GetLightIndices().begin() + cluster.offset + cluster.count);
+        const vector<uint32_t> lights_expected = expected_per_cluster[cluster_index] ? expected_per_cluster[cluster_index]->lights : vector<uint32_t>();
+
+        if (!TEST_CHECK(lights_binned == lights_expected))
+        {
+            printf("  cluster %u: %u lights binned, %u expected\n", cluster_index, static_cast<uint32_t>(lights_binned.size()), static_cast<uint32_t>(lights_expected.size()));
+        }
+
+        index_count += cluster.count;
+    }
+
+    TEST_CHECK(index_count == clusters.GetLightIndices().size());
+    TEST_CHECK(Spartan::LightClusters::GetSlice(near_plane, near_plane, far_plane) == 0);
+    TEST_CHECK(Spartan::LightClusters::GetSlice(far_plane, near_plane, far_plane) == Spartan::LightClusters::grid_z - 1);
+}
@@ -0,0 +1,130 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========================
+#include <vector>
+#include <string>
+#include "Test.h"
+#include "Core/Context.h"
+#include "RHI/RHI_Vertex.h"
+#include "Threading/Threading.h"
+#include "Rendering/OcclusionCuller.h"
+//=====================================
+
+//= NAMESPACES ==========
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//=======================
+
+namespace
+{
+    // A grid of boxes behind the wall, 2 units apart, at a depth of 20 to 21. The top row is y = 7, the left column x = -19.
+    constexpr uint32_t grid_width   = 20;
+    constexpr uint32_t grid_height  = 8;
+
+    // Visibility of the grid, '#' is visible and '.' is occluded. The wall hides the 10 columns in the middle, the floor the
+    // rows below it. The few boxes which stay visible in the row right under the floor are within the conservative margin.
+    const char* const golden[grid_height] =
+    {
+        "#####..........#####",
+        "#####..........#####",
+        "#####..........#####",
+        "#####..........#####",
+        "#####..........#####",
+        ".#.#............#.#.",
+        "....................",
+        "...................."
+    };
+}
+
+// Rasterizes a wall and a floor which crosses the near plane, then tests a few boxes placed by hand and a grid of boxes
+// against a stored golden result. The camera is at the origin, looking down +z.
+void Test::OcclusionCuller()
+{
+    const float near_plane          = 0.3f;
+    const Matrix view_projection    = Matrix::CreateLookAtLH(Vector3::Zero, Vector3::Forward, Vector3::Up) * Matrix::CreatePerspectiveFieldOfViewLH(1.0f, 16.0f / 9.0f, near_plane, 1000.0f);
+
+    // A 10x10 wall at a depth of 10
+    const vector<RHI_Vertex_PosTexNorTan> wall =
+    {
+        RHI_Vertex_PosTexNorTan(Vector3(-5.0f, -5.0f, 10.0f), Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3(5.0f,  -5.0f, 10.0f), Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3(-5.0f, 5.0f,  10.0f), Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3(5.0f,  5.0f,  10.0f), Vector2::Zero)
+    };
+
+    // A floor at y = -1, which starts behind the camera
+    const vector<RHI_Vertex_PosTexNorTan> ground =
+    {
+        RHI_Vertex_PosTexNorTan(Vector3(-50.0f, -1.0f, -5.0f),  Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3(50.0f,  -1.0f, -5.0f),  Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3(-50.0f, -1.0f, 100.0f), Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3(50.0f,  -1.0f, 100.0f), Vector2::Zero)
+    };
+
+    const vector<uint32_t> indices = { 0, 2, 1, 1, 2, 3 };
+
+    vector<Spartan::OcclusionCuller::Occluder> occluders(2);
+    occluders[0].vertices       = wall.data();
+    occluders[0].indices        = indices.data();
+    occluders[0].index_count    = static_cast<uint32_t>(indices.size());
+    occluders[0].transform      = Matrix::Identity;
+    occluders[1].vertices       = ground.data();
+    occluders[1].indices        = indices.data();
+    occluders[1].index_count    = static_cast<uint32_t>(indices.size());
+    occluders[1].transform      = Matrix::Identity;
+
+    Spartan::OcclusionCuller culler;
+    culler.Rasterize(view_projection, near_plane, occluders);
+
+    // Cases which follow from the scene
+    TEST_CHECK(!culler.IsVisible(BoundingBox(Vector3(-1.0f, -1.0f, 20.0f), Vector3(1.0f, 1.0f, 22.0f))));    // behind the wall
+    TEST_CHECK(culler.IsVisible(BoundingBox(Vector3(-1.0f, -1.0f, 5.0f), Vector3(1.0f, 1.0f, 6.0f))));       // in front of the wall
+    TEST_CHECK(culler.IsVisible(BoundingBox(Vector3(20.0f, -1.0f, 20.0f), Vector3(22.0f, 1.0f, 22.0f))));    // beside the wall
+    TEST_CHECK(culler.IsVisible(BoundingBox(Vector3(4.0f, -1.0f, 20.0f), Vector3(12.0f, 1.0f, 22.0f))));     // peeking past its edge
+    TEST_CHECK(culler.IsVisible(BoundingBox(Vector3(-1.0f, -1.0f, 9.5f), Vector3(1.0f, 1.0f, 10.5f))));      // going through it
+    TEST_CHECK(!culler.IsVisible(BoundingBox(Vector3(-2.0f, -5.0f, 20.0f), Vector3(2.0f, -2.0f, 25.0f))));   // under the floor
+    TEST_CHECK(culler.IsVisible(BoundingBox(Vector3(-1.0f, -1.0f, -1.0f), Vector3(1.0f, 1.0f, 1.0f))));      // around the camera
+
+    // The grid, against the golden result
+    for (uint32_t y = 0; y < grid_height; y++)
+    {
+        string row;
+        for (uint32_t x = 0; x < grid_width; x++)
+        {
+            const Vector3 min = Vector3(-19.5f + x * 2.0f, 6.5f - y * 2.0f, 20.0f);
+            row += culler.IsVisible(BoundingBox(min, min + Vector3::One)) ? '#' : '.';
+        }
+
+        if (!TEST_CHECK(row == golden[y]))
+        {
+            printf("  row %u: %s, expected %s\n", y, row.c_str(), golden[y]);
+        }
+    }
+
+    // Bands rasterized on the worker threads have to produce the same depth buffer
+    Context context;
+    context.RegisterSubsystem<Threading>();
+    Spartan::OcclusionCuller culler_threaded;
+    culler_threaded.Rasterize(view_projection, near_plane, occluders, context.GetSubsystem<Threading>());
+    TEST_CHECK(culler_threaded.GetLevel(0) == culler.GetLevel(0));
+}